@@ -1,6 +1,8 @@
 #ifndef ATTENDANCE_H
 #define ATTENDANCE_H
 
+#include <cstddef>
+#include <cstdint>
 #include <string>
 #include <vector>
 #include "user.h" // For User struct
@@ -16,10 +18,68 @@ struct AttendanceRecord {
     std::string meal_type;
 };
 
+// One cell of an edited attendance grid.
+struct AttendanceChange {
+    int user_id;
+    std::string date;      // YYYY-MM-DD
+    std::string meal_type;
+    bool attended;         // true records the meal, false removes it
+};
+
+// Attendance for every user of the mess over a date range, one bit per
+// (user, day, meal). Users are ordered by name, days run from the start date to
+// the end date inclusive, and meals are indexed Breakfast = 0, Lunch = 1,
+// Dinner = 2. Bits are laid out user-major so one user's range is contiguous.
+class AttendanceMatrix {
+public:
+    static constexpr int MEALS_PER_DAY = 3;
+    static constexpr size_t npos = static_cast<size_t>(-1);
+
+    AttendanceMatrix() = default;
+    explicit AttendanceMatrix(std::vector<std::string> dates);
+
+    void addUser(int userId, const std::string& name); // Appends a row with no meals set
+
+    size_t userCount() const { return userIds.size(); }
+    size_t dayCount() const { return days.size(); }
+    int userId(size_t user) const { return userIds[user]; }
+    const std::string& userName(size_t user) const { return userNames[user]; }
+    const std::string& date(size_t day) const { return days[day]; }
+    size_t userIndex(int userId) const; // npos if the user is not in the matrix
+    size_t dayIndex(const std::string& date) const; // npos if outside the range
+
+    bool attended(size_t user, size_t day, int meal) const;
+    void set(size_t user, size_t day, int meal, bool value);
+    size_t mealsForUser(size_t user) const;
+    size_t mealsOnDay(size_t day, int meal) const;
+
+    static int mealIndex(const std::string& mealType); // -1 if not a meal type
+    static const char* mealName(int meal);
+
+private:
+    size_t bitIndex(size_t user, size_t day, int meal) const {
+        return (user * days.size() + day) * MEALS_PER_DAY + static_cast<size_t>(meal);
+    }
+
+    std::vector<std::string> days;
+    int firstDay = 0;
+    std::vector<int> userIds;
+    std::vector<std::string> userNames;
+    std::vector<uint64_t> bits;
+};
+
 bool recordAttendance(int user_id, const std::string& date, const std::string& meal_type);
 std::vector<MealAttendance> getAttendanceForDate(const std::string& date);
 
+// Reads the matrix for [startDate, endDate] with one ordered query. Returns an
+// empty matrix if the range is invalid or the query fails.
+AttendanceMatrix getAttendanceRange(const std::string& startDate, const std::string& endDate);
+
 bool addMultipleAttendance(const std::string& date, const std::vector<AttendanceRecord>& records);
 bool deleteMultipleAttendance(const std::string& date, const std::vector<AttendanceRecord>& records);
 
+// Applies additions and removals across any number of dates in one
+// transaction: either every change is saved or none is.
+bool applyAttendanceChanges(const std::vector<AttendanceChange>& changes);
+
 #endif // ATTENDANCE_H
\ No newline at end of file
@@ -0,0 +1,47 @@
+#ifndef ATTENDANCEGRIDMODEL_H
+#define ATTENDANCEGRIDMODEL_H
+
+#include <QAbstractTableModel>
+#include <QStringList>
+#include <vector>
+#include "attendance.h"
+
+// Users as rows, (day, meal) as columns, over an AttendanceMatrix. Edits are
+// kept in memory next to the loaded state, so the view only paints visible
+// cells and saving sends just the cells that differ.
+class AttendanceGridModel : public QAbstractTableModel
+{
+    Q_OBJECT
+
+public:
+    explicit AttendanceGridModel(QObject *parent = nullptr);
+
+    void setMatrix(AttendanceMatrix matrix); // Discards pending changes
+
+    int rowCount(const QModelIndex &parent = QModelIndex()) const override;
+    int columnCount(const QModelIndex &parent = QModelIndex()) const override;
+    QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const override;
+    bool setData(const QModelIndex &index, const QVariant &value, int role = Qt::EditRole) override;
+    QVariant headerData(int section, Qt::Orientation orientation, int role = Qt::DisplayRole) const override;
+    Qt::ItemFlags flags(const QModelIndex &index) const override;
+
+    // Checks every cell in the column or row, or clears them if all are already checked.
+    void toggleColumn(int column);
+    void toggleRow(int row);
+
+    std::vector<AttendanceChange> pendingChanges() const;
+    int pendingChangeCount() const { return pendingCount; }
+
+signals:
+    void pendingChangeCountChanged(int count);
+
+private:
+    bool setCell(size_t user, size_t day, int meal, bool value); // True if the cell changed
+
+    AttendanceMatrix saved;
+    AttendanceMatrix edited;
+    QStringList columnHeaders;
+    int pendingCount = 0;
+};
+
+#endif // ATTENDANCEGRIDMODEL_H
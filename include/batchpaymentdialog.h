@@ -0,0 +1,40 @@
+#ifndef BATCHPAYMENTDIALOG_H
+#define BATCHPAYMENTDIALOG_H
+
+#include <QDialog>
+#include <QMap>
+#include <vector>
+#include "finance.h"
+
+class QPlainTextEdit;
+class QTableWidget;
+class QPushButton;
+class QDateEdit;
+class QLabel;
+
+// Pasted rows of "user, amount[, date]" checked against the user directory
+// and recorded together with recordPayments().
+class BatchPaymentDialog : public QDialog
+{
+    Q_OBJECT
+
+public:
+    explicit BatchPaymentDialog(QWidget *parent = nullptr);
+
+private slots:
+    void checkRows();
+    void recordClicked();
+
+private:
+    QPlainTextEdit *rowsTextEdit;
+    QDateEdit *defaultDateEdit;
+    QTableWidget *previewTable;
+    QLabel *summaryLabel;
+    QPushButton *recordButton;
+
+    QMap<int, QString> namesById;        // The mess's user directory
+    QMap<QString, int> idsByUsername;
+    std::vector<PaymentRecord> payments; // Rows of the last successful check
+};
+
+#endif // BATCHPAYMENTDIALOG_H
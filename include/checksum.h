@@ -0,0 +1,17 @@
+#ifndef CHECKSUM_H
+#define CHECKSUM_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// CRC-32 (IEEE 802.3), the same checksum zlib and gzip use. Guards the local
+// files the app writes (offline journal, reference snapshot) against torn writes.
+uint32_t crc32(const char* data, size_t size);
+inline uint32_t crc32(const std::string& data) { return crc32(data.data(), data.size()); }
+
+// SHA-256 as 64 lowercase hex characters. Fingerprints migration scripts, where
+// an accidental edit must not go unnoticed.
+std::string sha256Hex(const std::string& data);
+
+#endif // CHECKSUM_H
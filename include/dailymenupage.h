@@ -5,9 +5,13 @@
 #include <vector>
 #include "menu.h"
 
+struct ReferenceSnapshot;
+
 class QDateEdit;
 class QListWidget;
 class QPushButton;
+class QLineEdit;
+class QShowEvent;
 
 class DailyMenuPage : public QWidget
 {
@@ -16,8 +20,14 @@ class DailyMenuPage : public QWidget
 public:
     explicit DailyMenuPage(QWidget *parent = nullptr);
 
+    void applyReferenceSnapshot(const ReferenceSnapshot& snapshot);
+
+protected:
+    void showEvent(QShowEvent *event) override;
+
 private slots:
     void loadDailyMenu();
+    void filterAvailableMenuItems(const QString &query);
     void saveDailyMenuClicked();
     void addBreakfastItem();
     void removeBreakfastItem();
@@ -25,18 +35,26 @@ private slots:
     void removeLunchItem();
     void addDinnerItem();
     void removeDinnerItem();
+    void saveAsTemplateClicked();
+    void applyTemplateClicked();
 
 private:
     void loadAvailableMenuItems();
+    void populateAvailableMenuItems(const std::vector<MenuItem>& items);
     std::vector<int> getMenuItemIds(QListWidget* listWidget);
 
     QDateEdit *menuDateEdit;
+    QLineEdit *menuItemFilterEdit;
     QListWidget *availableMenuItemsList;
     QListWidget *breakfastList;
     QListWidget *lunchList;
     QListWidget *dinnerList;
 
     QPushButton *saveMenuButton;
+    QPushButton *saveTemplateButton;
+    QPushButton *applyTemplateButton;
+
+    bool loaded = false; // Set by the first showEvent()
 };
 
 #endif // DAILYMENUPAGE_H
\ No newline at end of file
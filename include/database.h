@@ -2,12 +2,50 @@
 
 #include <string>
 #include <memory>
+#include <vector>
 #include <cppconn/driver.h>
 #include <cppconn/exception.h>
 #include <cppconn/resultset.h>
 #include <cppconn/statement.h>
 #include <cppconn/connection.h>
 
+// Path of the INI file read by getConnection(); defaults to "config.ini" in the working directory.
+void setConfigFilePath(const std::string& path);
+const std::string& getConfigFilePath();
+
 std::unique_ptr<sql::Connection> getConnection();
+
+// Connection for read-only reporting queries. Goes round-robin to a healthy
+// [Replicas] endpoint from the config file; falls back to the primary when no
+// replica is configured or reachable, and for a short read-your-writes window
+// after noteWrite() so a user sees their own changes immediately.
+std::unique_ptr<sql::Connection> getReadConnection();
+
+// Called by data-layer functions after a successful write.
+void noteWrite();
+
+struct ReplicaStatus {
+    std::string host;
+    int consecutive_failures;
+    bool available; // False while backing off after a failed connect
+};
+std::vector<ReplicaStatus> getReplicaStatus();
+
+// A MySQL named lock (GET_LOCK) held on a connection for the object's lifetime.
+// Serializes maintenance such as DDL, which can't be made atomic with a transaction.
+class NamedLock {
+public:
+    NamedLock(sql::Connection& con, const std::string& name, int timeoutSeconds);
+    ~NamedLock();
+    NamedLock(const NamedLock&) = delete;
+    NamedLock& operator=(const NamedLock&) = delete;
+    bool acquired() const { return held; }
+
+private:
+    sql::Connection& con;
+    std::string name;
+    bool held = false;
+};
+
 std::string generateSalt();
 std::string hashPassword(const std::string& password, const std::string& salt);
\ No newline at end of file
@@ -0,0 +1,59 @@
+#ifndef DATAGEN_H
+#define DATAGEN_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Synthetic datasets for load testing.
+//
+// generateDataset() creates a new mess and fills it with users, meal periods,
+// menu items, daily menus, attendance, expenses and payments that follow the
+// patterns of a real hall: each user has their own appetite for each meal,
+// weekends are quieter and some users go home for them, absences come in
+// spells of several days, shopping happens most days with rent and bills on
+// fixed days of the month, and users pay at the start of each month. Meal
+// headcounts and ledger entries are written as the application would.
+//
+// All randomness comes from the seed through the generator's own PRNG and
+// distributions (not <random>'s, whose output differs between standard
+// libraries), and each kind of data draws from its own stream, so the same
+// options give the same rows on any platform, and changing e.g. the expense
+// rate leaves the attendance unchanged. Row IDs come from the target database;
+// load into a fresh schema for identical IDs as well.
+//
+// Rows are written with multi-row INSERTs of up to 1000 rows on one
+// connection, committing every few thousand rows, with foreign-key and unique
+// checks off for the session (the generated rows satisfy them by construction).
+
+struct DatasetOptions {
+    uint64_t seed = 1;
+    std::string mess_name;         // Must not exist yet; empty for "Synthetic <seed>"
+    int users = 50;                // Including one Admin and about one Staff per 20 users
+    std::string start_month = "2024-01"; // YYYY-MM
+    int months = 3;                // One meal period per month
+    int menu_items = 60;           // At least 6
+    double expenses_per_day = 3.0; // Average food purchases per day; bills and rent come on top
+    std::string password = "password"; // Shared by every generated user
+};
+
+struct DatasetSummary {
+    int mess_id = 0;
+    std::vector<int> period_ids; // In month order
+    size_t users = 0;
+    size_t menu_items = 0;
+    size_t daily_menu_rows = 0;
+    size_t attendance_rows = 0;
+    size_t expenses = 0;
+    size_t payments = 0;
+    size_t total_rows = 0; // Every row written, headcounts and ledger entries included
+};
+
+// Empty when the options are usable, otherwise what is wrong with them.
+std::string validateDatasetOptions(const DatasetOptions& options);
+
+// False if the mess could not be created or a write failed; a failure after
+// the mess was created leaves it partly filled (summary.mess_id says which).
+bool generateDataset(const DatasetOptions& options, DatasetSummary& summary);
+
+#endif // DATAGEN_H
@@ -0,0 +1,19 @@
+#ifndef DATEUTIL_H
+#define DATEUTIL_H
+
+#include <string>
+
+// Dates travel through the data layer as "YYYY-MM-DD" strings. These helpers
+// convert them to a day number (days since 1970-01-01) so ranges can be
+// expanded and compared without a round trip to the database.
+bool parseIsoDate(const std::string& date, int& dayNumber);
+std::string formatIsoDate(int dayNumber);
+int dayOfWeek(int dayNumber); // 0 = Monday ... 6 = Sunday
+
+// First day of a period's month ("May", "2024") and of the month after it, so
+// month filters can be half-open date ranges that use the date indexes and
+// let MySQL prune partitions. Surrounding blanks are ignored and the month
+// name is matched case-insensitively. False for an unknown month or bad year.
+bool monthDateRange(const std::string& monthName, const std::string& year, std::string& firstDay, std::string& nextFirstDay);
+
+#endif // DATEUTIL_H
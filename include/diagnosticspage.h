@@ -0,0 +1,43 @@
+#ifndef DIAGNOSTICSPAGE_H
+#define DIAGNOSTICSPAGE_H
+
+#include <QWidget>
+#include <vector>
+#include "slowquery.h"
+
+class QTableWidget;
+class QPlainTextEdit;
+class QLabel;
+class QShowEvent;
+
+// Recent entries of the slow-query file, with the SQL, bound values, timings
+// and plan of the selected one, and the GUI-thread stalls seen since startup.
+class DiagnosticsPage : public QWidget
+{
+    Q_OBJECT
+
+public:
+    explicit DiagnosticsPage(QWidget *parent = nullptr);
+
+protected:
+    void showEvent(QShowEvent *event) override;
+
+private slots:
+    void loadSlowQueries();
+    void showSelectedQuery();
+    void loadStalls();
+
+private:
+    static const int MAX_SHOWN = 200;
+
+    QLabel *captureLabel;
+    QTableWidget *slowQueryTable;
+    QPlainTextEdit *detailsTextEdit;
+    QLabel *stallLabel;
+    QTableWidget *stallTable;
+    std::vector<SlowQueryRecord> records;
+
+    bool loaded = false; // Set by the first showEvent()
+};
+
+#endif // DIAGNOSTICSPAGE_H
@@ -11,13 +11,22 @@ struct Expense {
     double price;
     int paid_by_user_id;
     std::string paid_by_user_name; // To hold the name of the user who paid
-    std::string category;
+    int category_id;
+    std::string category; // Display name resolved from expense_categories
 };
 
-bool addExpense(const std::string& purchase_date, const std::string& item_name, double price, int paid_by_user_id, const std::string& category);
-bool editExpense(int id, const std::string& item_name, double price, const std::string& category);
+struct ExpenseCategory {
+    int id;
+    std::string name;
+};
+
+bool addExpense(const std::string& purchase_date, const std::string& item_name, double price, int paid_by_user_id, int category_id);
+bool editExpense(int id, const std::string& item_name, double price, int category_id);
 bool deleteExpense(int id);
 std::vector<Expense> getAllExpenses();
-std::vector<Expense> getExpensesByCategory(const std::string& category);
+std::vector<Expense> getExpensesByCategory(int category_id);
+
+bool addExpenseCategory(const std::string& name);
+std::vector<ExpenseCategory> getAllExpenseCategories();
 
 #endif // EXPENSE_H
@@ -0,0 +1,74 @@
+#ifndef EXPENSEANALYTICS_H
+#define EXPENSEANALYTICS_H
+
+#include <string>
+#include <vector>
+#include <map>
+#include <tuple>
+#include <memory>
+#include <optional>
+
+// One row of the category x month x payer aggregate. Rows produced by
+// WITH ROLLUP carry the all_* flags for the dimensions they span.
+struct ExpenseCubeCell {
+    std::string category;
+    std::string month; // "YYYY-MM"
+    int payer_id;      // 0 when the paying user has been deleted
+    std::string payer_name;
+    double total;
+    int expense_count;
+    bool all_categories;
+    bool all_months;
+    bool all_payers;
+};
+
+struct ExpenseCubeFilter {
+    std::optional<std::string> category;
+    std::optional<std::string> month;
+    std::optional<int> payer_id;
+};
+
+struct ExpenseCubeTotals {
+    double total;
+    int expense_count;
+};
+
+enum class ExpenseDimension { Category, Month, Payer };
+
+struct ExpenseBreakdownRow {
+    std::string label;
+    double total;
+    int expense_count;
+};
+
+// Immutable snapshot of the expense aggregates. Totals that line up with a
+// rollup level (grand total, per category, per category and month) are O(log n)
+// lookups; any other slice is summed from the leaf cells in memory.
+class ExpenseCube {
+public:
+    explicit ExpenseCube(std::vector<ExpenseCubeCell> cells);
+
+    ExpenseCubeTotals totals(const ExpenseCubeFilter& filter) const;
+    std::vector<ExpenseBreakdownRow> breakdown(ExpenseDimension dimension, const ExpenseCubeFilter& filter) const;
+
+    const std::vector<std::string>& categories() const { return categoryValues; }
+    const std::vector<std::string>& months() const { return monthValues; }
+    const std::vector<std::pair<int, std::string>>& payers() const { return payerValues; }
+
+private:
+    using RollupKey = std::tuple<bool, std::string, bool, std::string, bool, int>;
+
+    std::vector<ExpenseCubeCell> leaves;
+    std::map<RollupKey, ExpenseCubeTotals> rollups;
+    std::vector<std::string> categoryValues;
+    std::vector<std::string> monthValues;
+    std::vector<std::pair<int, std::string>> payerValues;
+};
+
+// Returns the cached cube if a cheap fingerprint of the mess's expenses, users
+// and categories still matches the one it was built under; otherwise rebuilds
+// it with a single grouped query. Local writes also invalidate it directly.
+std::shared_ptr<const ExpenseCube> getExpenseCube();
+void invalidateExpenseCube();
+
+#endif // EXPENSEANALYTICS_H
@@ -0,0 +1,42 @@
+#ifndef EXPENSEANALYTICSPAGE_H
+#define EXPENSEANALYTICSPAGE_H
+
+#include <QWidget>
+#include <memory>
+#include "expenseanalytics.h"
+
+class QTableWidget;
+class QComboBox;
+class QLabel;
+class QShowEvent;
+
+class ExpenseAnalyticsPage : public QWidget
+{
+    Q_OBJECT
+
+public:
+    explicit ExpenseAnalyticsPage(QWidget *parent = nullptr);
+
+protected:
+    void showEvent(QShowEvent *event) override;
+
+private slots:
+    void refreshCube();
+    void updateBreakdown();
+
+private:
+    void populateFilters();
+
+    std::shared_ptr<const ExpenseCube> cube;
+
+    QComboBox *groupByComboBox;
+    QComboBox *categoryFilterComboBox;
+    QComboBox *monthFilterComboBox;
+    QComboBox *payerFilterComboBox;
+    QTableWidget *breakdownTable;
+    QLabel *totalLabel;
+
+    bool loaded = false; // Set by the first showEvent()
+};
+
+#endif // EXPENSEANALYTICSPAGE_H
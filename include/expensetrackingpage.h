@@ -2,13 +2,16 @@
 #define EXPENSETRACKINGPAGE_H
 
 #include <QWidget>
+#include <vector>
 #include "user.h"
+#include "expense.h"
 
 class QTableWidget;
 class QLineEdit;
 class QComboBox;
 class QDateEdit;
 class QPushButton;
+class QShowEvent;
 
 class ExpenseTrackingPage : public QWidget
 {
@@ -17,15 +20,21 @@ class ExpenseTrackingPage : public QWidget
 public:
     explicit ExpenseTrackingPage(User* currentUser, QWidget *parent = nullptr);
 
+protected:
+    void showEvent(QShowEvent *event) override;
+
 private slots:
     void addExpenseClicked();
     void editExpenseClicked();
     void deleteExpenseClicked();
     void refreshExpenses();
-    void filterExpensesByCategory(const QString &category);
+    void filterExpensesByCategory(int index);
+    void addCategoryClicked();
 
 private:
-    void loadExpenses(const QString &categoryFilter = "All");
+    void loadCategories();
+    void loadExpenses(int categoryFilterId = 0); // 0 shows every category
+    int currentFilterCategoryId() const;
     User* loggedInUser;
 
     QTableWidget *expenseTable;
@@ -37,6 +46,9 @@ private:
     QPushButton *editExpenseButton;
     QPushButton *deleteExpenseButton;
     QComboBox *filterCategoryComboBox;
+    std::vector<ExpenseCategory> categories;
+
+    bool loaded = false; // Set by the first showEvent()
 };
 
 #endif // EXPENSETRACKINGPAGE_H
\ No newline at end of file
@@ -0,0 +1,133 @@
+#ifndef EXPORT_H
+#define EXPORT_H
+
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+// Streaming export of settlements, attendance and the expense ledger.
+//
+// Rows are pulled from an unbuffered (forward-only) result set and pushed
+// through a fixed-size output buffer, so memory use does not grow with the
+// amount of history being exported.
+//
+// Columnar binary layout (all integers little-endian):
+//   "MMSCOL1\0"                         8-byte magic
+//   u32 column_count
+//   per column: u8 type (0 = int64, 1 = double, 2 = text), u16 name_length, name bytes
+//   row groups, each:
+//     u32 row_count (0 terminates the group list)
+//     per column:
+//       int64:  row_count x i64
+//       double: row_count x f64 (IEEE 754)
+//       text:   u32 byte_count, row_count x u32 lengths, byte_count bytes
+//   u64 total_rows
+
+enum class ExportFormat { Csv, Columnar };
+enum class ExportColumnType : uint8_t { Int = 0, Double = 1, Text = 2 };
+
+struct ExportColumn {
+    std::string name;
+    ExportColumnType type;
+    int csv_decimals = -1; // Double only: fixed decimals in CSV (2 for money); -1 writes the value exactly
+};
+
+// Writes through a fixed 64 KiB buffer to a file, or to stdout for path "-".
+class BufferedFileWriter {
+public:
+    explicit BufferedFileWriter(const std::string& path);
+    ~BufferedFileWriter();
+    BufferedFileWriter(const BufferedFileWriter&) = delete;
+    BufferedFileWriter& operator=(const BufferedFileWriter&) = delete;
+
+    bool isOpen() const { return file != nullptr; }
+    bool good() const { return !failed; }
+    void write(const void* data, size_t size);
+    void writeU8(uint8_t value) { write(&value, 1); }
+    void writeU16(uint16_t value);
+    void writeU32(uint32_t value);
+    void writeU64(uint64_t value);
+    bool close();
+
+private:
+    void flushBuffer();
+
+    static const size_t BUFFER_SIZE = 64 * 1024;
+    std::FILE* file;
+    bool ownsFile;
+    bool failed;
+    size_t used;
+    char buffer[BUFFER_SIZE];
+};
+
+// Receives rows one value at a time, in column order.
+class ExportSink {
+public:
+    virtual ~ExportSink() = default;
+    virtual void begin(const std::vector<ExportColumn>& columns) = 0;
+    virtual void addInt(int64_t value) = 0;
+    virtual void addDouble(double value) = 0;
+    virtual void addText(const std::string& value) = 0;
+    virtual void endRow() = 0;
+    virtual bool finish() = 0;
+};
+
+class CsvExportSink : public ExportSink {
+public:
+    explicit CsvExportSink(BufferedFileWriter& writer) : out(writer) {}
+    void begin(const std::vector<ExportColumn>& columns) override;
+    void addInt(int64_t value) override;
+    void addDouble(double value) override;
+    void addText(const std::string& value) override;
+    void endRow() override;
+    bool finish() override;
+
+private:
+    void separator();
+
+    BufferedFileWriter& out;
+    bool atRowStart = true;
+    std::vector<int> decimals; // csv_decimals per column
+    size_t column = 0;         // Index of the next value in the row
+};
+
+// Buffers at most one row group (ROWS_PER_GROUP rows or MAX_GROUP_TEXT_BYTES
+// of text) before writing it out column by column.
+class ColumnarExportSink : public ExportSink {
+public:
+    explicit ColumnarExportSink(BufferedFileWriter& writer) : out(writer) {}
+    void begin(const std::vector<ExportColumn>& columns) override;
+    void addInt(int64_t value) override;
+    void addDouble(double value) override;
+    void addText(const std::string& value) override;
+    void endRow() override;
+    bool finish() override;
+
+private:
+    struct ColumnBuffer {
+        ExportColumnType type;
+        std::vector<int64_t> ints;
+        std::vector<double> doubles;
+        std::vector<uint32_t> lengths;
+        std::string bytes;
+    };
+
+    void flushGroup();
+
+    static const uint32_t ROWS_PER_GROUP = 4096;
+    static const size_t MAX_GROUP_TEXT_BYTES = 1024 * 1024;
+
+    BufferedFileWriter& out;
+    std::vector<ColumnBuffer> buffers;
+    size_t nextColumn = 0;
+    uint32_t groupRows = 0;
+    size_t groupTextBytes = 0;
+    uint64_t totalRows = 0;
+};
+
+bool exportSettlement(int period_id, const std::string& path, ExportFormat format);
+bool exportAttendance(const std::string& startDate, const std::string& endDate, const std::string& path, ExportFormat format);
+bool exportExpenseLedger(const std::string& path, ExportFormat format);
+
+#endif // EXPORT_H
@@ -11,12 +11,21 @@ struct Payment {
     std::string date;
 };
 
+// One row of a batch of payments.
+struct PaymentRecord {
+    int user_id;
+    double amount;
+    std::string date; // YYYY-MM-DD
+};
+
+// A user's position from the ledger (see ledger.h).
 struct FinancialReport {
     int user_id;
     std::string user_name;
-    double total_contributions;
-    double total_expenses;
-    double debt_or_surplus;
+    double total_contributions; // Payments
+    double total_expenses;      // Shopping paid for the mess
+    double total_meal_cost;     // Meal costs of closed periods
+    double debt_or_surplus;     // contributions + expenses - meal cost; positive is surplus
 };
 
 struct SettlementReport {
@@ -31,9 +40,21 @@ struct SettlementReport {
 };
 
 bool recordPayment(int user_id, double amount, const std::string& date);
+// Records every payment or none: one transaction, multi-row inserts and one
+// ledger posting. Callers validate the user IDs first; payments have no
+// foreign key to users.
+bool recordPayments(const std::vector<PaymentRecord>& payments);
 std::vector<Payment> getPaymentsByUser(int user_id);
 FinancialReport getUserFinancialReport(int user_id);
 std::vector<FinancialReport> getAllFinancialReports();
+// Closed periods are read from period_settlements. Open ones are cached; the
+// aggregates are only re-run when a cheap fingerprint of the period's expenses,
+// attendance, payments and users has changed.
 std::pair<double, std::vector<SettlementReport>> generateMonthlySettlement(int period_id);
 
+// Computes the period's settlement once, stores it in period_settlements, posts
+// each user's meal cost to the ledger and marks the period closed. After that, attendance, expenses and payments dated
+// in its month are rejected (see lockOpenPeriods()).
+bool closeMealPeriod(int period_id);
+
 #endif // FINANCE_H
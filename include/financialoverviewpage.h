@@ -7,6 +7,8 @@ class QTableWidget;
 class QPushButton;
 class QLineEdit;
 class QDateEdit;
+class QComboBox;
+class QShowEvent;
 
 class FinancialOverviewPage : public QWidget
 {
@@ -15,9 +17,15 @@ class FinancialOverviewPage : public QWidget
 public:
     explicit FinancialOverviewPage(QWidget *parent = nullptr);
 
+protected:
+    void showEvent(QShowEvent *event) override;
+
 private slots:
     void loadFinancialReports();
     void recordPaymentClicked();
+    void batchPaymentsClicked();
+    void closePeriodClicked();
+    void viewStatementClicked();
 
 private:
     QTableWidget *financialReportTable;
@@ -25,6 +33,12 @@ private:
     QLineEdit *paymentAmountLineEdit;
     QDateEdit *paymentDateEdit;
     QPushButton *recordPaymentButton;
+    QComboBox *closePeriodComboBox;
+    QPushButton *closePeriodButton;
+
+    void loadOpenPeriods();
+
+    bool loaded = false; // Set by the first showEvent()
 };
 
 #endif // FINANCIALOVERVIEWPAGE_H
\ No newline at end of file
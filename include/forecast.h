@@ -0,0 +1,42 @@
+#ifndef FORECAST_H
+#define FORECAST_H
+
+#include <cppconn/connection.h>
+#include <string>
+#include <vector>
+
+// Expected headcount per meal for upcoming days, so the kitchen can cook for
+// the people who will actually turn up.
+//
+// meal_headcounts holds one row per (mess, date, meal type) with the number of
+// attendance rows recorded, and meal_weekday_counts one row per (mess, week,
+// user, meal type, weekday) with that user's meals; the attendance write paths
+// keep both current, so the forecast never scans meal_attendance. The forecast
+// for a meal is the sum over users of how often each one attended that meal on
+// the same weekday in the lookback window, shrunk toward the user's rate on all
+// weekdays so a single missed Monday does not swing it. Days with no attendance
+// at all (holidays, before the mess opened) are left out of the rates.
+
+struct MealForecast {
+    std::string date;       // YYYY-MM-DD
+    std::string meal_type;  // Breakfast, Lunch or Dinner
+    double expected;        // Forecast headcount
+    double weekday_average; // Mean headcount on this weekday over the lookback window
+    int recorded;           // Attendance already recorded for the date
+};
+
+// Recomputes meal_headcounts and meal_weekday_counts for the given dates from
+// meal_attendance. Runs on the caller's connection so it shares the caller's
+// transaction.
+void refreshMealHeadcounts(sql::Connection& con, int messId, const std::vector<std::string>& dates);
+
+// Rebuilds both tables for the current mess from scratch, except for
+// archived months, whose attendance is no longer in the live table.
+bool rebuildMealHeadcounts();
+
+// Forecasts each meal from fromDate for the given number of days, using the
+// lookbackWeeks weeks of attendance before fromDate. Returns Breakfast, Lunch
+// and Dinner for each day in date order.
+std::vector<MealForecast> forecastMealDemand(const std::string& fromDate, int days, int lookbackWeeks = 8);
+
+#endif // FORECAST_H
@@ -0,0 +1,93 @@
+#ifndef JOURNAL_H
+#define JOURNAL_H
+
+#include <cppconn/exception.h>
+#include <atomic>
+#include <cstdint>
+#include <cstddef>
+#include <functional>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Offline write journal.
+//
+// While the database is unreachable, attendance, expense and payment writes are
+// appended to a local file ("offline_journal.bin" in the working directory) and
+// fsync'd before the caller is told they succeeded. Each record is framed as
+//   u32 magic "MMJ1", u32 payload_length, u32 crc32(payload), payload
+// so a torn write at the end of the file is detected and ignored.
+//
+// replayJournal() writes the records back in batched transactions. Payments and
+// expenses carry an idempotency key with a unique index, and attendance is
+// unique per (user, date, meal), so replaying a record that already reached the
+// database changes nothing.
+//
+// A record is dropped only when the database rejects it for good: its period
+// is closed, it references a user or category that no longer exists, or it
+// violates a constraint. Any other error (a lock wait timeout, a deadlock)
+// stops the replay and leaves that record and the ones after it for next time.
+
+enum class JournalRecordType : uint8_t { Attendance = 1, Expense = 2, Payment = 3 };
+
+struct JournalRecord {
+    JournalRecordType type;
+    int mess_id = 0;
+    int user_id = 0;              // Attendee, expense payer or paying user
+    int category_id = 0;          // Expense only
+    double amount = 0.0;          // Expense price or payment amount
+    std::string date;             // YYYY-MM-DD
+    std::string meal_type;        // Attendance only
+    std::string item_name;        // Expense only
+    std::string idempotency_key;  // Expense and payment only
+};
+
+struct JournalRejection {
+    JournalRecord record;
+    std::string reason; // The database's error message
+};
+
+struct JournalReplayResult {
+    size_t replayed;  // Records now in the database (or already there)
+    size_t dropped;   // Records the database rejected outright, e.g. for a deleted user
+    size_t remaining; // Records still waiting for the database to come back
+    std::vector<JournalRejection> rejections; // One per dropped record, to show the user
+};
+
+// 32 hex characters; bound into the idempotency_key column on every insert.
+std::string generateIdempotencyKey();
+
+// True for client errors that mean the server could not be reached.
+bool isConnectionError(const sql::SQLException& e);
+
+// One line for the user, e.g. "Payment of 500.00 by user 7 on 2024-03-01".
+std::string describeJournalRecord(const JournalRecord& record);
+
+bool appendToJournal(const JournalRecord& record);
+size_t pendingJournalRecords();
+
+// The journal file is locked only while it is read and rewritten, not while
+// the records are sent, so appendToJournal() does not wait on a replay;
+// records appended during a replay are kept for the next one.
+JournalReplayResult replayJournal();
+
+// Runs replayJournal() on a worker thread. onReplayed runs on the worker
+// thread with the result, including when nothing was pending.
+class JournalReplayer {
+public:
+    using Callback = std::function<void(JournalReplayResult)>;
+
+    explicit JournalReplayer(Callback onReplayed);
+    ~JournalReplayer(); // Waits for a replay in progress
+    JournalReplayer(const JournalReplayer&) = delete;
+    JournalReplayer& operator=(const JournalReplayer&) = delete;
+
+    void start(); // No-op while a replay is still running
+
+private:
+    Callback onReplayed;
+    std::thread worker;
+    std::atomic<bool> running{false};
+};
+
+#endif // JOURNAL_H
@@ -0,0 +1,82 @@
+#ifndef LEDGER_H
+#define LEDGER_H
+
+#include <cppconn/connection.h>
+#include <string>
+#include <vector>
+
+// Double-entry ledger of each mess's money.
+//
+// Every payment, shopping expense and settled meal cost is posted as two
+// entries that sum to zero: one on the user's account and the opposite one on
+// the mess's pool account (MESS_POOL_ACCOUNT). A user's balance is positive
+// when the mess owes them: payments and shopping credit it, and the meal cost
+// of a period debits it when the period is closed. Entries are never changed;
+// an edited or deleted expense is corrected with a further entry.
+//
+// Each entry stores its account's balance after it, in posting (id) order, and
+// ledger_balances holds every account's current balance and totals, so a
+// balance is one primary-key lookup and a statement is a range scan over the
+// (mess_id, user_id, id) index. Postings lock the ledger_balances rows of the
+// accounts they touch in account order, so concurrent postings to an account
+// queue up instead of computing the same running balance twice.
+
+const int MESS_POOL_ACCOUNT = 0; // user_id of the mess's own account
+
+enum class LedgerEntryType { Payment, Shopping, MealCost };
+
+struct LedgerPosting {
+    int user_id;
+    LedgerEntryType type;
+    double amount;          // Credit to the user; negative for a debit or a correction
+    std::string entry_date; // YYYY-MM-DD
+    int source_id;          // Payment, expense or meal period ID
+    std::string description;
+};
+
+struct LedgerEntry {
+    long long id;
+    LedgerEntryType type;
+    double amount;          // Credit to the user; negative for a debit
+    double running_balance; // User's balance after this entry
+    std::string entry_date; // YYYY-MM-DD
+    int source_id;
+    std::string description;
+};
+
+// A window of a user's statement, oldest entry first.
+struct LedgerStatementPage {
+    std::vector<LedgerEntry> entries;
+    bool has_older = false;
+    bool has_newer = false;
+};
+
+struct LedgerBalance {
+    int user_id;
+    std::string user_name;
+    double total_payments;
+    double total_shopping;
+    double total_meal_cost; // Of closed periods, as a positive amount
+    double balance;
+};
+
+// Posts each posting and its pool counter-entry within the caller's transaction.
+void postLedgerEntries(sql::Connection& con, int messId, const std::vector<LedgerPosting>& postings);
+
+// Posts the payments and expenses with the given idempotency keys that have no
+// ledger entries yet. Used after replaying journaled writes, which may or may
+// not have reached the database before.
+void postUnpostedWrites(sql::Connection& con, int messId, const std::vector<std::string>& idempotencyKeys);
+
+// Balances of every user in the current mess, zero for users without entries.
+std::vector<LedgerBalance> getLedgerBalances();
+bool getLedgerBalance(int user_id, LedgerBalance& balance);
+
+// Statement pages are keyset-paginated on the entry id: each reads at most
+// limit + 1 rows from the (mess_id, user_id, id) index, however long the
+// history is. beforeId 0 gives the newest page. A page after afterId that
+// would come up short is the newest page instead, so windows stay full.
+LedgerStatementPage getLedgerStatementBefore(int user_id, long long beforeId, int limit);
+LedgerStatementPage getLedgerStatementAfter(int user_id, long long afterId, int limit);
+
+#endif // LEDGER_H
@@ -0,0 +1,51 @@
+#ifndef LOGGER_H
+#define LOGGER_H
+
+#include <cppconn/exception.h>
+#include <initializer_list>
+#include <string>
+#include <type_traits>
+
+// Asynchronous structured log.
+//
+// Callers format a record (level, function, message and key/value fields) and
+// push it onto a fixed-size lock-free ring; a background thread drains the ring
+// and appends one JSON object per line to the log file, so logging never waits
+// on disk. When the ring is full the record is dropped and counted, and the
+// writer reports the count with its next record.
+//
+// Configured in config.ini under [Logging]:
+//   file=meal_manager.log     Log file; empty to disable it
+//   level=info                Lowest level recorded: debug, info, warning, error
+//   console_level=warning     Lowest level also echoed to stderr; none to disable
+//   max_file_size_kb=10240    The file is rotated to file.1, file.2, ... at this size
+//   max_files=5               Rotated files kept
+// The settings are read when the first record is logged, and the queue is
+// flushed when the process exits normally.
+
+enum class LogLevel { Debug, Info, Warning, Error };
+
+struct LogField {
+    std::string key;
+    std::string value;
+    bool numeric = false; // Written unquoted
+
+    LogField(std::string key, std::string value) : key(std::move(key)), value(std::move(value)) {}
+    LogField(std::string key, const char* value) : key(std::move(key)), value(value) {}
+    template <typename T, typename = std::enable_if_t<std::is_arithmetic_v<T>>>
+    LogField(std::string key, T value) : key(std::move(key)), value(std::to_string(value)), numeric(true) {}
+};
+
+void logEvent(LogLevel level, const char* function, const std::string& message, std::initializer_list<LogField> fields = {});
+
+// Logs e at Error level with its MySQL error code and SQLSTATE as fields.
+void logSqlError(const char* function, const sql::SQLException& e, std::initializer_list<LogField> fields = {});
+
+// Blocks until every record logged so far has been written.
+void flushLog();
+
+// Renames path to path.1, path.1 to path.2 and so on, dropping path.maxFiles.
+// With maxFiles 0 the file is just removed.
+void rotateLogFiles(const std::string& path, int maxFiles);
+
+#endif // LOGGER_H
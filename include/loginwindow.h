@@ -8,6 +8,7 @@
 class QLineEdit;
 class QPushButton;
 class QLabel;
+class QComboBox;
 
 class LoginWindow : public QWidget {
     Q_OBJECT // Required macro for any class that uses Qt's signals and slots
@@ -22,6 +23,7 @@ private slots:
     void handleLoginAttempt(); // This function is a "slot" that will be called on button click
 
 private:
+    QComboBox *messComboBox;
     QLineEdit *usernameEdit;
     QLineEdit *passwordEdit;
 };
@@ -7,16 +7,21 @@
 #include "userprofilepage.h"
 #include "menumanagementpage.h"
 #include "expensetrackingpage.h"
+#include "expenseanalyticspage.h"
 #include "mealattendancepage.h"
 #include "usermanagementpage.h"
 #include "financialoverviewpage.h"
 #include "dailymenupage.h"
 #include "menuhistorypage.h"
+#include "snapshot.h"
+#include "journal.h"
 
 class QLabel;
 class QListWidget;
 class QStackedWidget;
 class QHBoxLayout;
+class QTimer;
+class QTableWidget;
 
 class MainWindow : public QWidget
 {
@@ -27,10 +32,29 @@ public:
 
 private slots:
     void changePage(int index);
+    void replayOfflineJournal();
 
 private:
+    void updateOfflineStatus(size_t pending);
+    void showJournalRejections(const std::vector<JournalRejection>& rejections);
+    void applyReferenceSnapshot(const ReferenceSnapshot& snapshot);
+    void loadMealForecast();
+
     QListWidget *sidebar;
     QStackedWidget *stackedWidget;
+    QLabel *offlineStatusLabel;
+    QTimer *journalReplayTimer;
+    QLabel *currentPeriodLabel;
+    QTableWidget *forecastTable;
+
+    // Pages painted from the reference snapshot and updated when it refreshes
+    MenuManagementPage *menuManagementPage;
+    MealAttendancePage *mealAttendancePage;
+    DailyMenuPage *dailyMenuPage;
+    UserManagementPage *userManagementPage;
+
+    std::unique_ptr<ReferenceSnapshotRefresher> snapshotRefresher;
+    std::unique_ptr<JournalReplayer> journalReplayer;
 };
 
 #endif // MAINWINDOW_H
\ No newline at end of file
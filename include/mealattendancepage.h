@@ -5,11 +5,19 @@
 #include <vector>
 #include "user.h"
 
+struct ReferenceSnapshot;
+
 class QTableWidget;
 class QDateEdit;
 class QComboBox;
 class QPushButton;
 class QCheckBox;
+class QLabel;
+class QStackedWidget;
+class QTableView;
+class AttendanceGridModel;
+
+class QShowEvent;
 
 class MealAttendancePage : public QWidget
 {
@@ -18,16 +26,38 @@ class MealAttendancePage : public QWidget
 public:
     explicit MealAttendancePage(QWidget *parent = nullptr);
 
+    void applyReferenceSnapshot(const ReferenceSnapshot& snapshot);
+
+protected:
+    void showEvent(QShowEvent *event) override;
+
 private slots:
     void loadAttendanceForDate();
     void recordAttendanceClicked();
+    void viewModeChanged(int index);
+    void reloadCurrentView();
+    void loadAttendanceGrid();
+    void saveAttendanceGridClicked();
+    void updatePendingChanges(int count);
 
 private:
     QDateEdit *attendanceDateEdit;
+    QComboBox *viewModeComboBox;
+    QStackedWidget *viewStack;
+
+    // Day mode: one date, checkbox per meal
     QTableWidget *userAttendanceTable;
     QPushButton *recordAttendanceButton;
 
+    // Week and month modes: users x (day, meal), saved as one diff
+    QTableView *attendanceGridView;
+    AttendanceGridModel *attendanceGridModel;
+    QLabel *pendingChangesLabel;
+    QPushButton *saveGridButton;
+
     std::vector<User> allUsers;
+
+    bool loaded = false; // Set by the first showEvent()
 };
 
 #endif // MEALATTENDANCEPAGE_H
\ No newline at end of file
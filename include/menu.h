@@ -16,6 +16,14 @@ struct DailyMenu {
     std::vector<MenuItem> dinner;
 };
 
+// A named rotation of daily menus (e.g. a 7-day cycle). Day offset 0 of the
+// template lands on the start date it is applied from.
+struct MenuTemplate {
+    int id;
+    std::string name;
+    int cycle_days;
+};
+
 bool addMenuItem(const std::string& name);
 bool editMenuItem(int id, const std::string& name);
 bool deleteMenuItem(int id);
@@ -24,4 +32,8 @@ bool setDailyMenu(const std::string& date, const std::vector<int>& breakfastItem
 DailyMenu getDailyMenu(const std::string& date);
 std::vector<DailyMenu> getMenuHistory();
 
+bool createMenuTemplateFromRange(const std::string& name, const std::string& startDate, int cycleDays);
+std::vector<MenuTemplate> getAllMenuTemplates();
+bool applyMenuTemplate(int templateId, const std::string& startDate, const std::string& endDate);
+
 #endif // MENU_H
@@ -0,0 +1,32 @@
+#ifndef MENUANALYTICS_H
+#define MENUANALYTICS_H
+
+#include <memory>
+#include <string>
+#include <vector>
+
+// Per-dish turnout: how many diners came to the meals a dish was on the menu
+// for, compared with the usual turnout for that meal type in the same period.
+struct DishStats {
+    int menu_item_id;
+    std::string name;
+    int times_served;       // Meals (date and meal type) the dish was on the menu for
+    double average_turnout; // Mean headcount at those meals
+    double relative_turnout; // average_turnout over the period's mean for the same meal types; 1.0 is typical
+    double trend_per_week;  // Least-squares change in turnout per week across the period; 0 if served on one day
+};
+
+struct DishAnalytics {
+    int period_id;
+    std::vector<DishStats> dishes; // Most relative turnout first
+};
+
+// Returns the cached analytics for a period if a cheap fingerprint of its daily
+// menus, headcounts and dish names still matches the one they were computed
+// under; otherwise recomputes them with a single query over daily_menus joined
+// with meal_headcounts. Local writes also invalidate them directly. Returns
+// nullptr if the query fails.
+std::shared_ptr<const DishAnalytics> getDishAnalytics(int periodId);
+void invalidateDishAnalytics();
+
+#endif // MENUANALYTICS_H
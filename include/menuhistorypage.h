@@ -4,6 +4,8 @@
 #include <QWidget>
 
 class QTableWidget;
+class QComboBox;
+class QShowEvent;
 
 class MenuHistoryPage : public QWidget
 {
@@ -12,10 +14,21 @@ class MenuHistoryPage : public QWidget
 public:
     explicit MenuHistoryPage(QWidget *parent = nullptr);
 
+protected:
+    void showEvent(QShowEvent *event) override;
+
+private slots:
+    void loadDishAnalytics();
+
 private:
     void loadMenuHistory();
+    void loadPeriods();
 
     QTableWidget *historyTable;
+    QComboBox *periodComboBox;
+    QTableWidget *dishTable;
+
+    bool loaded = false; // Set by the first showEvent()
 };
 
 #endif // MENUHISTORYPAGE_H
\ No newline at end of file
@@ -2,6 +2,10 @@
 #define MENUMANAGEMENTPAGE_H
 
 #include <QWidget>
+#include <vector>
+#include "menu.h"
+
+struct ReferenceSnapshot;
 
 class QTableWidget;
 class QLineEdit;
@@ -14,15 +18,20 @@ class MenuManagementPage : public QWidget
 public:
     explicit MenuManagementPage(QWidget *parent = nullptr);
 
+    void applyReferenceSnapshot(const ReferenceSnapshot& snapshot);
+
 private slots:
     void addMenuItemClicked();
     void editMenuItemClicked();
     void deleteMenuItemClicked();
     void refreshMenuItems();
+    void filterMenuItems(const QString &query);
 
 private:
     void loadMenuItems();
+    void populateMenuTable(const std::vector<MenuItem>& items);
 
+    QLineEdit *searchLineEdit;
     QTableWidget *menuTable;
     QLineEdit *menuItemNameLineEdit;
     QPushButton *addMenuItemButton;
@@ -0,0 +1,51 @@
+#ifndef MENUSEARCH_H
+#define MENUSEARCH_H
+
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <shared_mutex>
+#include <cstdint>
+#include "menu.h"
+
+// In-memory type-ahead index over MenuItem::name.
+//
+// Names are case-folded and broken into character trigrams; a query of three
+// or more characters intersects the posting lists of its trigrams and only
+// verifies the few surviving candidates. Shorter queries fall back to a scan
+// of the folded names, which is still cheap at catalog sizes. Matches are
+// ranked exact > name prefix > word prefix > substring, then by length and
+// name.
+class MenuSearchIndex {
+public:
+    void rebuild(const std::vector<MenuItem>& items);
+    void insert(const MenuItem& item);
+    void update(int id, const std::string& name);
+    void remove(int id);
+
+    // Returns every item when the query is blank. A limit of 0 means unlimited.
+    std::vector<MenuItem> search(const std::string& query, size_t limit = 0) const;
+    size_t size() const;
+
+private:
+    struct Entry {
+        int id;
+        std::string name;
+        std::string folded;
+        bool alive;
+    };
+
+    void addPostings(uint32_t slot);
+    void removePostings(uint32_t slot);
+
+    std::vector<Entry> entries;
+    std::unordered_map<int, uint32_t> slotById;
+    std::unordered_map<uint32_t, std::vector<uint32_t>> postings; // trigram -> ascending slots
+    mutable std::shared_mutex mutex;
+};
+
+// Process-wide index kept in sync by the menu item functions in menu.cpp.
+MenuSearchIndex& menuSearchIndex();
+std::vector<MenuItem> searchMenuItems(const std::string& query, size_t limit = 0);
+
+#endif // MENUSEARCH_H
@@ -0,0 +1,22 @@
+#ifndef MESS_H
+#define MESS_H
+
+#include <string>
+#include <vector>
+
+// A mess (dining hall) is a tenant: every data-layer query is scoped to the
+// current mess, which the login window or the CLI's --mess option selects.
+struct Mess {
+    int id;
+    std::string name;
+};
+
+// Switches the tenant for all subsequent queries and drops per-tenant caches.
+// Defaults to 1, the mess created by schema.sql.
+void setCurrentMessId(int mess_id);
+int currentMessId();
+
+std::vector<Mess> getAllMesses();
+bool addMess(const std::string& name); // Also creates its settings row and default expense categories
+
+#endif // MESS_H
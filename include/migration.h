@@ -0,0 +1,66 @@
+#ifndef MIGRATION_H
+#define MIGRATION_H
+
+#include <string>
+#include <vector>
+
+// Versioned schema migrations.
+//
+// Scripts named NNN_description.sql in the migrations directory ("migrations"
+// in the working directory, or [Migrations] directory= in config.ini) are
+// applied in version order, each at most once. The schema_version table
+// records every applied version with the SHA-256 of its script, so a script
+// edited after it ran is reported instead of silently diverging. Migrations
+// are forward-only; a fix is a new script.
+//
+// schema.sql inserts a baseline row (checksum NULL) for the last version it
+// already includes; scripts at or below the newest baseline are treated as
+// applied. A database created before schema_version existed must be
+// baselined once with `meal_cli migrate baseline <version>`.
+//
+// A run holds the MySQL named lock "meal_schema_migration", so clients that
+// start together apply each script once, and sets a short lock_wait_timeout
+// ([Migrations] lock_wait_timeout_seconds, default 10) so DDL waiting on a
+// busy table gives up instead of stalling every query queued behind it.
+// MySQL commits DDL implicitly, so progress through a script is recorded per
+// statement in schema_migration_progress: a script that fails part-way resumes
+// at the failed statement on the next run (unless the file has changed since).
+//
+// The GUI applies migrations at startup only with [Migrations]
+// apply_on_startup=true; `meal_cli migrate` is the supported way to upgrade.
+
+enum class MigrationOutcome {
+    UpToDate,
+    Applied,
+    Unreachable,  // No database connection; nothing was checked
+    NotBaselined, // The database has no schema_version table
+    Failed        // A script failed or an applied one was modified
+};
+
+struct MigrationRunResult {
+    MigrationOutcome outcome = MigrationOutcome::UpToDate;
+    int applied = 0;        // Scripts applied by this run
+    int schema_version = 0; // Highest version recorded afterwards
+    std::string message;    // What failed, for Failed, NotBaselined and Unreachable
+};
+
+struct MigrationStatus {
+    int version;
+    std::string name;       // File name, or "baseline ..." for a baseline row
+    bool applied;           // Recorded, or covered by a baseline
+    bool modified;          // Recorded with a different checksum than the file has now
+    std::string applied_at; // Empty when pending or covered by a baseline
+    int statements_done;    // Statements already run from a partly applied script; 0 otherwise
+};
+
+// True only with [Migrations] apply_on_startup=true in config.ini.
+bool migrationsRunOnStartup();
+
+MigrationRunResult applyPendingMigrations();
+std::vector<MigrationStatus> getMigrationStatus();
+
+// Records that the database already matches every script up to version,
+// creating schema_version if needed. For databases set up before it existed.
+bool baselineSchema(int version);
+
+#endif // MIGRATION_H
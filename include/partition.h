@@ -0,0 +1,51 @@
+#ifndef PARTITION_H
+#define PARTITION_H
+
+#include <string>
+#include <vector>
+
+// Monthly range partitioning of the large dated tables: meal_attendance,
+// expenses and payments.
+//
+// Each table is partitioned by RANGE COLUMNS on its date, one partition per
+// calendar month named pYYYYMM plus a catch-all pmax, so a month's queries
+// touch only that month's partition. Partitions are shared by all messes.
+//
+// Once every period of a month is closed its rows can be archived: each
+// table's partition is swapped (EXCHANGE PARTITION, a metadata-only change)
+// with an empty table named <table>_archive_YYYYMM, which is then rebuilt with
+// compressed pages. The empty partition stays in place, so restoring swaps the
+// rows straight back. Settlements of closed periods are stored separately and
+// stay readable while their month is archived; attendance and expense listings
+// for an archived month are empty until it is restored.
+
+struct PartitionInfo {
+    std::string table;
+    std::string partition; // pYYYYMM or pmax
+    long long rows;        // InnoDB estimate
+    long long bytes;       // Data plus indexes
+};
+
+struct ArchiveInfo {
+    std::string table;        // e.g. meal_attendance_archive_202405
+    std::string source_table; // e.g. meal_attendance
+    std::string month;        // YYYY-MM
+    long long rows;           // InnoDB estimate
+    long long bytes;          // Data plus indexes, after compression
+};
+
+// Splits pmax so every month up to monthsAhead months from now has its own
+// partition. A table with no monthly partitions yet starts from its oldest row.
+// Meant to be run from cron; does nothing when the partitions already exist.
+bool ensureFuturePartitions(int monthsAhead = 3);
+
+std::vector<PartitionInfo> listPartitions();
+std::vector<ArchiveInfo> listArchives();
+
+// month is "YYYY-MM". Archiving refuses a month with an open period, or with
+// rows for a mess that has no closed period for it. Restoring needs the live
+// partitions to still be empty.
+bool archiveMonth(const std::string& month);
+bool restoreArchivedMonth(const std::string& month);
+
+#endif // PARTITION_H
@@ -1,6 +1,7 @@
 #ifndef PERIOD_H
 #define PERIOD_H
 
+#include <cppconn/connection.h>
 #include <string>
 #include <vector>
 
@@ -8,9 +9,21 @@ struct MealPeriod {
     int id;
     std::string month;
     std::string year;
+    bool is_closed = false; // Settlement frozen in period_settlements; rows in the month can't change
 };
 
 bool setupMealPeriod(const std::string& month, const std::string& year);
 std::vector<MealPeriod> getAllMealPeriods();
 
+// Error code of the sql::SQLException thrown for a write into a closed period
+// (the code MySQL gives a SIGNAL with SQLSTATE 45000).
+const int ER_PERIOD_CLOSED = 1644;
+
+// Every write to attendance, expenses or payments calls this inside its
+// transaction before touching rows. It share-locks the meal periods the
+// dates fall in until the caller commits, and throws if any is closed.
+// closeMealPeriod() locks the period row exclusively, so a write either
+// commits before the close computes the settlement or is rejected after it.
+void lockOpenPeriods(sql::Connection& con, int messId, const std::vector<std::string>& dates);
+
 #endif // PERIOD_H
@@ -0,0 +1,96 @@
+#ifndef SLOWQUERY_H
+#define SLOWQUERY_H
+
+#include <cppconn/connection.h>
+#include <cppconn/prepared_statement.h>
+#include <cppconn/resultset.h>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Slow-query capture.
+//
+// Data-layer statements are prepared with prepareTraced(), which wraps the
+// connector's PreparedStatement, remembers the values bound to it and times
+// each execution. An execution slower than the threshold is queued with its
+// SQL id (a hash of the statement text, so every run of a statement shares
+// it), calling function, bound values, row count and timings. A background
+// thread optionally runs EXPLAIN for it on its own connection, then appends it
+// as one JSON object per line to the slow-query file, so the caller never
+// waits for either.
+//
+// Configured in config.ini under [SlowQueries]:
+//   threshold_ms=500            0 disables capture
+//   explain=true                Fetch the plan of slow SELECT, UPDATE and DELETE statements
+//   file=slow_queries.log       Rotated like the log file (see logger.h)
+//   max_file_size_kb=10240
+//   max_files=5
+
+class TracedStatement {
+public:
+    TracedStatement(std::unique_ptr<sql::PreparedStatement> statement, const char* function,
+                    std::string sql, double prepareMs);
+
+    void setInt(unsigned int index, int32_t value);
+    void setInt64(unsigned int index, int64_t value);
+    void setDouble(unsigned int index, double value);
+    void setString(unsigned int index, const std::string& value);
+
+    sql::ResultSet* executeQuery(); // Caller owns the result, as with PreparedStatement
+    int executeUpdate();
+    bool execute();
+
+private:
+    struct BoundValue {
+        char kind = 's';  // 'i'nteger, 'd'ouble or 's'tring
+        std::string text; // Numbers are formatted when bound
+    };
+
+    std::unique_ptr<sql::PreparedStatement> statement;
+    const char* function;
+    std::string sql;
+    double prepareMs; // Charged to the first execution only
+    std::vector<BoundValue> values;
+
+    void bind(unsigned int index, BoundValue value);
+    bool isSlow(double executeMs) const;
+    void report(double executeMs, long long rows);
+};
+
+std::unique_ptr<TracedStatement> prepareTraced(sql::Connection& con, const char* function, const std::string& sql);
+
+struct SlowQueryRecord {
+    std::string timestamp; // UTC, ISO 8601
+    std::string sql_id;
+    std::string function;
+    std::string sql;
+    std::vector<std::string> params; // Strings quoted, numbers as bound
+    long long rows;                  // -1 when the statement does not report it
+    double prepare_ms;
+    double execute_ms;
+    double total_ms;
+    std::string plan;                // Tab-separated EXPLAIN rows; empty if not fetched
+};
+
+// A traced statement still executing, as seen from another thread.
+struct InFlightStatement {
+    std::string function;
+    std::string sql_id;
+    std::string sql;
+    double elapsed_ms;
+};
+
+// Publishes the traced statement the given thread is executing, so a watchdog
+// on another thread can read it with currentInFlightStatement(). One thread at a time.
+void watchInFlightStatements(std::thread::id thread);
+bool currentInFlightStatement(InFlightStatement& statement);
+
+int slowQueryThresholdMs();
+const std::string& slowQueryLogPath();
+
+// The most recent records in the slow-query file and its last rotation, newest first.
+std::vector<SlowQueryRecord> readSlowQueries(size_t limit);
+
+#endif // SLOWQUERY_H
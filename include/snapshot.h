@@ -0,0 +1,70 @@
+#ifndef SNAPSHOT_H
+#define SNAPSHOT_H
+
+#include "finance.h"
+#include "menu.h"
+#include "period.h"
+#include "user.h"
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Local snapshot of reference data, so the main window can paint from disk
+// before the database has answered.
+//
+// One file per mess ("reference_snapshot_mess<N>.bin" in the working
+// directory). Layout, integers little-endian:
+//   "MMSNAP1\0"  u32 format_version  u32 mess_id  u64 created_unix
+//   u32 body_length  u32 crc32(body)  body
+// The file is memory-mapped and decoded at startup; a wrong version, mess or
+// checksum makes it count as missing. Password hashes are never written.
+
+struct ReferenceSnapshot {
+    int mess_id = 0;
+    int64_t created_unix = 0;
+    uint32_t body_checksum = 0; // Identifies the content; equal checksums mean nothing changed
+
+    std::vector<User> users;
+    std::vector<MenuItem> menu_items;
+    std::vector<MealPeriod> periods;
+    std::string currency;
+
+    // Settlement of the period for the current month, if one is set up
+    int current_period_id = 0;
+    double current_meal_rate = 0.0;
+    std::vector<SettlementReport> current_settlement;
+};
+
+// Maps the snapshot for currentMessId() from disk and makes it current.
+// Returns nullptr (and clears the current snapshot) if there is no valid file.
+std::shared_ptr<const ReferenceSnapshot> mapReferenceSnapshot();
+
+// The most recently mapped or refreshed snapshot, or nullptr.
+std::shared_ptr<const ReferenceSnapshot> currentReferenceSnapshot();
+
+// Rebuilds the snapshot from the database on a worker thread, writes it to
+// disk if its content changed, and makes it current. onRefreshed runs on the
+// worker thread with the new snapshot and whether it differs from the old one;
+// it is not called if the database could not be read.
+class ReferenceSnapshotRefresher {
+public:
+    using Callback = std::function<void(std::shared_ptr<const ReferenceSnapshot>, bool changed)>;
+
+    explicit ReferenceSnapshotRefresher(Callback onRefreshed);
+    ~ReferenceSnapshotRefresher(); // Waits for a refresh in progress
+    ReferenceSnapshotRefresher(const ReferenceSnapshotRefresher&) = delete;
+    ReferenceSnapshotRefresher& operator=(const ReferenceSnapshotRefresher&) = delete;
+
+    void start(); // No-op while a refresh is still running
+
+private:
+    Callback onRefreshed;
+    std::thread worker;
+    std::atomic<bool> running{false};
+};
+
+#endif // SNAPSHOT_H
@@ -0,0 +1,49 @@
+#ifndef STALLWATCHDOG_H
+#define STALLWATCHDOG_H
+
+#include <string>
+#include <vector>
+
+// GUI-thread stall watchdog.
+//
+// A timer on the GUI thread stamps a heartbeat every few tens of
+// milliseconds; a background thread checks the stamp and, when the event loop
+// has not run for longer than the threshold, notes which page slots were
+// running (the StallActivity scopes open on the GUI thread, outermost first,
+// as "Page::slot > Page::load") and the traced statement the GUI thread was
+// executing. When the heartbeat resumes, the stall is logged and added to
+// per-activity totals shown on the Diagnostics page.
+//
+// Configured in config.ini under [Watchdog]:
+//   stall_threshold_ms=250     0 disables the watchdog
+
+// Marks the enclosing scope of a GUI-thread slot. name must be a string literal.
+class StallActivity {
+public:
+    explicit StallActivity(const char* name);
+    ~StallActivity();
+
+    StallActivity(const StallActivity&) = delete;
+    StallActivity& operator=(const StallActivity&) = delete;
+};
+
+struct StallStats {
+    std::string activity;   // Open StallActivity names joined by " > "; "(unmarked)" if none
+    int count;
+    double total_ms;
+    double max_ms;
+    std::string last_query; // "function: sql" of the last stall caught in a query; empty if none
+    std::string last_seen;  // Local time, yyyy-MM-dd HH:mm:ss
+};
+
+// Call on the GUI thread once the QApplication exists; the heartbeat starts
+// with the event loop.
+void startStallWatchdog();
+void stopStallWatchdog();
+
+int stallThresholdMs(); // 0 when the watchdog is off
+
+// Stalls since startup, longest total first.
+std::vector<StallStats> getStallStats();
+
+#endif // STALLWATCHDOG_H
@@ -1,6 +1,7 @@
 #ifndef USER_H
 #define USER_H
 
+#include <cppconn/connection.h>
 #include <string>
 #include <memory>
 #include <vector>
@@ -27,4 +28,13 @@ std::unique_ptr<User> getUserById(int id);
 bool updateUserProfile(int id, const std::string& name);
 bool updateUserPassword(int id, const std::string& oldPassword, const std::string& newPassword);
 
+// Error code of the sql::SQLException thrown for a user of another mess (the
+// code MySQL gives a failed foreign key, which is what it amounts to).
+const int ER_NOT_MESS_MEMBER = 1452;
+
+// Writes that take user IDs from the caller (attendance, payments, expense
+// payers) call this inside their transaction. It share-locks the users' rows
+// until the caller commits and throws if any ID is not a user of the mess.
+void lockMessMembers(sql::Connection& con, int messId, const std::vector<int>& userIds);
+
 #endif // USER_H
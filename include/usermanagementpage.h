@@ -2,6 +2,10 @@
 #define USERMANAGEMENTPAGE_H
 
 #include <QWidget>
+#include <vector>
+#include "user.h"
+
+struct ReferenceSnapshot;
 
 class QTableWidget;
 class QLineEdit;
@@ -15,12 +19,15 @@ class UserManagementPage : public QWidget
 public:
     explicit UserManagementPage(QWidget *parent = nullptr);
 
+    void applyReferenceSnapshot(const ReferenceSnapshot& snapshot);
+
 private slots:
     void registerUserClicked();
     void refreshUsers();
 
 private:
     void loadUsers();
+    void populateUsers(const std::vector<User>& users);
 
     QTableWidget *userTable;
     QLineEdit *usernameLineEdit;
@@ -18,6 +18,7 @@ public:
 private slots:
     void saveProfile();
     void updatePassword();
+    void viewStatement();
 
 private:
     User* currentUser;
@@ -0,0 +1,39 @@
+#ifndef USERSTATEMENTDIALOG_H
+#define USERSTATEMENTDIALOG_H
+
+#include <QDialog>
+
+class QTableWidget;
+class QPushButton;
+class QLabel;
+struct LedgerStatementPage;
+
+// A user's ledger entries with their running balance, one window at a time.
+class UserStatementDialog : public QDialog
+{
+    Q_OBJECT
+
+public:
+    explicit UserStatementDialog(int userId, QWidget *parent = nullptr);
+
+private slots:
+    void showNewest();
+    void showOlder();
+    void showNewer();
+
+private:
+    static const int PAGE_SIZE = 50;
+
+    int userId;
+    long long firstEntryId = 0; // Oldest and newest entry on the current page
+    long long lastEntryId = 0;
+    QLabel *balanceLabel;
+    QTableWidget *statementTable;
+    QPushButton *newestButton;
+    QPushButton *newerButton;
+    QPushButton *olderButton;
+
+    void showPage(const LedgerStatementPage& page);
+};
+
+#endif // USERSTATEMENTDIALOG_H
@@ -0,0 +1,21 @@
+-- Adds named menu rotations that can be applied across a date range.
+
+CREATE TABLE IF NOT EXISTS `menu_templates`  (
+  `id` int NOT NULL AUTO_INCREMENT,
+  `name` varchar(100) NOT NULL,
+  `cycle_days` int NOT NULL DEFAULT 7,
+  PRIMARY KEY (`id`),
+  UNIQUE INDEX `template_name_unique` (`name`)
+) ENGINE = InnoDB;
+
+CREATE TABLE IF NOT EXISTS `menu_template_items`  (
+  `id` int NOT NULL AUTO_INCREMENT,
+  `template_id` int NOT NULL,
+  `day_offset` int NOT NULL,
+  `meal_type` enum('Breakfast','Lunch','Dinner') NOT NULL,
+  `menu_item_id` int NOT NULL,
+  PRIMARY KEY (`id`),
+  UNIQUE INDEX `template_item_unique`(`template_id`, `day_offset`, `meal_type`, `menu_item_id`),
+  CONSTRAINT `fk_template_items_template` FOREIGN KEY (`template_id`) REFERENCES `menu_templates` (`id`) ON DELETE CASCADE ON UPDATE CASCADE,
+  CONSTRAINT `fk_template_items_menu_item` FOREIGN KEY (`menu_item_id`) REFERENCES `menu_items` (`id`) ON DELETE CASCADE ON UPDATE CASCADE
+) ENGINE = InnoDB;
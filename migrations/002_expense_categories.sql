@@ -0,0 +1,28 @@
+-- Moves expenses.category from free text to an indexed lookup table.
+
+CREATE TABLE IF NOT EXISTS `expense_categories`  (
+  `id` int NOT NULL AUTO_INCREMENT,
+  `name` varchar(100) NOT NULL,
+  PRIMARY KEY (`id`),
+  UNIQUE INDEX `category_name_unique` (`name`)
+) ENGINE = InnoDB;
+
+INSERT IGNORE INTO `expense_categories` (`name`) VALUES ('Food'), ('Utilities'), ('Rent'), ('Other');
+
+-- Every distinct free-text value becomes a category; the case-insensitive
+-- unique index folds spellings like 'food' and 'Food' together.
+INSERT IGNORE INTO `expense_categories` (`name`)
+SELECT DISTINCT TRIM(`category`) FROM `expenses`
+WHERE `category` IS NOT NULL AND TRIM(`category`) <> '';
+
+ALTER TABLE `expenses` ADD COLUMN `category_id` int NULL DEFAULT NULL AFTER `paid_by_user_id`;
+
+UPDATE `expenses` e
+JOIN `expense_categories` c ON c.`name` = TRIM(e.`category`)
+SET e.`category_id` = c.`id`;
+
+ALTER TABLE `expenses`
+  ADD INDEX `expenses_category_date` (`category_id`, `purchase_date`),
+  ADD CONSTRAINT `fk_expenses_category` FOREIGN KEY (`category_id`) REFERENCES `expense_categories` (`id`) ON DELETE RESTRICT ON UPDATE CASCADE;
+
+ALTER TABLE `expenses` DROP COLUMN `category`;
@@ -0,0 +1,79 @@
+-- Lets one database serve several messes (dining halls). Existing rows all
+-- belong to the default mess with id 1.
+
+CREATE TABLE IF NOT EXISTS `messes`  (
+  `id` int NOT NULL AUTO_INCREMENT,
+  `name` varchar(100) NOT NULL,
+  PRIMARY KEY (`id`),
+  UNIQUE INDEX `mess_name_unique` (`name`)
+) ENGINE = InnoDB;
+
+INSERT IGNORE INTO `messes` (`id`, `name`) VALUES (1, 'Main Mess');
+
+ALTER TABLE `users`
+  ADD COLUMN `mess_id` int NOT NULL DEFAULT 1 AFTER `id`,
+  DROP INDEX `username_unique`,
+  ADD UNIQUE INDEX `username_unique` (`mess_id`, `username`),
+  ADD CONSTRAINT `fk_users_mess` FOREIGN KEY (`mess_id`) REFERENCES `messes` (`id`) ON DELETE RESTRICT ON UPDATE CASCADE;
+
+ALTER TABLE `meal_periods`
+  ADD COLUMN `mess_id` int NOT NULL DEFAULT 1 AFTER `id`,
+  DROP INDEX `period_unique`,
+  ADD UNIQUE INDEX `period_unique` (`mess_id`, `month`, `year`),
+  ADD CONSTRAINT `fk_meal_periods_mess` FOREIGN KEY (`mess_id`) REFERENCES `messes` (`id`) ON DELETE RESTRICT ON UPDATE CASCADE;
+
+ALTER TABLE `menu_items`
+  ADD COLUMN `mess_id` int NOT NULL DEFAULT 1 AFTER `id`,
+  DROP INDEX `name_unique`,
+  ADD UNIQUE INDEX `name_unique` (`mess_id`, `name`),
+  ADD CONSTRAINT `fk_menu_items_mess` FOREIGN KEY (`mess_id`) REFERENCES `messes` (`id`) ON DELETE RESTRICT ON UPDATE CASCADE;
+
+ALTER TABLE `daily_menus`
+  ADD COLUMN `mess_id` int NOT NULL DEFAULT 1 AFTER `id`,
+  DROP INDEX `daily_menu_unique`,
+  ADD UNIQUE INDEX `daily_menu_unique` (`mess_id`, `menu_date`, `meal_type`, `menu_item_id`),
+  ADD CONSTRAINT `fk_daily_menus_mess` FOREIGN KEY (`mess_id`) REFERENCES `messes` (`id`) ON DELETE RESTRICT ON UPDATE CASCADE;
+
+ALTER TABLE `menu_templates`
+  ADD COLUMN `mess_id` int NOT NULL DEFAULT 1 AFTER `id`,
+  DROP INDEX `template_name_unique`,
+  ADD UNIQUE INDEX `template_name_unique` (`mess_id`, `name`),
+  ADD CONSTRAINT `fk_menu_templates_mess` FOREIGN KEY (`mess_id`) REFERENCES `messes` (`id`) ON DELETE RESTRICT ON UPDATE CASCADE;
+
+ALTER TABLE `menu_template_items`
+  ADD COLUMN `mess_id` int NOT NULL DEFAULT 1 AFTER `id`,
+  ADD CONSTRAINT `fk_template_items_mess` FOREIGN KEY (`mess_id`) REFERENCES `messes` (`id`) ON DELETE RESTRICT ON UPDATE CASCADE;
+
+ALTER TABLE `expense_categories`
+  ADD COLUMN `mess_id` int NOT NULL DEFAULT 1 AFTER `id`,
+  DROP INDEX `category_name_unique`,
+  ADD UNIQUE INDEX `category_name_unique` (`mess_id`, `name`),
+  ADD CONSTRAINT `fk_expense_categories_mess` FOREIGN KEY (`mess_id`) REFERENCES `messes` (`id`) ON DELETE RESTRICT ON UPDATE CASCADE;
+
+ALTER TABLE `expenses`
+  ADD COLUMN `mess_id` int NOT NULL DEFAULT 1 AFTER `id`,
+  ADD INDEX `expenses_mess_date` (`mess_id`, `purchase_date`),
+  ADD CONSTRAINT `fk_expenses_mess` FOREIGN KEY (`mess_id`) REFERENCES `messes` (`id`) ON DELETE RESTRICT ON UPDATE CASCADE;
+
+ALTER TABLE `meal_attendance`
+  ADD COLUMN `mess_id` int NOT NULL DEFAULT 1 AFTER `id`,
+  ADD INDEX `attendance_mess_date` (`mess_id`, `attendance_date`),
+  ADD CONSTRAINT `fk_attendance_mess` FOREIGN KEY (`mess_id`) REFERENCES `messes` (`id`) ON DELETE RESTRICT ON UPDATE CASCADE;
+
+ALTER TABLE `payments`
+  ADD COLUMN `mess_id` INT NOT NULL DEFAULT 1 AFTER `id`,
+  ADD INDEX `payments_mess_date` (`mess_id`, `date`),
+  ADD CONSTRAINT `fk_payments_mess` FOREIGN KEY (`mess_id`) REFERENCES `messes` (`id`) ON DELETE RESTRICT ON UPDATE CASCADE;
+
+-- Settings become one row per mess instead of the single row with id 1.
+ALTER TABLE `settings`
+  ADD COLUMN `mess_id` INT NOT NULL DEFAULT 1 FIRST;
+
+DELETE FROM `settings` WHERE `id` <> 1;
+
+ALTER TABLE `settings`
+  DROP PRIMARY KEY,
+  DROP COLUMN `id`,
+  ALTER COLUMN `mess_id` DROP DEFAULT,
+  ADD PRIMARY KEY (`mess_id`),
+  ADD CONSTRAINT `fk_settings_mess` FOREIGN KEY (`mess_id`) REFERENCES `messes` (`id`) ON DELETE CASCADE ON UPDATE CASCADE;
@@ -0,0 +1,10 @@
+-- Lets writes replayed from the offline journal be applied at most once.
+-- Existing rows keep a NULL key, which the unique index allows any number of.
+
+ALTER TABLE `expenses`
+  ADD COLUMN `idempotency_key` char(32) NULL DEFAULT NULL AFTER `category_id`,
+  ADD UNIQUE INDEX `expense_idempotency_unique` (`idempotency_key`);
+
+ALTER TABLE `payments`
+  ADD COLUMN `idempotency_key` CHAR(32) NULL DEFAULT NULL AFTER `date`,
+  ADD UNIQUE INDEX `payment_idempotency_unique` (`idempotency_key`);
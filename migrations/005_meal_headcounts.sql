@@ -0,0 +1,16 @@
+-- Per-meal attendance totals used by the demand forecast. The application
+-- keeps them current on every attendance write; this backfills history.
+
+CREATE TABLE IF NOT EXISTS `meal_headcounts`  (
+  `mess_id` int NOT NULL,
+  `meal_date` date NOT NULL,
+  `meal_type` enum('Breakfast','Lunch','Dinner') NOT NULL,
+  `headcount` int NOT NULL DEFAULT 0,
+  PRIMARY KEY (`mess_id`, `meal_date`, `meal_type`),
+  CONSTRAINT `fk_headcounts_mess` FOREIGN KEY (`mess_id`) REFERENCES `messes` (`id`) ON DELETE RESTRICT ON UPDATE CASCADE
+) ENGINE = InnoDB;
+
+REPLACE INTO `meal_headcounts` (`mess_id`, `meal_date`, `meal_type`, `headcount`)
+SELECT `mess_id`, `attendance_date`, `meal_type`, COUNT(*) FROM `meal_attendance`
+WHERE `attendance_date` IS NOT NULL AND `meal_type` IS NOT NULL
+GROUP BY `mess_id`, `attendance_date`, `meal_type`;
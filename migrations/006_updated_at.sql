@@ -0,0 +1,12 @@
+-- Last-modified stamps for the editable tables the monthly settlement reads,
+-- so its cache can tell an edited row from an untouched one. Microsecond
+-- precision keeps two edits in the same second distinguishable.
+
+ALTER TABLE `users`
+  ADD COLUMN `updated_at` timestamp(6) NOT NULL DEFAULT CURRENT_TIMESTAMP(6) ON UPDATE CURRENT_TIMESTAMP(6) AFTER `role`;
+
+ALTER TABLE `expenses`
+  ADD COLUMN `updated_at` timestamp(6) NOT NULL DEFAULT CURRENT_TIMESTAMP(6) ON UPDATE CURRENT_TIMESTAMP(6) AFTER `idempotency_key`;
+
+ALTER TABLE `payments`
+  ADD COLUMN `updated_at` TIMESTAMP(6) NOT NULL DEFAULT CURRENT_TIMESTAMP(6) ON UPDATE CURRENT_TIMESTAMP(6) AFTER `idempotency_key`;
@@ -0,0 +1,24 @@
+-- Closing a period freezes its settlement. meal_periods.is_active = 0 marks a
+-- closed period; the application then rejects writes dated in its month.
+
+ALTER TABLE `meal_periods`
+  ADD COLUMN `closed_at` datetime NULL DEFAULT NULL AFTER `is_active`;
+
+CREATE TABLE IF NOT EXISTS `period_settlements`  (
+  `period_id` int NOT NULL,
+  `user_id` int NOT NULL,
+  `user_name` varchar(100) NULL DEFAULT NULL,
+  `meal_rate` decimal(12, 4) NOT NULL,
+  `total_meals` int NOT NULL,
+  `total_meal_cost` decimal(12, 2) NOT NULL,
+  `total_payments` decimal(12, 2) NOT NULL,
+  `total_shopping_expenses` decimal(12, 2) NOT NULL,
+  `total_contributions` decimal(12, 2) NOT NULL,
+  `final_balance` decimal(12, 2) NOT NULL,
+  PRIMARY KEY (`period_id`, `user_id`),
+  CONSTRAINT `fk_period_settlements_period` FOREIGN KEY (`period_id`) REFERENCES `meal_periods` (`id`) ON DELETE CASCADE ON UPDATE CASCADE
+) ENGINE = InnoDB;
+
+-- Nothing wrote is_active before this migration, so a stray 0 there would lock a
+-- month with no frozen settlement. Only periods closed by the application count.
+UPDATE `meal_periods` SET `is_active` = 1 WHERE `closed_at` IS NULL;
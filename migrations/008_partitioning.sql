@@ -0,0 +1,69 @@
+-- Partitions meal_attendance, expenses and payments by month on their date.
+-- MySQL needs the partitioning column in every unique key (so the primary and
+-- idempotency keys gain the date) and supports no foreign keys on partitioned
+-- tables, so those constraints are dropped and kept by the application; the
+-- indexes that backed them stay under plain names.
+--
+-- Every existing row starts in the catch-all pmax partition. Run
+-- `meal_cli partitions maintain` afterwards to split it into monthly partitions.
+-- Each ALTER rebuilds its table, so run this during a quiet period.
+--
+-- The date columns become NOT NULL. Attendance and expense rows without a date
+-- are moved, unchanged, to meal_attendance_undated and expenses_undated rather
+-- than deleted or given a guessed date. No monthly settlement ever counted
+-- them. After running, check both tables; to keep a row, enter it again with
+-- its date in the application, so it is also posted to the ledger.
+
+CREATE TABLE IF NOT EXISTS `meal_attendance_undated` LIKE `meal_attendance`;
+
+INSERT INTO `meal_attendance_undated` SELECT * FROM `meal_attendance` WHERE `attendance_date` IS NULL;
+
+DELETE FROM `meal_attendance` WHERE `attendance_date` IS NULL;
+
+ALTER TABLE `meal_attendance`
+  DROP FOREIGN KEY `fk_attendance_mess`,
+  DROP FOREIGN KEY `fk_attendance_user`;
+
+ALTER TABLE `meal_attendance`
+  MODIFY `attendance_date` date NOT NULL,
+  DROP PRIMARY KEY,
+  ADD PRIMARY KEY (`id`, `attendance_date`);
+
+ALTER TABLE `meal_attendance`
+  PARTITION BY RANGE COLUMNS (`attendance_date`) (PARTITION `pmax` VALUES LESS THAN (MAXVALUE));
+
+CREATE TABLE IF NOT EXISTS `expenses_undated` LIKE `expenses`;
+
+INSERT INTO `expenses_undated` SELECT * FROM `expenses` WHERE `purchase_date` IS NULL;
+
+DELETE FROM `expenses` WHERE `purchase_date` IS NULL;
+
+ALTER TABLE `expenses`
+  DROP FOREIGN KEY `fk_expenses_mess`,
+  DROP FOREIGN KEY `fk_expenses_user`,
+  DROP FOREIGN KEY `fk_expenses_category`;
+
+ALTER TABLE `expenses`
+  MODIFY `purchase_date` date NOT NULL,
+  DROP PRIMARY KEY,
+  ADD PRIMARY KEY (`id`, `purchase_date`),
+  DROP INDEX `expense_idempotency_unique`,
+  ADD UNIQUE INDEX `expense_idempotency_unique` (`idempotency_key`, `purchase_date`),
+  RENAME INDEX `fk_expenses_user` TO `expenses_user`;
+
+ALTER TABLE `expenses`
+  PARTITION BY RANGE COLUMNS (`purchase_date`) (PARTITION `pmax` VALUES LESS THAN (MAXVALUE));
+
+ALTER TABLE `payments`
+  DROP FOREIGN KEY `fk_payments_mess`,
+  DROP FOREIGN KEY `fk_payments_user`;
+
+ALTER TABLE `payments`
+  DROP PRIMARY KEY,
+  ADD PRIMARY KEY (`id`, `date`),
+  DROP INDEX `payment_idempotency_unique`,
+  ADD UNIQUE INDEX `payment_idempotency_unique` (`idempotency_key`, `date`),
+  RENAME INDEX `fk_payments_user` TO `payments_user`;
+
+ALTER TABLE `payments`
+  PARTITION BY RANGE COLUMNS (`date`) (PARTITION `pmax` VALUES LESS THAN (MAXVALUE));
@@ -0,0 +1,78 @@
+-- Double-entry ledger with stored running balances (see include/ledger.h),
+-- backfilled from existing payments, shopping expenses and the meal costs of
+-- closed periods. Each account's history is posted in date order; months
+-- archived with `meal_cli partitions archive` are not in the live tables, so
+-- restore them before applying this migration.
+
+CREATE TABLE IF NOT EXISTS `ledger_entries` (
+    `id` BIGINT NOT NULL AUTO_INCREMENT,
+    `mess_id` INT NOT NULL,
+    `user_id` INT NOT NULL,
+    `entry_type` ENUM('Payment','Shopping','MealCost') NOT NULL,
+    `amount` DECIMAL(12, 2) NOT NULL,
+    `running_balance` DECIMAL(12, 2) NOT NULL,
+    `entry_date` DATE NOT NULL,
+    `source_id` INT NOT NULL,
+    `description` VARCHAR(255) NULL DEFAULT NULL,
+    `created_at` TIMESTAMP NOT NULL DEFAULT CURRENT_TIMESTAMP,
+    PRIMARY KEY (`id`),
+    INDEX `ledger_account` (`mess_id`, `user_id`, `id`),
+    INDEX `ledger_source` (`mess_id`, `entry_type`, `source_id`),
+    CONSTRAINT `fk_ledger_entries_mess` FOREIGN KEY (`mess_id`) REFERENCES `messes` (`id`) ON DELETE RESTRICT ON UPDATE CASCADE
+) ENGINE = InnoDB;
+
+CREATE TABLE IF NOT EXISTS `ledger_balances` (
+    `mess_id` INT NOT NULL,
+    `user_id` INT NOT NULL,
+    `balance` DECIMAL(12, 2) NOT NULL DEFAULT 0,
+    `total_payments` DECIMAL(12, 2) NOT NULL DEFAULT 0,
+    `total_shopping` DECIMAL(12, 2) NOT NULL DEFAULT 0,
+    `total_meal_cost` DECIMAL(12, 2) NOT NULL DEFAULT 0,
+    `entry_count` INT NOT NULL DEFAULT 0,
+    PRIMARY KEY (`mess_id`, `user_id`),
+    CONSTRAINT `fk_ledger_balances_mess` FOREIGN KEY (`mess_id`) REFERENCES `messes` (`id`) ON DELETE RESTRICT ON UPDATE CASCADE
+) ENGINE = InnoDB;
+
+-- Re-runnable: start from an empty ledger
+DELETE FROM `ledger_entries`;
+DELETE FROM `ledger_balances`;
+
+-- User entries and their opposite pool (user_id 0) entries. The ORDER BY gives
+-- ids in the same order the window function accumulates the balances in.
+INSERT INTO `ledger_entries` (`mess_id`, `user_id`, `entry_type`, `amount`, `running_balance`, `entry_date`, `source_id`, `description`)
+SELECT `mess_id`, `user_id`, `entry_type`, `amount`,
+       SUM(`amount`) OVER (PARTITION BY `mess_id`, `user_id` ORDER BY `entry_date`, `type_order`, `source_id` ROWS UNBOUNDED PRECEDING),
+       `entry_date`, `source_id`, `description`
+FROM (
+    SELECT `mess_id`, `user_id`, 'Payment' AS `entry_type`, 1 AS `type_order`, `amount`, `date` AS `entry_date`, `id` AS `source_id`, 'Payment' AS `description`
+      FROM `payments` WHERE `user_id` > 0
+    UNION ALL
+    SELECT `mess_id`, 0, 'Payment', 1, -`amount`, `date`, `id`, 'Payment'
+      FROM `payments` WHERE `user_id` > 0
+    UNION ALL
+    SELECT `mess_id`, `paid_by_user_id`, 'Shopping', 2, `price`, `purchase_date`, `id`, `item_name`
+      FROM `expenses` WHERE `paid_by_user_id` > 0 AND `price` <> 0
+    UNION ALL
+    SELECT `mess_id`, 0, 'Shopping', 2, -`price`, `purchase_date`, `id`, `item_name`
+      FROM `expenses` WHERE `paid_by_user_id` > 0 AND `price` <> 0
+    UNION ALL
+    SELECT p.`mess_id`, s.`user_id`, 'MealCost', 3, -s.`total_meal_cost`,
+           LAST_DAY(STR_TO_DATE(CONCAT('1 ', p.`month`, ' ', p.`year`), '%d %M %Y')), p.`id`,
+           CONCAT('Meal cost, ', p.`month`, ' ', p.`year`, ' (', s.`total_meals`, ' meals)')
+      FROM `period_settlements` s JOIN `meal_periods` p ON p.`id` = s.`period_id` WHERE s.`total_meal_cost` <> 0
+    UNION ALL
+    SELECT p.`mess_id`, 0, 'MealCost', 3, s.`total_meal_cost`,
+           LAST_DAY(STR_TO_DATE(CONCAT('1 ', p.`month`, ' ', p.`year`), '%d %M %Y')), p.`id`,
+           CONCAT('Meal cost, ', p.`month`, ' ', p.`year`, ' (', s.`total_meals`, ' meals)')
+      FROM `period_settlements` s JOIN `meal_periods` p ON p.`id` = s.`period_id` WHERE s.`total_meal_cost` <> 0
+) postings
+ORDER BY `entry_date`, `type_order`, `source_id`, `user_id`;
+
+INSERT INTO `ledger_balances` (`mess_id`, `user_id`, `balance`, `total_payments`, `total_shopping`, `total_meal_cost`, `entry_count`)
+SELECT `mess_id`, `user_id`, SUM(`amount`),
+       SUM(IF(`entry_type` = 'Payment', `amount`, 0)),
+       SUM(IF(`entry_type` = 'Shopping', `amount`, 0)),
+       SUM(IF(`entry_type` = 'MealCost', `amount`, 0)),
+       COUNT(*)
+FROM `ledger_entries`
+GROUP BY `mess_id`, `user_id`;
@@ -0,0 +1,21 @@
+-- Per-user meal counts by week and weekday, read by the demand forecast
+-- instead of grouping meal_attendance. The application keeps them current on
+-- every attendance write, alongside meal_headcounts; this backfills history.
+-- week_start is the Monday of the week and weekday is 0 (Monday) to 6.
+
+CREATE TABLE IF NOT EXISTS `meal_weekday_counts`  (
+  `mess_id` int NOT NULL,
+  `week_start` date NOT NULL,
+  `user_id` int NOT NULL,
+  `meal_type` enum('Breakfast','Lunch','Dinner') NOT NULL,
+  `weekday` tinyint NOT NULL,
+  `meals` int NOT NULL DEFAULT 0,
+  PRIMARY KEY (`mess_id`, `week_start`, `user_id`, `meal_type`, `weekday`),
+  CONSTRAINT `fk_weekday_counts_mess` FOREIGN KEY (`mess_id`) REFERENCES `messes` (`id`) ON DELETE RESTRICT ON UPDATE CASCADE
+) ENGINE = InnoDB;
+
+REPLACE INTO `meal_weekday_counts` (`mess_id`, `week_start`, `user_id`, `meal_type`, `weekday`, `meals`)
+SELECT `mess_id`, `attendance_date` - INTERVAL WEEKDAY(`attendance_date`) DAY, `user_id`, `meal_type`, WEEKDAY(`attendance_date`), COUNT(*)
+FROM `meal_attendance`
+WHERE `user_id` IS NOT NULL AND `meal_type` IS NOT NULL
+GROUP BY `mess_id`, `attendance_date`, `user_id`, `meal_type`;
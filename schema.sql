@@ -14,19 +14,38 @@
 SET NAMES utf8mb4;
 SET FOREIGN_KEY_CHECKS = 0;
 
+--
+-- Table structure for `messes`
+-- Each mess (dining hall) is a tenant; every other table carries a `mess_id`
+-- and its indexes lead with it, so one hall's queries never scan another's rows.
+--
+DROP TABLE IF EXISTS `messes`;
+CREATE TABLE `messes`  (
+  `id` int NOT NULL AUTO_INCREMENT,
+  `name` varchar(100) NOT NULL,
+  PRIMARY KEY (`id`),
+  UNIQUE INDEX `mess_name_unique` (`name`)
+) ENGINE = InnoDB;
+
+-- Default mess
+INSERT INTO `messes` (`id`, `name`) VALUES (1, 'Main Mess');
+
 --
 -- Table structure for `users`
 --
 DROP TABLE IF EXISTS `users`;
 CREATE TABLE `users`  (
   `id` int NOT NULL AUTO_INCREMENT,
+  `mess_id` int NOT NULL DEFAULT 1,
   `username` varchar(50) NOT NULL,
   `password_hash` varchar(255) NOT NULL,
   `salt` varchar(64) NOT NULL,
   `name` varchar(100) NULL DEFAULT NULL,
   `role` enum('Student','Staff','Admin') NULL DEFAULT 'Student',
+  `updated_at` timestamp(6) NOT NULL DEFAULT CURRENT_TIMESTAMP(6) ON UPDATE CURRENT_TIMESTAMP(6),
   PRIMARY KEY (`id`),
-  UNIQUE INDEX `username_unique` (`username`)
+  UNIQUE INDEX `username_unique` (`mess_id`, `username`),
+  CONSTRAINT `fk_users_mess` FOREIGN KEY (`mess_id`) REFERENCES `messes` (`id`) ON DELETE RESTRICT ON UPDATE CASCADE
 ) ENGINE = InnoDB;
 
 --
@@ -35,11 +54,35 @@ CREATE TABLE `users`  (
 DROP TABLE IF EXISTS `meal_periods`;
 CREATE TABLE `meal_periods`  (
   `id` int NOT NULL AUTO_INCREMENT,
+  `mess_id` int NOT NULL DEFAULT 1,
   `month` varchar(20) NULL DEFAULT NULL,
   `year` varchar(4) NULL DEFAULT NULL,
   `is_active` tinyint(1) NULL DEFAULT 1,
+  `closed_at` datetime NULL DEFAULT NULL,
   PRIMARY KEY (`id`),
-  UNIQUE INDEX `period_unique`(`month`, `year`)
+  UNIQUE INDEX `period_unique`(`mess_id`, `month`, `year`),
+  CONSTRAINT `fk_meal_periods_mess` FOREIGN KEY (`mess_id`) REFERENCES `messes` (`id`) ON DELETE RESTRICT ON UPDATE CASCADE
+) ENGINE = InnoDB;
+
+--
+-- Table structure for `period_settlements`
+-- Settlement frozen when a period is closed; user_name is kept as it was, and
+-- rows outlive the user
+--
+DROP TABLE IF EXISTS `period_settlements`;
+CREATE TABLE `period_settlements`  (
+  `period_id` int NOT NULL,
+  `user_id` int NOT NULL,
+  `user_name` varchar(100) NULL DEFAULT NULL,
+  `meal_rate` decimal(12, 4) NOT NULL,
+  `total_meals` int NOT NULL,
+  `total_meal_cost` decimal(12, 2) NOT NULL,
+  `total_payments` decimal(12, 2) NOT NULL,
+  `total_shopping_expenses` decimal(12, 2) NOT NULL,
+  `total_contributions` decimal(12, 2) NOT NULL,
+  `final_balance` decimal(12, 2) NOT NULL,
+  PRIMARY KEY (`period_id`, `user_id`),
+  CONSTRAINT `fk_period_settlements_period` FOREIGN KEY (`period_id`) REFERENCES `meal_periods` (`id`) ON DELETE CASCADE ON UPDATE CASCADE
 ) ENGINE = InnoDB;
 
 --
@@ -48,9 +91,11 @@ CREATE TABLE `meal_periods`  (
 DROP TABLE IF EXISTS `menu_items`;
 CREATE TABLE `menu_items`  (
   `id` int NOT NULL AUTO_INCREMENT,
+  `mess_id` int NOT NULL DEFAULT 1,
   `name` varchar(255) NOT NULL,
   PRIMARY KEY (`id`),
-  UNIQUE INDEX `name_unique` (`name`)
+  UNIQUE INDEX `name_unique` (`mess_id`, `name`),
+  CONSTRAINT `fk_menu_items_mess` FOREIGN KEY (`mess_id`) REFERENCES `messes` (`id`) ON DELETE RESTRICT ON UPDATE CASCADE
 ) ENGINE = InnoDB;
 
 --
@@ -59,28 +104,90 @@ CREATE TABLE `menu_items`  (
 DROP TABLE IF EXISTS `daily_menus`;
 CREATE TABLE `daily_menus`  (
   `id` int NOT NULL AUTO_INCREMENT,
+  `mess_id` int NOT NULL DEFAULT 1,
   `menu_date` date NOT NULL,
   `meal_type` enum('Breakfast','Lunch','Dinner') NOT NULL,
   `menu_item_id` int NOT NULL,
   PRIMARY KEY (`id`),
-  UNIQUE INDEX `daily_menu_unique`(`menu_date`, `meal_type`, `menu_item_id`),
+  UNIQUE INDEX `daily_menu_unique`(`mess_id`, `menu_date`, `meal_type`, `menu_item_id`),
+  CONSTRAINT `fk_daily_menus_mess` FOREIGN KEY (`mess_id`) REFERENCES `messes` (`id`) ON DELETE RESTRICT ON UPDATE CASCADE,
   CONSTRAINT `fk_daily_menus_menu_item` FOREIGN KEY (`menu_item_id`) REFERENCES `menu_items` (`id`) ON DELETE CASCADE ON UPDATE CASCADE
 ) ENGINE = InnoDB;
 
+--
+-- Table structure for `menu_templates`
+--
+DROP TABLE IF EXISTS `menu_templates`;
+CREATE TABLE `menu_templates`  (
+  `id` int NOT NULL AUTO_INCREMENT,
+  `mess_id` int NOT NULL DEFAULT 1,
+  `name` varchar(100) NOT NULL,
+  `cycle_days` int NOT NULL DEFAULT 7,
+  PRIMARY KEY (`id`),
+  UNIQUE INDEX `template_name_unique` (`mess_id`, `name`),
+  CONSTRAINT `fk_menu_templates_mess` FOREIGN KEY (`mess_id`) REFERENCES `messes` (`id`) ON DELETE RESTRICT ON UPDATE CASCADE
+) ENGINE = InnoDB;
+
+--
+-- Table structure for `menu_template_items`
+--
+DROP TABLE IF EXISTS `menu_template_items`;
+CREATE TABLE `menu_template_items`  (
+  `id` int NOT NULL AUTO_INCREMENT,
+  `mess_id` int NOT NULL DEFAULT 1,
+  `template_id` int NOT NULL,
+  `day_offset` int NOT NULL,
+  `meal_type` enum('Breakfast','Lunch','Dinner') NOT NULL,
+  `menu_item_id` int NOT NULL,
+  PRIMARY KEY (`id`),
+  UNIQUE INDEX `template_item_unique`(`template_id`, `day_offset`, `meal_type`, `menu_item_id`),
+  CONSTRAINT `fk_template_items_mess` FOREIGN KEY (`mess_id`) REFERENCES `messes` (`id`) ON DELETE RESTRICT ON UPDATE CASCADE,
+  CONSTRAINT `fk_template_items_template` FOREIGN KEY (`template_id`) REFERENCES `menu_templates` (`id`) ON DELETE CASCADE ON UPDATE CASCADE,
+  CONSTRAINT `fk_template_items_menu_item` FOREIGN KEY (`menu_item_id`) REFERENCES `menu_items` (`id`) ON DELETE CASCADE ON UPDATE CASCADE
+) ENGINE = InnoDB;
+
+--
+-- Table structure for `expense_categories`
+--
+DROP TABLE IF EXISTS `expense_categories`;
+CREATE TABLE `expense_categories`  (
+  `id` int NOT NULL AUTO_INCREMENT,
+  `mess_id` int NOT NULL DEFAULT 1,
+  `name` varchar(100) NOT NULL,
+  PRIMARY KEY (`id`),
+  UNIQUE INDEX `category_name_unique` (`mess_id`, `name`),
+  CONSTRAINT `fk_expense_categories_mess` FOREIGN KEY (`mess_id`) REFERENCES `messes` (`id`) ON DELETE RESTRICT ON UPDATE CASCADE
+) ENGINE = InnoDB;
+
+-- Default expense categories for the default mess
+INSERT INTO `expense_categories` (`mess_id`, `name`) VALUES (1, 'Food'), (1, 'Utilities'), (1, 'Rent'), (1, 'Other');
+
 --
 -- Table structure for `expenses`
+-- expenses, meal_attendance and payments are partitioned by month on their
+-- date (see include/partition.h). MySQL requires the date in every unique key
+-- and allows no foreign keys on partitioned tables, so their references to
+-- messes, users and categories are kept by the application.
+-- Run `meal_cli partitions maintain` after setup to create the monthly partitions.
 --
 DROP TABLE IF EXISTS `expenses`;
 CREATE TABLE `expenses`  (
   `id` int NOT NULL AUTO_INCREMENT,
-  `purchase_date` date NULL DEFAULT NULL,
+  `mess_id` int NOT NULL DEFAULT 1,
+  `purchase_date` date NOT NULL,
   `item_name` varchar(255) NULL DEFAULT NULL,
   `price` decimal(10, 2) NULL DEFAULT NULL,
   `paid_by_user_id` int NULL DEFAULT NULL,
-  `category` varchar(100) NULL DEFAULT NULL,
-  PRIMARY KEY (`id`),
-  CONSTRAINT `fk_expenses_user` FOREIGN KEY (`paid_by_user_id`) REFERENCES `users` (`id`) ON DELETE SET NULL ON UPDATE CASCADE
-) ENGINE = InnoDB;
+  `category_id` int NULL DEFAULT NULL,
+  `idempotency_key` char(32) NULL DEFAULT NULL,
+  `updated_at` timestamp(6) NOT NULL DEFAULT CURRENT_TIMESTAMP(6) ON UPDATE CURRENT_TIMESTAMP(6),
+  PRIMARY KEY (`id`, `purchase_date`),
+  UNIQUE INDEX `expense_idempotency_unique` (`idempotency_key`, `purchase_date`),
+  INDEX `expenses_mess_date` (`mess_id`, `purchase_date`),
+  INDEX `expenses_category_date` (`category_id`, `purchase_date`),
+  INDEX `expenses_user` (`paid_by_user_id`)
+) ENGINE = InnoDB
+PARTITION BY RANGE COLUMNS (`purchase_date`) (PARTITION `pmax` VALUES LESS THAN (MAXVALUE));
 
 --
 -- Table structure for `meal_attendance`
@@ -88,12 +195,44 @@ CREATE TABLE `expenses`  (
 DROP TABLE IF EXISTS `meal_attendance`;
 CREATE TABLE `meal_attendance`  (
   `id` int NOT NULL AUTO_INCREMENT,
+  `mess_id` int NOT NULL DEFAULT 1,
   `user_id` int NULL DEFAULT NULL,
-  `attendance_date` date NULL DEFAULT NULL,
+  `attendance_date` date NOT NULL,
   `meal_type` enum('Breakfast','Lunch','Dinner') NULL DEFAULT NULL,
-  PRIMARY KEY (`id`),
+  PRIMARY KEY (`id`, `attendance_date`),
   UNIQUE INDEX `user_meal_unique`(`user_id`, `attendance_date`, `meal_type`),
-  CONSTRAINT `fk_attendance_user` FOREIGN KEY (`user_id`) REFERENCES `users` (`id`) ON DELETE CASCADE ON UPDATE CASCADE
+  INDEX `attendance_mess_date` (`mess_id`, `attendance_date`)
+) ENGINE = InnoDB
+PARTITION BY RANGE COLUMNS (`attendance_date`) (PARTITION `pmax` VALUES LESS THAN (MAXVALUE));
+
+--
+-- Table structure for `meal_headcounts`
+-- Attendance rows per (mess, date, meal type), kept current by the attendance writes; feeds demand forecasts
+--
+DROP TABLE IF EXISTS `meal_headcounts`;
+CREATE TABLE `meal_headcounts`  (
+  `mess_id` int NOT NULL,
+  `meal_date` date NOT NULL,
+  `meal_type` enum('Breakfast','Lunch','Dinner') NOT NULL,
+  `headcount` int NOT NULL DEFAULT 0,
+  PRIMARY KEY (`mess_id`, `meal_date`, `meal_type`),
+  CONSTRAINT `fk_headcounts_mess` FOREIGN KEY (`mess_id`) REFERENCES `messes` (`id`) ON DELETE RESTRICT ON UPDATE CASCADE
+) ENGINE = InnoDB;
+
+--
+-- Table structure for `meal_weekday_counts`
+-- Meals per (mess, week, user, meal type, weekday), kept current by the attendance writes; feeds demand forecasts
+--
+DROP TABLE IF EXISTS `meal_weekday_counts`;
+CREATE TABLE `meal_weekday_counts`  (
+  `mess_id` int NOT NULL,
+  `week_start` date NOT NULL,
+  `user_id` int NOT NULL,
+  `meal_type` enum('Breakfast','Lunch','Dinner') NOT NULL,
+  `weekday` tinyint NOT NULL,
+  `meals` int NOT NULL DEFAULT 0,
+  PRIMARY KEY (`mess_id`, `week_start`, `user_id`, `meal_type`, `weekday`),
+  CONSTRAINT `fk_weekday_counts_mess` FOREIGN KEY (`mess_id`) REFERENCES `messes` (`id`) ON DELETE RESTRICT ON UPDATE CASCADE
 ) ENGINE = InnoDB;
 
 --
@@ -102,11 +241,58 @@ CREATE TABLE `meal_attendance`  (
 DROP TABLE IF EXISTS `payments`;
 CREATE TABLE `payments` (
     `id` INT NOT NULL AUTO_INCREMENT,
+    `mess_id` INT NOT NULL DEFAULT 1,
     `user_id` INT NULL,
     `amount` DECIMAL(10, 2) NOT NULL,
     `date` DATE NOT NULL,
+    `idempotency_key` CHAR(32) NULL DEFAULT NULL,
+    `updated_at` TIMESTAMP(6) NOT NULL DEFAULT CURRENT_TIMESTAMP(6) ON UPDATE CURRENT_TIMESTAMP(6),
+    PRIMARY KEY (`id`, `date`),
+    UNIQUE INDEX `payment_idempotency_unique` (`idempotency_key`, `date`),
+    INDEX `payments_mess_date` (`mess_id`, `date`),
+    INDEX `payments_user` (`user_id`)
+) ENGINE = InnoDB
+PARTITION BY RANGE COLUMNS (`date`) (PARTITION `pmax` VALUES LESS THAN (MAXVALUE));
+
+--
+-- Table structure for `ledger_entries`
+-- Double-entry ledger (see include/ledger.h). user_id 0 is the mess's pool
+-- account; every posting is a user entry plus an opposite pool entry.
+-- running_balance is the account's balance after the entry, in id order.
+--
+DROP TABLE IF EXISTS `ledger_entries`;
+CREATE TABLE `ledger_entries` (
+    `id` BIGINT NOT NULL AUTO_INCREMENT,
+    `mess_id` INT NOT NULL,
+    `user_id` INT NOT NULL,
+    `entry_type` ENUM('Payment','Shopping','MealCost') NOT NULL,
+    `amount` DECIMAL(12, 2) NOT NULL,
+    `running_balance` DECIMAL(12, 2) NOT NULL,
+    `entry_date` DATE NOT NULL,
+    `source_id` INT NOT NULL,
+    `description` VARCHAR(255) NULL DEFAULT NULL,
+    `created_at` TIMESTAMP NOT NULL DEFAULT CURRENT_TIMESTAMP,
     PRIMARY KEY (`id`),
-    CONSTRAINT `fk_payments_user` FOREIGN KEY (`user_id`) REFERENCES `users` (`id`) ON DELETE CASCADE ON UPDATE CASCADE
+    INDEX `ledger_account` (`mess_id`, `user_id`, `id`),
+    INDEX `ledger_source` (`mess_id`, `entry_type`, `source_id`),
+    CONSTRAINT `fk_ledger_entries_mess` FOREIGN KEY (`mess_id`) REFERENCES `messes` (`id`) ON DELETE RESTRICT ON UPDATE CASCADE
+) ENGINE = InnoDB;
+
+--
+-- Table structure for `ledger_balances`
+-- Current balance and per-type totals of every ledger account
+--
+DROP TABLE IF EXISTS `ledger_balances`;
+CREATE TABLE `ledger_balances` (
+    `mess_id` INT NOT NULL,
+    `user_id` INT NOT NULL,
+    `balance` DECIMAL(12, 2) NOT NULL DEFAULT 0,
+    `total_payments` DECIMAL(12, 2) NOT NULL DEFAULT 0,
+    `total_shopping` DECIMAL(12, 2) NOT NULL DEFAULT 0,
+    `total_meal_cost` DECIMAL(12, 2) NOT NULL DEFAULT 0,
+    `entry_count` INT NOT NULL DEFAULT 0,
+    PRIMARY KEY (`mess_id`, `user_id`),
+    CONSTRAINT `fk_ledger_balances_mess` FOREIGN KEY (`mess_id`) REFERENCES `messes` (`id`) ON DELETE RESTRICT ON UPDATE CASCADE
 ) ENGINE = InnoDB;
 
 --
@@ -114,12 +300,45 @@ CREATE TABLE `payments` (
 --
 DROP TABLE IF EXISTS `settings`;
 CREATE TABLE `settings` (
-    `id` INT NOT NULL,
+    `mess_id` INT NOT NULL,
     `currency` VARCHAR(10) NOT NULL DEFAULT 'USD',
-    PRIMARY KEY (`id`)
+    PRIMARY KEY (`mess_id`),
+    CONSTRAINT `fk_settings_mess` FOREIGN KEY (`mess_id`) REFERENCES `messes` (`id`) ON DELETE CASCADE ON UPDATE CASCADE
 ) ENGINE = InnoDB;
 
--- Default settings record
-INSERT INTO `settings` (`id`, `currency`) VALUES (1, 'USD');
+-- Default settings record for the default mess
+INSERT INTO `settings` (`mess_id`, `currency`) VALUES (1, 'USD');
+
+--
+-- Table structure for `schema_version`
+-- One row per migration applied by the migration runner (see include/migration.h).
+-- A row with a NULL checksum is a baseline: this file already includes every
+-- migration up to that version. Bump it whenever a migration is added.
+--
+DROP TABLE IF EXISTS `schema_version`;
+CREATE TABLE `schema_version` (
+    `version` INT NOT NULL,
+    `name` VARCHAR(255) NOT NULL,
+    `checksum` CHAR(64) NULL DEFAULT NULL,
+    `applied_at` DATETIME NOT NULL DEFAULT CURRENT_TIMESTAMP,
+    `execution_ms` INT NOT NULL DEFAULT 0,
+    PRIMARY KEY (`version`)
+) ENGINE = InnoDB;
+
+INSERT INTO `schema_version` (`version`, `name`) VALUES (10, 'baseline schema.sql');
+
+--
+-- Table structure for `schema_migration_progress`
+-- Statements already run from a migration that failed part-way, so the next
+-- run resumes after them. Empty unless a migration is half applied.
+--
+DROP TABLE IF EXISTS `schema_migration_progress`;
+CREATE TABLE `schema_migration_progress` (
+    `version` INT NOT NULL,
+    `checksum` CHAR(64) NOT NULL,
+    `statements_done` INT NOT NULL,
+    `updated_at` DATETIME NOT NULL DEFAULT CURRENT_TIMESTAMP ON UPDATE CURRENT_TIMESTAMP,
+    PRIMARY KEY (`version`)
+) ENGINE = InnoDB;
 
 SET FOREIGN_KEY_CHECKS = 1;
\ No newline at end of file
@@ -1,26 +1,133 @@
 #include "attendance.h"
 #include "user.h"
 #include "database.h"
+#include "forecast.h"
+#include "menuanalytics.h"
+#include "dateutil.h"
+#include "journal.h"
+#include "mess.h"
+#include "period.h"
+#include "logger.h"
+#include "slowquery.h"
 #include <cppconn/prepared_statement.h>
 #include <cppconn/resultset.h>
-#include <iostream>
+#include <algorithm>
+#include <bitset>
+#include <set>
+#include <utility>
+
+AttendanceMatrix::AttendanceMatrix(std::vector<std::string> dates)
+    : days(std::move(dates)) {
+    if (!days.empty()) parseIsoDate(days.front(), firstDay);
+}
+
+void AttendanceMatrix::addUser(int userId, const std::string& name) {
+    userIds.push_back(userId);
+    userNames.push_back(name);
+    bits.resize((userIds.size() * days.size() * MEALS_PER_DAY + 63) / 64, 0);
+}
+
+size_t AttendanceMatrix::userIndex(int userId) const {
+    for (size_t i = 0; i < userIds.size(); ++i) {
+        if (userIds[i] == userId) return i;
+    }
+    return npos;
+}
+
+size_t AttendanceMatrix::dayIndex(const std::string& date) const {
+    int day;
+    if (days.empty() || !parseIsoDate(date, day) || day < firstDay) return npos;
+    size_t index = static_cast<size_t>(day - firstDay);
+    return index < days.size() ? index : npos;
+}
+
+bool AttendanceMatrix::attended(size_t user, size_t day, int meal) const {
+    size_t bit = bitIndex(user, day, meal);
+    return (bits[bit / 64] >> (bit % 64)) & 1;
+}
+
+void AttendanceMatrix::set(size_t user, size_t day, int meal, bool value) {
+    size_t bit = bitIndex(user, day, meal);
+    uint64_t mask = uint64_t(1) << (bit % 64);
+    if (value) {
+        bits[bit / 64] |= mask;
+    } else {
+        bits[bit / 64] &= ~mask;
+    }
+}
+
+size_t AttendanceMatrix::mealsForUser(size_t user) const {
+    // The user's bits are one contiguous run; count whole words where possible.
+    size_t begin = bitIndex(user, 0, 0);
+    size_t end = begin + days.size() * MEALS_PER_DAY;
+    size_t count = 0;
+    while (begin < end) {
+        size_t offset = begin % 64;
+        size_t take = std::min<size_t>(64 - offset, end - begin);
+        uint64_t word = bits[begin / 64] >> offset;
+        if (take < 64) word &= (uint64_t(1) << take) - 1;
+        count += std::bitset<64>(word).count();
+        begin += take;
+    }
+    return count;
+}
+
+size_t AttendanceMatrix::mealsOnDay(size_t day, int meal) const {
+    size_t count = 0;
+    for (size_t user = 0; user < userIds.size(); ++user) {
+        if (attended(user, day, meal)) ++count;
+    }
+    return count;
+}
+
+int AttendanceMatrix::mealIndex(const std::string& mealType) {
+    if (mealType == "Breakfast") return 0;
+    if (mealType == "Lunch") return 1;
+    if (mealType == "Dinner") return 2;
+    return -1;
+}
+
+const char* AttendanceMatrix::mealName(int meal) {
+    static const char* const names[MEALS_PER_DAY] = {"Breakfast", "Lunch", "Dinner"};
+    return names[meal];
+}
 
 bool recordAttendance(int user_id, const std::string& date, const std::string& meal_type) {
     try {
         std::unique_ptr<sql::Connection> con(getConnection());
-        std::unique_ptr<sql::PreparedStatement> pstmt(
-            con->prepareStatement("INSERT INTO meal_attendance (user_id, attendance_date, meal_type) VALUES (?, STR_TO_DATE(?, '%Y-%m-%d'), ?)")
+        con->setAutoCommit(false); // Closing the connection on error rolls the insert back
+        int messId = currentMessId();
+        lockOpenPeriods(*con, messId, {date});
+        lockMessMembers(*con, messId, {user_id});
+        std::unique_ptr<TracedStatement> pstmt(
+            prepareTraced(*con, "recordAttendance", "INSERT INTO meal_attendance (mess_id, user_id, attendance_date, meal_type) VALUES (?, ?, STR_TO_DATE(?, '%Y-%m-%d'), ?)")
         );
-        pstmt->setInt(1, user_id);
-        pstmt->setString(2, date);
-        pstmt->setString(3, meal_type);
+        pstmt->setInt(1, messId);
+        pstmt->setInt(2, user_id);
+        pstmt->setString(3, date);
+        pstmt->setString(4, meal_type);
         pstmt->execute();
+        refreshMealHeadcounts(*con, messId, {date});
+        con->commit();
+        noteWrite();
+        invalidateDishAnalytics();
         return true;
     } catch (sql::SQLException& e) {
         if (e.getErrorCode() == 1062) { // ER_DUP_ENTRY
-            std::cerr << "Error: Attendance for this user and meal has already been recorded." << std::endl;
+            logEvent(LogLevel::Error, "recordAttendance", "Attendance for this user and meal has already been recorded");
+        } else if (isConnectionError(e)) {
+            JournalRecord record;
+            record.type = JournalRecordType::Attendance;
+            record.mess_id = currentMessId();
+            record.user_id = user_id;
+            record.date = date;
+            record.meal_type = meal_type;
+            if (appendToJournal(record)) {
+                logEvent(LogLevel::Warning, "recordAttendance", "Database unreachable; attendance saved to the offline journal");
+                return true;
+            }
         } else {
-            std::cerr << "SQL Error in recordAttendance: " << e.what() << std::endl;
+            logSqlError("recordAttendance", e);
         }
         return false;
     }
@@ -31,16 +138,17 @@ std::vector<MealAttendance> getAttendanceForDate(const std::string& date) {
     std::vector<MealAttendance> attendanceList;
     try {
         std::unique_ptr<sql::Connection> con(getConnection());
-        std::unique_ptr<sql::PreparedStatement> pstmt(
-            con->prepareStatement(
+        std::unique_ptr<TracedStatement> pstmt(
+            prepareTraced(*con, "getAttendanceForDate",
                 "SELECT ma.user_id, ma.meal_type, u.name AS user_name "
                 "FROM meal_attendance ma "
                 "JOIN users u ON ma.user_id = u.id "
-                "WHERE ma.attendance_date = STR_TO_DATE(?, '%Y-%m-%d') "
+                "WHERE ma.mess_id = ? AND ma.attendance_date = STR_TO_DATE(?, '%Y-%m-%d') "
                 "ORDER BY ma.meal_type, u.name"
             )
         );
-        pstmt->setString(1, date);
+        pstmt->setInt(1, currentMessId());
+        pstmt->setString(2, date);
 
         std::unique_ptr<sql::ResultSet> res(pstmt->executeQuery());
 
@@ -52,20 +160,76 @@ std::vector<MealAttendance> getAttendanceForDate(const std::string& date) {
             attendanceList.push_back(attendance);
         }
     } catch (sql::SQLException& e) {
-        std::cerr << "SQL Error in getAttendanceForDate: " << e.what() << std::endl;
+        logSqlError("getAttendanceForDate", e);
     }
     return attendanceList;
 }
 
+AttendanceMatrix getAttendanceRange(const std::string& startDate, const std::string& endDate) {
+    int firstDay, lastDay;
+    if (!parseIsoDate(startDate, firstDay) || !parseIsoDate(endDate, lastDay) || lastDay < firstDay) {
+        logEvent(LogLevel::Error, "getAttendanceRange", "Invalid attendance range", {{"start_date", startDate}, {"end_date", endDate}});
+        return AttendanceMatrix();
+    }
+    std::vector<std::string> dates;
+    for (int day = firstDay; day <= lastDay; ++day) {
+        dates.push_back(formatIsoDate(day));
+    }
+    AttendanceMatrix matrix(std::move(dates));
+
+    try {
+        std::unique_ptr<sql::Connection> con(getReadConnection());
+        // Users with no attendance in the range still get a row (ma.* is NULL).
+        // Ordering by user means each user's rows arrive together, so rows are appended as they stream.
+        std::unique_ptr<TracedStatement> pstmt(prepareTraced(*con, "getAttendanceRange",
+            "SELECT u.id, u.name, DATE_FORMAT(ma.attendance_date, '%Y-%m-%d') AS attendance_date, ma.meal_type "
+            "FROM users u "
+            "LEFT JOIN meal_attendance ma ON ma.user_id = u.id AND ma.mess_id = u.mess_id "
+            "  AND ma.attendance_date BETWEEN STR_TO_DATE(?, '%Y-%m-%d') AND STR_TO_DATE(?, '%Y-%m-%d') "
+            "WHERE u.mess_id = ? "
+            "ORDER BY u.name, u.id, ma.attendance_date"
+        ));
+        pstmt->setString(1, startDate);
+        pstmt->setString(2, endDate);
+        pstmt->setInt(3, currentMessId());
+        std::unique_ptr<sql::ResultSet> res(pstmt->executeQuery());
+
+        while (res->next()) {
+            int userId = res->getInt("id");
+            if (matrix.userCount() == 0 || matrix.userId(matrix.userCount() - 1) != userId) {
+                matrix.addUser(userId, res->getString("name"));
+            }
+            if (res->isNull("attendance_date")) continue;
+            size_t day = matrix.dayIndex(res->getString("attendance_date"));
+            int meal = AttendanceMatrix::mealIndex(res->getString("meal_type"));
+            if (day != AttendanceMatrix::npos && meal >= 0) {
+                matrix.set(matrix.userCount() - 1, day, meal, true);
+            }
+        }
+    } catch (sql::SQLException& e) {
+        logSqlError("getAttendanceRange", e);
+        return AttendanceMatrix();
+    }
+    return matrix;
+}
+
 bool addMultipleAttendance(const std::string& date, const std::vector<AttendanceRecord>& records) {
     if (records.empty()) {
         return true;
     }
     try {
         std::unique_ptr<sql::Connection> con(getConnection());
-        std::string query = "INSERT INTO meal_attendance (user_id, attendance_date, meal_type) VALUES ";
+        con->setAutoCommit(false); // Closing the connection on error rolls the insert back
+        int messId = currentMessId();
+        lockOpenPeriods(*con, messId, {date});
+        std::vector<int> userIds;
+        for (const auto& record : records) {
+            userIds.push_back(record.user_id);
+        }
+        lockMessMembers(*con, messId, userIds);
+        std::string query = "INSERT INTO meal_attendance (mess_id, user_id, attendance_date, meal_type) VALUES ";
         for (size_t i = 0; i < records.size(); ++i) {
-            query += "(?, STR_TO_DATE(?, '%Y-%m-%d'), ?)";
+            query += "(?, ?, STR_TO_DATE(?, '%Y-%m-%d'), ?)";
             if (i < records.size() - 1) {
                 query += ", ";
             }
@@ -73,17 +237,38 @@ bool addMultipleAttendance(const std::string& date, const std::vector<Attendance
         // Add ON DUPLICATE KEY UPDATE to ignore errors if a record already exists
         query += " ON DUPLICATE KEY UPDATE user_id=user_id";
 
-        std::unique_ptr<sql::PreparedStatement> pstmt(con->prepareStatement(query));
+        std::unique_ptr<TracedStatement> pstmt(prepareTraced(*con, "addMultipleAttendance", query));
         int paramIndex = 1;
         for (const auto& record : records) {
+            pstmt->setInt(paramIndex++, messId);
             pstmt->setInt(paramIndex++, record.user_id);
             pstmt->setString(paramIndex++, date);
             pstmt->setString(paramIndex++, record.meal_type);
         }
         pstmt->execute();
+        refreshMealHeadcounts(*con, messId, {date});
+        con->commit();
+        noteWrite();
+        invalidateDishAnalytics();
         return true;
     } catch (sql::SQLException& e) {
-        std::cerr << "SQL Error in addMultipleAttendance: " << e.what() << std::endl;
+        if (isConnectionError(e)) {
+            bool journaled = true;
+            for (const auto& entry : records) {
+                JournalRecord record;
+                record.type = JournalRecordType::Attendance;
+                record.mess_id = currentMessId();
+                record.user_id = entry.user_id;
+                record.date = date;
+                record.meal_type = entry.meal_type;
+                journaled = appendToJournal(record) && journaled;
+            }
+            if (journaled) {
+                logEvent(LogLevel::Warning, "addMultipleAttendance", "Database unreachable; attendance saved to the offline journal", {{"count", records.size()}});
+                return true;
+            }
+        }
+        logSqlError("addMultipleAttendance", e);
         return false;
     }
 }
@@ -94,25 +279,119 @@ bool deleteMultipleAttendance(const std::string& date, const std::vector<Attenda
     }
     try {
         std::unique_ptr<sql::Connection> con(getConnection());
+        con->setAutoCommit(false); // Closing the connection on error rolls the delete back
+        int messId = currentMessId();
+        lockOpenPeriods(*con, messId, {date});
         // Build a query like: DELETE FROM ... WHERE (user_id, meal_type) IN ((?,?), (?,?)) AND attendance_date = ?
         std::string query = "DELETE FROM meal_attendance WHERE (user_id, meal_type) IN (";
         for (size_t i = 0; i < records.size(); ++i) {
             query += "(?, ?)";
             if (i < records.size() - 1) query += ",";
         }
-        query += ") AND attendance_date = STR_TO_DATE(?, '%Y-%m-%d')";
+        query += ") AND mess_id = ? AND attendance_date = STR_TO_DATE(?, '%Y-%m-%d')";
 
-        std::unique_ptr<sql::PreparedStatement> pstmt(con->prepareStatement(query));
+        std::unique_ptr<TracedStatement> pstmt(prepareTraced(*con, "deleteMultipleAttendance", query));
         int paramIndex = 1;
         for (const auto& record : records) {
             pstmt->setInt(paramIndex++, record.user_id);
             pstmt->setString(paramIndex++, record.meal_type);
         }
+        pstmt->setInt(paramIndex++, messId);
         pstmt->setString(paramIndex, date);
         pstmt->executeUpdate();
+        refreshMealHeadcounts(*con, messId, {date});
+        con->commit();
+        noteWrite();
+        invalidateDishAnalytics();
+        return true;
+    } catch (sql::SQLException& e) {
+        logSqlError("deleteMultipleAttendance", e);
+        return false;
+    }
+}
+bool applyAttendanceChanges(const std::vector<AttendanceChange>& changes) {
+    if (changes.empty()) {
+        return true;
+    }
+    // Rows per statement, keeping the placeholders well under MySQL's 65,535 limit
+    const size_t CHUNK_SIZE = 1000;
+
+    std::vector<const AttendanceChange*> additions, removals;
+    std::set<std::string> dates;
+    for (const auto& change : changes) {
+        (change.attended ? additions : removals).push_back(&change);
+        dates.insert(change.date);
+    }
+
+    std::unique_ptr<sql::Connection> con;
+    try {
+        con = getConnection();
+        con->setAutoCommit(false); // Start transaction
+        int messId = currentMessId();
+        lockOpenPeriods(*con, messId, std::vector<std::string>(dates.begin(), dates.end()));
+        std::vector<int> userIds;
+        for (const AttendanceChange* change : additions) {
+            userIds.push_back(change->user_id);
+        }
+        lockMessMembers(*con, messId, userIds);
+
+        for (size_t begin = 0; begin < additions.size(); begin += CHUNK_SIZE) {
+            size_t end = std::min(additions.size(), begin + CHUNK_SIZE);
+            std::string query = "INSERT INTO meal_attendance (mess_id, user_id, attendance_date, meal_type) VALUES ";
+            for (size_t i = begin; i < end; ++i) {
+                query += "(?, ?, STR_TO_DATE(?, '%Y-%m-%d'), ?)";
+                if (i < end - 1) query += ", ";
+            }
+            query += " ON DUPLICATE KEY UPDATE user_id = user_id";
+
+            std::unique_ptr<TracedStatement> pstmt(prepareTraced(*con, "applyAttendanceChanges", query));
+            int paramIndex = 1;
+            for (size_t i = begin; i < end; ++i) {
+                pstmt->setInt(paramIndex++, messId);
+                pstmt->setInt(paramIndex++, additions[i]->user_id);
+                pstmt->setString(paramIndex++, additions[i]->date);
+                pstmt->setString(paramIndex++, additions[i]->meal_type);
+            }
+            pstmt->executeUpdate();
+        }
+
+        for (size_t begin = 0; begin < removals.size(); begin += CHUNK_SIZE) {
+            size_t end = std::min(removals.size(), begin + CHUNK_SIZE);
+            std::string query = "DELETE FROM meal_attendance WHERE mess_id = ? AND (user_id, attendance_date, meal_type) IN (";
+            for (size_t i = begin; i < end; ++i) {
+                query += "(?, STR_TO_DATE(?, '%Y-%m-%d'), ?)";
+                if (i < end - 1) query += ", ";
+            }
+            query += ")";
+
+            std::unique_ptr<TracedStatement> pstmt(prepareTraced(*con, "applyAttendanceChanges", query));
+            int paramIndex = 1;
+            pstmt->setInt(paramIndex++, messId);
+            for (size_t i = begin; i < end; ++i) {
+                pstmt->setInt(paramIndex++, removals[i]->user_id);
+                pstmt->setString(paramIndex++, removals[i]->date);
+                pstmt->setString(paramIndex++, removals[i]->meal_type);
+            }
+            pstmt->executeUpdate();
+        }
+
+        refreshMealHeadcounts(*con, messId, std::vector<std::string>(dates.begin(), dates.end()));
+
+        con->commit();
+        noteWrite();
+        invalidateDishAnalytics();
+        con->setAutoCommit(true);
         return true;
     } catch (sql::SQLException& e) {
-        std::cerr << "SQL Error in deleteMultipleAttendance: " << e.what() << std::endl;
+        logSqlError("applyAttendanceChanges", e);
+        if (con) {
+            try {
+                con->rollback();
+                con->setAutoCommit(true);
+            } catch (sql::SQLException& ex) {
+                logSqlError("applyAttendanceChanges", ex, {{"during", "rollback"}});
+            }
+        }
         return false;
     }
-}
\ No newline at end of file
+}
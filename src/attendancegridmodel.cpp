@@ -0,0 +1,154 @@
+#include "attendancegridmodel.h"
+#include <QBrush>
+#include <QColor>
+#include <QDate>
+
+AttendanceGridModel::AttendanceGridModel(QObject *parent)
+    : QAbstractTableModel(parent)
+{
+}
+
+void AttendanceGridModel::setMatrix(AttendanceMatrix matrix)
+{
+    beginResetModel();
+    saved = std::move(matrix);
+    edited = saved;
+    pendingCount = 0;
+
+    // Two-line headers such as "Mon 03" / "B", built once rather than on every paint
+    columnHeaders.clear();
+    for (size_t day = 0; day < saved.dayCount(); ++day) {
+        QDate date = QDate::fromString(QString::fromStdString(saved.date(day)), "yyyy-MM-dd");
+        for (int meal = 0; meal < AttendanceMatrix::MEALS_PER_DAY; ++meal) {
+            columnHeaders << date.toString("ddd dd") + "\n" + QChar(AttendanceMatrix::mealName(meal)[0]);
+        }
+    }
+    endResetModel();
+    emit pendingChangeCountChanged(pendingCount);
+}
+
+int AttendanceGridModel::rowCount(const QModelIndex &parent) const
+{
+    return parent.isValid() ? 0 : static_cast<int>(edited.userCount());
+}
+
+int AttendanceGridModel::columnCount(const QModelIndex &parent) const
+{
+    return parent.isValid() ? 0 : static_cast<int>(edited.dayCount()) * AttendanceMatrix::MEALS_PER_DAY;
+}
+
+QVariant AttendanceGridModel::data(const QModelIndex &index, int role) const
+{
+    if (!index.isValid()) return QVariant();
+    size_t user = index.row();
+    size_t day = index.column() / AttendanceMatrix::MEALS_PER_DAY;
+    int meal = index.column() % AttendanceMatrix::MEALS_PER_DAY;
+
+    switch (role) {
+    case Qt::CheckStateRole:
+        return edited.attended(user, day, meal) ? Qt::Checked : Qt::Unchecked;
+    case Qt::BackgroundRole:
+        if (edited.attended(user, day, meal) != saved.attended(user, day, meal)) {
+            return QBrush(QColor(255, 236, 179)); // Unsaved change
+        }
+        return QVariant();
+    case Qt::ToolTipRole:
+        return QString("%1, %2 %3").arg(QString::fromStdString(edited.userName(user)),
+                                        QString::fromStdString(edited.date(day)),
+                                        AttendanceMatrix::mealName(meal));
+    default:
+        return QVariant();
+    }
+}
+
+bool AttendanceGridModel::setData(const QModelIndex &index, const QVariant &value, int role)
+{
+    if (!index.isValid() || role != Qt::CheckStateRole) return false;
+    bool checked = static_cast<Qt::CheckState>(value.toInt()) == Qt::Checked;
+    if (setCell(index.row(), index.column() / AttendanceMatrix::MEALS_PER_DAY,
+                index.column() % AttendanceMatrix::MEALS_PER_DAY, checked)) {
+        emit dataChanged(index, index, {Qt::CheckStateRole, Qt::BackgroundRole});
+        emit pendingChangeCountChanged(pendingCount);
+    }
+    return true;
+}
+
+QVariant AttendanceGridModel::headerData(int section, Qt::Orientation orientation, int role) const
+{
+    if (orientation == Qt::Vertical) {
+        if (role == Qt::DisplayRole && section < rowCount()) {
+            return QString::fromStdString(edited.userName(section));
+        }
+        return QVariant();
+    }
+    if (section >= columnHeaders.size()) return QVariant();
+    if (role == Qt::DisplayRole) {
+        return columnHeaders[section];
+    }
+    if (role == Qt::ToolTipRole) {
+        return QString("%1 %2 (click to toggle the column)")
+            .arg(QString::fromStdString(edited.date(section / AttendanceMatrix::MEALS_PER_DAY)),
+                 AttendanceMatrix::mealName(section % AttendanceMatrix::MEALS_PER_DAY));
+    }
+    return QVariant();
+}
+
+Qt::ItemFlags AttendanceGridModel::flags(const QModelIndex &index) const
+{
+    if (!index.isValid()) return Qt::NoItemFlags;
+    return Qt::ItemIsEnabled | Qt::ItemIsUserCheckable;
+}
+
+void AttendanceGridModel::toggleColumn(int column)
+{
+    if (column < 0 || column >= columnCount() || rowCount() == 0) return;
+    size_t day = column / AttendanceMatrix::MEALS_PER_DAY;
+    int meal = column % AttendanceMatrix::MEALS_PER_DAY;
+
+    bool allChecked = edited.mealsOnDay(day, meal) == edited.userCount();
+    for (size_t user = 0; user < edited.userCount(); ++user) {
+        setCell(user, day, meal, !allChecked);
+    }
+    emit dataChanged(index(0, column), index(rowCount() - 1, column), {Qt::CheckStateRole, Qt::BackgroundRole});
+    emit pendingChangeCountChanged(pendingCount);
+}
+
+void AttendanceGridModel::toggleRow(int row)
+{
+    if (row < 0 || row >= rowCount() || columnCount() == 0) return;
+    size_t user = row;
+
+    bool allChecked = edited.mealsForUser(user) == edited.dayCount() * AttendanceMatrix::MEALS_PER_DAY;
+    for (size_t day = 0; day < edited.dayCount(); ++day) {
+        for (int meal = 0; meal < AttendanceMatrix::MEALS_PER_DAY; ++meal) {
+            setCell(user, day, meal, !allChecked);
+        }
+    }
+    emit dataChanged(index(row, 0), index(row, columnCount() - 1), {Qt::CheckStateRole, Qt::BackgroundRole});
+    emit pendingChangeCountChanged(pendingCount);
+}
+
+std::vector<AttendanceChange> AttendanceGridModel::pendingChanges() const
+{
+    std::vector<AttendanceChange> changes;
+    changes.reserve(pendingCount);
+    for (size_t user = 0; user < edited.userCount(); ++user) {
+        for (size_t day = 0; day < edited.dayCount(); ++day) {
+            for (int meal = 0; meal < AttendanceMatrix::MEALS_PER_DAY; ++meal) {
+                bool attended = edited.attended(user, day, meal);
+                if (attended != saved.attended(user, day, meal)) {
+                    changes.push_back({edited.userId(user), edited.date(day), AttendanceMatrix::mealName(meal), attended});
+                }
+            }
+        }
+    }
+    return changes;
+}
+
+bool AttendanceGridModel::setCell(size_t user, size_t day, int meal, bool value)
+{
+    if (edited.attended(user, day, meal) == value) return false;
+    edited.set(user, day, meal, value);
+    pendingCount += value != saved.attended(user, day, meal) ? 1 : -1;
+    return true;
+}
@@ -0,0 +1,156 @@
+#include "batchpaymentdialog.h"
+#include "user.h"
+#include "stallwatchdog.h"
+#include <QVBoxLayout>
+#include <QHBoxLayout>
+#include <QPlainTextEdit>
+#include <QTableWidget>
+#include <QPushButton>
+#include <QHeaderView>
+#include <QMessageBox>
+#include <QDateEdit>
+#include <QLabel>
+#include <QRegularExpression>
+
+BatchPaymentDialog::BatchPaymentDialog(QWidget *parent)
+    : QDialog(parent)
+{
+    setWindowTitle("Batch Payments");
+    auto mainLayout = new QVBoxLayout(this);
+
+    // Load the user directory once; every row is checked against it
+    for (const auto& user : getAllUsers()) {
+        namesById.insert(user.id, QString::fromStdString(user.name));
+        idsByUsername.insert(QString::fromStdString(user.username).toLower(), user.id);
+    }
+
+    mainLayout->addWidget(new QLabel(
+        "Paste one payment per line: user ID or username, amount and an optional date (YYYY-MM-DD),\n"
+        "separated by tabs, commas or semicolons. Rows can be copied straight from a spreadsheet.", this));
+
+    rowsTextEdit = new QPlainTextEdit(this);
+    rowsTextEdit->setPlaceholderText("12\t1500.00\t2024-03-01\nalice, 1500");
+    mainLayout->addWidget(rowsTextEdit);
+
+    auto optionsLayout = new QHBoxLayout();
+    optionsLayout->addWidget(new QLabel("Date for rows without one:"));
+    defaultDateEdit = new QDateEdit(QDate::currentDate(), this);
+    defaultDateEdit->setCalendarPopup(true);
+    defaultDateEdit->setDisplayFormat("yyyy-MM-dd");
+    optionsLayout->addWidget(defaultDateEdit);
+    optionsLayout->addStretch();
+    auto checkButton = new QPushButton("Check Rows", this);
+    optionsLayout->addWidget(checkButton);
+    mainLayout->addLayout(optionsLayout);
+
+    // Preview of the parsed rows, with the problem for each rejected one
+    previewTable = new QTableWidget(this);
+    previewTable->setColumnCount(5);
+    previewTable->setHorizontalHeaderLabels({"Line", "User", "Amount", "Date", "Status"});
+    previewTable->horizontalHeader()->setStretchLastSection(true);
+    previewTable->setEditTriggers(QAbstractItemView::NoEditTriggers);
+    previewTable->verticalHeader()->setVisible(false);
+    mainLayout->addWidget(previewTable);
+
+    summaryLabel = new QLabel(this);
+    mainLayout->addWidget(summaryLabel);
+
+    auto buttonLayout = new QHBoxLayout();
+    buttonLayout->addStretch();
+    recordButton = new QPushButton("Record Payments", this);
+    recordButton->setEnabled(false);
+    buttonLayout->addWidget(recordButton);
+    auto cancelButton = new QPushButton("Cancel", this);
+    buttonLayout->addWidget(cancelButton);
+    mainLayout->addLayout(buttonLayout);
+
+    // Connections; any edit invalidates the last check
+    connect(checkButton, &QPushButton::clicked, this, &BatchPaymentDialog::checkRows);
+    connect(recordButton, &QPushButton::clicked, this, &BatchPaymentDialog::recordClicked);
+    connect(cancelButton, &QPushButton::clicked, this, &QDialog::reject);
+    connect(rowsTextEdit, &QPlainTextEdit::textChanged, this, [this]() { recordButton->setEnabled(false); });
+    connect(defaultDateEdit, &QDateEdit::dateChanged, this, [this]() { recordButton->setEnabled(false); });
+
+    resize(640, 560);
+    setLayout(mainLayout);
+}
+
+void BatchPaymentDialog::checkRows()
+{
+    payments.clear();
+    previewTable->setRowCount(0); // Clear existing rows
+
+    static const QRegularExpression separators("[\\t,;]");
+    QString defaultDate = defaultDateEdit->date().toString("yyyy-MM-dd");
+    QStringList lines = rowsTextEdit->toPlainText().split('\n');
+    int errors = 0;
+    double total = 0.0;
+
+    for (int lineNumber = 1; lineNumber <= lines.size(); ++lineNumber) {
+        QString line = lines[lineNumber - 1].trimmed();
+        if (line.isEmpty()) continue;
+        QStringList fields = line.split(separators);
+        for (auto& field : fields) field = field.trimmed();
+
+        QString error;
+        int userId = 0;
+        double amount = 0.0;
+        QString date = defaultDate;
+        if (fields.size() < 2 || fields.size() > 3) {
+            error = "Expected user, amount and an optional date";
+        } else {
+            bool isId = false;
+            userId = fields[0].toInt(&isId);
+            if (!isId) userId = idsByUsername.value(fields[0].toLower(), 0);
+            bool validAmount = false;
+            amount = fields[1].toDouble(&validAmount);
+            if (fields.size() == 3 && !fields[2].isEmpty()) date = fields[2];
+
+            if (!namesById.contains(userId)) {
+                error = "Unknown user";
+            } else if (!validAmount || amount < 0.01 || amount > 1000000.00) {
+                error = "Invalid amount";
+            } else if (!QDate::fromString(date, "yyyy-MM-dd").isValid()) {
+                error = "Invalid date";
+            }
+        }
+
+        int row = previewTable->rowCount();
+        previewTable->insertRow(row);
+        previewTable->setItem(row, 0, new QTableWidgetItem(QString::number(lineNumber)));
+        previewTable->setItem(row, 1, new QTableWidgetItem(namesById.contains(userId) ? namesById.value(userId) : fields.value(0)));
+        previewTable->setItem(row, 2, new QTableWidgetItem(fields.value(1)));
+        previewTable->setItem(row, 3, new QTableWidgetItem(date));
+        previewTable->setItem(row, 4, new QTableWidgetItem(error.isEmpty() ? "OK" : error));
+
+        if (error.isEmpty()) {
+            payments.push_back({userId, amount, date.toStdString()});
+            total += amount;
+        } else {
+            previewTable->item(row, 4)->setForeground(Qt::red);
+            ++errors;
+        }
+    }
+
+    if (errors > 0) {
+        summaryLabel->setText(QString("%1 of %2 rows have errors. Fix them and check again.")
+            .arg(errors).arg(previewTable->rowCount()));
+        payments.clear();
+    } else {
+        summaryLabel->setText(QString("%1 payments totalling %2 ready to record.")
+            .arg(payments.size()).arg(total, 0, 'f', 2));
+    }
+    recordButton->setEnabled(errors == 0 && !payments.empty());
+}
+
+void BatchPaymentDialog::recordClicked()
+{
+    StallActivity activity("BatchPaymentDialog::recordClicked");
+    if (recordPayments(payments)) {
+        QMessageBox::information(this, "Success", QString("%1 payments recorded.").arg(payments.size()));
+        accept();
+    } else {
+        QMessageBox::critical(this, "Error",
+            "Failed to record the payments; none were saved. A date in a closed period is a common cause. Please check the logs.");
+    }
+}
@@ -0,0 +1,36 @@
+#include "checksum.h"
+#include <array>
+#include <openssl/evp.h>
+#include <stdexcept>
+
+uint32_t crc32(const char* data, size_t size) {
+    static const std::array<uint32_t, 256> table = [] {
+        std::array<uint32_t, 256> t{};
+        for (uint32_t i = 0; i < 256; ++i) {
+            uint32_t c = i;
+            for (int k = 0; k < 8; ++k) c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+            t[i] = c;
+        }
+        return t;
+    }();
+    uint32_t crc = 0xFFFFFFFFu;
+    for (size_t i = 0; i < size; ++i) {
+        crc = table[(crc ^ static_cast<unsigned char>(data[i])) & 0xFF] ^ (crc >> 8);
+    }
+    return crc ^ 0xFFFFFFFFu;
+}
+
+std::string sha256Hex(const std::string& data) {
+    unsigned char hash[EVP_MAX_MD_SIZE];
+    unsigned int length = 0;
+    if (EVP_Digest(data.data(), data.size(), hash, &length, EVP_sha256(), nullptr) != 1) {
+        throw std::runtime_error("SHA-256 digest failed.");
+    }
+    static const char* hex = "0123456789abcdef";
+    std::string digest;
+    for (unsigned int i = 0; i < length; ++i) {
+        digest += hex[hash[i] >> 4];
+        digest += hex[hash[i] & 0x0F];
+    }
+    return digest;
+}
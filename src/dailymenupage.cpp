@@ -1,4 +1,5 @@
 #include "dailymenupage.h"
+#include <QShowEvent>
 #include <QVBoxLayout>
 #include <QHBoxLayout>
 #include <QDateEdit>
@@ -6,7 +7,13 @@
 #include <QPushButton>
 #include <QMessageBox>
 #include <QLabel>
+#include <QInputDialog>
+#include <QLineEdit>
+#include <set>
 #include "database.h"
+#include "menusearch.h"
+#include "snapshot.h"
+#include "stallwatchdog.h"
 
 DailyMenuPage::DailyMenuPage(QWidget *parent)
     : QWidget(parent)
@@ -35,6 +42,10 @@ DailyMenuPage::DailyMenuPage(QWidget *parent)
     // Available Menu Items
     auto availableLayout = new QVBoxLayout();
     availableLayout->addWidget(new QLabel("Available Menu Items:"));
+    menuItemFilterEdit = new QLineEdit(this);
+    menuItemFilterEdit->setPlaceholderText("Search menu items...");
+    menuItemFilterEdit->setClearButtonEnabled(true);
+    availableLayout->addWidget(menuItemFilterEdit);
     availableMenuItemsList = new QListWidget(this);
     availableLayout->addWidget(availableMenuItemsList);
     contentLayout->addLayout(availableLayout);
@@ -85,8 +96,17 @@ DailyMenuPage::DailyMenuPage(QWidget *parent)
     saveMenuButton = new QPushButton("Save Daily Menu", this);
     mainLayout->addWidget(saveMenuButton);
 
+    // Template actions
+    auto templateLayout = new QHBoxLayout();
+    saveTemplateButton = new QPushButton("Save as Template...", this);
+    applyTemplateButton = new QPushButton("Apply Template...", this);
+    templateLayout->addWidget(saveTemplateButton);
+    templateLayout->addWidget(applyTemplateButton);
+    mainLayout->addLayout(templateLayout);
+
     // Connections
     connect(menuDateEdit, &QDateEdit::dateChanged, this, &DailyMenuPage::loadDailyMenu);
+    connect(menuItemFilterEdit, &QLineEdit::textChanged, this, &DailyMenuPage::filterAvailableMenuItems);
     connect(saveMenuButton, &QPushButton::clicked, this, &DailyMenuPage::saveDailyMenuClicked);
     connect(addBreakfastBtn, &QPushButton::clicked, this, &DailyMenuPage::addBreakfastItem);
     connect(removeBreakfastBtn, &QPushButton::clicked, this, &DailyMenuPage::removeBreakfastItem);
@@ -94,27 +114,70 @@ DailyMenuPage::DailyMenuPage(QWidget *parent)
     connect(removeLunchBtn, &QPushButton::clicked, this, &DailyMenuPage::removeLunchItem);
     connect(addDinnerBtn, &QPushButton::clicked, this, &DailyMenuPage::addDinnerItem);
     connect(removeDinnerBtn, &QPushButton::clicked, this, &DailyMenuPage::removeDinnerItem);
+    connect(saveTemplateButton, &QPushButton::clicked, this, &DailyMenuPage::saveAsTemplateClicked);
+    connect(applyTemplateButton, &QPushButton::clicked, this, &DailyMenuPage::applyTemplateClicked);
 
-    // Initial load
-    loadAvailableMenuItems();
-    loadDailyMenu();
+    // The menu catalog comes from the local snapshot when there is one; the day's menu loads on first show
+    if (auto snapshot = currentReferenceSnapshot()) {
+        applyReferenceSnapshot(*snapshot);
+    }
 
     setLayout(mainLayout);
 }
 
+void DailyMenuPage::showEvent(QShowEvent *event)
+{
+    QWidget::showEvent(event);
+    if (loaded) return;
+    loaded = true;
+    if (!currentReferenceSnapshot()) {
+        loadAvailableMenuItems();
+    }
+    loadDailyMenu();
+}
+
+void DailyMenuPage::applyReferenceSnapshot(const ReferenceSnapshot& snapshot)
+{
+    menuSearchIndex().rebuild(snapshot.menu_items);
+    filterAvailableMenuItems(menuItemFilterEdit->text());
+}
+
 void DailyMenuPage::loadAvailableMenuItems()
 {
+    StallActivity activity("DailyMenuPage::loadAvailableMenuItems");
+    getAllMenuItems(); // Reloads the catalog and resyncs the search index
+    filterAvailableMenuItems(menuItemFilterEdit->text());
+}
+
+void DailyMenuPage::filterAvailableMenuItems(const QString &query)
+{
+    populateAvailableMenuItems(searchMenuItems(query.toStdString()));
+}
+
+void DailyMenuPage::populateAvailableMenuItems(const std::vector<MenuItem>& items)
+{
+    // Dishes already on one of the day's meals are not offered again
+    std::set<int> listedIds;
+    for (QListWidget* mealList : {breakfastList, lunchList, dinnerList}) {
+        for (int id : getMenuItemIds(mealList)) {
+            listedIds.insert(id);
+        }
+    }
+
+    availableMenuItemsList->setUpdatesEnabled(false);
     availableMenuItemsList->clear();
-    std::vector<MenuItem> items = getAllMenuItems();
     for (const auto& item : items) {
+        if (listedIds.count(item.id)) continue;
         QListWidgetItem *listItem = new QListWidgetItem(QString::fromStdString(item.name));
         listItem->setData(Qt::UserRole, item.id); // Store ID in UserRole
         availableMenuItemsList->addItem(listItem);
     }
+    availableMenuItemsList->setUpdatesEnabled(true);
 }
 
 void DailyMenuPage::loadDailyMenu()
 {
+    StallActivity activity("DailyMenuPage::loadDailyMenu");
     breakfastList->clear();
     lunchList->clear();
     dinnerList->clear();
@@ -137,6 +200,7 @@ void DailyMenuPage::loadDailyMenu()
         listItem->setData(Qt::UserRole, item.id);
         dinnerList->addItem(listItem);
     }
+    filterAvailableMenuItems(menuItemFilterEdit->text()); // Drop the day's dishes from the available list
 }
 
 std::vector<int> DailyMenuPage::getMenuItemIds(QListWidget* listWidget)
@@ -150,6 +214,7 @@ std::vector<int> DailyMenuPage::getMenuItemIds(QListWidget* listWidget)
 
 void DailyMenuPage::saveDailyMenuClicked()
 {
+    StallActivity activity("DailyMenuPage::saveDailyMenuClicked");
     QString selectedDate = menuDateEdit->date().toString("yyyy-MM-dd");
     std::vector<int> breakfastIds = getMenuItemIds(breakfastList);
     std::vector<int> lunchIds = getMenuItemIds(lunchList);
@@ -176,9 +241,8 @@ void DailyMenuPage::removeBreakfastItem()
 {
     QListWidgetItem *selectedItem = breakfastList->currentItem();
     if (selectedItem) {
-        QListWidgetItem *newItem = selectedItem->clone();
-        availableMenuItemsList->addItem(newItem);
         delete breakfastList->takeItem(breakfastList->row(selectedItem));
+        filterAvailableMenuItems(menuItemFilterEdit->text()); // Lists it again if it matches the filter
     }
 }
 
@@ -196,9 +260,8 @@ void DailyMenuPage::removeLunchItem()
 {
     QListWidgetItem *selectedItem = lunchList->currentItem();
     if (selectedItem) {
-        QListWidgetItem *newItem = selectedItem->clone();
-        availableMenuItemsList->addItem(newItem);
         delete lunchList->takeItem(lunchList->row(selectedItem));
+        filterAvailableMenuItems(menuItemFilterEdit->text()); // Lists it again if it matches the filter
     }
 }
 
@@ -216,8 +279,77 @@ void DailyMenuPage::removeDinnerItem()
 {
     QListWidgetItem *selectedItem = dinnerList->currentItem();
     if (selectedItem) {
-        QListWidgetItem *newItem = selectedItem->clone();
-        availableMenuItemsList->addItem(newItem);
         delete dinnerList->takeItem(dinnerList->row(selectedItem));
+        filterAvailableMenuItems(menuItemFilterEdit->text()); // Lists it again if it matches the filter
     }
-}
\ No newline at end of file
+}
+
+void DailyMenuPage::saveAsTemplateClicked()
+{
+    StallActivity activity("DailyMenuPage::saveAsTemplateClicked");
+    bool ok;
+    QString name = QInputDialog::getText(this, "Save as Template",
+                                         "Template name:",
+                                         QLineEdit::Normal, QString(), &ok).trimmed();
+    if (!ok) return; // User cancelled
+    if (name.isEmpty()) {
+        QMessageBox::warning(this, "Input Error", "Template name cannot be empty.");
+        return;
+    }
+
+    int cycleDays = QInputDialog::getInt(this, "Save as Template",
+                                         "Number of days in the rotation, starting from the selected date:",
+                                         7, 1, 62, 1, &ok);
+    if (!ok) return;
+
+    QString startDate = menuDateEdit->date().toString("yyyy-MM-dd");
+    if (createMenuTemplateFromRange(name.toStdString(), startDate.toStdString(), cycleDays)) {
+        QMessageBox::information(this, "Success", "Menu template saved successfully.");
+    } else {
+        QMessageBox::critical(this, "Error", "Failed to save menu template. The name might already exist.");
+    }
+}
+
+void DailyMenuPage::applyTemplateClicked()
+{
+    StallActivity activity("DailyMenuPage::applyTemplateClicked");
+    std::vector<MenuTemplate> templates = getAllMenuTemplates();
+    if (templates.empty()) {
+        QMessageBox::information(this, "Apply Template", "No menu templates have been saved yet.");
+        return;
+    }
+
+    QStringList names;
+    for (const auto& tpl : templates) {
+        names << QString("%1 (%2 days)").arg(QString::fromStdString(tpl.name)).arg(tpl.cycle_days);
+    }
+
+    bool ok;
+    QString choice = QInputDialog::getItem(this, "Apply Template",
+                                           "Template:",
+                                           names, 0, false, &ok);
+    if (!ok) return;
+    const MenuTemplate& selected = templates[names.indexOf(choice)];
+
+    int dayCount = QInputDialog::getInt(this, "Apply Template",
+                                        "Number of days to fill, starting from the selected date:",
+                                        30, 1, 366, 1, &ok);
+    if (!ok) return;
+
+    QDate startDate = menuDateEdit->date();
+    QDate endDate = startDate.addDays(dayCount - 1);
+    if (QMessageBox::question(this, "Confirm Apply",
+                              "This replaces all menus from " + startDate.toString("yyyy-MM-dd") +
+                              " to " + endDate.toString("yyyy-MM-dd") + ". Continue?",
+                              QMessageBox::Yes | QMessageBox::No) != QMessageBox::Yes) {
+        return;
+    }
+
+    if (applyMenuTemplate(selected.id, startDate.toString("yyyy-MM-dd").toStdString(),
+                          endDate.toString("yyyy-MM-dd").toStdString())) {
+        QMessageBox::information(this, "Success", "Menu template applied successfully.");
+        loadDailyMenu();
+    } else {
+        QMessageBox::critical(this, "Error", "Failed to apply menu template.");
+    }
+}
@@ -1,5 +1,4 @@
 #include "database.h"
-#include <iostream>
 #include <sstream>
 #include <iomanip>
 #include <openssl/evp.h> // Use modern EVP API for hashing
@@ -8,7 +7,7 @@
 #include <mysql_driver.h> // Include for sql::mysql::get_driver_instance()
 
 #include "database.h"
-#include <iostream>
+#include "logger.h"
 #include <sstream>
 #include <iomanip>
 #include <stdexcept>      // For std::runtime_error
@@ -16,44 +15,212 @@
 #include <openssl/rand.h> // For salt generation
 #include <memory> // For std::unique_ptr
 #include <mysql_driver.h> // Include for sql::mysql::get_driver_instance()
+#include <cppconn/prepared_statement.h>
 #include <QSettings>      // For reading config file
 #include <QFileInfo>      // For checking if config file exists
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <limits>
+#include <mutex>
+#include <vector>
 
-std::unique_ptr<sql::Connection> getConnection() {
-    const QString configFileName = "config.ini";
-    QFileInfo configFile(configFileName);
+namespace { // Anonymous namespace for file-local state
+    std::string configFilePath = "config.ini";
+
+    struct ConnectionSettings {
+        std::string host;
+        std::string user;
+        std::string password;
+        std::string schema;
+    };
+
+    // A [Replicas] host and what we have learned about its health.
+    struct ReplicaEndpoint {
+        std::string host;
+        int consecutiveFailures = 0;
+        std::chrono::steady_clock::time_point retryAt; // Skipped until then after a failure
+    };
 
-    if (!configFile.exists()) {
-        throw std::runtime_error("FATAL: Configuration file 'config.ini' not found. "
-                                 "Please copy 'config.ini.example' to 'config.ini' and fill in your database details.");
+    std::mutex replicaMutex;
+    bool replicasLoaded = false;
+    std::vector<ReplicaEndpoint> replicas;
+    ConnectionSettings replicaSettings; // host is per endpoint
+    size_t nextReplica = 0;
+    long long readYourWritesMs = 5000;
+
+    // Time of the last write by this process, in steady_clock milliseconds.
+    std::atomic<long long> lastWriteMs{std::numeric_limits<long long>::min() / 2};
+
+    long long steadyNowMs() {
+        return std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
     }
 
-    QSettings settings(configFileName, QSettings::IniFormat);
+    QSettings openConfig() {
+        const QString configFileName = QString::fromStdString(configFilePath);
+        QFileInfo configFile(configFileName);
 
-    std::string host = settings.value("Database/host").toString().toStdString();
-    std::string user = settings.value("Database/user").toString().toStdString();
-    std::string password = settings.value("Database/password").toString().toStdString();
-    std::string schema = settings.value("Database/database").toString().toStdString();
+        if (!configFile.exists()) {
+            throw std::runtime_error("FATAL: Configuration file '" + configFilePath + "' not found. "
+                                     "Please copy 'config.ini.example' to 'config.ini' and fill in your database details.");
+        }
+        return QSettings(configFileName, QSettings::IniFormat);
+    }
 
-    if (host.empty() || user.empty() || schema.empty()) {
+    ConnectionSettings readPrimarySettings(const QSettings& settings) {
+        ConnectionSettings primary;
+        primary.host = settings.value("Database/host").toString().toStdString();
+        primary.user = settings.value("Database/user").toString().toStdString();
+        primary.password = settings.value("Database/password").toString().toStdString();
+        primary.schema = settings.value("Database/database").toString().toStdString();
+        return primary;
+    }
+
+    std::unique_ptr<sql::Connection> connectTo(const ConnectionSettings& target) {
+        sql::Driver* driver = sql::mysql::get_driver_instance();
+        std::unique_ptr<sql::Connection> con(driver->connect(target.host, target.user, target.password));
+        con->setSchema(target.schema);
+        return con;
+    }
+
+    // Reads [Replicas] once per config file. Credentials default to [Database]'s.
+    void loadReplicasLocked() {
+        if (replicasLoaded) return;
+        replicas.clear();
+        nextReplica = 0;
+
+        QSettings settings = openConfig();
+        ConnectionSettings primary = readPrimarySettings(settings);
+        replicaSettings.user = settings.value("Replicas/user", QString::fromStdString(primary.user)).toString().toStdString();
+        replicaSettings.password = settings.value("Replicas/password", QString::fromStdString(primary.password)).toString().toStdString();
+        replicaSettings.schema = settings.value("Replicas/database", QString::fromStdString(primary.schema)).toString().toStdString();
+        readYourWritesMs = static_cast<long long>(settings.value("Replicas/read_your_writes_seconds", 5.0).toDouble() * 1000);
+
+        // An unquoted comma-separated value is already split into a list by QSettings.
+        for (const QString& host : settings.value("Replicas/hosts").toStringList()) {
+            QString trimmed = host.trimmed();
+            if (trimmed.isEmpty()) continue;
+            ReplicaEndpoint endpoint;
+            endpoint.host = trimmed.toStdString();
+            replicas.push_back(endpoint);
+        }
+        replicasLoaded = true;
+    }
+} // namespace
+
+void setConfigFilePath(const std::string& path) {
+    configFilePath = path;
+    std::lock_guard<std::mutex> lock(replicaMutex);
+    replicasLoaded = false; // Re-read [Replicas] from the new file
+}
+
+const std::string& getConfigFilePath() {
+    return configFilePath;
+}
+
+std::unique_ptr<sql::Connection> getConnection() {
+    ConnectionSettings primary = readPrimarySettings(openConfig());
+
+    if (primary.host.empty() || primary.user.empty() || primary.schema.empty()) {
         throw std::runtime_error("FATAL: One or more required database settings (host, user, database) are missing from 'config.ini'.");
     }
-     if (password == "your_password") {
-        std::cerr << "WARNING: You are using the default password from 'config.ini.example'. Please change it." << std::endl;
+     if (primary.password == "your_password") {
+        logEvent(LogLevel::Warning, "getConnection", "You are using the default password from 'config.ini.example'. Please change it.");
     }
 
 
     try {
-        sql::Driver* driver = sql::mysql::get_driver_instance();
-        std::unique_ptr<sql::Connection> con(driver->connect(host, user, password));
-        con->setSchema(schema);
-        return con;
+        return connectTo(primary);
     } catch (sql::SQLException &e) {
-        std::cerr << "Could not connect to the database. Error: " << e.what() << std::endl;
+        logSqlError("getConnection", e, {{"host", primary.host}});
         throw; // Re-throw the exception to be handled by the caller
     }
 }
 
+std::unique_ptr<sql::Connection> getReadConnection() {
+    std::vector<size_t> candidates;
+    ConnectionSettings target;
+    {
+        std::lock_guard<std::mutex> lock(replicaMutex);
+        loadReplicasLocked();
+        // With no replicas, or inside the read-your-writes window, candidates stays empty.
+        bool recentWrite = steadyNowMs() - lastWriteMs.load() < readYourWritesMs;
+        auto now = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < replicas.size() && !recentWrite; ++i) {
+            size_t index = (nextReplica + i) % replicas.size();
+            if (replicas[index].retryAt <= now) candidates.push_back(index);
+        }
+        if (!replicas.empty()) nextReplica = (nextReplica + 1) % replicas.size();
+        target = replicaSettings;
+    }
+
+    for (size_t index : candidates) {
+        std::string host;
+        {
+            std::lock_guard<std::mutex> lock(replicaMutex);
+            if (index >= replicas.size()) break; // Config was reloaded meanwhile
+            host = replicas[index].host;
+        }
+        target.host = host;
+        try {
+            std::unique_ptr<sql::Connection> con = connectTo(target);
+            std::lock_guard<std::mutex> lock(replicaMutex);
+            if (index < replicas.size() && replicas[index].host == host) {
+                replicas[index].consecutiveFailures = 0;
+            }
+            return con;
+        } catch (sql::SQLException &e) {
+            std::lock_guard<std::mutex> lock(replicaMutex);
+            if (index < replicas.size() && replicas[index].host == host) {
+                ReplicaEndpoint& endpoint = replicas[index];
+                // Back off 1s, 2s, 4s, ... capped at 64s, before trying this replica again.
+                int exponent = std::min(endpoint.consecutiveFailures, 6);
+                endpoint.consecutiveFailures++;
+                endpoint.retryAt = std::chrono::steady_clock::now() + std::chrono::seconds(1LL << exponent);
+                logEvent(LogLevel::Warning, "getReadConnection", std::string("Read replica is unavailable: ") + e.what(),
+                         {{"host", host}, {"error_code", e.getErrorCode()}, {"retry_in_s", 1LL << exponent}});
+            }
+        }
+    }
+
+    return getConnection(); // No replica configured, none healthy, or a recent write
+}
+
+void noteWrite() {
+    lastWriteMs.store(steadyNowMs());
+}
+
+std::vector<ReplicaStatus> getReplicaStatus() {
+    std::vector<ReplicaStatus> statuses;
+    std::lock_guard<std::mutex> lock(replicaMutex);
+    loadReplicasLocked();
+    auto now = std::chrono::steady_clock::now();
+    for (const auto& endpoint : replicas) {
+        statuses.push_back({endpoint.host, endpoint.consecutiveFailures, endpoint.retryAt <= now});
+    }
+    return statuses;
+}
+
+NamedLock::NamedLock(sql::Connection& con, const std::string& name, int timeoutSeconds) : con(con), name(name) {
+    std::unique_ptr<sql::PreparedStatement> pstmt(con.prepareStatement("SELECT GET_LOCK(?, ?) AS acquired"));
+    pstmt->setString(1, name);
+    pstmt->setInt(2, timeoutSeconds);
+    std::unique_ptr<sql::ResultSet> res(pstmt->executeQuery());
+    held = res->next() && res->getInt("acquired") == 1;
+}
+
+NamedLock::~NamedLock() {
+    if (!held) return;
+    try {
+        std::unique_ptr<sql::PreparedStatement> pstmt(con.prepareStatement("SELECT RELEASE_LOCK(?)"));
+        pstmt->setString(1, name);
+        std::unique_ptr<sql::ResultSet> res(pstmt->executeQuery());
+    } catch (sql::SQLException&) {
+        // The server releases it when the connection closes anyway
+    }
+}
+
 std::string generateSalt() {
     unsigned char salt_bytes[32]; // 256 bits
     if (RAND_bytes(salt_bytes, sizeof(salt_bytes)) != 1) {
@@ -79,7 +246,7 @@ std::string hashPassword(const std::string& password, const std::string& salt) {
 
     md = EVP_get_digestbyname("SHA256");
     if (md == NULL) {
-        std::cerr << "Error: SHA256 digest not found." << std::endl;
+        logEvent(LogLevel::Error, "hashPassword", "SHA256 digest not found");
         return "";
     }
 
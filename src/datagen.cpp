@@ -0,0 +1,636 @@
+#include "datagen.h"
+#include "database.h"
+#include "dateutil.h"
+#include "ledger.h"
+#include "logger.h"
+#include "mess.h"
+#include "slowquery.h"
+#include <cppconn/prepared_statement.h>
+#include <cppconn/resultset.h>
+#include <algorithm>
+#include <array>
+#include <cctype>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <map>
+#include <memory>
+#include <set>
+
+namespace { // Anonymous namespace for file-local helpers
+    // Rows per statement, keeping the placeholders well under MySQL's 65,535 limit
+    const size_t MAX_ROWS_PER_INSERT = 1000;
+    const size_t ROWS_PER_COMMIT = 20000;
+    const size_t KEYS_PER_POSTING = 500; // Each key is bound twice by postUnpostedWrites
+
+    const char* MEAL_TYPES[] = {"Breakfast", "Lunch", "Dinner"};
+    const double WEEKEND_APPETITE[] = {0.6, 0.85, 0.9}; // Share of a user's weekday appetite for each meal
+    const char* MONTH_NAMES[] = {"January", "February", "March", "April", "May", "June", "July",
+                                 "August", "September", "October", "November", "December"};
+
+    const char* FIRST_NAMES[] = {"Aarav", "Aisha", "Ben", "Chen", "Diego", "Elena", "Farhan", "Grace", "Hana", "Ibrahim",
+                                 "Isla", "Jonas", "Kavya", "Leo", "Maya", "Nadia", "Omar", "Priya", "Quinn", "Rahul",
+                                 "Sara", "Tariq", "Uma", "Victor", "Wei", "Yusuf", "Zara", "Arjun", "Lina", "Mateo"};
+    const char* LAST_NAMES[] = {"Ahmed", "Brown", "Chowdhury", "Das", "Evans", "Fernandez", "Garcia", "Hossain", "Iyer", "Jensen",
+                                "Khan", "Li", "Martin", "Nguyen", "Okafor", "Patel", "Rahman", "Silva", "Tanaka", "Uddin",
+                                "Verma", "Wang", "Yilmaz", "Zhang", "Islam", "Kumar", "Lopez", "Mehta", "Novak", "Sato"};
+
+    const char* BREAKFAST_DISHES[] = {"Paratha", "Omelette", "Porridge", "Pancakes", "Toast", "Poha",
+                                      "Upma", "Idli", "Boiled Eggs", "Cereal", "Puri Bhaji", "French Toast"};
+    const char* MAIN_DISHES[] = {"Chicken Curry", "Beef Curry", "Fish Fry", "Dal", "Rice", "Vegetable Curry",
+                                 "Khichuri", "Biryani", "Egg Curry", "Mixed Vegetables", "Chana Masala", "Pasta",
+                                 "Noodles", "Fried Rice", "Salad", "Soup", "Paneer Masala", "Mashed Potatoes",
+                                 "Roti", "Lentil Soup", "Grilled Chicken", "Fish Curry", "Aloo Gobi", "Spinach"};
+    const char* DISH_STYLES[] = {"Spicy", "Home-style", "Garlic", "Lemon", "Butter", "Smoked", "Herb", "Tandoori", "Coconut", "Special"};
+
+    struct Purchase {
+        const char* item;
+        double low;
+        double high;
+    };
+    const Purchase FOOD_PURCHASES[] = {{"Rice", 40, 70}, {"Lentils", 10, 25}, {"Chicken", 30, 80}, {"Fish", 25, 70},
+                                       {"Vegetables", 8, 30}, {"Eggs", 6, 12}, {"Milk", 5, 15}, {"Cooking Oil", 15, 30},
+                                       {"Spices", 5, 20}, {"Bread", 3, 8}, {"Fruit", 8, 25}, {"Flour", 10, 25},
+                                       {"Onions", 4, 12}, {"Potatoes", 5, 14}};
+    const Purchase OTHER_PURCHASES[] = {{"Cleaning Supplies", 5, 20}, {"Dish Soap", 2, 6}, {"Kitchen Utensils", 10, 40},
+                                        {"Repairs", 20, 100}, {"Trash Bags", 3, 8}};
+
+    // Independent random streams, so one kind of data doesn't shift another
+    enum Stream : uint64_t { UsersStream = 1, DailyMenuStream, AttendanceStream, ExpenseStream, PaymentStream, CredentialStream };
+
+    uint64_t splitMix64(uint64_t& state) {
+        uint64_t z = (state += 0x9e3779b97f4a7c15ULL);
+        z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+        z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+        return z ^ (z >> 31);
+    }
+
+    // xoshiro256**, seeded through splitmix64. The distributions below are
+    // defined here rather than taken from <random> so they give the same
+    // values with every standard library.
+    class Random {
+    public:
+        Random(uint64_t seed, uint64_t stream) {
+            uint64_t state = seed ^ (stream * 0xd1b54a32d192ed03ULL);
+            for (auto& word : words) word = splitMix64(state);
+        }
+
+        uint64_t next() {
+            uint64_t result = rotl(words[1] * 5, 7) * 9;
+            uint64_t t = words[1] << 17;
+            words[2] ^= words[0];
+            words[3] ^= words[1];
+            words[1] ^= words[2];
+            words[0] ^= words[3];
+            words[2] ^= t;
+            words[3] = rotl(words[3], 45);
+            return result;
+        }
+
+        double uniform() { return static_cast<double>(next() >> 11) * 0x1.0p-53; } // [0, 1)
+        double between(double low, double high) { return low + (high - low) * uniform(); }
+        int between(int low, int high) { return low + static_cast<int>(next() % static_cast<uint64_t>(high - low + 1)); }
+        bool chance(double probability) { return uniform() < probability; }
+
+        int poisson(double mean) { // Knuth; means here are small
+            double limit = std::exp(-mean), product = uniform();
+            int count = 0;
+            while (product > limit) {
+                ++count;
+                product *= uniform();
+            }
+            return count;
+        }
+
+        std::string hex(size_t length) {
+            static const char digits[] = "0123456789abcdef";
+            std::string text;
+            while (text.size() < length) {
+                uint64_t bits = next();
+                for (int i = 0; i < 16 && text.size() < length; ++i, bits >>= 4) text += digits[bits & 0xf];
+            }
+            return text;
+        }
+
+    private:
+        std::array<uint64_t, 4> words;
+
+        static uint64_t rotl(uint64_t x, int k) { return (x << k) | (x >> (64 - k)); }
+    };
+
+    double roundCents(double amount) {
+        return std::round(amount * 100.0) / 100.0;
+    }
+
+    std::string lowercase(std::string text) {
+        std::transform(text.begin(), text.end(), text.begin(), [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+        return text;
+    }
+
+    std::string placeholders(const std::string& row, size_t count) {
+        std::string values;
+        for (size_t i = 0; i < count; ++i) {
+            values += row;
+            if (i < count - 1) values += ", ";
+        }
+        return values;
+    }
+
+    // Commits the load every ROWS_PER_COMMIT rows, so no transaction holds a
+    // whole table's worth of undo.
+    class CommitPacer {
+    public:
+        explicit CommitPacer(sql::Connection& con) : con(con) {}
+
+        void written(size_t rows) {
+            total += rows;
+            uncommitted += rows;
+            if (uncommitted >= ROWS_PER_COMMIT) commit();
+        }
+
+        void commit() {
+            con.commit();
+            uncommitted = 0;
+        }
+
+        size_t totalRows() const { return total; }
+
+    private:
+        sql::Connection& con;
+        size_t uncommitted = 0;
+        size_t total = 0;
+    };
+
+    // Buffers one table's rows and writes them with multi-row INSERTs. The
+    // statement for a full batch is prepared once and reused.
+    class RowLoader {
+    public:
+        RowLoader(sql::Connection& con, CommitPacer& pacer, std::string insertPrefix, std::string rowPlaceholder)
+            : con(con), pacer(pacer), insertPrefix(std::move(insertPrefix)), rowPlaceholder(std::move(rowPlaceholder)) {}
+
+        void add(int value) { values.push_back({'i', value, 0.0, std::string()}); }
+        void add(double value) { values.push_back({'d', 0, value, std::string()}); }
+        void add(const std::string& value) { values.push_back({'s', 0, 0.0, value}); }
+
+        void endRow() {
+            ++rows;
+            if (++pendingRows == MAX_ROWS_PER_INSERT) flush();
+        }
+
+        void finish() { flush(); }
+
+        size_t rowCount() const { return rows; }
+
+    private:
+        struct Value {
+            char kind; // 'i'nteger, 'd'ouble or 's'tring
+            int number;
+            double real;
+            std::string text;
+        };
+
+        sql::Connection& con;
+        CommitPacer& pacer;
+        std::string insertPrefix;
+        std::string rowPlaceholder;
+        std::vector<Value> values;
+        size_t pendingRows = 0;
+        size_t rows = 0;
+        std::unique_ptr<TracedStatement> fullBatch;
+
+        void flush() {
+            if (pendingRows == 0) return;
+            std::unique_ptr<TracedStatement> partialBatch;
+            TracedStatement* pstmt;
+            if (pendingRows == MAX_ROWS_PER_INSERT) {
+                if (!fullBatch) fullBatch = prepareTraced(con, "generateDataset", insertPrefix + placeholders(rowPlaceholder, pendingRows));
+                pstmt = fullBatch.get();
+            } else {
+                partialBatch = prepareTraced(con, "generateDataset", insertPrefix + placeholders(rowPlaceholder, pendingRows));
+                pstmt = partialBatch.get();
+            }
+            unsigned int paramIndex = 1;
+            for (const auto& value : values) {
+                switch (value.kind) {
+                    case 'i': pstmt->setInt(paramIndex++, value.number); break;
+                    case 'd': pstmt->setDouble(paramIndex++, value.real); break;
+                    default:  pstmt->setString(paramIndex++, value.text); break;
+                }
+            }
+            pstmt->executeUpdate();
+            pacer.written(pendingRows);
+            values.clear();
+            pendingRows = 0;
+        }
+    };
+
+    struct GeneratedUser {
+        int id = 0;
+        std::string username;
+        std::string name;
+        const char* role;
+        std::array<double, 3> appetite; // Chance of eating each meal on a weekday
+        bool homeOnWeekends;
+        bool shopper;                   // Does some of the food shopping
+    };
+
+    struct GeneratedMenuItem {
+        int id = 0;
+        std::string name;
+        bool breakfast;
+    };
+
+    // Reads back the IDs of rows just inserted for the mess, keyed by a unique text column.
+    std::map<std::string, int> readIds(sql::Connection& con, const std::string& table, const std::string& keyColumn, int messId) {
+        std::unique_ptr<TracedStatement> pstmt(prepareTraced(con, "generateDataset",
+            "SELECT id, " + keyColumn + " AS name FROM " + table + " WHERE mess_id = ?"));
+        pstmt->setInt(1, messId);
+        std::unique_ptr<sql::ResultSet> res(pstmt->executeQuery());
+        std::map<std::string, int> ids;
+        while (res->next()) {
+            ids[res->getString("name")] = res->getInt("id");
+        }
+        return ids;
+    }
+
+    std::vector<GeneratedUser> makeUsers(const DatasetOptions& options) {
+        Random random(options.seed, UsersStream);
+        const size_t firstCount = sizeof(FIRST_NAMES) / sizeof(FIRST_NAMES[0]);
+        const size_t lastCount = sizeof(LAST_NAMES) / sizeof(LAST_NAMES[0]);
+        int staffCount = std::max(1, options.users / 20);
+
+        std::vector<GeneratedUser> users;
+        std::map<std::string, int> usernameUses;
+        for (int i = 0; i < options.users; ++i) {
+            GeneratedUser user;
+            std::string first = FIRST_NAMES[random.next() % firstCount];
+            std::string last = LAST_NAMES[random.next() % lastCount];
+            user.name = first + " " + last;
+            user.role = i == 0 ? "Admin" : i <= staffCount ? "Staff" : "Student";
+            if (i == 0) {
+                user.username = "admin";
+            } else {
+                std::string base = lowercase(first + "." + last);
+                int uses = ++usernameUses[base];
+                user.username = uses == 1 ? base : base + std::to_string(uses);
+            }
+            user.appetite = {random.between(0.3, 0.9), random.between(0.55, 0.95), random.between(0.65, 0.98)};
+            user.homeOnWeekends = random.chance(0.15);
+            user.shopper = i <= staffCount || random.chance(0.1);
+            users.push_back(user);
+        }
+        return users;
+    }
+
+    // Plain dishes first, one breakfast dish to two mains, then styled variants of them
+    std::vector<GeneratedMenuItem> makeMenuItems(const DatasetOptions& options) {
+        std::vector<std::pair<std::string, bool>> bases;
+        const size_t breakfastCount = sizeof(BREAKFAST_DISHES) / sizeof(BREAKFAST_DISHES[0]);
+        const size_t mainCount = sizeof(MAIN_DISHES) / sizeof(MAIN_DISHES[0]);
+        for (size_t i = 0; i < breakfastCount || 2 * i < mainCount; ++i) {
+            if (i < breakfastCount) bases.push_back({BREAKFAST_DISHES[i], true});
+            if (2 * i < mainCount) bases.push_back({MAIN_DISHES[2 * i], false});
+            if (2 * i + 1 < mainCount) bases.push_back({MAIN_DISHES[2 * i + 1], false});
+        }
+
+        const size_t styleCount = sizeof(DISH_STYLES) / sizeof(DISH_STYLES[0]);
+        std::vector<GeneratedMenuItem> items;
+        for (size_t round = 0; items.size() < static_cast<size_t>(options.menu_items); ++round) {
+            for (const auto& [dish, breakfast] : bases) {
+                if (items.size() == static_cast<size_t>(options.menu_items)) break;
+                GeneratedMenuItem item;
+                if (round == 0) {
+                    item.name = dish;
+                } else if (round <= styleCount) {
+                    item.name = std::string(DISH_STYLES[round - 1]) + " " + dish;
+                } else {
+                    item.name = dish + " No. " + std::to_string(round - styleCount + 1);
+                }
+                item.breakfast = breakfast;
+                items.push_back(item);
+            }
+        }
+        return items;
+    }
+
+    // count distinct entries of pool, in pool order
+    std::vector<int> pickDistinct(Random& random, const std::vector<int>& pool, size_t count) {
+        count = std::min(count, pool.size());
+        std::set<size_t> picked;
+        while (picked.size() < count) picked.insert(random.next() % pool.size());
+        std::vector<int> result;
+        for (size_t index : picked) result.push_back(pool[index]);
+        return result;
+    }
+} // namespace
+
+std::string validateDatasetOptions(const DatasetOptions& options) {
+    if (options.users < 1) return "users must be at least 1";
+    if (options.months < 1) return "months must be at least 1";
+    if (options.menu_items < 6) return "menu items must be at least 6";
+    if (options.expenses_per_day < 0.0 || options.expenses_per_day > 100.0) return "expenses per day must be between 0 and 100";
+    if (options.password.empty()) return "password must not be empty";
+    int year = 0, month = 0;
+    char extra;
+    if (std::sscanf(options.start_month.c_str(), "%4d-%2d%c", &year, &month, &extra) != 2 || year < 1970 || month < 1 || month > 12) {
+        return "start month must be YYYY-MM";
+    }
+    return std::string();
+}
+
+bool generateDataset(const DatasetOptions& options, DatasetSummary& summary) {
+    summary = DatasetSummary();
+    std::string problem = validateDatasetOptions(options);
+    if (!problem.empty()) {
+        logEvent(LogLevel::Error, "generateDataset", "Invalid options: " + problem);
+        return false;
+    }
+    auto start = std::chrono::steady_clock::now();
+
+    std::string messName = options.mess_name.empty() ? "Synthetic " + std::to_string(options.seed) : options.mess_name;
+    if (!addMess(messName)) return false; // Also creates the settings row and expense categories
+    for (const auto& mess : getAllMesses()) {
+        if (mess.name == messName) summary.mess_id = mess.id;
+    }
+    if (summary.mess_id == 0) return false;
+    const int messId = summary.mess_id;
+
+    // The months covered, as day numbers of their first days plus the day after the last
+    int startYear = 0, startMonth = 0;
+    std::sscanf(options.start_month.c_str(), "%4d-%2d", &startYear, &startMonth);
+    std::vector<std::pair<std::string, std::string>> periods; // Month name, year
+    std::vector<int> monthStarts;
+    for (int i = 0; i <= options.months; ++i) {
+        int monthIndex = (startMonth - 1 + i) % 12;
+        std::string year = std::to_string(startYear + (startMonth - 1 + i) / 12);
+        std::string firstDay, nextFirstDay;
+        int dayNumber;
+        monthDateRange(MONTH_NAMES[monthIndex], year, firstDay, nextFirstDay);
+        parseIsoDate(firstDay, dayNumber);
+        monthStarts.push_back(dayNumber);
+        if (i < options.months) periods.push_back({MONTH_NAMES[monthIndex], year});
+    }
+
+    std::vector<GeneratedUser> users = makeUsers(options);
+    std::vector<GeneratedMenuItem> menuItems = makeMenuItems(options);
+
+    try {
+        std::unique_ptr<sql::Connection> con(getConnection());
+        con->setAutoCommit(false);
+        std::unique_ptr<sql::Statement> stmt(con->createStatement());
+        stmt->execute("SET SESSION foreign_key_checks = 0, unique_checks = 0");
+        CommitPacer pacer(*con);
+
+        std::map<std::string, int> categoryIds = readIds(*con, "expense_categories", "name", messId);
+
+        // Users, sharing one salted hash of the password
+        Random credentials(options.seed, CredentialStream);
+        std::string salt = credentials.hex(64);
+        std::string passwordHash = hashPassword(options.password, salt);
+        RowLoader userLoader(*con, pacer, "INSERT INTO users (mess_id, username, password_hash, salt, name, role) VALUES ",
+                             "(?, ?, ?, ?, ?, ?)");
+        for (const auto& user : users) {
+            userLoader.add(messId);
+            userLoader.add(user.username);
+            userLoader.add(passwordHash);
+            userLoader.add(salt);
+            userLoader.add(user.name);
+            userLoader.add(std::string(user.role));
+            userLoader.endRow();
+        }
+        userLoader.finish();
+        std::map<std::string, int> userIds = readIds(*con, "users", "username", messId);
+        for (auto& user : users) user.id = userIds[user.username];
+
+        RowLoader periodLoader(*con, pacer, "INSERT INTO meal_periods (mess_id, month, year) VALUES ", "(?, ?, ?)");
+        for (const auto& [month, year] : periods) {
+            periodLoader.add(messId);
+            periodLoader.add(month);
+            periodLoader.add(year);
+            periodLoader.endRow();
+        }
+        periodLoader.finish();
+        std::map<std::string, int> periodIds = readIds(*con, "meal_periods", "CONCAT(month, ' ', year)", messId);
+        for (const auto& [month, year] : periods) summary.period_ids.push_back(periodIds[month + " " + year]);
+
+        RowLoader menuItemLoader(*con, pacer, "INSERT INTO menu_items (mess_id, name) VALUES ", "(?, ?)");
+        for (const auto& item : menuItems) {
+            menuItemLoader.add(messId);
+            menuItemLoader.add(item.name);
+            menuItemLoader.endRow();
+        }
+        menuItemLoader.finish();
+        std::map<std::string, int> menuItemIds = readIds(*con, "menu_items", "name", messId);
+        std::vector<int> breakfastPool, mainPool;
+        for (auto& item : menuItems) {
+            item.id = menuItemIds[item.name];
+            (item.breakfast ? breakfastPool : mainPool).push_back(item.id);
+        }
+
+        // What a month costs, to size the payments: food scales with the
+        // number of users, rent per head, bills and gas roughly fixed
+        double scale = std::max(1.0, options.users / 25.0);
+        double averageFood = 0.0;
+        for (const auto& purchase : FOOD_PURCHASES) averageFood += (purchase.low + purchase.high) / 2.0;
+        averageFood /= sizeof(FOOD_PURCHASES) / sizeof(FOOD_PURCHASES[0]);
+        double monthlySpend = 30.0 * options.expenses_per_day * averageFood * scale + 25.0 * options.users + 270.0 * scale + 150.0;
+        std::vector<double> expectedMeals; // Per user per month
+        double totalExpectedMeals = 0.0;
+        for (const auto& user : users) {
+            double weekday = user.appetite[0] + user.appetite[1] + user.appetite[2];
+            double weekend = 0.0;
+            for (int meal = 0; meal < 3 && !user.homeOnWeekends; ++meal) weekend += WEEKEND_APPETITE[meal] * user.appetite[meal];
+            expectedMeals.push_back(30.0 * (5.0 * weekday + 2.0 * weekend) / 7.0 * 0.93); // Less absences
+            totalExpectedMeals += expectedMeals.back();
+        }
+        double mealRateEstimate = monthlySpend / std::max(1.0, totalExpectedMeals);
+
+        std::vector<const GeneratedUser*> shoppers;
+        for (const auto& user : users) {
+            if (user.shopper) shoppers.push_back(&user);
+        }
+
+        RowLoader dailyMenuLoader(*con, pacer, "INSERT INTO daily_menus (mess_id, menu_date, meal_type, menu_item_id) VALUES ",
+                                  "(?, STR_TO_DATE(?, '%Y-%m-%d'), ?, ?)");
+        RowLoader attendanceLoader(*con, pacer, "INSERT INTO meal_attendance (mess_id, user_id, attendance_date, meal_type) VALUES ",
+                                   "(?, ?, STR_TO_DATE(?, '%Y-%m-%d'), ?)");
+        RowLoader expenseLoader(*con, pacer,
+                                "INSERT INTO expenses (mess_id, purchase_date, item_name, price, paid_by_user_id, category_id, idempotency_key) VALUES ",
+                                "(?, STR_TO_DATE(?, '%Y-%m-%d'), ?, ?, ?, ?, ?)");
+        RowLoader paymentLoader(*con, pacer, "INSERT INTO payments (mess_id, user_id, amount, date, idempotency_key) VALUES ",
+                                "(?, ?, ?, STR_TO_DATE(?, '%Y-%m-%d'), ?)");
+
+        Random dailyMenuRandom(options.seed, DailyMenuStream);
+        Random expenseRandom(options.seed, ExpenseStream);
+        Random paymentRandom(options.seed, PaymentStream);
+        std::vector<Random> attendanceRandom; // One stream per user
+        for (size_t i = 0; i < users.size(); ++i) {
+            attendanceRandom.emplace_back(options.seed, (static_cast<uint64_t>(AttendanceStream) << 32) | i);
+        }
+        std::vector<int> absentUntil(users.size(), 0);
+        std::vector<std::array<int, 3>> headcounts;
+        std::vector<std::string> ledgerKeys; // Payments and expenses, in date order
+
+        auto addExpense = [&](const std::string& date, const std::string& item, double price, const GeneratedUser& payer,
+                              const std::string& category) {
+            if (roundCents(price) <= 0.0) return;
+            std::string key = expenseRandom.hex(32);
+            expenseLoader.add(messId);
+            expenseLoader.add(date);
+            expenseLoader.add(item);
+            expenseLoader.add(roundCents(price));
+            expenseLoader.add(payer.id);
+            expenseLoader.add(categoryIds[category]);
+            expenseLoader.add(key);
+            expenseLoader.endRow();
+            ledgerKeys.push_back(key);
+        };
+        auto addPayment = [&](const std::string& date, const GeneratedUser& user, double amount) {
+            if (roundCents(amount) <= 0.0) return;
+            std::string key = paymentRandom.hex(32);
+            paymentLoader.add(messId);
+            paymentLoader.add(user.id);
+            paymentLoader.add(roundCents(amount));
+            paymentLoader.add(date);
+            paymentLoader.add(key);
+            paymentLoader.endRow();
+            ledgerKeys.push_back(key);
+        };
+
+        for (int month = 0; month < options.months; ++month) {
+            // Most users pay once in the first week, some split it with a
+            // second payment mid-month, and a few skip the month
+            std::map<int, std::vector<std::pair<size_t, double>>> paymentsByDay;
+            for (size_t i = 0; i < users.size(); ++i) {
+                if (paymentRandom.chance(0.05)) continue;
+                double amount = std::round(expectedMeals[i] * mealRateEstimate * paymentRandom.between(0.9, 1.3) / 10.0) * 10.0;
+                if (paymentRandom.chance(0.25)) {
+                    double first = std::round(amount / 20.0) * 10.0;
+                    paymentsByDay[paymentRandom.between(0, 6)].push_back({i, first});
+                    paymentsByDay[paymentRandom.between(11, 19)].push_back({i, amount - first});
+                } else {
+                    paymentsByDay[paymentRandom.between(0, 6)].push_back({i, amount});
+                }
+            }
+
+            for (int day = monthStarts[month]; day < monthStarts[month + 1]; ++day) {
+                std::string date = formatIsoDate(day);
+                int dayOfMonth = day - monthStarts[month];
+                bool weekend = dayOfWeek(day) >= 5;
+
+                for (int meal = 0; meal < 3; ++meal) {
+                    const std::vector<int>& pool = meal == 0 ? breakfastPool : mainPool;
+                    for (int itemId : pickDistinct(dailyMenuRandom, pool, meal == 0 ? 2 : 3)) {
+                        dailyMenuLoader.add(messId);
+                        dailyMenuLoader.add(date);
+                        dailyMenuLoader.add(std::string(MEAL_TYPES[meal]));
+                        dailyMenuLoader.add(itemId);
+                        dailyMenuLoader.endRow();
+                    }
+                }
+
+                std::array<int, 3> headcount = {0, 0, 0};
+                for (size_t i = 0; i < users.size(); ++i) {
+                    Random& random = attendanceRandom[i];
+                    const GeneratedUser& user = users[i];
+                    if (day >= absentUntil[i] && random.chance(1.0 / 45.0)) {
+                        absentUntil[i] = day + random.between(2, 7); // Trip home, illness, field work
+                    }
+                    bool sick = random.chance(0.02);
+                    if (day < absentUntil[i] || sick || (weekend && user.homeOnWeekends)) continue;
+                    for (int meal = 0; meal < 3; ++meal) {
+                        double probability = user.appetite[meal] * (weekend ? WEEKEND_APPETITE[meal] : 1.0);
+                        if (!random.chance(probability)) continue;
+                        attendanceLoader.add(messId);
+                        attendanceLoader.add(user.id);
+                        attendanceLoader.add(date);
+                        attendanceLoader.add(std::string(MEAL_TYPES[meal]));
+                        attendanceLoader.endRow();
+                        ++headcount[meal];
+                    }
+                }
+                headcounts.push_back(headcount);
+
+                for (const auto& [userIndex, amount] : paymentsByDay[dayOfMonth]) {
+                    addPayment(date, users[userIndex], amount);
+                }
+
+                const GeneratedUser& admin = users[0];
+                if (dayOfMonth == 0) {
+                    addExpense(date, "Rent", std::round(expenseRandom.between(20.0, 30.0) * options.users / 50.0) * 50.0, admin, "Rent");
+                }
+                if (dayOfMonth == 4) addExpense(date, "Electricity Bill", expenseRandom.between(150.0, 300.0) * scale, admin, "Utilities");
+                if (dayOfMonth == 9) addExpense(date, "Water Bill", expenseRandom.between(30.0, 60.0) * scale, admin, "Utilities");
+                if (dayOfMonth % 10 == 0 && dayOfMonth < 30) {
+                    addExpense(date, "Gas Cylinder", expenseRandom.between(40.0, 60.0), admin, "Utilities");
+                }
+                int purchases = expenseRandom.poisson(options.expenses_per_day);
+                for (int p = 0; p < purchases; ++p) {
+                    const Purchase& purchase = FOOD_PURCHASES[expenseRandom.next() % (sizeof(FOOD_PURCHASES) / sizeof(FOOD_PURCHASES[0]))];
+                    const GeneratedUser& payer = *shoppers[expenseRandom.next() % shoppers.size()];
+                    addExpense(date, purchase.item, expenseRandom.between(purchase.low, purchase.high) * scale, payer, "Food");
+                }
+                if (expenseRandom.chance(0.1)) {
+                    const Purchase& purchase = OTHER_PURCHASES[expenseRandom.next() % (sizeof(OTHER_PURCHASES) / sizeof(OTHER_PURCHASES[0]))];
+                    addExpense(date, purchase.item, expenseRandom.between(purchase.low, purchase.high), admin, "Other");
+                }
+            }
+        }
+        dailyMenuLoader.finish();
+        attendanceLoader.finish();
+        expenseLoader.finish();
+        paymentLoader.finish();
+
+        // Headcounts as the attendance writes would have left them
+        RowLoader headcountLoader(*con, pacer, "INSERT INTO meal_headcounts (mess_id, meal_date, meal_type, headcount) VALUES ",
+                                  "(?, STR_TO_DATE(?, '%Y-%m-%d'), ?, ?)");
+        for (size_t dayIndex = 0; dayIndex < headcounts.size(); ++dayIndex) {
+            for (int meal = 0; meal < 3; ++meal) {
+                if (headcounts[dayIndex][meal] == 0) continue;
+                headcountLoader.add(messId);
+                headcountLoader.add(formatIsoDate(monthStarts[0] + static_cast<int>(dayIndex)));
+                headcountLoader.add(std::string(MEAL_TYPES[meal]));
+                headcountLoader.add(headcounts[dayIndex][meal]);
+                headcountLoader.endRow();
+            }
+        }
+        headcountLoader.finish();
+
+        // Per-user weekday counts for the forecast, derived from the attendance just loaded
+        std::unique_ptr<TracedStatement> pstmt_counts(prepareTraced(*con, "generateDataset",
+            "INSERT INTO meal_weekday_counts (mess_id, week_start, user_id, meal_type, weekday, meals) "
+            "SELECT mess_id, attendance_date - INTERVAL WEEKDAY(attendance_date) DAY, user_id, meal_type, WEEKDAY(attendance_date), COUNT(*) "
+            "FROM meal_attendance WHERE mess_id = ? AND user_id IS NOT NULL AND meal_type IS NOT NULL "
+            "GROUP BY mess_id, attendance_date, user_id, meal_type"));
+        pstmt_counts->setInt(1, messId);
+        pacer.written(static_cast<size_t>(pstmt_counts->executeUpdate()));
+        pacer.commit();
+
+        // Ledger entries through the normal posting path, oldest first
+        for (size_t begin = 0; begin < ledgerKeys.size(); begin += KEYS_PER_POSTING) {
+            size_t end = std::min(ledgerKeys.size(), begin + KEYS_PER_POSTING);
+            postUnpostedWrites(*con, messId, std::vector<std::string>(ledgerKeys.begin() + begin, ledgerKeys.begin() + end));
+            pacer.written(2 * (end - begin)); // A user entry and a pool entry each
+        }
+        pacer.commit();
+        con->setAutoCommit(true);
+        noteWrite();
+
+        summary.users = userLoader.rowCount();
+        summary.menu_items = menuItemLoader.rowCount();
+        summary.daily_menu_rows = dailyMenuLoader.rowCount();
+        summary.attendance_rows = attendanceLoader.rowCount();
+        summary.expenses = expenseLoader.rowCount();
+        summary.payments = paymentLoader.rowCount();
+        summary.total_rows = pacer.totalRows();
+    } catch (sql::SQLException& e) {
+        logSqlError("generateDataset", e, {{"mess_id", messId}});
+        return false;
+    }
+
+    auto elapsedMs = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start).count();
+    logEvent(LogLevel::Info, "generateDataset", "Generated dataset",
+             {LogField("mess_id", messId), LogField("seed", std::to_string(options.seed)), LogField("rows", summary.total_rows),
+              LogField("duration_ms", elapsedMs)});
+    return true;
+}
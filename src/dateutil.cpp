@@ -0,0 +1,99 @@
+#include "dateutil.h"
+#include <cctype>
+#include <cstdio>
+
+namespace { // Anonymous namespace for file-local helpers
+    // Civil-calendar conversions from Howard Hinnant's date algorithms.
+    int daysFromCivil(int y, unsigned m, unsigned d) {
+        y -= m <= 2;
+        const int era = (y >= 0 ? y : y - 399) / 400;
+        const unsigned yoe = static_cast<unsigned>(y - era * 400);
+        const unsigned doy = (153 * (m + (m > 2 ? -3 : 9)) + 2) / 5 + d - 1;
+        const unsigned doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+        return era * 146097 + static_cast<int>(doe) - 719468;
+    }
+
+    void civilFromDays(int z, int& y, unsigned& m, unsigned& d) {
+        z += 719468;
+        const int era = (z >= 0 ? z : z - 146096) / 146097;
+        const unsigned doe = static_cast<unsigned>(z - era * 146097);
+        const unsigned yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+        const unsigned doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+        const unsigned mp = (5 * doy + 2) / 153;
+        d = doy - (153 * mp + 2) / 5 + 1;
+        m = mp < 10 ? mp + 3 : mp - 9;
+        y = static_cast<int>(yoe) + era * 400 + (m <= 2);
+    }
+
+    bool isLeapYear(int y) {
+        return (y % 4 == 0 && y % 100 != 0) || y % 400 == 0;
+    }
+
+    std::string trimmed(const std::string& text) {
+        size_t begin = 0, end = text.size();
+        while (begin < end && std::isspace(static_cast<unsigned char>(text[begin]))) ++begin;
+        while (end > begin && std::isspace(static_cast<unsigned char>(text[end - 1]))) --end;
+        return text.substr(begin, end - begin);
+    }
+
+    bool equalsIgnoreCase(const std::string& a, const char* b) {
+        size_t i = 0;
+        for (; i < a.size() && b[i] != '\0'; ++i) {
+            if (std::tolower(static_cast<unsigned char>(a[i])) != std::tolower(static_cast<unsigned char>(b[i]))) return false;
+        }
+        return i == a.size() && b[i] == '\0';
+    }
+} // namespace
+
+bool parseIsoDate(const std::string& date, int& dayNumber) {
+    int y = 0;
+    unsigned m = 0, d = 0;
+    char trailing = 0;
+    if (std::sscanf(date.c_str(), "%4d-%2u-%2u%c", &y, &m, &d, &trailing) != 3) {
+        return false;
+    }
+    static const unsigned daysInMonth[] = {31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31};
+    if (m < 1 || m > 12 || d < 1) {
+        return false;
+    }
+    unsigned maxDay = daysInMonth[m - 1] + (m == 2 && isLeapYear(y) ? 1 : 0);
+    if (d > maxDay) {
+        return false;
+    }
+    dayNumber = daysFromCivil(y, m, d);
+    return true;
+}
+
+std::string formatIsoDate(int dayNumber) {
+    int y;
+    unsigned m, d;
+    civilFromDays(dayNumber, y, m, d);
+    char buffer[16];
+    std::snprintf(buffer, sizeof(buffer), "%04d-%02u-%02u", y, m, d);
+    return buffer;
+}
+
+int dayOfWeek(int dayNumber) {
+    // 1970-01-01 was a Thursday (index 3 when Monday is 0).
+    return ((dayNumber % 7) + 7 + 3) % 7;
+}
+
+bool monthDateRange(const std::string& monthName, const std::string& year, std::string& firstDay, std::string& nextFirstDay) {
+    static const char* monthNames[] = {"January", "February", "March", "April", "May", "June", "July",
+                                       "August", "September", "October", "November", "December"};
+    // Periods are typed in by hand, so " may" and "MAY" name the same month
+    std::string month = trimmed(monthName);
+    int y = 0;
+    char trailing = 0;
+    if (std::sscanf(trimmed(year).c_str(), "%4d%c", &y, &trailing) != 1) {
+        return false;
+    }
+    for (unsigned m = 1; m <= 12; ++m) {
+        if (equalsIgnoreCase(month, monthNames[m - 1])) {
+            firstDay = formatIsoDate(daysFromCivil(y, m, 1));
+            nextFirstDay = formatIsoDate(m == 12 ? daysFromCivil(y + 1, 1, 1) : daysFromCivil(y, m + 1, 1));
+            return true;
+        }
+    }
+    return false;
+}
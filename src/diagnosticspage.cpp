@@ -0,0 +1,151 @@
+#include "diagnosticspage.h"
+#include "stallwatchdog.h"
+#include <QShowEvent>
+#include <QVBoxLayout>
+#include <QHBoxLayout>
+#include <QTableWidget>
+#include <QPlainTextEdit>
+#include <QPushButton>
+#include <QHeaderView>
+#include <QFontDatabase>
+#include <QLabel>
+
+DiagnosticsPage::DiagnosticsPage(QWidget *parent)
+    : QWidget(parent)
+{
+    auto mainLayout = new QVBoxLayout(this);
+
+    // Title
+    auto titleLabel = new QLabel("Diagnostics", this);
+    titleLabel->setStyleSheet("font-size: 24px; font-weight: bold;");
+    titleLabel->setAlignment(Qt::AlignCenter);
+    mainLayout->addWidget(titleLabel);
+    mainLayout->addSpacing(20);
+
+    captureLabel = new QLabel(this);
+    captureLabel->setWordWrap(true);
+    mainLayout->addWidget(captureLabel);
+
+    // Newest first; one row per slow execution
+    slowQueryTable = new QTableWidget(this);
+    slowQueryTable->setColumnCount(5);
+    slowQueryTable->setHorizontalHeaderLabels({"Time (UTC)", "SQL ID", "Function", "Total (ms)", "Rows"});
+    slowQueryTable->horizontalHeader()->setStretchLastSection(true);
+    slowQueryTable->setSelectionBehavior(QAbstractItemView::SelectRows);
+    slowQueryTable->setSelectionMode(QAbstractItemView::SingleSelection);
+    slowQueryTable->setEditTriggers(QAbstractItemView::NoEditTriggers);
+    slowQueryTable->verticalHeader()->setVisible(false);
+    mainLayout->addWidget(slowQueryTable, 1);
+
+    detailsTextEdit = new QPlainTextEdit(this);
+    detailsTextEdit->setReadOnly(true);
+    detailsTextEdit->setLineWrapMode(QPlainTextEdit::NoWrap);
+    detailsTextEdit->setFont(QFontDatabase::systemFont(QFontDatabase::FixedFont));
+    mainLayout->addWidget(detailsTextEdit, 1);
+
+    // Longest total first; one row per chain of page slots
+    stallLabel = new QLabel(this);
+    stallLabel->setWordWrap(true);
+    mainLayout->addWidget(stallLabel);
+
+    stallTable = new QTableWidget(this);
+    stallTable->setColumnCount(6);
+    stallTable->setHorizontalHeaderLabels({"Activity", "Stalls", "Total (ms)", "Max (ms)", "Last Seen", "Last Query"});
+    stallTable->horizontalHeader()->setStretchLastSection(true);
+    stallTable->setSelectionBehavior(QAbstractItemView::SelectRows);
+    stallTable->setEditTriggers(QAbstractItemView::NoEditTriggers);
+    stallTable->verticalHeader()->setVisible(false);
+    mainLayout->addWidget(stallTable, 1);
+
+    auto refreshButton = new QPushButton("Refresh", this);
+    mainLayout->addWidget(refreshButton);
+
+    // Connections
+    connect(refreshButton, &QPushButton::clicked, this, &DiagnosticsPage::loadSlowQueries);
+    connect(refreshButton, &QPushButton::clicked, this, &DiagnosticsPage::loadStalls);
+    connect(slowQueryTable, &QTableWidget::itemSelectionChanged, this, &DiagnosticsPage::showSelectedQuery);
+
+    setLayout(mainLayout);
+}
+
+void DiagnosticsPage::showEvent(QShowEvent *event)
+{
+    QWidget::showEvent(event);
+    if (loaded) return;
+    loaded = true;
+    loadSlowQueries();
+    loadStalls();
+}
+
+void DiagnosticsPage::loadSlowQueries()
+{
+    StallActivity activity("DiagnosticsPage::loadSlowQueries");
+    int threshold = slowQueryThresholdMs();
+    QString path = QString::fromStdString(slowQueryLogPath());
+    if (threshold <= 0 || path.isEmpty()) {
+        captureLabel->setText("Slow-query capture is off. Set threshold_ms and file under [SlowQueries] in config.ini to enable it.");
+    } else {
+        captureLabel->setText(QString("Statements taking %1 ms or more are recorded in %2.").arg(threshold).arg(path));
+    }
+
+    records = readSlowQueries(MAX_SHOWN);
+    slowQueryTable->setRowCount(0); // Clear existing rows
+    slowQueryTable->setRowCount(records.size());
+    for (size_t i = 0; i < records.size(); ++i) {
+        const SlowQueryRecord& record = records[i];
+        slowQueryTable->setItem(i, 0, new QTableWidgetItem(QString::fromStdString(record.timestamp)));
+        slowQueryTable->setItem(i, 1, new QTableWidgetItem(QString::fromStdString(record.sql_id)));
+        slowQueryTable->setItem(i, 2, new QTableWidgetItem(QString::fromStdString(record.function)));
+        slowQueryTable->setItem(i, 3, new QTableWidgetItem(QString::number(record.total_ms, 'f', 1)));
+        slowQueryTable->setItem(i, 4, new QTableWidgetItem(record.rows < 0 ? QString("-") : QString::number(record.rows)));
+    }
+    detailsTextEdit->clear();
+}
+
+void DiagnosticsPage::showSelectedQuery()
+{
+    int row = slowQueryTable->currentRow();
+    if (row < 0 || row >= static_cast<int>(records.size())) {
+        detailsTextEdit->clear();
+        return;
+    }
+    const SlowQueryRecord& record = records[row];
+    QStringList params;
+    for (const auto& param : record.params) {
+        params << QString::fromStdString(param);
+    }
+
+    QString details;
+    details += "SQL:\n" + QString::fromStdString(record.sql) + "\n\n";
+    details += "Parameters: " + (params.isEmpty() ? QString("(none)") : params.join(", ")) + "\n\n";
+    details += QString("Timing: prepare %1 ms, execute %2 ms, total %3 ms\n")
+        .arg(record.prepare_ms, 0, 'f', 1).arg(record.execute_ms, 0, 'f', 1).arg(record.total_ms, 0, 'f', 1);
+    details += "Rows: " + (record.rows < 0 ? QString("not reported") : QString::number(record.rows)) + "\n\n";
+    details += "Plan:\n" + (record.plan.empty() ? QString("(not fetched)") : QString::fromStdString(record.plan));
+    detailsTextEdit->setPlainText(details);
+}
+
+void DiagnosticsPage::loadStalls()
+{
+    int threshold = stallThresholdMs();
+    if (threshold <= 0) {
+        stallLabel->setText("The GUI stall watchdog is off. Set stall_threshold_ms under [Watchdog] in config.ini to enable it.");
+    } else {
+        stallLabel->setText(QString("GUI stalls since startup: times the window stopped responding for %1 ms or more.").arg(threshold));
+    }
+
+    std::vector<StallStats> stalls = getStallStats();
+    stallTable->setRowCount(0); // Clear existing rows
+    stallTable->setRowCount(stalls.size());
+    for (size_t i = 0; i < stalls.size(); ++i) {
+        const StallStats& stall = stalls[i];
+        stallTable->setItem(i, 0, new QTableWidgetItem(QString::fromStdString(stall.activity)));
+        stallTable->setItem(i, 1, new QTableWidgetItem(QString::number(stall.count)));
+        stallTable->setItem(i, 2, new QTableWidgetItem(QString::number(stall.total_ms, 'f', 0)));
+        stallTable->setItem(i, 3, new QTableWidgetItem(QString::number(stall.max_ms, 'f', 0)));
+        stallTable->setItem(i, 4, new QTableWidgetItem(QString::fromStdString(stall.last_seen)));
+        auto queryItem = new QTableWidgetItem(QString::fromStdString(stall.last_query).simplified());
+        queryItem->setToolTip(QString::fromStdString(stall.last_query));
+        stallTable->setItem(i, 5, queryItem);
+    }
+}
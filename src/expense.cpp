@@ -1,28 +1,94 @@
 #include "expense.h"
 #include "user.h"
 #include "database.h"
+#include "expenseanalytics.h"
+#include "journal.h"
+#include "ledger.h"
+#include "mess.h"
+#include "period.h"
+#include "logger.h"
+#include "slowquery.h"
 #include <cppconn/resultset.h>
 #include <cppconn/prepared_statement.h>
-#include <iostream>
 #include <memory>
 #include <vector>
 
-bool addExpense(const std::string& purchase_date, const std::string& item_name, double price, int paid_by_user_id, const std::string& category) {
+namespace { // Anonymous namespace for file-local helpers
+    // The row as it was before a change, for correcting its ledger entries.
+    struct LockedExpense {
+        std::string purchase_date;
+        std::string item_name;
+        double price = 0.0;
+        int paid_by_user_id = 0; // 0 if nobody is recorded as the payer
+    };
+
+    // Locks an expense and the meal period it is dated in for the caller's
+    // transaction. Returns false if the mess has no such expense.
+    bool lockExpenseForChange(sql::Connection& con, int id, int messId, LockedExpense& expense) {
+        std::unique_ptr<TracedStatement> pstmt(prepareTraced(con, "lockExpenseForChange",
+            "SELECT DATE_FORMAT(purchase_date, '%Y-%m-%d') AS purchase_date, item_name, price, paid_by_user_id "
+            "FROM expenses WHERE id = ? AND mess_id = ? FOR UPDATE"));
+        pstmt->setInt(1, id);
+        pstmt->setInt(2, messId);
+        std::unique_ptr<sql::ResultSet> res(pstmt->executeQuery());
+        if (!res->next()) return false;
+        expense.purchase_date = res->getString("purchase_date");
+        expense.item_name = res->getString("item_name");
+        expense.price = res->getDouble("price");
+        expense.paid_by_user_id = res->isNull("paid_by_user_id") ? 0 : res->getInt("paid_by_user_id");
+        lockOpenPeriods(con, messId, {expense.purchase_date});
+        return true;
+    }
+} // namespace
+
+bool addExpense(const std::string& purchase_date, const std::string& item_name, double price, int paid_by_user_id, int category_id) {
+    // The key makes a replay from the offline journal a no-op if this insert did land.
+    std::string idempotencyKey = generateIdempotencyKey();
     try {
         std::unique_ptr<sql::Connection> con(getConnection());
+        con->setAutoCommit(false); // Closing the connection on error rolls the insert back
+        lockOpenPeriods(*con, currentMessId(), {purchase_date});
+        if (paid_by_user_id > 0) lockMessMembers(*con, currentMessId(), {paid_by_user_id});
         // Using STR_TO_DATE to convert the string date from the user to a SQL DATE type
-        std::unique_ptr<sql::PreparedStatement> pstmt(
-            con->prepareStatement("INSERT INTO expenses (purchase_date, item_name, price, paid_by_user_id, category) VALUES (STR_TO_DATE(?, '%Y-%m-%d'), ?, ?, ?, ?)")
+        std::unique_ptr<TracedStatement> pstmt(
+            prepareTraced(*con, "addExpense", "INSERT INTO expenses (mess_id, purchase_date, item_name, price, paid_by_user_id, category_id, idempotency_key) VALUES (?, STR_TO_DATE(?, '%Y-%m-%d'), ?, ?, ?, ?, ?)")
         );
-        pstmt->setString(1, purchase_date);
-        pstmt->setString(2, item_name);
-        pstmt->setDouble(3, price);
-        pstmt->setInt(4, paid_by_user_id);
-        pstmt->setString(5, category);
+        pstmt->setInt(1, currentMessId());
+        pstmt->setString(2, purchase_date);
+        pstmt->setString(3, item_name);
+        pstmt->setDouble(4, price);
+        pstmt->setInt(5, paid_by_user_id);
+        pstmt->setInt(6, category_id);
+        pstmt->setString(7, idempotencyKey);
         pstmt->execute();
+
+        if (paid_by_user_id > 0) {
+            std::unique_ptr<sql::Statement> stmt(con->createStatement());
+            std::unique_ptr<sql::ResultSet> res(stmt->executeQuery("SELECT LAST_INSERT_ID() AS id"));
+            res->next();
+            postLedgerEntries(*con, currentMessId(), {{paid_by_user_id, LedgerEntryType::Shopping, price, purchase_date, res->getInt("id"), item_name}});
+        }
+        con->commit();
+        noteWrite();
+        invalidateExpenseCube();
         return true;
     } catch (sql::SQLException& e) {
-        std::cerr << "SQL Error in addExpense: " << e.what() << std::endl;
+        if (isConnectionError(e)) {
+            JournalRecord record;
+            record.type = JournalRecordType::Expense;
+            record.mess_id = currentMessId();
+            record.user_id = paid_by_user_id;
+            record.category_id = category_id;
+            record.amount = price;
+            record.date = purchase_date;
+            record.item_name = item_name;
+            record.idempotency_key = idempotencyKey;
+            if (appendToJournal(record)) {
+                logEvent(LogLevel::Warning, "addExpense", "Database unreachable; expense saved to the offline journal");
+                return true;
+            }
+        }
+        logSqlError("addExpense", e);
         return false;
     }
 }
@@ -30,32 +96,57 @@ bool addExpense(const std::string& purchase_date, const std::string& item_name,
 // Stubs for other functions declared in expense.h
 // These can be implemented later.
 
-bool editExpense(int id, const std::string& item_name, double price, const std::string& category) {
+bool editExpense(int id, const std::string& item_name, double price, int category_id) {
     try {
         std::unique_ptr<sql::Connection> con(getConnection());
-        std::unique_ptr<sql::PreparedStatement> pstmt(
-            con->prepareStatement("UPDATE expenses SET item_name = ?, price = ?, category = ? WHERE id = ?")
+        con->setAutoCommit(false); // Closing the connection on error rolls the update back
+        LockedExpense before;
+        if (!lockExpenseForChange(*con, id, currentMessId(), before)) return false;
+        std::unique_ptr<TracedStatement> pstmt(
+            prepareTraced(*con, "editExpense", "UPDATE expenses SET item_name = ?, price = ?, category_id = ? WHERE id = ? AND mess_id = ?")
         );
         pstmt->setString(1, item_name);
         pstmt->setDouble(2, price);
-        pstmt->setString(3, category);
+        pstmt->setInt(3, category_id);
         pstmt->setInt(4, id);
-        return pstmt->executeUpdate() > 0; // Returns true if a row was updated
+        pstmt->setInt(5, currentMessId());
+        bool updated = pstmt->executeUpdate() > 0; // Returns true if a row was updated
+        if (updated && before.paid_by_user_id > 0) {
+            // The ledger keeps the original entry and posts the difference
+            postLedgerEntries(*con, currentMessId(), {{before.paid_by_user_id, LedgerEntryType::Shopping, price - before.price,
+                                                       before.purchase_date, id, "Correction: " + item_name}});
+        }
+        con->commit();
+        noteWrite();
+        if (updated) invalidateExpenseCube();
+        return updated;
     } catch (sql::SQLException& e) {
-        std::cerr << "SQL Error in editExpense: " << e.what() << std::endl;
+        logSqlError("editExpense", e);
         return false;
     }
 }
 bool deleteExpense(int id) {
     try {
         std::unique_ptr<sql::Connection> con(getConnection());
-        std::unique_ptr<sql::PreparedStatement> pstmt(
-            con->prepareStatement("DELETE FROM expenses WHERE id = ?")
+        con->setAutoCommit(false); // Closing the connection on error rolls the delete back
+        LockedExpense before;
+        if (!lockExpenseForChange(*con, id, currentMessId(), before)) return false;
+        std::unique_ptr<TracedStatement> pstmt(
+            prepareTraced(*con, "deleteExpense", "DELETE FROM expenses WHERE id = ? AND mess_id = ?")
         );
         pstmt->setInt(1, id);
-        return pstmt->executeUpdate() > 0; // Returns true if a row was deleted
+        pstmt->setInt(2, currentMessId());
+        bool deleted = pstmt->executeUpdate() > 0; // Returns true if a row was deleted
+        if (deleted && before.paid_by_user_id > 0) {
+            postLedgerEntries(*con, currentMessId(), {{before.paid_by_user_id, LedgerEntryType::Shopping, -before.price,
+                                                       before.purchase_date, id, "Deleted: " + before.item_name}});
+        }
+        con->commit();
+        noteWrite();
+        if (deleted) invalidateExpenseCube();
+        return deleted;
     } catch (sql::SQLException& e) {
-        std::cerr << "SQL Error in deleteExpense: " << e.what() << std::endl;
+        logSqlError("deleteExpense", e);
         return false;
     }
 }
@@ -63,13 +154,17 @@ std::vector<Expense> getAllExpenses() {
     std::vector<Expense> expenses;
     try {
         std::unique_ptr<sql::Connection> con(getConnection());
-        std::unique_ptr<sql::Statement> stmt(con->createStatement());
         // Join with the users table to get the name of the person who paid
-        std::unique_ptr<sql::ResultSet> res(stmt->executeQuery(
-            "SELECT e.id, DATE_FORMAT(e.purchase_date, '%Y-%m-%d') AS purchase_date, e.item_name, e.price, e.category, u.name AS paid_by_user_name "
+        std::unique_ptr<TracedStatement> pstmt(prepareTraced(*con, "getAllExpenses",
+            "SELECT e.id, DATE_FORMAT(e.purchase_date, '%Y-%m-%d') AS purchase_date, e.item_name, e.price, "
+            "COALESCE(e.category_id, 0) AS category_id, COALESCE(c.name, '') AS category, u.name AS paid_by_user_name "
             "FROM expenses e JOIN users u ON e.paid_by_user_id = u.id "
+            "LEFT JOIN expense_categories c ON e.category_id = c.id "
+            "WHERE e.mess_id = ? " // Served by the expenses_mess_date index
             "ORDER BY e.purchase_date DESC, e.id DESC"
         ));
+        pstmt->setInt(1, currentMessId());
+        std::unique_ptr<sql::ResultSet> res(pstmt->executeQuery());
 
         while (res->next()) {
             Expense expense;
@@ -78,27 +173,31 @@ std::vector<Expense> getAllExpenses() {
             expense.item_name = res->getString("item_name");
             expense.price = res->getDouble("price");
             expense.paid_by_user_name = res->getString("paid_by_user_name");
+            expense.category_id = res->getInt("category_id");
             expense.category = res->getString("category");
             expenses.push_back(expense);
         }
     } catch (sql::SQLException& e) {
-        std::cerr << "SQL Error in getAllExpenses: " << e.what() << std::endl;
+        logSqlError("getAllExpenses", e);
     }
     return expenses;
 }
-std::vector<Expense> getExpensesByCategory(const std::string& category) {
+std::vector<Expense> getExpensesByCategory(int category_id) {
     std::vector<Expense> expenses;
     try {
         std::unique_ptr<sql::Connection> con(getConnection());
-        std::unique_ptr<sql::PreparedStatement> pstmt(
-            con->prepareStatement(
-                "SELECT e.id, DATE_FORMAT(e.purchase_date, '%Y-%m-%d') AS purchase_date, e.item_name, e.price, e.category, u.name AS paid_by_user_name "
+        std::unique_ptr<TracedStatement> pstmt(
+            prepareTraced(*con, "getExpensesByCategory",
+                "SELECT e.id, DATE_FORMAT(e.purchase_date, '%Y-%m-%d') AS purchase_date, e.item_name, e.price, "
+                "e.category_id, c.name AS category, u.name AS paid_by_user_name "
                 "FROM expenses e JOIN users u ON e.paid_by_user_id = u.id "
-                "WHERE e.category = ? "
+                "JOIN expense_categories c ON e.category_id = c.id "
+                "WHERE e.category_id = ? AND e.mess_id = ? " // Served by the expenses_category_date index
                 "ORDER BY e.purchase_date DESC, e.id DESC"
             )
         );
-        pstmt->setString(1, category);
+        pstmt->setInt(1, category_id);
+        pstmt->setInt(2, currentMessId());
         std::unique_ptr<sql::ResultSet> res(pstmt->executeQuery());
 
         while (res->next()) {
@@ -108,11 +207,55 @@ std::vector<Expense> getExpensesByCategory(const std::string& category) {
             expense.item_name = res->getString("item_name");
             expense.price = res->getDouble("price");
             expense.paid_by_user_name = res->getString("paid_by_user_name");
+            expense.category_id = res->getInt("category_id");
             expense.category = res->getString("category");
             expenses.push_back(expense);
         }
     } catch (sql::SQLException& e) {
-        std::cerr << "SQL Error in getExpensesByCategory: " << e.what() << std::endl;
+        logSqlError("getExpensesByCategory", e);
     }
     return expenses;
-}
\ No newline at end of file
+}
+
+bool addExpenseCategory(const std::string& name) {
+    try {
+        std::unique_ptr<sql::Connection> con(getConnection());
+        std::unique_ptr<TracedStatement> pstmt(
+            prepareTraced(*con, "addExpenseCategory", "INSERT INTO expense_categories (mess_id, name) VALUES (?, ?)")
+        );
+        pstmt->setInt(1, currentMessId());
+        pstmt->setString(2, name);
+        pstmt->execute();
+        noteWrite();
+        return true;
+    } catch (sql::SQLException& e) {
+        if (e.getErrorCode() == 1062) { // ER_DUP_ENTRY
+            logEvent(LogLevel::Error, "addExpenseCategory", "Expense category already exists", {{"name", name}});
+        } else {
+            logSqlError("addExpenseCategory", e);
+        }
+        return false;
+    }
+}
+
+std::vector<ExpenseCategory> getAllExpenseCategories() {
+    std::vector<ExpenseCategory> categories;
+    try {
+        std::unique_ptr<sql::Connection> con(getConnection());
+        std::unique_ptr<TracedStatement> pstmt(
+            prepareTraced(*con, "getAllExpenseCategories", "SELECT id, name FROM expense_categories WHERE mess_id = ? ORDER BY name ASC")
+        );
+        pstmt->setInt(1, currentMessId());
+        std::unique_ptr<sql::ResultSet> res(pstmt->executeQuery());
+
+        while (res->next()) {
+            ExpenseCategory category;
+            category.id = res->getInt("id");
+            category.name = res->getString("name");
+            categories.push_back(category);
+        }
+    } catch (sql::SQLException& e) {
+        logSqlError("getAllExpenseCategories", e);
+    }
+    return categories;
+}
@@ -0,0 +1,200 @@
+#include "expenseanalytics.h"
+#include "database.h"
+#include "mess.h"
+#include "logger.h"
+#include "slowquery.h"
+#include <cppconn/prepared_statement.h>
+#include <cppconn/resultset.h>
+#include <mutex>
+#include <algorithm>
+
+namespace { // Anonymous namespace for file-local helpers
+    std::mutex cubeMutex;
+    std::shared_ptr<const ExpenseCube> cachedCube;
+    std::string cachedFingerprint;    // expenseFingerprint() the cached cube was built under
+    unsigned long cubeGeneration = 0; // Bumped on every invalidation
+
+    // Row count, highest id and latest updated_at of the mess's expenses and
+    // users, and a checksum of its category names, so a write made by another
+    // client (or by the journal replay on a worker thread) is noticed without
+    // rerunning the rollup. The mess ID is part of it, so switching mess misses.
+    std::string expenseFingerprint(sql::Connection& con, int messId) {
+        std::unique_ptr<TracedStatement> pstmt(prepareTraced(con, "expenseFingerprint",
+            "SELECT CONCAT_WS('|', ?, "
+            " (SELECT CONCAT_WS(':', COUNT(*), COALESCE(MAX(id), 0), COALESCE(MAX(updated_at), '')) FROM expenses WHERE mess_id = ?), "
+            " (SELECT CONCAT_WS(':', COUNT(*), COALESCE(MAX(id), 0), COALESCE(MAX(updated_at), '')) FROM users WHERE mess_id = ?), "
+            " (SELECT CONCAT_WS(':', COUNT(*), COALESCE(SUM(CRC32(name)), 0)) FROM expense_categories WHERE mess_id = ?) "
+            ") AS fingerprint"
+        ));
+        for (int i = 1; i <= 4; ++i) {
+            pstmt->setInt(i, messId);
+        }
+        std::unique_ptr<sql::ResultSet> res(pstmt->executeQuery());
+        return res->next() ? res->getString("fingerprint") : std::string();
+    }
+
+    bool matches(const ExpenseCubeCell& cell, const ExpenseCubeFilter& filter) {
+        return (!filter.category || cell.category == *filter.category) &&
+               (!filter.month || cell.month == *filter.month) &&
+               (!filter.payer_id || cell.payer_id == *filter.payer_id);
+    }
+} // namespace
+
+ExpenseCube::ExpenseCube(std::vector<ExpenseCubeCell> cells) {
+    std::map<int, std::string> payerNames;
+    for (auto& cell : cells) {
+        bool isLeaf = !cell.all_categories && !cell.all_months && !cell.all_payers;
+        if (isLeaf) {
+            categoryValues.push_back(cell.category);
+            monthValues.push_back(cell.month);
+            payerNames[cell.payer_id] = cell.payer_name;
+            leaves.push_back(std::move(cell));
+        } else {
+            RollupKey key{cell.all_categories, cell.all_categories ? std::string() : cell.category,
+                          cell.all_months, cell.all_months ? std::string() : cell.month,
+                          cell.all_payers, cell.all_payers ? 0 : cell.payer_id};
+            rollups[key] = {cell.total, cell.expense_count};
+        }
+    }
+
+    std::sort(categoryValues.begin(), categoryValues.end());
+    categoryValues.erase(std::unique(categoryValues.begin(), categoryValues.end()), categoryValues.end());
+    std::sort(monthValues.begin(), monthValues.end(), std::greater<std::string>()); // Newest first
+    monthValues.erase(std::unique(monthValues.begin(), monthValues.end()), monthValues.end());
+    payerValues.assign(payerNames.begin(), payerNames.end());
+}
+
+ExpenseCubeTotals ExpenseCube::totals(const ExpenseCubeFilter& filter) const {
+    // WITH ROLLUP only produces the prefixes of the GROUP BY list:
+    // (category, month, payer), (category, month), (category) and ().
+    bool onRollupLevel = (!filter.month || filter.category) && (!filter.payer_id || filter.month);
+    if (onRollupLevel) {
+        if (filter.category && filter.month && filter.payer_id) {
+            for (const auto& leaf : leaves) {
+                if (matches(leaf, filter)) return {leaf.total, leaf.expense_count};
+            }
+            return {0.0, 0};
+        }
+        RollupKey key{!filter.category, filter.category.value_or(std::string()),
+                      !filter.month, filter.month.value_or(std::string()),
+                      true, 0};
+        auto it = rollups.find(key);
+        return it != rollups.end() ? it->second : ExpenseCubeTotals{0.0, 0};
+    }
+
+    ExpenseCubeTotals result{0.0, 0};
+    for (const auto& leaf : leaves) {
+        if (matches(leaf, filter)) {
+            result.total += leaf.total;
+            result.expense_count += leaf.expense_count;
+        }
+    }
+    return result;
+}
+
+std::vector<ExpenseBreakdownRow> ExpenseCube::breakdown(ExpenseDimension dimension, const ExpenseCubeFilter& filter) const {
+    std::vector<ExpenseBreakdownRow> rows;
+    auto addRow = [&](const std::string& label, const ExpenseCubeFilter& slice) {
+        ExpenseCubeTotals t = totals(slice);
+        if (t.expense_count > 0) rows.push_back({label, t.total, t.expense_count});
+    };
+
+    switch (dimension) {
+        case ExpenseDimension::Category:
+            for (const auto& category : categoryValues) {
+                if (filter.category && *filter.category != category) continue;
+                ExpenseCubeFilter slice = filter;
+                slice.category = category;
+                addRow(category.empty() ? "(none)" : category, slice);
+            }
+            break;
+        case ExpenseDimension::Month:
+            for (const auto& month : monthValues) {
+                if (filter.month && *filter.month != month) continue;
+                ExpenseCubeFilter slice = filter;
+                slice.month = month;
+                addRow(month, slice);
+            }
+            break;
+        case ExpenseDimension::Payer:
+            for (const auto& [payerId, payerName] : payerValues) {
+                if (filter.payer_id && *filter.payer_id != payerId) continue;
+                ExpenseCubeFilter slice = filter;
+                slice.payer_id = payerId;
+                addRow(payerName, slice);
+            }
+            break;
+    }
+    return rows;
+}
+
+std::shared_ptr<const ExpenseCube> getExpenseCube() {
+    unsigned long generation;
+    {
+        std::lock_guard<std::mutex> lock(cubeMutex);
+        generation = cubeGeneration;
+    }
+
+    std::vector<ExpenseCubeCell> cells;
+    std::string fingerprint;
+    try {
+        std::unique_ptr<sql::Connection> con(getReadConnection());
+        int messId = currentMessId();
+
+        // Reuse the cube unless an expense, payer or category has moved since it was built
+        fingerprint = expenseFingerprint(*con, messId);
+        {
+            std::lock_guard<std::mutex> lock(cubeMutex);
+            if (cachedCube && generation == cubeGeneration && !fingerprint.empty() && fingerprint == cachedFingerprint) {
+                return cachedCube;
+            }
+        }
+
+        std::unique_ptr<TracedStatement> pstmt(prepareTraced(*con, "getExpenseCube",
+            "SELECT category, month, payer_id, MAX(payer_name) AS payer_name, "
+            "SUM(price) AS total, COUNT(*) AS expense_count, "
+            "GROUPING(category) AS all_categories, GROUPING(month) AS all_months, GROUPING(payer_id) AS all_payers "
+            "FROM (SELECT COALESCE(c.name, '') AS category, DATE_FORMAT(e.purchase_date, '%Y-%m') AS month, "
+            "      COALESCE(e.paid_by_user_id, 0) AS payer_id, COALESCE(u.name, '(deleted user)') AS payer_name, e.price "
+            "      FROM expenses e LEFT JOIN users u ON e.paid_by_user_id = u.id "
+            "      LEFT JOIN expense_categories c ON e.category_id = c.id "
+            "      WHERE e.mess_id = ?) x "
+            "GROUP BY category, month, payer_id WITH ROLLUP"
+        ));
+        pstmt->setInt(1, messId);
+        std::unique_ptr<sql::ResultSet> res(pstmt->executeQuery());
+
+        while (res->next()) {
+            ExpenseCubeCell cell;
+            cell.all_categories = res->getInt("all_categories") != 0;
+            cell.all_months = res->getInt("all_months") != 0;
+            cell.all_payers = res->getInt("all_payers") != 0;
+            cell.category = cell.all_categories ? "" : res->getString("category");
+            cell.month = cell.all_months ? "" : res->getString("month");
+            cell.payer_id = cell.all_payers ? 0 : res->getInt("payer_id");
+            cell.payer_name = res->getString("payer_name");
+            cell.total = res->getDouble("total");
+            cell.expense_count = res->getInt("expense_count");
+            cells.push_back(cell);
+        }
+    } catch (sql::SQLException& e) {
+        logSqlError("getExpenseCube", e);
+        return std::make_shared<const ExpenseCube>(std::vector<ExpenseCubeCell>()); // Not cached, so the next call retries
+    }
+
+    auto cube = std::make_shared<const ExpenseCube>(std::move(cells));
+    std::lock_guard<std::mutex> lock(cubeMutex);
+    if (generation == cubeGeneration) { // Don't cache a result an expense write raced with
+        // Stored under the fingerprint read before the rollup, so a write that
+        // lands in between only causes a rebuild on the next call.
+        cachedCube = cube;
+        cachedFingerprint = fingerprint;
+    }
+    return cube;
+}
+
+void invalidateExpenseCube() {
+    std::lock_guard<std::mutex> lock(cubeMutex);
+    cachedCube.reset();
+    ++cubeGeneration;
+}
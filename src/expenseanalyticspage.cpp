@@ -0,0 +1,156 @@
+#include "expenseanalyticspage.h"
+#include "stallwatchdog.h"
+#include <QShowEvent>
+#include <QVBoxLayout>
+#include <QHBoxLayout>
+#include <QTableWidget>
+#include <QComboBox>
+#include <QPushButton>
+#include <QHeaderView>
+#include <QLabel>
+#include <QSignalBlocker>
+#include <algorithm>
+
+ExpenseAnalyticsPage::ExpenseAnalyticsPage(QWidget *parent)
+    : QWidget(parent)
+{
+    auto mainLayout = new QVBoxLayout(this);
+
+    // Title
+    auto titleLabel = new QLabel("Expense Analytics", this);
+    titleLabel->setStyleSheet("font-size: 24px; font-weight: bold;");
+    titleLabel->setAlignment(Qt::AlignCenter);
+    mainLayout->addWidget(titleLabel);
+    mainLayout->addSpacing(20);
+
+    // Grouping and filters
+    auto filterLayout = new QHBoxLayout();
+    filterLayout->addWidget(new QLabel("Group by:"));
+    groupByComboBox = new QComboBox(this);
+    groupByComboBox->addItem("Category", static_cast<int>(ExpenseDimension::Category));
+    groupByComboBox->addItem("Month", static_cast<int>(ExpenseDimension::Month));
+    groupByComboBox->addItem("Paid By", static_cast<int>(ExpenseDimension::Payer));
+    filterLayout->addWidget(groupByComboBox);
+
+    filterLayout->addWidget(new QLabel("Category:"));
+    categoryFilterComboBox = new QComboBox(this);
+    filterLayout->addWidget(categoryFilterComboBox);
+
+    filterLayout->addWidget(new QLabel("Month:"));
+    monthFilterComboBox = new QComboBox(this);
+    filterLayout->addWidget(monthFilterComboBox);
+
+    filterLayout->addWidget(new QLabel("Paid By:"));
+    payerFilterComboBox = new QComboBox(this);
+    filterLayout->addWidget(payerFilterComboBox);
+    filterLayout->addStretch();
+    mainLayout->addLayout(filterLayout);
+
+    // Breakdown table
+    breakdownTable = new QTableWidget(this);
+    breakdownTable->setColumnCount(4);
+    breakdownTable->setHorizontalHeaderLabels({"Group", "Total", "Expenses", "Share"});
+    breakdownTable->horizontalHeader()->setStretchLastSection(true);
+    breakdownTable->setSelectionBehavior(QAbstractItemView::SelectRows);
+    breakdownTable->setEditTriggers(QAbstractItemView::NoEditTriggers);
+    mainLayout->addWidget(breakdownTable);
+
+    totalLabel = new QLabel(this);
+    mainLayout->addWidget(totalLabel);
+
+    auto refreshButton = new QPushButton("Refresh", this);
+    mainLayout->addWidget(refreshButton);
+
+    // Filter changes only re-slice the cube in memory; Refresh checks the database for changes.
+    connect(groupByComboBox, &QComboBox::currentIndexChanged, this, &ExpenseAnalyticsPage::updateBreakdown);
+    connect(categoryFilterComboBox, &QComboBox::currentIndexChanged, this, &ExpenseAnalyticsPage::updateBreakdown);
+    connect(monthFilterComboBox, &QComboBox::currentIndexChanged, this, &ExpenseAnalyticsPage::updateBreakdown);
+    connect(payerFilterComboBox, &QComboBox::currentIndexChanged, this, &ExpenseAnalyticsPage::updateBreakdown);
+    connect(refreshButton, &QPushButton::clicked, this, &ExpenseAnalyticsPage::refreshCube);
+
+    setLayout(mainLayout);
+}
+
+void ExpenseAnalyticsPage::showEvent(QShowEvent *event)
+{
+    QWidget::showEvent(event);
+    if (loaded) return;
+    loaded = true;
+    refreshCube();
+}
+
+void ExpenseAnalyticsPage::refreshCube()
+{
+    StallActivity activity("ExpenseAnalyticsPage::refreshCube");
+    cube = getExpenseCube(); // Rebuilt only if the expenses changed since the last build, here or elsewhere
+    populateFilters();
+    updateBreakdown();
+}
+
+void ExpenseAnalyticsPage::populateFilters()
+{
+    // Keep the current selections where they still exist in the new cube.
+    QString category = categoryFilterComboBox->currentText();
+    QString month = monthFilterComboBox->currentText();
+    QVariant payer = payerFilterComboBox->currentData();
+
+    const QSignalBlocker categoryBlocker(categoryFilterComboBox);
+    const QSignalBlocker monthBlocker(monthFilterComboBox);
+    const QSignalBlocker payerBlocker(payerFilterComboBox);
+
+    categoryFilterComboBox->clear();
+    categoryFilterComboBox->addItem("All");
+    for (const auto& value : cube->categories()) {
+        categoryFilterComboBox->addItem(QString::fromStdString(value));
+    }
+
+    monthFilterComboBox->clear();
+    monthFilterComboBox->addItem("All");
+    for (const auto& value : cube->months()) {
+        monthFilterComboBox->addItem(QString::fromStdString(value));
+    }
+
+    payerFilterComboBox->clear();
+    payerFilterComboBox->addItem("All");
+    for (const auto& [payerId, payerName] : cube->payers()) {
+        payerFilterComboBox->addItem(QString::fromStdString(payerName), payerId);
+    }
+
+    categoryFilterComboBox->setCurrentIndex(std::max(0, categoryFilterComboBox->findText(category)));
+    monthFilterComboBox->setCurrentIndex(std::max(0, monthFilterComboBox->findText(month)));
+    payerFilterComboBox->setCurrentIndex(payer.isValid() ? std::max(0, payerFilterComboBox->findData(payer)) : 0);
+}
+
+void ExpenseAnalyticsPage::updateBreakdown()
+{
+    if (!cube) return;
+
+    ExpenseCubeFilter filter;
+    if (categoryFilterComboBox->currentIndex() > 0) {
+        filter.category = categoryFilterComboBox->currentText().toStdString();
+    }
+    if (monthFilterComboBox->currentIndex() > 0) {
+        filter.month = monthFilterComboBox->currentText().toStdString();
+    }
+    if (payerFilterComboBox->currentIndex() > 0) {
+        filter.payer_id = payerFilterComboBox->currentData().toInt();
+    }
+
+    auto dimension = static_cast<ExpenseDimension>(groupByComboBox->currentData().toInt());
+    std::vector<ExpenseBreakdownRow> rows = cube->breakdown(dimension, filter);
+    ExpenseCubeTotals totals = cube->totals(filter);
+
+    breakdownTable->setRowCount(0); // Clear existing rows
+    breakdownTable->setRowCount(rows.size());
+    for (size_t i = 0; i < rows.size(); ++i) {
+        double share = totals.total > 0 ? rows[i].total / totals.total * 100.0 : 0.0;
+        breakdownTable->setItem(i, 0, new QTableWidgetItem(QString::fromStdString(rows[i].label)));
+        breakdownTable->setItem(i, 1, new QTableWidgetItem(QString::number(rows[i].total, 'f', 2)));
+        breakdownTable->setItem(i, 2, new QTableWidgetItem(QString::number(rows[i].expense_count)));
+        breakdownTable->setItem(i, 3, new QTableWidgetItem(QString::number(share, 'f', 1) + "%"));
+    }
+
+    totalLabel->setText(QString("Total: %1 across %2 expenses")
+                            .arg(QString::number(totals.total, 'f', 2))
+                            .arg(totals.expense_count));
+}
@@ -1,5 +1,6 @@
 #include "expensetrackingpage.h"
 #include "database.h"
+#include <QShowEvent>
 #include <QVBoxLayout>
 #include <QHBoxLayout>
 #include <QTableWidget>
@@ -11,8 +12,11 @@
 #include <QComboBox>
 #include <QLabel>
 #include <QInputDialog> // Added for editing
+#include <QSignalBlocker>
+#include <algorithm>
 #include "expense.h"
 #include "user.h"
+#include "stallwatchdog.h"
 
 ExpenseTrackingPage::ExpenseTrackingPage(User* currentUser, QWidget *parent)
     : QWidget(parent), loggedInUser(currentUser)
@@ -42,13 +46,11 @@ ExpenseTrackingPage::ExpenseTrackingPage(User* currentUser, QWidget *parent)
     inputLayout->addWidget(priceLineEdit);
 
     categoryComboBox = new QComboBox(this);
-    categoryComboBox->addItem("Food");
-    categoryComboBox->addItem("Utilities");
-    categoryComboBox->addItem("Rent");
-    categoryComboBox->addItem("Other");
-    // Add more categories as needed
     inputLayout->addWidget(categoryComboBox);
 
+    auto addCategoryButton = new QPushButton("New Category...", this);
+    inputLayout->addWidget(addCategoryButton);
+
     addExpenseButton = new QPushButton("Add Expense", this);
     inputLayout->addWidget(addExpenseButton);
     mainLayout->addLayout(inputLayout);
@@ -57,11 +59,6 @@ ExpenseTrackingPage::ExpenseTrackingPage(User* currentUser, QWidget *parent)
     auto filterLayout = new QHBoxLayout();
     filterLayout->addWidget(new QLabel("Filter by Category:"));
     filterCategoryComboBox = new QComboBox(this);
-    filterCategoryComboBox->addItem("All");
-    filterCategoryComboBox->addItem("Food");
-    filterCategoryComboBox->addItem("Utilities");
-    filterCategoryComboBox->addItem("Rent");
-    filterCategoryComboBox->addItem("Other");
     filterLayout->addWidget(filterCategoryComboBox);
     filterLayout->addStretch();
     mainLayout->addLayout(filterLayout);
@@ -91,23 +88,54 @@ ExpenseTrackingPage::ExpenseTrackingPage(User* currentUser, QWidget *parent)
     connect(editExpenseButton, &QPushButton::clicked, this, &ExpenseTrackingPage::editExpenseClicked);
     connect(deleteExpenseButton, &QPushButton::clicked, this, &ExpenseTrackingPage::deleteExpenseClicked);
     connect(refreshButton, &QPushButton::clicked, this, &ExpenseTrackingPage::refreshExpenses);
-    connect(filterCategoryComboBox, &QComboBox::currentTextChanged, this, &ExpenseTrackingPage::filterExpensesByCategory);
+    connect(filterCategoryComboBox, &QComboBox::currentIndexChanged, this, &ExpenseTrackingPage::filterExpensesByCategory);
+    connect(addCategoryButton, &QPushButton::clicked, this, &ExpenseTrackingPage::addCategoryClicked);
+
+    setLayout(mainLayout);
+}
 
-    // Initial load
+void ExpenseTrackingPage::showEvent(QShowEvent *event)
+{
+    QWidget::showEvent(event);
+    if (loaded) return;
+    loaded = true;
+    loadCategories();
     loadExpenses();
+}
 
-    setLayout(mainLayout);
+void ExpenseTrackingPage::loadCategories()
+{
+    StallActivity activity("ExpenseTrackingPage::loadCategories");
+    categories = getAllExpenseCategories();
+    int selectedFilterId = currentFilterCategoryId();
+
+    // Both combo boxes carry the category id as item data; the filter adds "All" with id 0.
+    const QSignalBlocker blocker(filterCategoryComboBox);
+    categoryComboBox->clear();
+    filterCategoryComboBox->clear();
+    filterCategoryComboBox->addItem("All", 0);
+    for (const auto& category : categories) {
+        categoryComboBox->addItem(QString::fromStdString(category.name), category.id);
+        filterCategoryComboBox->addItem(QString::fromStdString(category.name), category.id);
+    }
+    filterCategoryComboBox->setCurrentIndex(std::max(0, filterCategoryComboBox->findData(selectedFilterId)));
+}
+
+int ExpenseTrackingPage::currentFilterCategoryId() const
+{
+    return filterCategoryComboBox->currentIndex() >= 0 ? filterCategoryComboBox->currentData().toInt() : 0;
 }
 
-void ExpenseTrackingPage::loadExpenses(const QString &categoryFilter)
+void ExpenseTrackingPage::loadExpenses(int categoryFilterId)
 {
+    StallActivity activity("ExpenseTrackingPage::loadExpenses");
     expenseTable->setRowCount(0); // Clear existing rows
     std::vector<Expense> expenses;
 
-    if (categoryFilter == "All") {
+    if (categoryFilterId == 0) {
         expenses = getAllExpenses();
     } else {
-        expenses = getExpensesByCategory(categoryFilter.toStdString());
+        expenses = getExpensesByCategory(categoryFilterId);
     }
 
     expenseTable->setRowCount(expenses.size());
@@ -118,27 +146,30 @@ void ExpenseTrackingPage::loadExpenses(const QString &categoryFilter)
         expenseTable->setItem(i, 2, new QTableWidgetItem(QString::fromStdString(expenses[i].item_name)));
         expenseTable->setItem(i, 3, new QTableWidgetItem(QString::number(expenses[i].price, 'f', 2)));
         expenseTable->setItem(i, 4, new QTableWidgetItem(QString::fromStdString(expenses[i].paid_by_user_name)));
-        expenseTable->setItem(i, 5, new QTableWidgetItem(QString::fromStdString(expenses[i].category)));
+        auto *categoryItem = new QTableWidgetItem(QString::fromStdString(expenses[i].category));
+        categoryItem->setData(Qt::UserRole, expenses[i].category_id);
+        expenseTable->setItem(i, 5, categoryItem);
     }
 }
 
 void ExpenseTrackingPage::addExpenseClicked()
 {
+    StallActivity activity("ExpenseTrackingPage::addExpenseClicked");
     QString date = purchaseDateEdit->date().toString("yyyy-MM-dd");
     QString itemName = itemNameLineEdit->text().trimmed();
     double price = priceLineEdit->text().toDouble();
-    QString category = categoryComboBox->currentText();
+    int categoryId = categoryComboBox->currentData().toInt();
 
-    if (itemName.isEmpty() || price <= 0) {
-        QMessageBox::warning(this, "Input Error", "Item name cannot be empty and price must be greater than 0.");
+    if (itemName.isEmpty() || price <= 0 || categoryComboBox->currentIndex() < 0) {
+        QMessageBox::warning(this, "Input Error", "Item name cannot be empty, price must be greater than 0 and a category must be selected.");
         return;
     }
 
-    if (addExpense(date.toStdString(), itemName.toStdString(), price, loggedInUser->id, category.toStdString())) {
+    if (addExpense(date.toStdString(), itemName.toStdString(), price, loggedInUser->id, categoryId)) {
         QMessageBox::information(this, "Success", "Expense added successfully.");
         itemNameLineEdit->clear();
         priceLineEdit->clear();
-        loadExpenses(filterCategoryComboBox->currentText()); // Refresh the table with current filter
+        loadExpenses(currentFilterCategoryId()); // Refresh the table with current filter
     } else {
         QMessageBox::critical(this, "Error", "Failed to add expense.");
     }
@@ -146,6 +177,7 @@ void ExpenseTrackingPage::addExpenseClicked()
 
 void ExpenseTrackingPage::editExpenseClicked()
 {
+    StallActivity activity("ExpenseTrackingPage::editExpenseClicked");
     int selectedRow = expenseTable->currentRow();
     if (selectedRow < 0) {
         QMessageBox::warning(this, "Selection Error", "Please select an expense to edit.");
@@ -155,7 +187,7 @@ void ExpenseTrackingPage::editExpenseClicked()
     int id = expenseTable->item(selectedRow, 0)->text().toInt();
     QString currentItemName = expenseTable->item(selectedRow, 2)->text();
     double currentPrice = expenseTable->item(selectedRow, 3)->text().toDouble();
-    QString currentCategory = expenseTable->item(selectedRow, 5)->text();
+    int currentCategoryId = expenseTable->item(selectedRow, 5)->data(Qt::UserRole).toInt();
 
     bool ok;
     QString newItemName = QInputDialog::getText(this, "Edit Expense",
@@ -168,19 +200,22 @@ void ExpenseTrackingPage::editExpenseClicked()
                                               currentPrice, 0.01, 1000000.00, 2, &ok);
     if (!ok || newPrice <= 0) return; // User cancelled or entered invalid price
 
-    QStringList categories;
-    for (int i = 0; i < categoryComboBox->count(); ++i) {
-        if (categoryComboBox->itemText(i) != "All") // Exclude "All" from editable categories
-            categories << categoryComboBox->itemText(i);
+    QStringList categoryNames;
+    int currentIndex = 0;
+    for (size_t i = 0; i < categories.size(); ++i) {
+        categoryNames << QString::fromStdString(categories[i].name);
+        if (categories[i].id == currentCategoryId) currentIndex = static_cast<int>(i);
     }
+    if (categoryNames.isEmpty()) return;
     QString newCategory = QInputDialog::getItem(this, "Edit Expense",
                                                 "New category:",
-                                                categories, categories.indexOf(currentCategory), false, &ok);
+                                                categoryNames, currentIndex, false, &ok);
     if (!ok) return; // User cancelled
+    int newCategoryId = categories[categoryNames.indexOf(newCategory)].id;
 
-    if (editExpense(id, newItemName.toStdString(), newPrice, newCategory.toStdString())) {
+    if (editExpense(id, newItemName.toStdString(), newPrice, newCategoryId)) {
         QMessageBox::information(this, "Success", "Expense updated successfully.");
-        loadExpenses(filterCategoryComboBox->currentText());
+        loadExpenses(currentFilterCategoryId());
     } else {
         QMessageBox::critical(this, "Error", "Failed to update expense.");
     }
@@ -188,6 +223,7 @@ void ExpenseTrackingPage::editExpenseClicked()
 
 void ExpenseTrackingPage::deleteExpenseClicked()
 {
+    StallActivity activity("ExpenseTrackingPage::deleteExpenseClicked");
     int selectedRow = expenseTable->currentRow();
     if (selectedRow < 0) {
         QMessageBox::warning(this, "Selection Error", "Please select an expense to delete.");
@@ -202,7 +238,7 @@ void ExpenseTrackingPage::deleteExpenseClicked()
                               QMessageBox::Yes | QMessageBox::No) == QMessageBox::Yes) {
         if (deleteExpense(id)) {
             QMessageBox::information(this, "Success", "Expense deleted successfully.");
-            loadExpenses(filterCategoryComboBox->currentText());
+            loadExpenses(currentFilterCategoryId());
         } else {
             QMessageBox::critical(this, "Error", "Failed to delete expense.");
         }
@@ -211,11 +247,34 @@ void ExpenseTrackingPage::deleteExpenseClicked()
 
 void ExpenseTrackingPage::refreshExpenses()
 {
-    loadExpenses(filterCategoryComboBox->currentText());
+    StallActivity activity("ExpenseTrackingPage::refreshExpenses");
+    loadExpenses(currentFilterCategoryId());
     QMessageBox::information(this, "Refresh", "Expenses refreshed.");
 }
 
-void ExpenseTrackingPage::filterExpensesByCategory(const QString &category)
+void ExpenseTrackingPage::filterExpensesByCategory(int index)
+{
+    StallActivity activity("ExpenseTrackingPage::filterExpensesByCategory");
+    loadExpenses(index >= 0 ? filterCategoryComboBox->itemData(index).toInt() : 0);
+}
+
+void ExpenseTrackingPage::addCategoryClicked()
 {
-    loadExpenses(category);
+    StallActivity activity("ExpenseTrackingPage::addCategoryClicked");
+    bool ok;
+    QString name = QInputDialog::getText(this, "New Category",
+                                         "Category name:",
+                                         QLineEdit::Normal, QString(), &ok).trimmed();
+    if (!ok) return; // User cancelled
+    if (name.isEmpty()) {
+        QMessageBox::warning(this, "Input Error", "Category name cannot be empty.");
+        return;
+    }
+
+    if (addExpenseCategory(name.toStdString())) {
+        loadCategories();
+        categoryComboBox->setCurrentIndex(categoryComboBox->findText(name));
+    } else {
+        QMessageBox::critical(this, "Error", "Failed to add category. It might already exist.");
+    }
 }
\ No newline at end of file
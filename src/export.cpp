@@ -0,0 +1,356 @@
+#include "export.h"
+#include "database.h"
+#include "dateutil.h"
+#include "finance.h"
+#include "mess.h"
+#include "logger.h"
+#include <cppconn/resultset.h>
+#include <cppconn/statement.h>
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <memory>
+
+BufferedFileWriter::BufferedFileWriter(const std::string& path)
+    : file(nullptr), ownsFile(false), failed(false), used(0)
+{
+    if (path == "-") {
+        file = stdout;
+    } else {
+        file = std::fopen(path.c_str(), "wb");
+        ownsFile = file != nullptr;
+    }
+    if (file) {
+        std::setvbuf(file, nullptr, _IONBF, 0); // Our own buffer is the only one
+    } else {
+        failed = true;
+    }
+}
+
+BufferedFileWriter::~BufferedFileWriter() {
+    close();
+}
+
+void BufferedFileWriter::write(const void* data, size_t size) {
+    const char* bytes = static_cast<const char*>(data);
+    while (size > 0 && !failed) {
+        if (used == BUFFER_SIZE) flushBuffer();
+        size_t chunk = std::min(size, BUFFER_SIZE - used);
+        std::memcpy(buffer + used, bytes, chunk);
+        used += chunk;
+        bytes += chunk;
+        size -= chunk;
+    }
+}
+
+void BufferedFileWriter::writeU16(uint16_t value) {
+    uint8_t bytes[2] = {static_cast<uint8_t>(value), static_cast<uint8_t>(value >> 8)};
+    write(bytes, sizeof(bytes));
+}
+
+void BufferedFileWriter::writeU32(uint32_t value) {
+    uint8_t bytes[4];
+    for (int i = 0; i < 4; ++i) bytes[i] = static_cast<uint8_t>(value >> (8 * i));
+    write(bytes, sizeof(bytes));
+}
+
+void BufferedFileWriter::writeU64(uint64_t value) {
+    uint8_t bytes[8];
+    for (int i = 0; i < 8; ++i) bytes[i] = static_cast<uint8_t>(value >> (8 * i));
+    write(bytes, sizeof(bytes));
+}
+
+void BufferedFileWriter::flushBuffer() {
+    if (used > 0 && file && std::fwrite(buffer, 1, used, file) != used) {
+        failed = true;
+    }
+    used = 0;
+}
+
+bool BufferedFileWriter::close() {
+    if (!file) return !failed;
+    flushBuffer();
+    if (std::fflush(file) != 0) failed = true;
+    if (ownsFile && std::fclose(file) != 0) failed = true;
+    file = nullptr;
+    return !failed;
+}
+
+// --- CSV ---
+
+void CsvExportSink::begin(const std::vector<ExportColumn>& columns) {
+    decimals.clear();
+    for (const auto& column : columns) {
+        addText(column.name);
+        decimals.push_back(column.csv_decimals);
+    }
+    endRow();
+}
+
+void CsvExportSink::separator() {
+    if (!atRowStart) out.write(",", 1);
+    atRowStart = false;
+    ++column;
+}
+
+void CsvExportSink::addInt(int64_t value) {
+    separator();
+    char text[24];
+    int length = std::snprintf(text, sizeof(text), "%lld", static_cast<long long>(value));
+    out.write(text, length);
+}
+
+void CsvExportSink::addDouble(double value) {
+    separator();
+    int places = column - 1 < decimals.size() ? decimals[column - 1] : -1;
+    char text[32];
+    int length;
+    if (places >= 0) {
+        length = std::snprintf(text, sizeof(text), "%.*f", places, value);
+    } else {
+        // The shortest form that reads back as the same double; %.17g always does
+        length = std::snprintf(text, sizeof(text), "%.15g", value);
+        if (std::strtod(text, nullptr) != value) length = std::snprintf(text, sizeof(text), "%.17g", value);
+    }
+    out.write(text, length);
+}
+
+void CsvExportSink::addText(const std::string& value) {
+    separator();
+    if (value.find_first_of(",\"\n\r") == std::string::npos) {
+        out.write(value.data(), value.size());
+        return;
+    }
+    out.write("\"", 1);
+    for (char c : value) {
+        if (c == '"') out.write("\"", 1);
+        out.write(&c, 1);
+    }
+    out.write("\"", 1);
+}
+
+void CsvExportSink::endRow() {
+    out.write("\n", 1);
+    atRowStart = true;
+    column = 0;
+}
+
+bool CsvExportSink::finish() {
+    return out.good();
+}
+
+// --- Columnar ---
+
+void ColumnarExportSink::begin(const std::vector<ExportColumn>& columns) {
+    out.write("MMSCOL1\0", 8);
+    out.writeU32(static_cast<uint32_t>(columns.size()));
+    buffers.clear();
+    for (const auto& column : columns) {
+        out.writeU8(static_cast<uint8_t>(column.type));
+        out.writeU16(static_cast<uint16_t>(column.name.size()));
+        out.write(column.name.data(), column.name.size());
+
+        ColumnBuffer buffer;
+        buffer.type = column.type;
+        buffers.push_back(std::move(buffer));
+    }
+}
+
+void ColumnarExportSink::addInt(int64_t value) {
+    ColumnBuffer& column = buffers[nextColumn++];
+    if (column.type == ExportColumnType::Double) {
+        column.doubles.push_back(static_cast<double>(value));
+    } else {
+        column.ints.push_back(value);
+    }
+}
+
+void ColumnarExportSink::addDouble(double value) {
+    buffers[nextColumn++].doubles.push_back(value);
+}
+
+void ColumnarExportSink::addText(const std::string& value) {
+    ColumnBuffer& column = buffers[nextColumn++];
+    column.lengths.push_back(static_cast<uint32_t>(value.size()));
+    column.bytes += value;
+    groupTextBytes += value.size();
+}
+
+void ColumnarExportSink::endRow() {
+    nextColumn = 0;
+    ++groupRows;
+    ++totalRows;
+    if (groupRows >= ROWS_PER_GROUP || groupTextBytes >= MAX_GROUP_TEXT_BYTES) {
+        flushGroup();
+    }
+}
+
+void ColumnarExportSink::flushGroup() {
+    if (groupRows == 0) return;
+    out.writeU32(groupRows);
+    for (auto& column : buffers) {
+        switch (column.type) {
+            case ExportColumnType::Int:
+                for (int64_t value : column.ints) out.writeU64(static_cast<uint64_t>(value));
+                column.ints.clear();
+                break;
+            case ExportColumnType::Double:
+                for (double value : column.doubles) {
+                    uint64_t bits;
+                    std::memcpy(&bits, &value, sizeof(bits));
+                    out.writeU64(bits);
+                }
+                column.doubles.clear();
+                break;
+            case ExportColumnType::Text:
+                out.writeU32(static_cast<uint32_t>(column.bytes.size()));
+                for (uint32_t length : column.lengths) out.writeU32(length);
+                out.write(column.bytes.data(), column.bytes.size());
+                column.lengths.clear();
+                column.bytes.clear();
+                break;
+        }
+    }
+    groupRows = 0;
+    groupTextBytes = 0;
+}
+
+bool ColumnarExportSink::finish() {
+    flushGroup();
+    out.writeU32(0);
+    out.writeU64(totalRows);
+    return out.good();
+}
+
+// --- Exports ---
+
+namespace { // Anonymous namespace for file-local helpers
+    bool runExport(const std::string& path, ExportFormat format, const char* name,
+                   const std::function<bool(ExportSink&)>& produce) {
+        BufferedFileWriter writer(path);
+        if (!writer.isOpen()) {
+            logEvent(LogLevel::Error, name, "Could not open the export file for writing", {{"path", path}});
+            return false;
+        }
+
+        std::unique_ptr<ExportSink> sink;
+        if (format == ExportFormat::Csv) {
+            sink = std::make_unique<CsvExportSink>(writer);
+        } else {
+            sink = std::make_unique<ColumnarExportSink>(writer);
+        }
+
+        bool ok = produce(*sink) && sink->finish();
+        ok = writer.close() && ok;
+        if (!ok) {
+            logEvent(LogLevel::Error, name, "Export did not complete; the file may be truncated", {{"path", path}});
+        }
+        return ok;
+    }
+
+    // Values are bound into the SQL text because the forward-only result set
+    // that makes MySQL stream rows (mysql_use_result) is only available on a
+    // plain Statement. Callers must pass validated literals only.
+    bool streamQuery(const std::string& query, const std::vector<ExportColumn>& columns, ExportSink& sink, const char* name) {
+        try {
+            std::unique_ptr<sql::Connection> con(getReadConnection());
+            std::unique_ptr<sql::Statement> stmt(con->createStatement());
+            stmt->setResultSetType(sql::ResultSet::TYPE_FORWARD_ONLY);
+            std::unique_ptr<sql::ResultSet> res(stmt->executeQuery(query));
+
+            sink.begin(columns);
+            while (res->next()) {
+                for (uint32_t i = 0; i < columns.size(); ++i) {
+                    switch (columns[i].type) {
+                        case ExportColumnType::Int:    sink.addInt(res->getInt64(i + 1)); break;
+                        case ExportColumnType::Double: sink.addDouble(static_cast<double>(res->getDouble(i + 1))); break;
+                        case ExportColumnType::Text:   sink.addText(res->getString(i + 1)); break;
+                    }
+                }
+                sink.endRow();
+            }
+            return true;
+        } catch (sql::SQLException& e) {
+            logSqlError(name, e);
+            return false;
+        }
+    }
+} // namespace
+
+bool exportSettlement(int period_id, const std::string& path, ExportFormat format) {
+    return runExport(path, format, "exportSettlement", [&](ExportSink& sink) {
+        // Settlement output is one row per user, so the in-memory result is already bounded.
+        auto [mealRate, reports] = generateMonthlySettlement(period_id);
+        sink.begin({
+            {"user_id", ExportColumnType::Int},
+            {"user_name", ExportColumnType::Text},
+            {"total_meals", ExportColumnType::Int},
+            {"meal_rate", ExportColumnType::Double},
+            {"total_meal_cost", ExportColumnType::Double, 2},
+            {"total_payments", ExportColumnType::Double, 2},
+            {"total_shopping_expenses", ExportColumnType::Double, 2},
+            {"final_balance", ExportColumnType::Double, 2},
+        });
+        for (const auto& r : reports) {
+            sink.addInt(r.user_id);
+            sink.addText(r.user_name);
+            sink.addInt(r.total_meals);
+            sink.addDouble(mealRate);
+            sink.addDouble(r.total_meal_cost);
+            sink.addDouble(r.total_payments);
+            sink.addDouble(r.total_shopping_expenses);
+            sink.addDouble(r.final_balance);
+            sink.endRow();
+        }
+        return true;
+    });
+}
+
+bool exportAttendance(const std::string& startDate, const std::string& endDate, const std::string& path, ExportFormat format) {
+    int startDay, endDay;
+    if (!parseIsoDate(startDate, startDay) || !parseIsoDate(endDate, endDay) || endDay < startDay) {
+        logEvent(LogLevel::Error, "exportAttendance", "Invalid date range", {{"start_date", startDate}, {"end_date", endDate}});
+        return false;
+    }
+
+    // Re-formatting the parsed dates guarantees only digits and dashes reach the SQL text.
+    std::string query =
+        "SELECT DATE_FORMAT(ma.attendance_date, '%Y-%m-%d'), ma.user_id, u.name, ma.meal_type "
+        "FROM meal_attendance ma JOIN users u ON ma.user_id = u.id "
+        "WHERE ma.mess_id = " + std::to_string(currentMessId()) + " "
+        "AND ma.attendance_date BETWEEN '" + formatIsoDate(startDay) + "' AND '" + formatIsoDate(endDay) + "' "
+        "ORDER BY ma.attendance_date, ma.user_id, ma.meal_type";
+
+    return runExport(path, format, "exportAttendance", [&](ExportSink& sink) {
+        return streamQuery(query, {
+            {"date", ExportColumnType::Text},
+            {"user_id", ExportColumnType::Int},
+            {"user_name", ExportColumnType::Text},
+            {"meal_type", ExportColumnType::Text},
+        }, sink, "exportAttendance");
+    });
+}
+
+bool exportExpenseLedger(const std::string& path, ExportFormat format) {
+    std::string query =
+        "SELECT e.id, DATE_FORMAT(e.purchase_date, '%Y-%m-%d'), e.item_name, e.price, "
+        "COALESCE(e.paid_by_user_id, 0), COALESCE(u.name, ''), COALESCE(c.name, '') "
+        "FROM expenses e "
+        "LEFT JOIN users u ON e.paid_by_user_id = u.id "
+        "LEFT JOIN expense_categories c ON e.category_id = c.id "
+        "WHERE e.mess_id = " + std::to_string(currentMessId()) + " "
+        "ORDER BY e.purchase_date, e.id";
+
+    return runExport(path, format, "exportExpenseLedger", [&](ExportSink& sink) {
+        return streamQuery(query, {
+            {"id", ExportColumnType::Int},
+            {"purchase_date", ExportColumnType::Text},
+            {"item_name", ExportColumnType::Text},
+            {"price", ExportColumnType::Double, 2},
+            {"paid_by_user_id", ExportColumnType::Int},
+            {"paid_by_user_name", ExportColumnType::Text},
+            {"category", ExportColumnType::Text},
+        }, sink, "exportExpenseLedger");
+    });
+}
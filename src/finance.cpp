@@ -1,21 +1,268 @@
 #include "finance.h"
 #include "period.h"
+#include "user.h"
 #include "database.h"
+#include "mess.h"
+#include "journal.h"
+#include "ledger.h"
+#include "dateutil.h"
+#include "logger.h"
+#include "slowquery.h"
 #include <cppconn/prepared_statement.h>
 #include <cppconn/resultset.h>
-#include <iostream>
+#include <algorithm>
+#include <map>
+#include <mutex>
+#include <set>
+
+namespace { // Anonymous namespace for file-local helpers
+    const size_t MAX_ROWS_PER_INSERT = 1000;
+
+    struct CachedSettlement {
+        std::string fingerprint;
+        std::pair<double, std::vector<SettlementReport>> result;
+    };
+    std::mutex settlementCacheMutex;
+    std::map<int, CachedSettlement> settlementCache; // By period ID
+
+    // Row count, highest id and latest updated_at of every table the settlement
+    // reads, limited to the period's month. Inserts move the id, deletes the
+    // count and edits updated_at, so an equal fingerprint means equal inputs.
+    // One round trip over the (mess_id, date) indexes, touching one partition of each table.
+    std::string settlementFingerprint(sql::Connection& con, int messId, const std::string& firstDay, const std::string& nextFirstDay) {
+        std::unique_ptr<TracedStatement> pstmt(prepareTraced(con, "settlementFingerprint",
+            "SELECT CONCAT_WS('|', "
+            " (SELECT CONCAT_WS(':', COUNT(*), COALESCE(MAX(id), 0), COALESCE(MAX(updated_at), '')) FROM expenses "
+            "  WHERE mess_id = ? AND purchase_date >= ? AND purchase_date < ?), "
+            " (SELECT CONCAT_WS(':', COUNT(*), COALESCE(MAX(id), 0)) FROM meal_attendance "
+            "  WHERE mess_id = ? AND attendance_date >= ? AND attendance_date < ?), "
+            " (SELECT CONCAT_WS(':', COUNT(*), COALESCE(MAX(id), 0), COALESCE(MAX(updated_at), '')) FROM payments "
+            "  WHERE mess_id = ? AND date >= ? AND date < ?), "
+            " (SELECT CONCAT_WS(':', COUNT(*), COALESCE(MAX(id), 0), COALESCE(MAX(updated_at), '')) FROM users WHERE mess_id = ?) "
+            ") AS fingerprint"
+        ));
+        int paramIndex = 1;
+        for (int i = 0; i < 3; ++i) {
+            pstmt->setInt(paramIndex++, messId);
+            pstmt->setString(paramIndex++, firstDay);
+            pstmt->setString(paramIndex++, nextFirstDay);
+        }
+        pstmt->setInt(paramIndex, messId);
+        std::unique_ptr<sql::ResultSet> res(pstmt->executeQuery());
+        return res->next() ? res->getString("fingerprint") : std::string();
+    }
+
+    // Runs the settlement aggregates for one month on the given connection. The
+    // month is the half-open range [firstDay, nextFirstDay), so each table is
+    // read from one partition.
+    std::pair<double, std::vector<SettlementReport>> computeSettlement(sql::Connection& con, int messId, const std::string& firstDay, const std::string& nextFirstDay) {
+        double meal_rate = 0.0;
+        std::vector<SettlementReport> reports;
+
+        // 1. Calculate total expenses for the period
+        double total_expenses_period = 0.0;
+        std::unique_ptr<TracedStatement> pstmt_exp(prepareTraced(con, "computeSettlement", "SELECT COALESCE(SUM(price), 0) AS total FROM expenses WHERE mess_id = ? AND purchase_date >= ? AND purchase_date < ?"));
+        pstmt_exp->setInt(1, messId);
+        pstmt_exp->setString(2, firstDay);
+        pstmt_exp->setString(3, nextFirstDay);
+        std::unique_ptr<sql::ResultSet> res_exp(pstmt_exp->executeQuery());
+        if (res_exp->next()) {
+            total_expenses_period = res_exp->getDouble("total");
+        }
+
+        // 2. Calculate total meals for the period
+        int total_meals_period = 0;
+        std::unique_ptr<TracedStatement> pstmt_meals(prepareTraced(con, "computeSettlement", "SELECT COUNT(*) AS total FROM meal_attendance WHERE mess_id = ? AND attendance_date >= ? AND attendance_date < ?"));
+        pstmt_meals->setInt(1, messId);
+        pstmt_meals->setString(2, firstDay);
+        pstmt_meals->setString(3, nextFirstDay);
+        std::unique_ptr<sql::ResultSet> res_meals(pstmt_meals->executeQuery());
+        if (res_meals->next()) {
+            total_meals_period = res_meals->getInt("total");
+        }
+
+        // 3. Calculate meal rate
+        if (total_meals_period > 0) {
+            meal_rate = total_expenses_period / total_meals_period;
+        }
+
+        // 4. Get data for all users and calculate their individual reports
+        std::unique_ptr<TracedStatement> pstmt_users(prepareTraced(con, "computeSettlement",
+            "SELECT u.id, u.name, "
+            "COALESCE(att.meal_count, 0) AS total_meals, "
+            "COALESCE(pay.total_payments, 0) AS total_payments, "
+            "COALESCE(exp.total_shopping, 0) AS total_shopping "
+            "FROM users u "
+            "LEFT JOIN (SELECT user_id, COUNT(*) as meal_count FROM meal_attendance WHERE mess_id = ? AND attendance_date >= ? AND attendance_date < ? GROUP BY user_id) att ON u.id = att.user_id "
+            "LEFT JOIN (SELECT user_id, SUM(amount) as total_payments FROM payments WHERE mess_id = ? AND date >= ? AND date < ? GROUP BY user_id) pay ON u.id = pay.user_id "
+            "LEFT JOIN (SELECT paid_by_user_id, SUM(price) as total_shopping FROM expenses WHERE mess_id = ? AND purchase_date >= ? AND purchase_date < ? GROUP BY paid_by_user_id) exp ON u.id = exp.paid_by_user_id "
+            "WHERE u.mess_id = ? "
+            "ORDER BY u.id"
+        ));
+        // Bind parameters for all subqueries
+        int paramIndex = 1;
+        for (int i = 0; i < 3; ++i) {
+            pstmt_users->setInt(paramIndex++, messId);
+            pstmt_users->setString(paramIndex++, firstDay);
+            pstmt_users->setString(paramIndex++, nextFirstDay);
+        }
+        pstmt_users->setInt(paramIndex, messId);
+
+        std::unique_ptr<sql::ResultSet> res_users(pstmt_users->executeQuery());
+        while (res_users->next()) {
+            SettlementReport report;
+            report.user_id = res_users->getInt("id");
+            report.user_name = res_users->getString("name");
+            report.total_meals = res_users->getInt("total_meals");
+            report.total_payments = res_users->getDouble("total_payments");
+            report.total_shopping_expenses = res_users->getDouble("total_shopping");
+
+            // Perform final calculations
+            report.total_meal_cost = report.total_meals * meal_rate;
+            report.total_contributions = report.total_payments + report.total_shopping_expenses;
+            report.final_balance = report.total_contributions - report.total_meal_cost;
+
+            reports.push_back(report);
+        }
+
+        return {meal_rate, reports};
+    }
+
+    // O(users): one indexed read of the rows stored when the period was closed.
+    std::pair<double, std::vector<SettlementReport>> readFrozenSettlement(sql::Connection& con, int periodId) {
+        double meal_rate = 0.0;
+        std::vector<SettlementReport> reports;
+        std::unique_ptr<TracedStatement> pstmt(prepareTraced(con, "readFrozenSettlement",
+            "SELECT user_id, user_name, meal_rate, total_meals, total_meal_cost, total_payments, "
+            "total_shopping_expenses, total_contributions, final_balance "
+            "FROM period_settlements WHERE period_id = ? ORDER BY user_id"));
+        pstmt->setInt(1, periodId);
+        std::unique_ptr<sql::ResultSet> res(pstmt->executeQuery());
+        while (res->next()) {
+            meal_rate = res->getDouble("meal_rate");
+            SettlementReport report;
+            report.user_id = res->getInt("user_id");
+            report.user_name = res->getString("user_name");
+            report.total_meals = res->getInt("total_meals");
+            report.total_meal_cost = res->getDouble("total_meal_cost");
+            report.total_payments = res->getDouble("total_payments");
+            report.total_shopping_expenses = res->getDouble("total_shopping_expenses");
+            report.total_contributions = res->getDouble("total_contributions");
+            report.final_balance = res->getDouble("final_balance");
+            reports.push_back(report);
+        }
+        return {meal_rate, reports};
+    }
+} // namespace
 
 bool recordPayment(int user_id, double amount, const std::string& date) {
+    // The key makes a replay from the offline journal a no-op if this insert did land.
+    std::string idempotencyKey = generateIdempotencyKey();
     try {
         std::unique_ptr<sql::Connection> con(getConnection());
-        std::unique_ptr<sql::PreparedStatement> pstmt(con->prepareStatement("INSERT INTO payments(user_id, amount, date) VALUES(?, ?, STR_TO_DATE(?, '%Y-%m-%d'))"));
-        pstmt->setInt(1, user_id);
-        pstmt->setDouble(2, amount);
-        pstmt->setString(3, date);
+        con->setAutoCommit(false); // Closing the connection on error rolls the insert back
+        lockOpenPeriods(*con, currentMessId(), {date});
+        lockMessMembers(*con, currentMessId(), {user_id});
+        std::unique_ptr<TracedStatement> pstmt(prepareTraced(*con, "recordPayment", "INSERT INTO payments(mess_id, user_id, amount, date, idempotency_key) VALUES(?, ?, ?, STR_TO_DATE(?, '%Y-%m-%d'), ?)"));
+        pstmt->setInt(1, currentMessId());
+        pstmt->setInt(2, user_id);
+        pstmt->setDouble(3, amount);
+        pstmt->setString(4, date);
+        pstmt->setString(5, idempotencyKey);
         pstmt->executeUpdate();
+
+        std::unique_ptr<sql::Statement> stmt(con->createStatement());
+        std::unique_ptr<sql::ResultSet> res(stmt->executeQuery("SELECT LAST_INSERT_ID() AS id"));
+        res->next();
+        postLedgerEntries(*con, currentMessId(), {{user_id, LedgerEntryType::Payment, amount, date, res->getInt("id"), "Payment"}});
+        con->commit();
+        noteWrite();
         return true;
     } catch (sql::SQLException &e) {
-        std::cerr << "SQLException in recordPayment: " << e.what() << std::endl;
+        if (isConnectionError(e)) {
+            JournalRecord record;
+            record.type = JournalRecordType::Payment;
+            record.mess_id = currentMessId();
+            record.user_id = user_id;
+            record.amount = amount;
+            record.date = date;
+            record.idempotency_key = idempotencyKey;
+            if (appendToJournal(record)) {
+                logEvent(LogLevel::Warning, "recordPayment", "Database unreachable; payment saved to the offline journal");
+                return true;
+            }
+        }
+        logSqlError("recordPayment", e);
+        return false;
+    }
+}
+
+bool recordPayments(const std::vector<PaymentRecord>& payments) {
+    if (payments.empty()) {
+        return true;
+    }
+    std::vector<std::string> idempotencyKeys;
+    for (size_t i = 0; i < payments.size(); ++i) {
+        idempotencyKeys.push_back(generateIdempotencyKey());
+    }
+    try {
+        std::unique_ptr<sql::Connection> con(getConnection());
+        con->setAutoCommit(false); // Closing the connection on error rolls every insert back
+        int messId = currentMessId();
+        std::set<std::string> dates;
+        std::vector<int> userIds;
+        for (const auto& payment : payments) {
+            dates.insert(payment.date);
+            userIds.push_back(payment.user_id);
+        }
+        lockOpenPeriods(*con, messId, std::vector<std::string>(dates.begin(), dates.end()));
+        lockMessMembers(*con, messId, userIds);
+
+        for (size_t start = 0; start < payments.size(); start += MAX_ROWS_PER_INSERT) {
+            size_t count = std::min(MAX_ROWS_PER_INSERT, payments.size() - start);
+            std::string query = "INSERT INTO payments (mess_id, user_id, amount, date, idempotency_key) VALUES ";
+            for (size_t i = 0; i < count; ++i) {
+                query += "(?, ?, ?, STR_TO_DATE(?, '%Y-%m-%d'), ?)";
+                if (i < count - 1) {
+                    query += ", ";
+                }
+            }
+            std::unique_ptr<TracedStatement> pstmt(prepareTraced(*con, "recordPayments", query));
+            int paramIndex = 1;
+            for (size_t i = start; i < start + count; ++i) {
+                pstmt->setInt(paramIndex++, messId);
+                pstmt->setInt(paramIndex++, payments[i].user_id);
+                pstmt->setDouble(paramIndex++, payments[i].amount);
+                pstmt->setString(paramIndex++, payments[i].date);
+                pstmt->setString(paramIndex++, idempotencyKeys[i]);
+            }
+            pstmt->executeUpdate();
+        }
+
+        // Ids of a multi-row insert need not be consecutive, so find the rows by key
+        postUnpostedWrites(*con, messId, idempotencyKeys);
+        con->commit();
+        noteWrite();
+        return true;
+    } catch (sql::SQLException& e) {
+        if (isConnectionError(e)) {
+            bool journaled = true;
+            for (size_t i = 0; i < payments.size(); ++i) {
+                JournalRecord record;
+                record.type = JournalRecordType::Payment;
+                record.mess_id = currentMessId();
+                record.user_id = payments[i].user_id;
+                record.amount = payments[i].amount;
+                record.date = payments[i].date;
+                record.idempotency_key = idempotencyKeys[i];
+                journaled = appendToJournal(record) && journaled;
+            }
+            if (journaled) {
+                logEvent(LogLevel::Warning, "recordPayments", "Database unreachable; payments saved to the offline journal", {{"count", payments.size()}});
+                return true;
+            }
+        }
+        logSqlError("recordPayments", e);
         return false;
     }
 }
@@ -24,8 +271,9 @@ std::vector<Payment> getPaymentsByUser(int user_id) {
     std::vector<Payment> payments;
     try {
         std::unique_ptr<sql::Connection> con(getConnection());
-        std::unique_ptr<sql::PreparedStatement> pstmt(con->prepareStatement("SELECT id, amount, date FROM payments WHERE user_id = ?"));
+        std::unique_ptr<TracedStatement> pstmt(prepareTraced(*con, "getPaymentsByUser", "SELECT id, amount, date FROM payments WHERE user_id = ? AND mess_id = ?"));
         pstmt->setInt(1, user_id);
+        pstmt->setInt(2, currentMessId());
         std::unique_ptr<sql::ResultSet> res(pstmt->executeQuery());
         while (res->next()) {
             Payment p;
@@ -36,148 +284,178 @@ std::vector<Payment> getPaymentsByUser(int user_id) {
             payments.push_back(p);
         }
     } catch (sql::SQLException &e) {
-        std::cerr << "SQLException in getPaymentsByUser: " << e.what() << std::endl;
+        logSqlError("getPaymentsByUser", e);
     }
     return payments;
 }
 
 FinancialReport getUserFinancialReport(int user_id) {
-    FinancialReport report = {user_id, "", 0.0, 0.0, 0.0};
-    try {
-        std::unique_ptr<sql::Connection> con(getConnection());
-        std::unique_ptr<sql::PreparedStatement> pstmt(con->prepareStatement(
-            "SELECT u.name, COALESCE(SUM(p.amount), 0) AS total_payments, COALESCE(SUM(e.price), 0) AS total_expenses "
-            "FROM users u "
-            "LEFT JOIN payments p ON u.id = p.user_id "
-            "LEFT JOIN expenses e ON u.id = e.paid_by_user_id "
-            "WHERE u.id = ? "
-            "GROUP BY u.id, u.name"
-        ));
-        pstmt->setInt(1, user_id);
-        std::unique_ptr<sql::ResultSet> res(pstmt->executeQuery());
-        if (res->next()) {
-            report.user_name = res->getString("name");
-            report.total_contributions = res->getDouble("total_payments");
-            report.total_expenses = res->getDouble("total_expenses");
-            report.debt_or_surplus = report.total_contributions - report.total_expenses;
-        }
-    } catch (sql::SQLException &e) {
-        std::cerr << "SQLException in getUserFinancialReport: " << e.what() << std::endl;
+    FinancialReport report = {user_id, "", 0.0, 0.0, 0.0, 0.0};
+    LedgerBalance balance;
+    if (getLedgerBalance(user_id, balance)) {
+        report = {balance.user_id, balance.user_name, balance.total_payments, balance.total_shopping,
+                  balance.total_meal_cost, balance.balance};
     }
     return report;
 }
 
 std::vector<FinancialReport> getAllFinancialReports() {
     std::vector<FinancialReport> reports;
-    try {
-        std::unique_ptr<sql::Connection> con(getConnection());
-        std::unique_ptr<sql::Statement> stmt(con->createStatement());
-        std::unique_ptr<sql::ResultSet> res(stmt->executeQuery(
-            "SELECT u.id, u.name, COALESCE(p.total_payments, 0) AS total_payments, COALESCE(e.total_expenses, 0) AS total_expenses "
-            "FROM users u "
-            "LEFT JOIN (SELECT user_id, SUM(amount) AS total_payments FROM payments GROUP BY user_id) p ON u.id = p.user_id "
-            "LEFT JOIN (SELECT paid_by_user_id, SUM(price) AS total_expenses FROM expenses GROUP BY paid_by_user_id) e ON u.id = e.paid_by_user_id"
-        ));
-
-        while (res->next()) {
-            FinancialReport report;
-            report.user_id = res->getInt("id");
-            report.user_name = res->getString("name");
-            report.total_contributions = res->getDouble("total_payments");
-            report.total_expenses = res->getDouble("total_expenses");
-            report.debt_or_surplus = report.total_contributions - report.total_expenses;
-            reports.push_back(report);
-        }
-    } catch (sql::SQLException &e) {
-        std::cerr << "SQLException in getAllFinancialReports: " << e.what() << std::endl;
+    for (const auto& balance : getLedgerBalances()) {
+        reports.push_back({balance.user_id, balance.user_name, balance.total_payments, balance.total_shopping,
+                           balance.total_meal_cost, balance.balance});
     }
     return reports;
 }
 
 std::pair<double, std::vector<SettlementReport>> generateMonthlySettlement(int period_id) {
-    double meal_rate = 0.0;
-    std::vector<SettlementReport> reports;
-    std::string month, year;
-
     try {
-        std::unique_ptr<sql::Connection> con(getConnection());
+        std::unique_ptr<sql::Connection> con(getReadConnection());
+        int messId = currentMessId();
 
-        // 1. Get the month and year for the selected period
-        std::unique_ptr<sql::PreparedStatement> pstmt_period(con->prepareStatement("SELECT month, year FROM meal_periods WHERE id = ?"));
+        // Get the month and year for the selected period
+        std::unique_ptr<TracedStatement> pstmt_period(prepareTraced(*con, "generateMonthlySettlement", "SELECT month, year, is_active FROM meal_periods WHERE id = ? AND mess_id = ?"));
         pstmt_period->setInt(1, period_id);
+        pstmt_period->setInt(2, messId);
         std::unique_ptr<sql::ResultSet> res_period(pstmt_period->executeQuery());
         if (!res_period->next()) {
-            std::cerr << "Error: Meal period with ID " << period_id << " not found." << std::endl;
-            return {meal_rate, reports};
+            logEvent(LogLevel::Error, "generateMonthlySettlement", "Meal period not found", {{"period_id", period_id}});
+            return {0.0, {}};
         }
-        month = res_period->getString("month");
-        year = res_period->getString("year");
+        std::string month = res_period->getString("month");
+        std::string year = res_period->getString("year");
 
-        // 2. Calculate total expenses for the period
-        double total_expenses_period = 0.0;
-        std::unique_ptr<sql::PreparedStatement> pstmt_exp(con->prepareStatement("SELECT COALESCE(SUM(price), 0) AS total FROM expenses WHERE MONTHNAME(purchase_date) = ? AND YEAR(purchase_date) = ?"));
-        pstmt_exp->setString(1, month);
-        pstmt_exp->setString(2, year);
-        std::unique_ptr<sql::ResultSet> res_exp(pstmt_exp->executeQuery());
-        if (res_exp->next()) {
-            total_expenses_period = res_exp->getDouble("total");
+        // A closed period's settlement was frozen when it was closed
+        if (!res_period->isNull("is_active") && res_period->getInt("is_active") == 0) {
+            return readFrozenSettlement(*con, period_id);
         }
 
-        // 3. Calculate total meals for the period
-        int total_meals_period = 0;
-        std::unique_ptr<sql::PreparedStatement> pstmt_meals(con->prepareStatement("SELECT COUNT(*) AS total FROM meal_attendance WHERE MONTHNAME(attendance_date) = ? AND YEAR(attendance_date) = ?"));
-        pstmt_meals->setString(1, month);
-        pstmt_meals->setString(2, year);
-        std::unique_ptr<sql::ResultSet> res_meals(pstmt_meals->executeQuery());
-        if (res_meals->next()) {
-            total_meals_period = res_meals->getInt("total");
+        std::string firstDay, nextFirstDay;
+        if (!monthDateRange(month, year, firstDay, nextFirstDay)) {
+            logEvent(LogLevel::Error, "generateMonthlySettlement", "Meal period has an unrecognised month or year",
+                     {{"period_id", period_id}, {"month", month}, {"year", year}});
+            return {0.0, {}};
         }
 
-        // 4. Calculate meal rate
-        if (total_meals_period > 0) {
-            meal_rate = total_expenses_period / total_meals_period;
+        // Reuse the last result for this period unless one of its inputs has moved
+        std::string fingerprint = settlementFingerprint(*con, messId, firstDay, nextFirstDay);
+        {
+            std::lock_guard<std::mutex> lock(settlementCacheMutex);
+            auto it = settlementCache.find(period_id);
+            if (it != settlementCache.end() && !fingerprint.empty() && it->second.fingerprint == fingerprint) {
+                return it->second.result;
+            }
         }
 
-        // 5. Get data for all users and calculate their individual reports
-        std::unique_ptr<sql::PreparedStatement> pstmt_users(con->prepareStatement(
-            "SELECT u.id, u.name, "
-            "COALESCE(att.meal_.count, 0) AS total_meals, "
-            "COALESCE(pay.total_payments, 0) AS total_payments, "
-            "COALESCE(exp.total_shopping, 0) AS total_shopping "
-            "FROM users u "
-            "LEFT JOIN (SELECT user_id, COUNT(*) as meal_count FROM meal_attendance WHERE MONTHNAME(attendance_date) = ? AND YEAR(attendance_date) = ? GROUP BY user_id) att ON u.id = att.user_id "
-            "LEFT JOIN (SELECT user_id, SUM(amount) as total_payments FROM payments WHERE MONTHNAME(date) = ? AND YEAR(date) = ? GROUP BY user_id) pay ON u.id = pay.user_id "
-            "LEFT JOIN (SELECT paid_by_user_id, SUM(price) as total_shopping FROM expenses WHERE MONTHNAME(purchase_date) = ? AND YEAR(purchase_date) = ? GROUP BY paid_by_user_id) exp ON u.id = exp.paid_by_user_id "
-            "ORDER BY u.id"
-        ));
-        // Bind parameters for all subqueries
-        pstmt_users->setString(1, month);
-        pstmt_users->setString(2, year);
-        pstmt_users->setString(3, month);
-        pstmt_users->setString(4, year);
-        pstmt_users->setString(5, month);
-        pstmt_users->setString(6, year);
+        auto result = computeSettlement(*con, messId, firstDay, nextFirstDay);
 
-        std::unique_ptr<sql::ResultSet> res_users(pstmt_users->executeQuery());
-        while (res_users->next()) {
-            SettlementReport report;
-            report.user_id = res_users->getInt("id");
-            report.user_name = res_users->getString("name");
-            report.total_meals = res_users->getInt("total_meals");
-            report.total_payments = res_users->getDouble("total_payments");
-            report.total_shopping_expenses = res_users->getDouble("total_shopping");
+        // Stored under the fingerprint read before the aggregates, so a write that
+        // lands in between only causes a recompute on the next call.
+        std::lock_guard<std::mutex> lock(settlementCacheMutex);
+        settlementCache[period_id] = {fingerprint, result};
+        return result;
+    } catch (sql::SQLException &e) {
+        logSqlError("generateMonthlySettlement", e);
+        return {0.0, {}};
+    }
+}
 
-            // Perform final calculations
-            report.total_meal_cost = report.total_meals * meal_rate;
-            report.total_contributions = report.total_payments + report.total_shopping_expenses;
-            report.final_balance = report.total_contributions - report.total_meal_cost;
+bool closeMealPeriod(int period_id) {
+    std::unique_ptr<sql::Connection> con;
+    try {
+        con = getConnection();
+        con->setAutoCommit(false); // Start transaction
+        int messId = currentMessId();
 
-            reports.push_back(report);
+        // The exclusive lock waits for writes holding the period's shared lock
+        // (lockOpenPeriods) to commit, and holds off new ones until the close is done.
+        std::unique_ptr<TracedStatement> pstmt_period(prepareTraced(*con, "closeMealPeriod",
+            "SELECT month, year, is_active FROM meal_periods WHERE id = ? AND mess_id = ? FOR UPDATE"));
+        pstmt_period->setInt(1, period_id);
+        pstmt_period->setInt(2, messId);
+        std::unique_ptr<sql::ResultSet> res_period(pstmt_period->executeQuery());
+        if (!res_period->next()) {
+            logEvent(LogLevel::Error, "closeMealPeriod", "Meal period not found", {{"period_id", period_id}});
+            con->rollback();
+            con->setAutoCommit(true);
+            return false;
+        }
+        if (!res_period->isNull("is_active") && res_period->getInt("is_active") == 0) {
+            logEvent(LogLevel::Error, "closeMealPeriod", "Meal period is already closed", {{"period_id", period_id}});
+            con->rollback();
+            con->setAutoCommit(true);
+            return false;
+        }
+        std::string month = res_period->getString("month");
+        std::string year = res_period->getString("year");
+        std::string firstDay, nextFirstDay;
+        int nextFirstDayNumber;
+        if (!monthDateRange(month, year, firstDay, nextFirstDay) || !parseIsoDate(nextFirstDay, nextFirstDayNumber)) {
+            // Closing would freeze an empty settlement and lock nothing
+            logEvent(LogLevel::Error, "closeMealPeriod", "Meal period has an unrecognised month or year",
+                     {{"period_id", period_id}, {"month", month}, {"year", year}});
+            con->rollback();
+            con->setAutoCommit(true);
+            return false;
+        }
+
+        auto [mealRate, reports] = computeSettlement(*con, messId, firstDay, nextFirstDay);
+
+        if (!reports.empty()) {
+            std::string query = "INSERT INTO period_settlements (period_id, user_id, user_name, meal_rate, total_meals, total_meal_cost, "
+                                "total_payments, total_shopping_expenses, total_contributions, final_balance) VALUES ";
+            for (size_t i = 0; i < reports.size(); ++i) {
+                query += "(?, ?, ?, ?, ?, ?, ?, ?, ?, ?)";
+                if (i < reports.size() - 1) query += ", ";
+            }
+            std::unique_ptr<TracedStatement> pstmt_insert(prepareTraced(*con, "closeMealPeriod", query));
+            int paramIndex = 1;
+            for (const auto& report : reports) {
+                pstmt_insert->setInt(paramIndex++, period_id);
+                pstmt_insert->setInt(paramIndex++, report.user_id);
+                pstmt_insert->setString(paramIndex++, report.user_name);
+                pstmt_insert->setDouble(paramIndex++, mealRate);
+                pstmt_insert->setInt(paramIndex++, report.total_meals);
+                pstmt_insert->setDouble(paramIndex++, report.total_meal_cost);
+                pstmt_insert->setDouble(paramIndex++, report.total_payments);
+                pstmt_insert->setDouble(paramIndex++, report.total_shopping_expenses);
+                pstmt_insert->setDouble(paramIndex++, report.total_contributions);
+                pstmt_insert->setDouble(paramIndex++, report.final_balance);
+            }
+            pstmt_insert->executeUpdate();
         }
 
+        // Each user's meal cost, dated the last day of the month
+        std::string lastDay = formatIsoDate(nextFirstDayNumber - 1);
+        std::vector<LedgerPosting> postings;
+        for (const auto& report : reports) {
+            postings.push_back({report.user_id, LedgerEntryType::MealCost, -report.total_meal_cost, lastDay, period_id,
+                                "Meal cost, " + month + " " + year + " (" + std::to_string(report.total_meals) + " meals)"});
+        }
+        postLedgerEntries(*con, messId, postings);
+
+        std::unique_ptr<TracedStatement> pstmt_close(prepareTraced(*con, "closeMealPeriod",
+            "UPDATE meal_periods SET is_active = 0, closed_at = NOW() WHERE id = ?"));
+        pstmt_close->setInt(1, period_id);
+        pstmt_close->executeUpdate();
+
+        con->commit();
+        noteWrite();
+        con->setAutoCommit(true);
+
+        std::lock_guard<std::mutex> lock(settlementCacheMutex);
+        settlementCache.erase(period_id); // Reads now come from period_settlements
+        return true;
     } catch (sql::SQLException &e) {
-        std::cerr << "SQLException in generateMonthlySettlement: " << e.what() << std::endl;
+        logSqlError("closeMealPeriod", e);
+        if (con) {
+            try {
+                con->rollback();
+                con->setAutoCommit(true);
+            } catch (sql::SQLException& ex) {
+                logSqlError("closeMealPeriod", ex, {{"during", "rollback"}});
+            }
+        }
+        return false;
     }
-
-    return {meal_rate, reports};
-}
\ No newline at end of file
+}
@@ -1,5 +1,9 @@
 #include "financialoverviewpage.h"
 #include "finance.h"
+#include "period.h"
+#include "userstatementdialog.h"
+#include "batchpaymentdialog.h"
+#include <QShowEvent>
 #include <QVBoxLayout>
 #include <QHBoxLayout>
 #include <QTableWidget>
@@ -8,8 +12,10 @@
 #include <QHeaderView>
 #include <QMessageBox>
 #include <QDateEdit>
+#include <QComboBox>
 #include <QLabel> // Added missing include
 #include "database.h"
+#include "stallwatchdog.h"
 
 FinancialOverviewPage::FinancialOverviewPage(QWidget *parent)
     : QWidget(parent)
@@ -25,16 +31,20 @@ FinancialOverviewPage::FinancialOverviewPage(QWidget *parent)
 
     // Table for displaying financial reports
     financialReportTable = new QTableWidget(this);
-    financialReportTable->setColumnCount(4); // User Name, Total Contributions, Total Expenses, Debt/Surplus
-    financialReportTable->setHorizontalHeaderLabels({"User Name", "Contributions", "Expenses", "Balance"});
+    financialReportTable->setColumnCount(5); // User Name, Payments, Shopping, Meal Cost, Debt/Surplus
+    financialReportTable->setHorizontalHeaderLabels({"User Name", "Payments", "Shopping", "Meal Cost", "Balance"});
     financialReportTable->horizontalHeader()->setStretchLastSection(true);
     financialReportTable->setSelectionBehavior(QAbstractItemView::SelectRows);
     financialReportTable->setEditTriggers(QAbstractItemView::NoEditTriggers);
     mainLayout->addWidget(financialReportTable);
 
-    // Refresh button for reports
+    // Refresh and statement buttons for reports; double-clicking a row also opens its statement
+    auto reportButtonsLayout = new QHBoxLayout();
     auto refreshReportsButton = new QPushButton("Refresh Reports", this);
-    mainLayout->addWidget(refreshReportsButton);
+    reportButtonsLayout->addWidget(refreshReportsButton);
+    auto viewStatementButton = new QPushButton("View Statement", this);
+    reportButtonsLayout->addWidget(viewStatementButton);
+    mainLayout->addLayout(reportButtonsLayout);
     mainLayout->addSpacing(20);
 
     // Input fields for recording payments
@@ -57,34 +67,62 @@ FinancialOverviewPage::FinancialOverviewPage(QWidget *parent)
 
     recordPaymentButton = new QPushButton("Record Payment", this);
     paymentLayout->addWidget(recordPaymentButton);
+    auto batchPaymentsButton = new QPushButton("Batch Payments...", this);
+    paymentLayout->addWidget(batchPaymentsButton);
     mainLayout->addLayout(paymentLayout);
+    mainLayout->addSpacing(20);
+
+    // Closing a period freezes its settlement and locks its month against edits
+    auto closePeriodLayout = new QHBoxLayout();
+    closePeriodLayout->addWidget(new QLabel("Close Period:"));
+    closePeriodComboBox = new QComboBox(this);
+    closePeriodLayout->addWidget(closePeriodComboBox);
+    closePeriodButton = new QPushButton("Close Period", this);
+    closePeriodLayout->addWidget(closePeriodButton);
+    closePeriodLayout->addStretch();
+    mainLayout->addLayout(closePeriodLayout);
 
     // Connections
     connect(refreshReportsButton, &QPushButton::clicked, this, &FinancialOverviewPage::loadFinancialReports);
     connect(recordPaymentButton, &QPushButton::clicked, this, &FinancialOverviewPage::recordPaymentClicked);
-
-    // Initial load
-    loadFinancialReports();
+    connect(batchPaymentsButton, &QPushButton::clicked, this, &FinancialOverviewPage::batchPaymentsClicked);
+    connect(closePeriodButton, &QPushButton::clicked, this, &FinancialOverviewPage::closePeriodClicked);
+    connect(viewStatementButton, &QPushButton::clicked, this, &FinancialOverviewPage::viewStatementClicked);
+    connect(financialReportTable, &QTableWidget::cellDoubleClicked, this, &FinancialOverviewPage::viewStatementClicked);
 
     setLayout(mainLayout);
 }
 
+void FinancialOverviewPage::showEvent(QShowEvent *event)
+{
+    QWidget::showEvent(event);
+    if (loaded) return;
+    loaded = true;
+    loadFinancialReports();
+    loadOpenPeriods();
+}
+
 void FinancialOverviewPage::loadFinancialReports()
 {
+    StallActivity activity("FinancialOverviewPage::loadFinancialReports");
     financialReportTable->setRowCount(0); // Clear existing rows
     std::vector<FinancialReport> reports = getAllFinancialReports();
     financialReportTable->setRowCount(reports.size());
 
     for (size_t i = 0; i < reports.size(); ++i) {
-        financialReportTable->setItem(i, 0, new QTableWidgetItem(QString::fromStdString(reports[i].user_name)));
+        auto nameItem = new QTableWidgetItem(QString::fromStdString(reports[i].user_name));
+        nameItem->setData(Qt::UserRole, reports[i].user_id);
+        financialReportTable->setItem(i, 0, nameItem);
         financialReportTable->setItem(i, 1, new QTableWidgetItem(QString::number(reports[i].total_contributions, 'f', 2)));
         financialReportTable->setItem(i, 2, new QTableWidgetItem(QString::number(reports[i].total_expenses, 'f', 2)));
-        financialReportTable->setItem(i, 3, new QTableWidgetItem(QString::number(reports[i].debt_or_surplus, 'f', 2)));
+        financialReportTable->setItem(i, 3, new QTableWidgetItem(QString::number(reports[i].total_meal_cost, 'f', 2)));
+        financialReportTable->setItem(i, 4, new QTableWidgetItem(QString::number(reports[i].debt_or_surplus, 'f', 2)));
     }
 }
 
 void FinancialOverviewPage::recordPaymentClicked()
 {
+    StallActivity activity("FinancialOverviewPage::recordPaymentClicked");
     int userId = paymentUserIdLineEdit->text().toInt();
     double amount = paymentAmountLineEdit->text().toDouble();
     QString date = paymentDateEdit->date().toString("yyyy-MM-dd");
@@ -102,4 +140,55 @@ void FinancialOverviewPage::recordPaymentClicked()
     } else {
         QMessageBox::critical(this, "Error", "Failed to record payment.");
     }
-}
\ No newline at end of file
+}
+
+void FinancialOverviewPage::batchPaymentsClicked()
+{
+    StallActivity activity("FinancialOverviewPage::batchPaymentsClicked");
+    BatchPaymentDialog dialog(this);
+    if (dialog.exec() == QDialog::Accepted) {
+        loadFinancialReports(); // Once for the whole batch
+    }
+}
+
+void FinancialOverviewPage::loadOpenPeriods()
+{
+    StallActivity activity("FinancialOverviewPage::loadOpenPeriods");
+    closePeriodComboBox->clear();
+    for (const auto& period : getAllMealPeriods()) {
+        if (!period.is_closed) {
+            closePeriodComboBox->addItem(QString::fromStdString(period.month + " " + period.year), period.id);
+        }
+    }
+    closePeriodButton->setEnabled(closePeriodComboBox->count() > 0);
+}
+
+void FinancialOverviewPage::closePeriodClicked()
+{
+    StallActivity activity("FinancialOverviewPage::closePeriodClicked");
+    if (closePeriodComboBox->currentIndex() < 0) return;
+    QString periodName = closePeriodComboBox->currentText();
+    auto answer = QMessageBox::question(this, "Close Period",
+        QString("Close %1? Its settlement will be frozen and attendance, expenses and payments "
+                "in that month can no longer be changed.").arg(periodName));
+    if (answer != QMessageBox::Yes) return;
+
+    if (closeMealPeriod(closePeriodComboBox->currentData().toInt())) {
+        QMessageBox::information(this, "Success", periodName + " is closed.");
+        loadOpenPeriods();
+        loadFinancialReports(); // Closing posted the period's meal costs
+    } else {
+        QMessageBox::critical(this, "Error", "Failed to close the period. Please check the logs.");
+    }
+}
+
+void FinancialOverviewPage::viewStatementClicked()
+{
+    int row = financialReportTable->currentRow();
+    if (row < 0) {
+        QMessageBox::warning(this, "View Statement", "Please select a user to view their statement.");
+        return;
+    }
+    UserStatementDialog dialog(financialReportTable->item(row, 0)->data(Qt::UserRole).toInt(), this);
+    dialog.exec();
+}
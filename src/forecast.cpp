@@ -0,0 +1,280 @@
+#include "forecast.h"
+#include "database.h"
+#include "dateutil.h"
+#include "mess.h"
+#include "partition.h"
+#include "logger.h"
+#include "slowquery.h"
+#include <cppconn/prepared_statement.h>
+#include <cppconn/resultset.h>
+#include <array>
+#include <map>
+#include <set>
+#include <utility>
+
+namespace { // Anonymous namespace for file-local helpers
+    const char* const MEAL_TYPES[] = {"Breakfast", "Lunch", "Dinner"};
+
+    // Weight, in weekdays, of a user's all-days rate in their per-weekday rate.
+    const double SHRINKAGE = 2.0;
+
+    // Recomputes the meal_weekday_counts rows for the given dates. A date is keyed
+    // as the Monday of its week plus its weekday.
+    void refreshWeekdayCounts(sql::Connection& con, int messId, const std::vector<std::string>& dates) {
+        std::vector<std::pair<std::string, int>> keys;
+        for (const auto& date : dates) {
+            int day;
+            if (!parseIsoDate(date, day)) continue;
+            int weekday = dayOfWeek(day);
+            keys.push_back({formatIsoDate(day - weekday), weekday});
+        }
+        if (keys.empty()) {
+            return;
+        }
+        std::string keyList;
+        for (size_t i = 0; i < keys.size(); ++i) {
+            keyList += "(STR_TO_DATE(?, '%Y-%m-%d'), ?)";
+            if (i < keys.size() - 1) keyList += ", ";
+        }
+
+        std::unique_ptr<TracedStatement> pstmt_delete(prepareTraced(con, "refreshMealHeadcounts",
+            "DELETE FROM meal_weekday_counts WHERE mess_id = ? AND (week_start, weekday) IN (" + keyList + ")"));
+        int paramIndex = 1;
+        pstmt_delete->setInt(paramIndex++, messId);
+        for (const auto& [weekStart, weekday] : keys) {
+            pstmt_delete->setString(paramIndex++, weekStart);
+            pstmt_delete->setInt(paramIndex++, weekday);
+        }
+        pstmt_delete->executeUpdate();
+
+        std::string dateList;
+        for (size_t i = 0; i < dates.size(); ++i) {
+            dateList += "STR_TO_DATE(?, '%Y-%m-%d')";
+            if (i < dates.size() - 1) dateList += ", ";
+        }
+        std::unique_ptr<TracedStatement> pstmt_insert(prepareTraced(con, "refreshMealHeadcounts",
+            "INSERT INTO meal_weekday_counts (mess_id, week_start, user_id, meal_type, weekday, meals) "
+            "SELECT mess_id, attendance_date - INTERVAL WEEKDAY(attendance_date) DAY, user_id, meal_type, WEEKDAY(attendance_date), COUNT(*) "
+            "FROM meal_attendance "
+            "WHERE mess_id = ? AND attendance_date IN (" + dateList + ") AND user_id IS NOT NULL AND meal_type IS NOT NULL "
+            "GROUP BY mess_id, attendance_date, user_id, meal_type"));
+        pstmt_insert->setInt(1, messId);
+        for (size_t i = 0; i < dates.size(); ++i) {
+            pstmt_insert->setString(static_cast<int>(i) + 2, dates[i]);
+        }
+        pstmt_insert->executeUpdate();
+    }
+} // namespace
+
+void refreshMealHeadcounts(sql::Connection& con, int messId, const std::vector<std::string>& dates) {
+    if (dates.empty()) {
+        return;
+    }
+    // Dates are bound as STR_TO_DATE so the index on (mess_id, meal_date) is used.
+    std::string dateList;
+    for (size_t i = 0; i < dates.size(); ++i) {
+        dateList += "STR_TO_DATE(?, '%Y-%m-%d')";
+        if (i < dates.size() - 1) dateList += ", ";
+    }
+
+    std::unique_ptr<TracedStatement> pstmt_delete(prepareTraced(con, "refreshMealHeadcounts",
+        "DELETE FROM meal_headcounts WHERE mess_id = ? AND meal_date IN (" + dateList + ")"));
+    pstmt_delete->setInt(1, messId);
+    for (size_t i = 0; i < dates.size(); ++i) {
+        pstmt_delete->setString(static_cast<int>(i) + 2, dates[i]);
+    }
+    pstmt_delete->executeUpdate();
+
+    std::unique_ptr<TracedStatement> pstmt_insert(prepareTraced(con, "refreshMealHeadcounts",
+        "INSERT INTO meal_headcounts (mess_id, meal_date, meal_type, headcount) "
+        "SELECT mess_id, attendance_date, meal_type, COUNT(*) FROM meal_attendance "
+        "WHERE mess_id = ? AND attendance_date IN (" + dateList + ") AND meal_type IS NOT NULL "
+        "GROUP BY mess_id, attendance_date, meal_type"));
+    pstmt_insert->setInt(1, messId);
+    for (size_t i = 0; i < dates.size(); ++i) {
+        pstmt_insert->setString(static_cast<int>(i) + 2, dates[i]);
+    }
+    pstmt_insert->executeUpdate();
+
+    refreshWeekdayCounts(con, messId, dates);
+}
+
+bool rebuildMealHeadcounts() {
+    std::unique_ptr<sql::Connection> con;
+    try {
+        con = getConnection();
+        con->setAutoCommit(false); // Start transaction
+        int messId = currentMessId();
+
+        // Archived months have no live attendance to rebuild from, so their headcounts are kept
+        std::vector<std::string> archivedMonths;
+        for (const auto& archive : listArchives()) {
+            if (archive.source_table == "meal_attendance") archivedMonths.push_back(archive.month);
+        }
+        std::string query = "DELETE FROM meal_headcounts WHERE mess_id = ?";
+        if (!archivedMonths.empty()) {
+            query += " AND DATE_FORMAT(meal_date, '%Y-%m') NOT IN (";
+            for (size_t i = 0; i < archivedMonths.size(); ++i) {
+                query += (i > 0 ? ", ?" : "?");
+            }
+            query += ")";
+        }
+        std::unique_ptr<TracedStatement> pstmt_delete(prepareTraced(*con, "rebuildMealHeadcounts", query));
+        pstmt_delete->setInt(1, messId);
+        for (size_t i = 0; i < archivedMonths.size(); ++i) {
+            pstmt_delete->setString(static_cast<int>(i) + 2, archivedMonths[i]);
+        }
+        pstmt_delete->executeUpdate();
+
+        std::unique_ptr<TracedStatement> pstmt_insert(prepareTraced(*con, "rebuildMealHeadcounts",
+            "INSERT INTO meal_headcounts (mess_id, meal_date, meal_type, headcount) "
+            "SELECT mess_id, attendance_date, meal_type, COUNT(*) FROM meal_attendance "
+            "WHERE mess_id = ? AND attendance_date IS NOT NULL AND meal_type IS NOT NULL GROUP BY mess_id, attendance_date, meal_type"));
+        pstmt_insert->setInt(1, messId);
+        pstmt_insert->executeUpdate();
+
+        // The same for the per-user weekday counts, keyed by the day each row counts
+        std::string countsQuery = "DELETE FROM meal_weekday_counts WHERE mess_id = ?";
+        if (!archivedMonths.empty()) {
+            countsQuery += " AND DATE_FORMAT(week_start + INTERVAL weekday DAY, '%Y-%m') NOT IN (";
+            for (size_t i = 0; i < archivedMonths.size(); ++i) {
+                countsQuery += (i > 0 ? ", ?" : "?");
+            }
+            countsQuery += ")";
+        }
+        std::unique_ptr<TracedStatement> pstmt_delete_counts(prepareTraced(*con, "rebuildMealHeadcounts", countsQuery));
+        pstmt_delete_counts->setInt(1, messId);
+        for (size_t i = 0; i < archivedMonths.size(); ++i) {
+            pstmt_delete_counts->setString(static_cast<int>(i) + 2, archivedMonths[i]);
+        }
+        pstmt_delete_counts->executeUpdate();
+
+        std::unique_ptr<TracedStatement> pstmt_insert_counts(prepareTraced(*con, "rebuildMealHeadcounts",
+            "INSERT INTO meal_weekday_counts (mess_id, week_start, user_id, meal_type, weekday, meals) "
+            "SELECT mess_id, attendance_date - INTERVAL WEEKDAY(attendance_date) DAY, user_id, meal_type, WEEKDAY(attendance_date), COUNT(*) "
+            "FROM meal_attendance "
+            "WHERE mess_id = ? AND attendance_date IS NOT NULL AND user_id IS NOT NULL AND meal_type IS NOT NULL "
+            "GROUP BY mess_id, attendance_date, user_id, meal_type"));
+        pstmt_insert_counts->setInt(1, messId);
+        pstmt_insert_counts->executeUpdate();
+
+        con->commit();
+        noteWrite();
+        con->setAutoCommit(true);
+        return true;
+    } catch (sql::SQLException& e) {
+        logSqlError("rebuildMealHeadcounts", e);
+        if (con) {
+            try {
+                con->rollback();
+                con->setAutoCommit(true);
+            } catch (sql::SQLException& ex) {
+                logSqlError("rebuildMealHeadcounts", ex, {{"during", "rollback"}});
+            }
+        }
+        return false;
+    }
+}
+
+std::vector<MealForecast> forecastMealDemand(const std::string& fromDate, int days, int lookbackWeeks) {
+    std::vector<MealForecast> forecasts;
+    int firstDay;
+    if (!parseIsoDate(fromDate, firstDay) || days <= 0 || lookbackWeeks <= 0) {
+        logEvent(LogLevel::Error, "forecastMealDemand", "Invalid forecast range", {{"from_date", fromDate}});
+        return forecasts;
+    }
+    const int historyStart = firstDay - 7 * lookbackWeeks;
+    const int endDay = firstDay + days; // Exclusive
+
+    try {
+        std::unique_ptr<sql::Connection> con(getReadConnection());
+        int messId = currentMessId();
+
+        // 1. Headcounts over the lookback window and the forecast range
+        std::unique_ptr<TracedStatement> pstmt_headcounts(prepareTraced(*con, "forecastMealDemand",
+            "SELECT DATE_FORMAT(meal_date, '%Y-%m-%d') AS meal_date, meal_type, headcount FROM meal_headcounts "
+            "WHERE mess_id = ? AND meal_date >= STR_TO_DATE(?, '%Y-%m-%d') AND meal_date < STR_TO_DATE(?, '%Y-%m-%d')"));
+        pstmt_headcounts->setInt(1, messId);
+        pstmt_headcounts->setString(2, formatIsoDate(historyStart));
+        pstmt_headcounts->setString(3, formatIsoDate(endDay));
+        std::unique_ptr<sql::ResultSet> res_headcounts(pstmt_headcounts->executeQuery());
+
+        std::set<int> servedDays;                                   // History days with any attendance
+        std::map<std::string, std::array<int, 7>> weekdayTotals;     // meal_type -> headcount per weekday
+        std::map<std::pair<int, std::string>, int> recorded;        // (day, meal_type) in the forecast range
+        while (res_headcounts->next()) {
+            int day;
+            if (!parseIsoDate(res_headcounts->getString("meal_date"), day)) continue;
+            std::string mealType = res_headcounts->getString("meal_type");
+            int headcount = res_headcounts->getInt("headcount");
+            if (day < firstDay) {
+                if (headcount > 0) servedDays.insert(day);
+                weekdayTotals[mealType][dayOfWeek(day)] += headcount;
+            } else {
+                recorded[{day, mealType}] = headcount;
+            }
+        }
+
+        std::array<int, 7> servedPerWeekday{};
+        for (int day : servedDays) {
+            ++servedPerWeekday[dayOfWeek(day)];
+        }
+
+        // 2. Per-user attendance by meal and weekday over the lookback window, from
+        // the counts the attendance writes keep. The week_start bounds select the
+        // weeks that overlap the window; the day test trims the partial ones.
+        std::unique_ptr<TracedStatement> pstmt_users(prepareTraced(*con, "forecastMealDemand",
+            "SELECT c.user_id, c.meal_type, c.weekday, SUM(c.meals) AS meals "
+            "FROM meal_weekday_counts c JOIN users u ON u.id = c.user_id "
+            "WHERE c.mess_id = ? AND u.mess_id = ? "
+            "AND c.week_start > STR_TO_DATE(?, '%Y-%m-%d') - INTERVAL 7 DAY AND c.week_start < STR_TO_DATE(?, '%Y-%m-%d') "
+            "AND c.week_start + INTERVAL c.weekday DAY >= STR_TO_DATE(?, '%Y-%m-%d') "
+            "AND c.week_start + INTERVAL c.weekday DAY < STR_TO_DATE(?, '%Y-%m-%d') "
+            "GROUP BY c.user_id, c.meal_type, c.weekday"));
+        pstmt_users->setInt(1, messId);
+        pstmt_users->setInt(2, messId);
+        pstmt_users->setString(3, formatIsoDate(historyStart));
+        pstmt_users->setString(4, formatIsoDate(firstDay));
+        pstmt_users->setString(5, formatIsoDate(historyStart));
+        pstmt_users->setString(6, formatIsoDate(firstDay));
+        std::unique_ptr<sql::ResultSet> res_users(pstmt_users->executeQuery());
+
+        // (user_id, meal_type) -> meals attended per weekday (0 = Monday, as WEEKDAY() and dayOfWeek() agree)
+        std::map<std::pair<int, std::string>, std::array<int, 7>> userMeals;
+        while (res_users->next()) {
+            int weekday = res_users->getInt("weekday");
+            if (weekday < 0 || weekday > 6) continue;
+            userMeals[{res_users->getInt("user_id"), res_users->getString("meal_type")}][weekday] += res_users->getInt("meals");
+        }
+
+        // 3. Sum each user's shrunk per-weekday rate for every meal in the range
+        const double servedTotal = static_cast<double>(servedDays.size());
+        for (int day = firstDay; day < endDay; ++day) {
+            int weekday = dayOfWeek(day);
+            double servedOnWeekday = servedPerWeekday[weekday];
+            for (const char* mealType : MEAL_TYPES) {
+                MealForecast forecast;
+                forecast.date = formatIsoDate(day);
+                forecast.meal_type = mealType;
+                forecast.expected = 0.0;
+                for (const auto& [key, meals] : userMeals) {
+                    if (key.second != mealType) continue;
+                    int attendedAnyDay = 0;
+                    for (int count : meals) attendedAnyDay += count;
+                    double overallRate = servedTotal > 0 ? attendedAnyDay / servedTotal : 0.0;
+                    forecast.expected += (meals[weekday] + SHRINKAGE * overallRate) / (servedOnWeekday + SHRINKAGE);
+                }
+                auto totals = weekdayTotals.find(mealType);
+                forecast.weekday_average = (servedOnWeekday > 0 && totals != weekdayTotals.end())
+                    ? totals->second[weekday] / servedOnWeekday : 0.0;
+                auto recordedIt = recorded.find({day, mealType});
+                forecast.recorded = recordedIt != recorded.end() ? recordedIt->second : 0;
+                forecasts.push_back(forecast);
+            }
+        }
+    } catch (sql::SQLException& e) {
+        logSqlError("forecastMealDemand", e);
+        forecasts.clear();
+    }
+    return forecasts;
+}
@@ -0,0 +1,469 @@
+#include "journal.h"
+#include "checksum.h"
+#include "database.h"
+#include "expenseanalytics.h"
+#include "forecast.h"
+#include "ledger.h"
+#include "menuanalytics.h"
+#include "period.h"
+#include "user.h"
+#include "logger.h"
+#include "slowquery.h"
+#include <cppconn/driver.h>
+#include <cppconn/prepared_statement.h>
+#include <mysql_driver.h>
+#include <openssl/rand.h>
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <stdexcept>
+#include <unistd.h>
+#include <vector>
+
+namespace { // Anonymous namespace for file-local helpers
+    const char* JOURNAL_PATH = "offline_journal.bin";
+    const uint32_t RECORD_MAGIC = 0x314A4D4D; // "MMJ1" little-endian
+    const size_t HEADER_SIZE = 12;
+    const size_t REPLAY_BATCH_SIZE = 200;
+
+    std::mutex journalMutex; // Guards the journal file
+    std::mutex replayMutex;  // One replay at a time
+
+    void putU32(std::string& out, uint32_t value) {
+        for (int i = 0; i < 4; ++i) out += static_cast<char>(value >> (8 * i));
+    }
+
+    void putString(std::string& out, const std::string& value) {
+        putU32(out, static_cast<uint32_t>(value.size()));
+        out += value;
+    }
+
+    // Reads fields back in the order encode() wrote them; fails on any overrun.
+    class PayloadReader {
+    public:
+        explicit PayloadReader(const std::string& payload) : data(payload) {}
+        bool u32(uint32_t& value) {
+            if (data.size() - pos < 4) return false;
+            value = 0;
+            for (int i = 0; i < 4; ++i) value |= static_cast<uint32_t>(static_cast<unsigned char>(data[pos + i])) << (8 * i);
+            pos += 4;
+            return true;
+        }
+        bool string(std::string& value) {
+            uint32_t length;
+            if (!u32(length) || data.size() - pos < length) return false;
+            value = data.substr(pos, length);
+            pos += length;
+            return true;
+        }
+        bool atEnd() const { return pos == data.size(); }
+
+    private:
+        const std::string& data;
+        size_t pos = 0;
+    };
+
+    std::string encode(const JournalRecord& record) {
+        std::string payload;
+        payload += static_cast<char>(record.type);
+        putU32(payload, static_cast<uint32_t>(record.mess_id));
+        putU32(payload, static_cast<uint32_t>(record.user_id));
+        putU32(payload, static_cast<uint32_t>(record.category_id));
+        uint64_t amountBits;
+        std::memcpy(&amountBits, &record.amount, sizeof(amountBits));
+        putU32(payload, static_cast<uint32_t>(amountBits));
+        putU32(payload, static_cast<uint32_t>(amountBits >> 32));
+        putString(payload, record.date);
+        putString(payload, record.meal_type);
+        putString(payload, record.item_name);
+        putString(payload, record.idempotency_key);
+
+        std::string framed;
+        putU32(framed, RECORD_MAGIC);
+        putU32(framed, static_cast<uint32_t>(payload.size()));
+        putU32(framed, crc32(payload));
+        return framed + payload;
+    }
+
+    bool decode(const std::string& payload, JournalRecord& record) {
+        if (payload.empty()) return false;
+        uint8_t type = static_cast<uint8_t>(payload[0]);
+        if (type < 1 || type > 3) return false;
+        record.type = static_cast<JournalRecordType>(type);
+
+        std::string rest = payload.substr(1);
+        PayloadReader in(rest);
+        uint32_t messId, userId, categoryId, amountLow, amountHigh;
+        if (!in.u32(messId) || !in.u32(userId) || !in.u32(categoryId) || !in.u32(amountLow) || !in.u32(amountHigh) ||
+            !in.string(record.date) || !in.string(record.meal_type) || !in.string(record.item_name) ||
+            !in.string(record.idempotency_key) || !in.atEnd()) {
+            return false;
+        }
+        record.mess_id = static_cast<int>(messId);
+        record.user_id = static_cast<int>(userId);
+        record.category_id = static_cast<int>(categoryId);
+        uint64_t amountBits = (static_cast<uint64_t>(amountHigh) << 32) | amountLow;
+        std::memcpy(&record.amount, &amountBits, sizeof(amountBits));
+        return true;
+    }
+
+    // Returns every intact record; stops at the first torn or corrupt one.
+    std::vector<JournalRecord> readJournalLocked() {
+        std::vector<JournalRecord> records;
+        std::FILE* file = std::fopen(JOURNAL_PATH, "rb");
+        if (!file) return records;
+
+        long offset = 0;
+        unsigned char header[HEADER_SIZE];
+        while (std::fread(header, 1, HEADER_SIZE, file) == HEADER_SIZE) {
+            auto field = [&](int index) {
+                uint32_t value = 0;
+                for (int i = 0; i < 4; ++i) value |= static_cast<uint32_t>(header[index * 4 + i]) << (8 * i);
+                return value;
+            };
+            uint32_t magic = field(0), length = field(1), checksum = field(2);
+            if (magic != RECORD_MAGIC || length > (1u << 20)) {
+                logEvent(LogLevel::Warning, "readJournalLocked", "Offline journal is corrupt; ignoring the rest", {{"offset", offset}});
+                break;
+            }
+            std::string payload(length, '\0');
+            JournalRecord record;
+            if (std::fread(&payload[0], 1, length, file) != length) break; // Torn final append
+            if (crc32(payload) != checksum || !decode(payload, record)) {
+                logEvent(LogLevel::Warning, "readJournalLocked", "Offline journal record failed its checksum; ignoring the rest", {{"offset", offset}});
+                break;
+            }
+            records.push_back(record);
+            offset += static_cast<long>(HEADER_SIZE + length);
+        }
+        std::fclose(file);
+        return records;
+    }
+
+    bool writeFully(int fd, const std::string& data) {
+        size_t written = 0;
+        while (written < data.size()) {
+            ssize_t n = ::write(fd, data.data() + written, data.size() - written);
+            if (n < 0) return false;
+            written += static_cast<size_t>(n);
+        }
+        return true;
+    }
+
+    // Atomically replaces the journal with the given records (or removes it).
+    bool rewriteJournalLocked(const std::vector<JournalRecord>& records) {
+        if (records.empty()) {
+            return std::remove(JOURNAL_PATH) == 0 || errno == ENOENT;
+        }
+        std::string tempPath = std::string(JOURNAL_PATH) + ".tmp";
+        int fd = ::open(tempPath.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0600);
+        if (fd < 0) return false;
+        std::string data;
+        for (const auto& record : records) data += encode(record);
+        bool ok = writeFully(fd, data) && ::fsync(fd) == 0;
+        ok = ::close(fd) == 0 && ok;
+        return ok && std::rename(tempPath.c_str(), JOURNAL_PATH) == 0;
+    }
+
+    // Writes one batch with a multi-row INSERT per record type; the caller owns the transaction.
+    void insertBatch(sql::Connection& con, const std::vector<const JournalRecord*>& batch) {
+        // Records dated in a closed period or naming a user no longer in the
+        // mess make the batch fail like any other rejected record, so the
+        // per-record fallback drops them.
+        std::map<int, std::vector<std::string>> datesByMessId;
+        std::map<int, std::vector<int>> usersByMessId;
+        for (const JournalRecord* record : batch) {
+            datesByMessId[record->mess_id].push_back(record->date);
+            if (record->user_id > 0) usersByMessId[record->mess_id].push_back(record->user_id);
+        }
+        for (const auto& [messId, dates] : datesByMessId) {
+            lockOpenPeriods(con, messId, dates);
+            lockMessMembers(con, messId, usersByMessId[messId]);
+        }
+
+        std::vector<const JournalRecord*> attendance, expenses, payments;
+        for (const JournalRecord* record : batch) {
+            switch (record->type) {
+                case JournalRecordType::Attendance: attendance.push_back(record); break;
+                case JournalRecordType::Expense:    expenses.push_back(record); break;
+                case JournalRecordType::Payment:    payments.push_back(record); break;
+            }
+        }
+
+        auto placeholders = [](const std::string& row, size_t count) {
+            std::string values;
+            for (size_t i = 0; i < count; ++i) {
+                values += row;
+                if (i < count - 1) values += ", ";
+            }
+            return values;
+        };
+
+        if (!attendance.empty()) {
+            std::unique_ptr<TracedStatement> pstmt(prepareTraced(con, "insertBatch",
+                "INSERT INTO meal_attendance (mess_id, user_id, attendance_date, meal_type) VALUES " +
+                placeholders("(?, ?, STR_TO_DATE(?, '%Y-%m-%d'), ?)", attendance.size()) +
+                " ON DUPLICATE KEY UPDATE user_id = user_id"));
+            int paramIndex = 1;
+            for (const JournalRecord* r : attendance) {
+                pstmt->setInt(paramIndex++, r->mess_id);
+                pstmt->setInt(paramIndex++, r->user_id);
+                pstmt->setString(paramIndex++, r->date);
+                pstmt->setString(paramIndex++, r->meal_type);
+            }
+            pstmt->executeUpdate();
+
+            std::map<int, std::set<std::string>> datesByMess;
+            for (const JournalRecord* r : attendance) {
+                datesByMess[r->mess_id].insert(r->date);
+            }
+            for (const auto& [messId, dates] : datesByMess) {
+                refreshMealHeadcounts(con, messId, std::vector<std::string>(dates.begin(), dates.end()));
+            }
+        }
+        if (!expenses.empty()) {
+            std::unique_ptr<TracedStatement> pstmt(prepareTraced(con, "insertBatch",
+                "INSERT INTO expenses (mess_id, purchase_date, item_name, price, paid_by_user_id, category_id, idempotency_key) VALUES " +
+                placeholders("(?, STR_TO_DATE(?, '%Y-%m-%d'), ?, ?, ?, ?, ?)", expenses.size()) +
+                " ON DUPLICATE KEY UPDATE id = id"));
+            int paramIndex = 1;
+            for (const JournalRecord* r : expenses) {
+                pstmt->setInt(paramIndex++, r->mess_id);
+                pstmt->setString(paramIndex++, r->date);
+                pstmt->setString(paramIndex++, r->item_name);
+                pstmt->setDouble(paramIndex++, r->amount);
+                pstmt->setInt(paramIndex++, r->user_id);
+                pstmt->setInt(paramIndex++, r->category_id);
+                pstmt->setString(paramIndex++, r->idempotency_key);
+            }
+            pstmt->executeUpdate();
+        }
+        if (!payments.empty()) {
+            std::unique_ptr<TracedStatement> pstmt(prepareTraced(con, "insertBatch",
+                "INSERT INTO payments (mess_id, user_id, amount, date, idempotency_key) VALUES " +
+                placeholders("(?, ?, ?, STR_TO_DATE(?, '%Y-%m-%d'), ?)", payments.size()) +
+                " ON DUPLICATE KEY UPDATE id = id"));
+            int paramIndex = 1;
+            for (const JournalRecord* r : payments) {
+                pstmt->setInt(paramIndex++, r->mess_id);
+                pstmt->setInt(paramIndex++, r->user_id);
+                pstmt->setDouble(paramIndex++, r->amount);
+                pstmt->setString(paramIndex++, r->date);
+                pstmt->setString(paramIndex++, r->idempotency_key);
+            }
+            pstmt->executeUpdate();
+        }
+
+        // Post what actually landed now; rows an earlier replay already inserted have their entries
+        std::map<int, std::vector<std::string>> keysByMess;
+        for (const JournalRecord* r : expenses) keysByMess[r->mess_id].push_back(r->idempotency_key);
+        for (const JournalRecord* r : payments) keysByMess[r->mess_id].push_back(r->idempotency_key);
+        for (const auto& [messId, keys] : keysByMess) {
+            postUnpostedWrites(con, messId, keys);
+        }
+    }
+
+    // Errors that will not go away by retrying the same record later.
+    bool isDefinitiveRejection(const sql::SQLException& e) {
+        switch (e.getErrorCode()) {
+            case ER_PERIOD_CLOSED:
+            case 1048: // ER_BAD_NULL_ERROR
+            case 1062: // ER_DUP_ENTRY
+            case 1216: // ER_NO_REFERENCED_ROW
+            case 1217: // ER_ROW_IS_REFERENCED
+            case 1264: // ER_WARN_DATA_OUT_OF_RANGE
+            case 1366: // ER_TRUNCATED_WRONG_VALUE_FOR_FIELD
+            case 1406: // ER_DATA_TOO_LONG
+            case 1451: // ER_ROW_IS_REFERENCED_2
+            case 1452: // ER_NO_REFERENCED_ROW_2, and ER_NOT_MESS_MEMBER
+                return true;
+            default:
+                return false;
+        }
+    }
+
+    // Runs a batch in its own transaction. Rethrows so the caller can tell
+    // a lost connection from a record the database rejects.
+    void commitBatch(sql::Connection& con, const std::vector<const JournalRecord*>& batch) {
+        con.setAutoCommit(false);
+        try {
+            insertBatch(con, batch);
+            con.commit();
+            con.setAutoCommit(true);
+        } catch (sql::SQLException&) {
+            try {
+                con.rollback();
+                con.setAutoCommit(true);
+            } catch (sql::SQLException& ex) {
+                logSqlError("commitBatch", ex, {{"during", "rollback"}});
+            }
+            throw;
+        }
+    }
+} // namespace
+
+std::string generateIdempotencyKey() {
+    unsigned char bytes[16];
+    if (RAND_bytes(bytes, sizeof(bytes)) != 1) {
+        throw std::runtime_error("Failed to generate idempotency key.");
+    }
+    static const char* hex = "0123456789abcdef";
+    std::string key;
+    for (unsigned char byte : bytes) {
+        key += hex[byte >> 4];
+        key += hex[byte & 0x0F];
+    }
+    return key;
+}
+
+bool isConnectionError(const sql::SQLException& e) {
+    switch (e.getErrorCode()) {
+        case 2002: // CR_CONNECTION_ERROR
+        case 2003: // CR_CONN_HOST_ERROR
+        case 2005: // CR_UNKNOWN_HOST
+        case 2006: // CR_SERVER_GONE_ERROR
+        case 2013: // CR_SERVER_LOST
+        case 2055: // CR_SERVER_LOST_EXTENDED
+            return true;
+        default:
+            return false;
+    }
+}
+
+std::string describeJournalRecord(const JournalRecord& record) {
+    char amount[32];
+    std::snprintf(amount, sizeof(amount), "%.2f", record.amount);
+    switch (record.type) {
+        case JournalRecordType::Attendance:
+            return "Attendance of user " + std::to_string(record.user_id) + " at " + record.meal_type + " on " + record.date;
+        case JournalRecordType::Expense:
+            return "Expense \"" + record.item_name + "\" of " + amount + " paid by user " + std::to_string(record.user_id) + " on " + record.date;
+        case JournalRecordType::Payment:
+            return "Payment of " + std::string(amount) + " by user " + std::to_string(record.user_id) + " on " + record.date;
+    }
+    return "Unknown record";
+}
+
+bool appendToJournal(const JournalRecord& record) {
+    std::string data = encode(record);
+    std::lock_guard<std::mutex> lock(journalMutex);
+    int fd = ::open(JOURNAL_PATH, O_WRONLY | O_CREAT | O_APPEND, 0600);
+    if (fd < 0) {
+        logEvent(LogLevel::Error, "appendToJournal", "Could not open offline journal", {{"path", JOURNAL_PATH}, {"error", std::strerror(errno)}});
+        return false;
+    }
+    bool ok = writeFully(fd, data) && ::fsync(fd) == 0; // Durable before we report success
+    ok = ::close(fd) == 0 && ok;
+    if (!ok) {
+        logEvent(LogLevel::Error, "appendToJournal", "Could not write to offline journal", {{"path", JOURNAL_PATH}});
+    }
+    return ok;
+}
+
+size_t pendingJournalRecords() {
+    std::lock_guard<std::mutex> lock(journalMutex);
+    return readJournalLocked().size();
+}
+
+JournalReplayResult replayJournal() {
+    std::lock_guard<std::mutex> replayLock(replayMutex);
+    std::vector<JournalRecord> records;
+    {
+        std::lock_guard<std::mutex> lock(journalMutex);
+        records = readJournalLocked();
+    }
+    JournalReplayResult result{0, 0, records.size(), {}};
+    if (records.empty()) return result;
+
+    std::vector<JournalRecord> remaining;
+    try {
+        std::unique_ptr<sql::Connection> con(getConnection());
+
+        size_t next = 0;
+        try {
+            while (next < records.size()) {
+                size_t end = std::min(next + REPLAY_BATCH_SIZE, records.size());
+                std::vector<const JournalRecord*> batch;
+                for (size_t i = next; i < end; ++i) batch.push_back(&records[i]);
+
+                try {
+                    commitBatch(*con, batch);
+                    result.replayed += batch.size();
+                } catch (sql::SQLException& e) {
+                    if (!isDefinitiveRejection(e)) throw;
+                    // Something in the batch is rejected; find it by replaying one at a time.
+                    for (const JournalRecord* record : batch) {
+                        try {
+                            commitBatch(*con, {record});
+                            ++result.replayed;
+                        } catch (sql::SQLException& single) {
+                            if (!isDefinitiveRejection(single)) throw;
+                            logSqlError("replayJournal", single, {{"dropped_record", describeJournalRecord(*record)}});
+                            result.rejections.push_back({*record, single.what()});
+                            ++result.dropped;
+                        }
+                    }
+                }
+                next = end;
+            }
+        } catch (sql::SQLException& e) {
+            // Offline again, or a transient error such as a lock wait timeout or deadlock
+            logSqlError("replayJournal", e, {{"kept_records", records.size() - result.replayed - result.dropped}});
+        }
+        // Anything not yet counted stays journaled; replaying it again later is harmless.
+        size_t done = result.replayed + result.dropped;
+        remaining.assign(records.begin() + static_cast<long>(done), records.end());
+    } catch (sql::SQLException&) {
+        return result; // Still offline
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(journalMutex);
+        // Keep what was appended while the records were being sent
+        std::vector<JournalRecord> current = readJournalLocked();
+        if (current.size() > records.size()) {
+            remaining.insert(remaining.end(), current.begin() + static_cast<long>(records.size()), current.end());
+        }
+        if (!rewriteJournalLocked(remaining)) {
+            logEvent(LogLevel::Error, "replayJournal", "Could not rewrite offline journal; replayed records will be replayed again", {{"path", JOURNAL_PATH}});
+        }
+    }
+    result.remaining = remaining.size();
+    if (result.replayed > 0) {
+        noteWrite();
+        invalidateExpenseCube();
+        invalidateDishAnalytics();
+    }
+    return result;
+}
+
+JournalReplayer::JournalReplayer(Callback onReplayed)
+    : onReplayed(std::move(onReplayed))
+{
+}
+
+JournalReplayer::~JournalReplayer() {
+    if (worker.joinable()) worker.join();
+}
+
+void JournalReplayer::start() {
+    if (running.exchange(true)) return;
+    if (worker.joinable()) worker.join(); // The previous replay has finished
+
+    worker = std::thread([this] {
+        sql::Driver* driver = sql::mysql::get_driver_instance();
+        driver->threadInit(); // Connector/C++ needs this on every thread that connects
+
+        JournalReplayResult result = replayJournal();
+        if (onReplayed) onReplayed(std::move(result));
+
+        driver->threadEnd();
+        running = false;
+    });
+}
@@ -0,0 +1,287 @@
+#include "ledger.h"
+#include "database.h"
+#include "mess.h"
+#include "logger.h"
+#include "slowquery.h"
+#include <cppconn/prepared_statement.h>
+#include <cppconn/resultset.h>
+#include <algorithm>
+#include <climits>
+#include <cmath>
+#include <map>
+#include <set>
+
+namespace { // Anonymous namespace for file-local helpers
+    const size_t MAX_ROWS_PER_INSERT = 1000;
+
+    // Amounts are stored as decimal(12, 2); rounding each step keeps the
+    // running balances equal to what SUM() over the stored amounts gives.
+    double roundCents(double amount) {
+        return std::round(amount * 100.0) / 100.0;
+    }
+
+    const char* entryTypeName(LedgerEntryType type) {
+        switch (type) {
+            case LedgerEntryType::Payment:  return "Payment";
+            case LedgerEntryType::Shopping: return "Shopping";
+            case LedgerEntryType::MealCost: return "MealCost";
+        }
+        return "Payment";
+    }
+
+    LedgerEntryType entryTypeFromName(const std::string& name) {
+        if (name == "Shopping") return LedgerEntryType::Shopping;
+        if (name == "MealCost") return LedgerEntryType::MealCost;
+        return LedgerEntryType::Payment;
+    }
+
+    struct AccountState {
+        double balance = 0.0;
+        double totalPayments = 0.0;
+        double totalShopping = 0.0;
+        double totalMealCost = 0.0;
+        int entryCount = 0;
+    };
+
+    struct Entry {
+        int account;
+        const LedgerPosting* posting;
+        double amount;
+        double runningBalance;
+    };
+
+    std::string placeholders(const std::string& row, size_t count) {
+        std::string values;
+        for (size_t i = 0; i < count; ++i) {
+            values += row;
+            if (i < count - 1) values += ", ";
+        }
+        return values;
+    }
+
+    LedgerBalance readBalance(sql::ResultSet& res) {
+        LedgerBalance balance;
+        balance.user_id = res.getInt("id");
+        balance.user_name = res.getString("name");
+        balance.total_payments = res.getDouble("total_payments");
+        balance.total_shopping = res.getDouble("total_shopping");
+        balance.total_meal_cost = -res.getDouble("total_meal_cost");
+        balance.balance = res.getDouble("balance");
+        return balance;
+    }
+
+    // Reads up to limit + 1 entries of the user's account past anchorId, in
+    // the direction of the scan, and reports whether the extra row existed.
+    bool readStatementEntries(int user_id, long long anchorId, bool older, int limit, std::vector<LedgerEntry>& entries) {
+        std::unique_ptr<sql::Connection> con(getReadConnection());
+        std::unique_ptr<TracedStatement> pstmt(prepareTraced(*con, "readStatementEntries",
+            std::string("SELECT id, entry_type, amount, running_balance, DATE_FORMAT(entry_date, '%Y-%m-%d') AS entry_date, source_id, description "
+                        "FROM ledger_entries WHERE mess_id = ? AND user_id = ? AND ") +
+            (older ? "id < ? ORDER BY id DESC" : "id > ? ORDER BY id ASC") + " LIMIT ?"));
+        pstmt->setInt(1, currentMessId());
+        pstmt->setInt(2, user_id);
+        pstmt->setInt64(3, anchorId);
+        pstmt->setInt(4, limit + 1);
+        std::unique_ptr<sql::ResultSet> res(pstmt->executeQuery());
+        while (res->next()) {
+            entries.push_back({static_cast<long long>(res->getInt64("id")), entryTypeFromName(res->getString("entry_type")),
+                               static_cast<double>(res->getDouble("amount")), static_cast<double>(res->getDouble("running_balance")),
+                               res->getString("entry_date"), res->getInt("source_id"), res->getString("description")});
+        }
+        bool hasMore = entries.size() > static_cast<size_t>(limit);
+        if (hasMore) entries.pop_back();
+        if (older) std::reverse(entries.begin(), entries.end());
+        return hasMore;
+    }
+} // namespace
+
+void postLedgerEntries(sql::Connection& con, int messId, const std::vector<LedgerPosting>& postings) {
+    std::vector<Entry> entries;
+    std::set<int> accounts; // Ordered, so every posting locks accounts in the same order
+    for (const auto& posting : postings) {
+        double amount = roundCents(posting.amount);
+        if (amount == 0.0) continue;
+        entries.push_back({posting.user_id, &posting, amount, 0.0});
+        entries.push_back({MESS_POOL_ACCOUNT, &posting, -amount, 0.0});
+        accounts.insert(posting.user_id);
+        accounts.insert(MESS_POOL_ACCOUNT);
+    }
+    if (entries.empty()) return;
+
+    // Create missing balance rows, then lock them all until the caller commits
+    std::unique_ptr<TracedStatement> pstmt_ensure(prepareTraced(con, "postLedgerEntries",
+        "INSERT INTO ledger_balances (mess_id, user_id) VALUES " + placeholders("(?, ?)", accounts.size()) +
+        " ON DUPLICATE KEY UPDATE user_id = user_id"));
+    int paramIndex = 1;
+    for (int account : accounts) {
+        pstmt_ensure->setInt(paramIndex++, messId);
+        pstmt_ensure->setInt(paramIndex++, account);
+    }
+    pstmt_ensure->executeUpdate();
+
+    std::unique_ptr<TracedStatement> pstmt_lock(prepareTraced(con, "postLedgerEntries",
+        "SELECT user_id, balance, total_payments, total_shopping, total_meal_cost, entry_count FROM ledger_balances "
+        "WHERE mess_id = ? AND user_id IN (" + placeholders("?", accounts.size()) + ") ORDER BY user_id FOR UPDATE"));
+    pstmt_lock->setInt(1, messId);
+    paramIndex = 2;
+    for (int account : accounts) {
+        pstmt_lock->setInt(paramIndex++, account);
+    }
+    std::map<int, AccountState> states;
+    std::unique_ptr<sql::ResultSet> res(pstmt_lock->executeQuery());
+    while (res->next()) {
+        AccountState& state = states[res->getInt("user_id")];
+        state.balance = res->getDouble("balance");
+        state.totalPayments = res->getDouble("total_payments");
+        state.totalShopping = res->getDouble("total_shopping");
+        state.totalMealCost = res->getDouble("total_meal_cost");
+        state.entryCount = res->getInt("entry_count");
+    }
+
+    for (auto& entry : entries) {
+        AccountState& state = states[entry.account];
+        state.balance = roundCents(state.balance + entry.amount);
+        switch (entry.posting->type) {
+            case LedgerEntryType::Payment:  state.totalPayments = roundCents(state.totalPayments + entry.amount); break;
+            case LedgerEntryType::Shopping: state.totalShopping = roundCents(state.totalShopping + entry.amount); break;
+            case LedgerEntryType::MealCost: state.totalMealCost = roundCents(state.totalMealCost + entry.amount); break;
+        }
+        ++state.entryCount;
+        entry.runningBalance = state.balance;
+    }
+
+    // Inserted in posting order, so entry ids follow the running balances
+    for (size_t start = 0; start < entries.size(); start += MAX_ROWS_PER_INSERT) {
+        size_t count = std::min(MAX_ROWS_PER_INSERT, entries.size() - start);
+        std::unique_ptr<TracedStatement> pstmt_entries(prepareTraced(con, "postLedgerEntries",
+            "INSERT INTO ledger_entries (mess_id, user_id, entry_type, amount, running_balance, entry_date, source_id, description) VALUES " +
+            placeholders("(?, ?, ?, ?, ?, STR_TO_DATE(?, '%Y-%m-%d'), ?, ?)", count)));
+        paramIndex = 1;
+        for (size_t i = start; i < start + count; ++i) {
+            const Entry& entry = entries[i];
+            pstmt_entries->setInt(paramIndex++, messId);
+            pstmt_entries->setInt(paramIndex++, entry.account);
+            pstmt_entries->setString(paramIndex++, entryTypeName(entry.posting->type));
+            pstmt_entries->setDouble(paramIndex++, entry.amount);
+            pstmt_entries->setDouble(paramIndex++, entry.runningBalance);
+            pstmt_entries->setString(paramIndex++, entry.posting->entry_date);
+            pstmt_entries->setInt(paramIndex++, entry.posting->source_id);
+            pstmt_entries->setString(paramIndex++, entry.posting->description);
+        }
+        pstmt_entries->executeUpdate();
+    }
+
+    std::unique_ptr<TracedStatement> pstmt_balances(prepareTraced(con, "postLedgerEntries",
+        "INSERT INTO ledger_balances (mess_id, user_id, balance, total_payments, total_shopping, total_meal_cost, entry_count) VALUES " +
+        placeholders("(?, ?, ?, ?, ?, ?, ?)", states.size()) +
+        " ON DUPLICATE KEY UPDATE balance = VALUES(balance), total_payments = VALUES(total_payments), "
+        "total_shopping = VALUES(total_shopping), total_meal_cost = VALUES(total_meal_cost), entry_count = VALUES(entry_count)"));
+    paramIndex = 1;
+    for (const auto& [account, state] : states) {
+        pstmt_balances->setInt(paramIndex++, messId);
+        pstmt_balances->setInt(paramIndex++, account);
+        pstmt_balances->setDouble(paramIndex++, state.balance);
+        pstmt_balances->setDouble(paramIndex++, state.totalPayments);
+        pstmt_balances->setDouble(paramIndex++, state.totalShopping);
+        pstmt_balances->setDouble(paramIndex++, state.totalMealCost);
+        pstmt_balances->setInt(paramIndex++, state.entryCount);
+    }
+    pstmt_balances->executeUpdate();
+}
+
+void postUnpostedWrites(sql::Connection& con, int messId, const std::vector<std::string>& idempotencyKeys) {
+    if (idempotencyKeys.empty()) return;
+    std::string keyList = placeholders("?", idempotencyKeys.size());
+    std::unique_ptr<TracedStatement> pstmt(prepareTraced(con, "postUnpostedWrites",
+        "SELECT 'Payment' AS kind, p.id, p.user_id, p.amount, DATE_FORMAT(p.date, '%Y-%m-%d') AS entry_date, 'Payment' AS description "
+        "FROM payments p WHERE p.mess_id = ? AND p.user_id > 0 AND p.idempotency_key IN (" + keyList + ") "
+        "AND NOT EXISTS (SELECT 1 FROM ledger_entries l WHERE l.mess_id = p.mess_id AND l.entry_type = 'Payment' AND l.source_id = p.id) "
+        "UNION ALL "
+        "SELECT 'Shopping', e.id, e.paid_by_user_id, e.price, DATE_FORMAT(e.purchase_date, '%Y-%m-%d'), e.item_name "
+        "FROM expenses e WHERE e.mess_id = ? AND e.paid_by_user_id > 0 AND e.idempotency_key IN (" + keyList + ") "
+        "AND NOT EXISTS (SELECT 1 FROM ledger_entries l WHERE l.mess_id = e.mess_id AND l.entry_type = 'Shopping' AND l.source_id = e.id) "
+        "ORDER BY entry_date, id"));
+    int paramIndex = 1;
+    for (int table = 0; table < 2; ++table) {
+        pstmt->setInt(paramIndex++, messId);
+        for (const auto& key : idempotencyKeys) {
+            pstmt->setString(paramIndex++, key);
+        }
+    }
+
+    std::vector<LedgerPosting> postings;
+    std::unique_ptr<sql::ResultSet> res(pstmt->executeQuery());
+    while (res->next()) {
+        bool isPayment = res->getString("kind") == "Payment";
+        postings.push_back({res->getInt("user_id"), isPayment ? LedgerEntryType::Payment : LedgerEntryType::Shopping,
+                            static_cast<double>(res->getDouble("amount")), res->getString("entry_date"), res->getInt("id"), res->getString("description")});
+    }
+    postLedgerEntries(con, messId, postings);
+}
+
+std::vector<LedgerBalance> getLedgerBalances() {
+    std::vector<LedgerBalance> balances;
+    try {
+        std::unique_ptr<sql::Connection> con(getReadConnection());
+        std::unique_ptr<TracedStatement> pstmt(prepareTraced(*con, "getLedgerBalances",
+            "SELECT u.id, u.name, COALESCE(b.total_payments, 0) AS total_payments, COALESCE(b.total_shopping, 0) AS total_shopping, "
+            "COALESCE(b.total_meal_cost, 0) AS total_meal_cost, COALESCE(b.balance, 0) AS balance "
+            "FROM users u LEFT JOIN ledger_balances b ON b.mess_id = u.mess_id AND b.user_id = u.id "
+            "WHERE u.mess_id = ? ORDER BY u.name, u.id"));
+        pstmt->setInt(1, currentMessId());
+        std::unique_ptr<sql::ResultSet> res(pstmt->executeQuery());
+        while (res->next()) {
+            balances.push_back(readBalance(*res));
+        }
+    } catch (sql::SQLException& e) {
+        logSqlError("getLedgerBalances", e);
+    }
+    return balances;
+}
+
+bool getLedgerBalance(int user_id, LedgerBalance& balance) {
+    try {
+        std::unique_ptr<sql::Connection> con(getReadConnection());
+        std::unique_ptr<TracedStatement> pstmt(prepareTraced(*con, "getLedgerBalance",
+            "SELECT u.id, u.name, COALESCE(b.total_payments, 0) AS total_payments, COALESCE(b.total_shopping, 0) AS total_shopping, "
+            "COALESCE(b.total_meal_cost, 0) AS total_meal_cost, COALESCE(b.balance, 0) AS balance "
+            "FROM users u LEFT JOIN ledger_balances b ON b.mess_id = u.mess_id AND b.user_id = u.id "
+            "WHERE u.id = ? AND u.mess_id = ?"));
+        pstmt->setInt(1, user_id);
+        pstmt->setInt(2, currentMessId());
+        std::unique_ptr<sql::ResultSet> res(pstmt->executeQuery());
+        if (!res->next()) return false;
+        balance = readBalance(*res);
+        return true;
+    } catch (sql::SQLException& e) {
+        logSqlError("getLedgerBalance", e);
+        return false;
+    }
+}
+
+LedgerStatementPage getLedgerStatementBefore(int user_id, long long beforeId, int limit) {
+    LedgerStatementPage page;
+    try {
+        page.has_older = readStatementEntries(user_id, beforeId > 0 ? beforeId : LLONG_MAX, true, limit, page.entries);
+        page.has_newer = beforeId > 0;
+    } catch (sql::SQLException& e) {
+        logSqlError("getLedgerStatementBefore", e);
+        page.entries.clear();
+    }
+    return page;
+}
+
+LedgerStatementPage getLedgerStatementAfter(int user_id, long long afterId, int limit) {
+    LedgerStatementPage page;
+    try {
+        page.has_newer = readStatementEntries(user_id, afterId, false, limit, page.entries);
+        if (!page.has_newer && page.entries.size() < static_cast<size_t>(limit)) {
+            return getLedgerStatementBefore(user_id, 0, limit);
+        }
+        page.has_older = true;
+    } catch (sql::SQLException& e) {
+        logSqlError("getLedgerStatementAfter", e);
+        page.entries.clear();
+    }
+    return page;
+}
@@ -0,0 +1,342 @@
+#include "logger.h"
+#include "database.h"
+#include <QSettings>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <ctime>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace { // Anonymous namespace for file-local helpers
+    const size_t RING_CAPACITY = 4096; // Power of two
+    const auto IDLE_WAIT = std::chrono::milliseconds(200);
+
+    struct LogRecord {
+        LogLevel level = LogLevel::Info;
+        std::string timestamp;
+        std::string function;
+        std::string message;
+        std::vector<LogField> fields;
+    };
+
+    struct LogSettings {
+        std::string file;
+        LogLevel level = LogLevel::Info;
+        int consoleLevel = static_cast<int>(LogLevel::Warning); // Above Error for none
+        uintmax_t maxFileBytes = 10240 * 1024;
+        int maxFiles = 5;
+    };
+
+    const char* levelName(LogLevel level) {
+        switch (level) {
+            case LogLevel::Debug:   return "debug";
+            case LogLevel::Info:    return "info";
+            case LogLevel::Warning: return "warning";
+            case LogLevel::Error:   return "error";
+        }
+        return "info";
+    }
+
+    int parseLevel(const std::string& name, int fallback) {
+        if (name == "debug") return static_cast<int>(LogLevel::Debug);
+        if (name == "info") return static_cast<int>(LogLevel::Info);
+        if (name == "warning") return static_cast<int>(LogLevel::Warning);
+        if (name == "error") return static_cast<int>(LogLevel::Error);
+        if (name == "none") return static_cast<int>(LogLevel::Error) + 1;
+        return fallback;
+    }
+
+    LogSettings readLogSettings() {
+        QSettings settings(QString::fromStdString(getConfigFilePath()), QSettings::IniFormat);
+        LogSettings result;
+        result.file = settings.value("Logging/file", "meal_manager.log").toString().toStdString();
+        result.level = static_cast<LogLevel>(std::min(parseLevel(settings.value("Logging/level", "info").toString().toStdString(),
+                                                                 static_cast<int>(LogLevel::Info)),
+                                                      static_cast<int>(LogLevel::Error)));
+        result.consoleLevel = parseLevel(settings.value("Logging/console_level", "warning").toString().toStdString(),
+                                         static_cast<int>(LogLevel::Warning));
+        result.maxFileBytes = static_cast<uintmax_t>(std::max(0, settings.value("Logging/max_file_size_kb", 10240).toInt())) * 1024;
+        result.maxFiles = std::max(0, settings.value("Logging/max_files", 5).toInt());
+        return result;
+    }
+
+    // UTC, to the millisecond: 2024-03-01T12:00:00.123Z
+    std::string currentTimestamp() {
+        auto now = std::chrono::system_clock::now();
+        std::time_t seconds = std::chrono::system_clock::to_time_t(now);
+        int millis = static_cast<int>(std::chrono::duration_cast<std::chrono::milliseconds>(now.time_since_epoch()).count() % 1000);
+        std::tm utc{};
+        gmtime_r(&seconds, &utc);
+        char buffer[32];
+        std::strftime(buffer, sizeof(buffer), "%Y-%m-%dT%H:%M:%S", &utc);
+        char withMillis[40];
+        std::snprintf(withMillis, sizeof(withMillis), "%s.%03dZ", buffer, millis);
+        return withMillis;
+    }
+
+    void appendJsonString(std::string& out, const std::string& text) {
+        out += '"';
+        for (unsigned char c : text) {
+            switch (c) {
+                case '"':  out += "\\\""; break;
+                case '\\': out += "\\\\"; break;
+                case '\n': out += "\\n"; break;
+                case '\r': out += "\\r"; break;
+                case '\t': out += "\\t"; break;
+                default:
+                    if (c < 0x20) {
+                        char escaped[8];
+                        std::snprintf(escaped, sizeof(escaped), "\\u%04x", c);
+                        out += escaped;
+                    } else {
+                        out += static_cast<char>(c);
+                    }
+            }
+        }
+        out += '"';
+    }
+
+    std::string formatJson(const LogRecord& record) {
+        std::string line = "{\"ts\":\"" + record.timestamp + "\",\"level\":\"" + levelName(record.level) + "\",\"fn\":";
+        appendJsonString(line, record.function);
+        line += ",\"msg\":";
+        appendJsonString(line, record.message);
+        for (const auto& field : record.fields) {
+            line += ',';
+            appendJsonString(line, field.key);
+            line += ':';
+            if (field.numeric) {
+                line += field.value;
+            } else {
+                appendJsonString(line, field.value);
+            }
+        }
+        line += "}\n";
+        return line;
+    }
+
+    std::string formatConsole(const LogRecord& record) {
+        std::string line = std::string("[") + levelName(record.level) + "] ";
+        if (!record.function.empty()) line += record.function + ": ";
+        line += record.message;
+        if (!record.fields.empty()) {
+            line += " (";
+            for (size_t i = 0; i < record.fields.size(); ++i) {
+                if (i > 0) line += ", ";
+                line += record.fields[i].key + "=" + record.fields[i].value;
+            }
+            line += ")";
+        }
+        return line;
+    }
+
+    // Bounded multi-producer queue (Vyukov). Each slot's sequence number says
+    // whether it is free for the producer at that position or holds a record
+    // for the consumer, so producers only contend on one atomic increment.
+    // There is a single consumer, the writer thread.
+    class LogRing {
+    public:
+        LogRing() : slots(new Slot[RING_CAPACITY]) {
+            for (size_t i = 0; i < RING_CAPACITY; ++i) {
+                slots[i].sequence.store(i, std::memory_order_relaxed);
+            }
+        }
+
+        bool push(LogRecord&& record) {
+            size_t pos = enqueuePos.load(std::memory_order_relaxed);
+            Slot* slot;
+            for (;;) {
+                slot = &slots[pos & (RING_CAPACITY - 1)];
+                size_t sequence = slot->sequence.load(std::memory_order_acquire);
+                intptr_t diff = static_cast<intptr_t>(sequence) - static_cast<intptr_t>(pos);
+                if (diff == 0) {
+                    if (enqueuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) break;
+                } else if (diff < 0) {
+                    return false; // Full
+                } else {
+                    pos = enqueuePos.load(std::memory_order_relaxed);
+                }
+            }
+            slot->record = std::move(record);
+            slot->sequence.store(pos + 1, std::memory_order_release);
+            return true;
+        }
+
+        bool pop(LogRecord& record) {
+            Slot& slot = slots[dequeuePos & (RING_CAPACITY - 1)];
+            if (slot.sequence.load(std::memory_order_acquire) != dequeuePos + 1) return false;
+            record = std::move(slot.record);
+            slot.sequence.store(dequeuePos + RING_CAPACITY, std::memory_order_release);
+            ++dequeuePos;
+            return true;
+        }
+
+        // Positions claimed so far; every record below it is written once
+        // the consumer has popped that far.
+        size_t claimed() const { return enqueuePos.load(std::memory_order_acquire); }
+
+    private:
+        struct Slot {
+            std::atomic<size_t> sequence;
+            LogRecord record;
+        };
+        std::unique_ptr<Slot[]> slots;
+        alignas(64) std::atomic<size_t> enqueuePos{0};
+        alignas(64) size_t dequeuePos = 0; // Writer thread only
+    };
+
+    class Logger {
+    public:
+        Logger() : settings(readLogSettings()), writer(&Logger::run, this) {}
+
+        ~Logger() {
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                stopping = true;
+            }
+            wake.notify_one();
+            writer.join();
+        }
+
+        bool enabled(LogLevel level) const { return level >= settings.level; }
+
+        void push(LogRecord&& record) {
+            if (!ring.push(std::move(record))) {
+                dropped.fetch_add(1, std::memory_order_relaxed);
+                return;
+            }
+            wake.notify_one();
+        }
+
+        void flush() {
+            size_t target = ring.claimed();
+            std::unique_lock<std::mutex> lock(mutex);
+            wake.notify_one();
+            flushed.wait(lock, [&] { return written >= target || stopping; });
+        }
+
+    private:
+        LogSettings settings;
+        LogRing ring;
+        std::atomic<size_t> dropped{0};
+        std::mutex mutex; // Guards stopping and written, for the waits only
+        std::condition_variable wake;
+        std::condition_variable flushed;
+        bool stopping = false;
+        size_t written = 0;
+        std::ofstream file;
+        uintmax_t fileBytes = 0;
+        std::thread writer; // Last, so it starts after everything it uses
+
+        void run() {
+            openFile();
+            for (;;) {
+                size_t count = drain();
+                std::unique_lock<std::mutex> lock(mutex);
+                written += count;
+                flushed.notify_all();
+                if (count > 0) continue;
+                if (stopping) break;
+                wake.wait_for(lock, IDLE_WAIT);
+            }
+            drain(); // Anything pushed while stopping
+            file.close();
+        }
+
+        size_t drain() {
+            size_t count = 0;
+            LogRecord record;
+            while (ring.pop(record)) {
+                write(record);
+                ++count;
+            }
+            size_t lost = dropped.exchange(0, std::memory_order_relaxed);
+            if (lost > 0) {
+                LogRecord notice{LogLevel::Warning, currentTimestamp(), "logger", "Log queue full; records dropped",
+                                 {LogField("dropped", lost)}};
+                write(notice);
+            }
+            if (count > 0 && file.is_open()) file.flush();
+            return count;
+        }
+
+        void write(const LogRecord& record) {
+            if (static_cast<int>(record.level) >= settings.consoleLevel) {
+                std::cerr << formatConsole(record) << std::endl;
+            }
+            if (!file.is_open()) return;
+            std::string line = formatJson(record);
+            if (settings.maxFileBytes > 0 && fileBytes > 0 && fileBytes + line.size() > settings.maxFileBytes) {
+                rotate();
+                if (!file.is_open()) return;
+            }
+            file << line;
+            fileBytes += line.size();
+        }
+
+        void openFile() {
+            if (settings.file.empty()) return;
+            file.open(settings.file, std::ios::app);
+            if (!file) {
+                std::cerr << "Could not open log file '" << settings.file << "'; logging to stderr only." << std::endl;
+                return;
+            }
+            std::error_code ec;
+            fileBytes = std::filesystem::file_size(settings.file, ec);
+            if (ec) fileBytes = 0;
+        }
+
+        void rotate() {
+            file.close();
+            rotateLogFiles(settings.file, settings.maxFiles);
+            file.open(settings.file, std::ios::trunc);
+            fileBytes = 0;
+        }
+    };
+
+    Logger& logger() {
+        static Logger instance;
+        return instance;
+    }
+} // namespace
+
+void logEvent(LogLevel level, const char* function, const std::string& message, std::initializer_list<LogField> fields) {
+    Logger& log = logger();
+    if (!log.enabled(level)) return;
+    log.push({level, currentTimestamp(), function ? function : "", message, std::vector<LogField>(fields)});
+}
+
+void logSqlError(const char* function, const sql::SQLException& e, std::initializer_list<LogField> fields) {
+    Logger& log = logger();
+    if (!log.enabled(LogLevel::Error)) return;
+    std::vector<LogField> allFields{LogField("error_code", e.getErrorCode()), LogField("sql_state", e.getSQLState())};
+    allFields.insert(allFields.end(), fields.begin(), fields.end());
+    log.push({LogLevel::Error, currentTimestamp(), function ? function : "", e.what(), std::move(allFields)});
+}
+
+void flushLog() {
+    logger().flush();
+}
+
+void rotateLogFiles(const std::string& path, int maxFiles) {
+    namespace fs = std::filesystem;
+    std::error_code ec; // Missing files are expected; rotation never fails the caller
+    if (maxFiles <= 0) {
+        fs::remove(path, ec);
+        return;
+    }
+    fs::remove(path + "." + std::to_string(maxFiles), ec);
+    for (int i = maxFiles - 1; i >= 1; --i) {
+        fs::rename(path + "." + std::to_string(i), path + "." + std::to_string(i + 1), ec);
+    }
+    fs::rename(path, path + ".1", ec);
+}
@@ -1,5 +1,7 @@
 #include "loginwindow.h"
 #include "user.h" // Your existing user logic
+#include "mess.h"
+#include "stallwatchdog.h"
 
 // Qt includes for UI elements and layout
 #include <QVBoxLayout>
@@ -8,9 +10,24 @@
 #include <QLineEdit>
 #include <QPushButton>
 #include <QMessageBox>
+#include <QComboBox>
+#include <exception>
 
 LoginWindow::LoginWindow(QWidget *parent) : QWidget(parent) {
     // Create UI elements
+    auto *messLabel = new QLabel("Mess:");
+    messComboBox = new QComboBox();
+    std::vector<Mess> messes;
+    try {
+        messes = getAllMesses();
+    } catch (const std::exception&) {
+        // No usable configuration yet; the login attempt will report it.
+    }
+    for (const auto& mess : messes) {
+        messComboBox->addItem(QString::fromStdString(mess.name), mess.id);
+        if (mess.id == currentMessId()) messComboBox->setCurrentIndex(messComboBox->count() - 1);
+    }
+
     auto *usernameLabel = new QLabel("Username:");
     usernameEdit = new QLineEdit();
     auto *passwordLabel = new QLabel("Password:");
@@ -25,10 +42,12 @@ LoginWindow::LoginWindow(QWidget *parent) : QWidget(parent) {
 
     // Assemble the form
     auto *formLeft = new QVBoxLayout();
+    formLeft->addWidget(messLabel);
     formLeft->addWidget(usernameLabel);
     formLeft->addWidget(passwordLabel);
 
     auto *formRight = new QVBoxLayout();
+    formRight->addWidget(messComboBox);
     formRight->addWidget(usernameEdit);
     formRight->addWidget(passwordEdit);
 
@@ -39,6 +58,12 @@ LoginWindow::LoginWindow(QWidget *parent) : QWidget(parent) {
     mainLayout->addLayout(formLayout);
     mainLayout->addWidget(loginButton);
 
+    // A single-mess deployment has nothing to choose
+    if (messComboBox->count() <= 1) {
+        messLabel->hide();
+        messComboBox->hide();
+    }
+
     setLayout(mainLayout);
     setWindowTitle("Meal Management System - Login");
 
@@ -47,8 +72,12 @@ LoginWindow::LoginWindow(QWidget *parent) : QWidget(parent) {
 }
 
 void LoginWindow::handleLoginAttempt() {
+    StallActivity activity("LoginWindow::handleLoginAttempt");
     std::string username = usernameEdit->text().toStdString();
     std::string password = passwordEdit->text().toStdString();
+    if (messComboBox->count() > 0) {
+        setCurrentMessId(messComboBox->currentData().toInt()); // Usernames are unique per mess
+    }
 
     // Call your existing backend function!
     if (auto user = loginUser(username, password)) { // `user` is a std::unique_ptr<User>
@@ -1,6 +1,10 @@
 #include <QApplication>
 #include "loginwindow.h"
 #include "mainwindow.h"
+#include "migration.h"
+#include "logger.h"
+#include "stallwatchdog.h"
+#include <QMessageBox>
 #include <memory>
 
 #include <QMetaType>
@@ -13,6 +17,22 @@ int main(int argc, char *argv[])
     // Set a flag to ensure the app doesn't quit when the login window closes
     app.setQuitOnLastWindowClosed(false);
 
+    // With apply_on_startup=true, bring the database schema up to date before
+    // anything queries it (otherwise `meal_cli migrate` does). An unreachable
+    // database is left to the login window (and the offline journal).
+    if (migrationsRunOnStartup()) {
+        MigrationRunResult migration = applyPendingMigrations();
+        if (migration.outcome == MigrationOutcome::Failed) {
+            QMessageBox::critical(nullptr, "Database Upgrade Failed", QString::fromStdString(migration.message));
+            return 1;
+        }
+        if (migration.outcome == MigrationOutcome::NotBaselined) {
+            QMessageBox::warning(nullptr, "Database Not Versioned", QString::fromStdString(migration.message));
+        } else if (migration.outcome == MigrationOutcome::Unreachable) {
+            logEvent(LogLevel::Warning, "main", "Skipping schema migrations: " + migration.message);
+        }
+    }
+
     // Create the login window
     LoginWindow loginWindow;
 
@@ -28,5 +48,10 @@ int main(int argc, char *argv[])
 
     loginWindow.show();
 
-    return app.exec();
+    // Watch the event loop for slots that block it (see stallwatchdog.h)
+    startStallWatchdog();
+
+    int result = app.exec();
+    stopStallWatchdog();
+    return result;
 }
\ No newline at end of file
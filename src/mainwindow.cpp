@@ -6,14 +6,25 @@
 #include <QStackedWidget>
 #include <QPushButton>
 #include <QApplication>
+#include <QTimer>
+#include <QTableWidget>
+#include <QHeaderView>
+#include <QMessageBox>
+#include <QDate>
 #include "user.h"
+#include "journal.h"
+#include "forecast.h"
+#include "snapshot.h"
 #include "menumanagementpage.h"
 #include "expensetrackingpage.h"
+#include "expenseanalyticspage.h"
 #include "mealattendancepage.h"
 #include "usermanagementpage.h"
 #include "financialoverviewpage.h"
 #include "dailymenupage.h"
 #include "menuhistorypage.h"
+#include "diagnosticspage.h"
+#include "stallwatchdog.h"
 
 MainWindow::MainWindow(User* userPtr, QWidget *parent)
     : QWidget(parent)
@@ -21,6 +32,12 @@ MainWindow::MainWindow(User* userPtr, QWidget *parent)
     setWindowTitle("Meal Management Dashboard");
     setMinimumSize(800, 600);
 
+    // Paint from the last reference snapshot on disk and refresh it in the background. The
+    // other pages read the database the first time they are shown; the dashboard's headcount
+    // forecast (primary-key reads of meal_headcounts and meal_weekday_counts) is the only read
+    // before the first paint.
+    auto snapshot = mapReferenceSnapshot();
+
     // Main horizontal layout for sidebar and content
     auto mainLayout = new QHBoxLayout(this);
 
@@ -32,17 +49,27 @@ MainWindow::MainWindow(User* userPtr, QWidget *parent)
     sidebar->addItem("User Profile");
     sidebar->addItem("Menu Management");
     sidebar->addItem("Expense Tracking");
+    sidebar->addItem("Expense Analytics");
     sidebar->addItem("Meal Attendance");
     sidebar->addItem("Daily Menu");
     sidebar->addItem("Menu History");
     sidebar->addItem("User Management");
     sidebar->addItem("Financial Overview");
+    if (userPtr->role == UserRole::Admin) {
+        sidebar->addItem("Diagnostics");
+    }
     
     auto exitButton = new QPushButton("Exit", this);
     connect(exitButton, &QPushButton::clicked, qApp, &QApplication::quit);
 
+    // Shown while writes made during a database outage wait in the offline journal
+    offlineStatusLabel = new QLabel(this);
+    offlineStatusLabel->setWordWrap(true);
+    offlineStatusLabel->setStyleSheet("color: #b35c00;");
+
     sidebarLayout->addWidget(sidebar);
     sidebarLayout->addStretch(); // Pushes the exit button to the bottom
+    sidebarLayout->addWidget(offlineStatusLabel);
     sidebarLayout->addWidget(exitButton);
 
 
@@ -56,6 +83,19 @@ MainWindow::MainWindow(User* userPtr, QWidget *parent)
     auto welcomeLabel = new QLabel("Welcome, " + QString::fromStdString(userPtr->name) + "!", dashboardPage);
     welcomeLabel->setAlignment(Qt::AlignCenter);
     dashboardLayout->addWidget(welcomeLabel);
+    currentPeriodLabel = new QLabel(dashboardPage);
+    currentPeriodLabel->setAlignment(Qt::AlignCenter);
+    dashboardLayout->addWidget(currentPeriodLabel);
+
+    // Expected headcount for the coming week, so the kitchen knows how much to cook
+    dashboardLayout->addWidget(new QLabel("Expected headcount (recorded so far in brackets):", dashboardPage));
+    forecastTable = new QTableWidget(dashboardPage);
+    forecastTable->setColumnCount(4);
+    forecastTable->setHorizontalHeaderLabels({"Date", "Breakfast", "Lunch", "Dinner"});
+    forecastTable->horizontalHeader()->setSectionResizeMode(QHeaderView::Stretch);
+    forecastTable->verticalHeader()->setVisible(false);
+    forecastTable->setEditTriggers(QAbstractItemView::NoEditTriggers);
+    dashboardLayout->addWidget(forecastTable);
     dashboardPage->setLayout(dashboardLayout);
     stackedWidget->addWidget(dashboardPage);
 
@@ -64,19 +104,23 @@ MainWindow::MainWindow(User* userPtr, QWidget *parent)
     stackedWidget->addWidget(userProfilePage);
 
     // Menu Management Page
-    auto menuManagementPage = new MenuManagementPage();
+    menuManagementPage = new MenuManagementPage();
     stackedWidget->addWidget(menuManagementPage);
 
     // Expense Tracking Page
     auto expenseTrackingPage = new ExpenseTrackingPage(userPtr);
     stackedWidget->addWidget(expenseTrackingPage);
 
+    // Expense Analytics Page
+    auto expenseAnalyticsPage = new ExpenseAnalyticsPage();
+    stackedWidget->addWidget(expenseAnalyticsPage);
+
     // Meal Attendance Page
-    auto mealAttendancePage = new MealAttendancePage();
+    mealAttendancePage = new MealAttendancePage();
     stackedWidget->addWidget(mealAttendancePage);
 
     // Daily Menu Page
-    auto dailyMenuPage = new DailyMenuPage();
+    dailyMenuPage = new DailyMenuPage();
     stackedWidget->addWidget(dailyMenuPage);
 
     // Menu History Page
@@ -84,13 +128,18 @@ MainWindow::MainWindow(User* userPtr, QWidget *parent)
     stackedWidget->addWidget(menuHistoryPage);
 
     // User Management Page
-    auto userManagementPage = new UserManagementPage();
+    userManagementPage = new UserManagementPage();
     stackedWidget->addWidget(userManagementPage);
 
     // Financial Overview Page
     auto financialOverviewPage = new FinancialOverviewPage();
     stackedWidget->addWidget(financialOverviewPage);
 
+    // Diagnostics Page (slow queries), for admins only; kept last so the other indices don't shift
+    if (userPtr->role == UserRole::Admin) {
+        stackedWidget->addWidget(new DiagnosticsPage());
+    }
+
     // Connect sidebar selection to stacked widget page change
     connect(sidebar, &QListWidget::currentRowChanged, this, &MainWindow::changePage);
 
@@ -102,9 +151,106 @@ MainWindow::MainWindow(User* userPtr, QWidget *parent)
     mainLayout->addWidget(stackedWidget);
 
     setLayout(mainLayout);
+
+    if (snapshot) {
+        applyReferenceSnapshot(*snapshot);
+    }
+
+    // Rebuild the snapshot from the database off the GUI thread and repaint only if it changed
+    snapshotRefresher = std::make_unique<ReferenceSnapshotRefresher>(
+        [this](std::shared_ptr<const ReferenceSnapshot> refreshed, bool changed) {
+            if (!changed) return;
+            QMetaObject::invokeMethod(this, [this, refreshed]() {
+                applyReferenceSnapshot(*refreshed);
+                menuManagementPage->applyReferenceSnapshot(*refreshed);
+                mealAttendancePage->applyReferenceSnapshot(*refreshed);
+                dailyMenuPage->applyReferenceSnapshot(*refreshed);
+                userManagementPage->applyReferenceSnapshot(*refreshed);
+            }, Qt::QueuedConnection);
+        });
+    snapshotRefresher->start();
+
+    // Retry the offline journal off the GUI thread and show the outcome when it is done
+    journalReplayer = std::make_unique<JournalReplayer>([this](JournalReplayResult result) {
+        QMetaObject::invokeMethod(this, [this, result]() {
+            updateOfflineStatus(result.remaining);
+            showJournalRejections(result.rejections);
+        }, Qt::QueuedConnection);
+    });
+
+    // Retry periodically; a replay with nothing pending is just a file check.
+    journalReplayTimer = new QTimer(this);
+    connect(journalReplayTimer, &QTimer::timeout, this, &MainWindow::replayOfflineJournal);
+    journalReplayTimer->start(30 * 1000);
+    replayOfflineJournal();
 }
 
 void MainWindow::changePage(int index)
 {
     stackedWidget->setCurrentIndex(index);
+    if (index == 0) {
+        loadMealForecast(); // Picks up attendance recorded since the dashboard was last shown
+    }
+}
+
+void MainWindow::replayOfflineJournal()
+{
+    journalReplayer->start();
+}
+
+void MainWindow::showJournalRejections(const std::vector<JournalRejection>& rejections)
+{
+    if (rejections.empty()) return;
+    QString message = QString("%1 change(s) made while offline were rejected by the database and discarded. "
+                              "Re-enter them if they are still needed.\n").arg(rejections.size());
+    for (const auto& rejection : rejections) {
+        message += "\n" + QString::fromStdString(describeJournalRecord(rejection.record)) + ": " +
+                   QString::fromStdString(rejection.reason);
+    }
+    QMessageBox::warning(this, "Offline Changes Rejected", message);
+}
+
+void MainWindow::applyReferenceSnapshot(const ReferenceSnapshot& snapshot)
+{
+    if (snapshot.current_period_id == 0) {
+        currentPeriodLabel->setText("No meal period set up for this month.");
+        return;
+    }
+    int totalMeals = 0;
+    for (const auto& report : snapshot.current_settlement) {
+        totalMeals += report.total_meals;
+    }
+    currentPeriodLabel->setText(QString("This month: %1 meals, meal rate %2 %3")
+                                    .arg(totalMeals)
+                                    .arg(snapshot.current_meal_rate, 0, 'f', 2)
+                                    .arg(QString::fromStdString(snapshot.currency)));
+}
+
+void MainWindow::loadMealForecast()
+{
+    StallActivity activity("MainWindow::loadMealForecast");
+    const int days = 7;
+    std::vector<MealForecast> forecasts =
+        forecastMealDemand(QDate::currentDate().addDays(1).toString("yyyy-MM-dd").toStdString(), days);
+
+    forecastTable->setRowCount(0);
+    forecastTable->setRowCount(forecasts.size() / 3);
+    for (size_t i = 0; i < forecasts.size(); ++i) {
+        const MealForecast& forecast = forecasts[i];
+        int row = static_cast<int>(i / 3);
+        int column = forecast.meal_type == "Breakfast" ? 1 : forecast.meal_type == "Lunch" ? 2 : 3;
+        if (column == 1) {
+            QDate date = QDate::fromString(QString::fromStdString(forecast.date), "yyyy-MM-dd");
+            forecastTable->setItem(row, 0, new QTableWidgetItem(date.toString("ddd yyyy-MM-dd")));
+        }
+        auto item = new QTableWidgetItem(QString("%1 (%2)").arg(forecast.expected, 0, 'f', 0).arg(forecast.recorded));
+        item->setToolTip(QString("Usual on this weekday: %1").arg(forecast.weekday_average, 0, 'f', 1));
+        forecastTable->setItem(row, column, item);
+    }
+}
+
+void MainWindow::updateOfflineStatus(size_t pending)
+{
+    offlineStatusLabel->setVisible(pending > 0);
+    offlineStatusLabel->setText(QString("Offline: %1 write(s) waiting for the database").arg(pending));
 }
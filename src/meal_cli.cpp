@@ -0,0 +1,489 @@
+// Headless command-line entry point for batch work (month-end settlement,
+// imports, exports). Links only the data layer, so it runs on servers without
+// a display and can be timed from scripts.
+
+#include "database.h"
+#include "attendance.h"
+#include "dateutil.h"
+#include "export.h"
+#include "finance.h"
+#include "forecast.h"
+#include "journal.h"
+#include "logger.h"
+#include "migration.h"
+#include "mess.h"
+#include "partition.h"
+#include "period.h"
+#include <chrono>
+#include <cstdio>
+#include <ctime>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace { // Anonymous namespace for file-local helpers
+    const int EXIT_USAGE = 2;
+
+    struct CommandLine {
+        std::string command;
+        std::vector<std::string> positional;
+        std::map<std::string, std::string> options;
+        bool timing = false;
+    };
+
+    void printUsage() {
+        std::cerr <<
+            "Usage: meal_cli [--config <file>] [--mess <id>] [--timing] <command> [options]\n"
+            "\n"
+            "Commands:\n"
+            "  messes                                 List messes (tenants) and their IDs\n"
+            "  add-mess <name>                        Create a new mess\n"
+            "  periods                                List meal periods and their IDs\n"
+            "  settle --period <id>                   Print the monthly settlement for a period\n"
+            "  close-period --period <id>             Freeze a period's settlement and lock its records\n"
+            "  import-attendance <file.csv>           Import rows of date,user_id,meal_type\n"
+            "  export settlement --period <id>        Export a period's settlement\n"
+            "  export attendance --from <date> --to <date>\n"
+            "                                         Export attendance rows in a date range\n"
+            "  export expenses                        Export the full expense ledger\n"
+            "  attendance --from <date> --to <date>   Print a user x day grid (B, L, D per attended meal)\n"
+            "  forecast [--from <date>] [--days <n>]  Expected headcount per meal (default: 7 days from tomorrow)\n"
+            "  replica-status                         Show the health of configured read replicas\n"
+            "  replay-journal                         Write journaled offline writes to the database\n"
+            "  recompute-aggregates                   Rebuild the stored meal headcounts from attendance\n"
+            "  migrate [status]                       Apply pending schema migrations, or list them\n"
+            "  migrate baseline <version>             Mark a pre-existing database as having migrations up to version\n"
+            "  partitions                             List monthly partitions and archived months\n"
+            "  partitions maintain [--ahead <n>]      Create partitions up to n months ahead (default 3)\n"
+            "  partitions archive --month <YYYY-MM>   Move a closed month's rows to compressed archive tables\n"
+            "  partitions restore --month <YYYY-MM>   Move an archived month's rows back\n"
+            "\n"
+            "Exports accept [--format csv|columnar] (default csv) and [--out <file>] (default stdout).\n"
+            "Commands act on mess 1 unless --mess is given; partitions are shared by all messes.\n"
+            "Dates use YYYY-MM-DD. --timing prints the elapsed time to stderr.\n";
+    }
+
+    bool parseCommandLine(int argc, char* argv[], CommandLine& cmd) {
+        for (int i = 1; i < argc; ++i) {
+            std::string arg = argv[i];
+            if (arg == "--timing") {
+                cmd.timing = true;
+            } else if (arg.rfind("--", 0) == 0) {
+                if (i + 1 >= argc) {
+                    std::cerr << "Error: Option " << arg << " requires a value." << std::endl;
+                    return false;
+                }
+                cmd.options[arg.substr(2)] = argv[++i];
+            } else if (cmd.command.empty()) {
+                cmd.command = arg;
+            } else {
+                cmd.positional.push_back(arg);
+            }
+        }
+        return !cmd.command.empty();
+    }
+
+    bool parseInt(const std::string& text, int& value) {
+        try {
+            size_t consumed = 0;
+            value = std::stoi(text, &consumed);
+            return consumed == text.size();
+        } catch (const std::exception&) {
+            return false;
+        }
+    }
+
+    bool optionAsInt(const CommandLine& cmd, const std::string& name, int& value) {
+        auto it = cmd.options.find(name);
+        if (it == cmd.options.end()) {
+            std::cerr << "Error: Missing required option --" << name << "." << std::endl;
+            return false;
+        }
+        if (parseInt(it->second, value)) return true;
+        std::cerr << "Error: Option --" << name << " must be an integer." << std::endl;
+        return false;
+    }
+
+    int runMesses() {
+        for (const auto& mess : getAllMesses()) {
+            std::cout << mess.id << "\t" << mess.name << "\n";
+        }
+        return 0;
+    }
+
+    int runAddMess(const CommandLine& cmd) {
+        if (cmd.positional.size() != 1) {
+            std::cerr << "Error: add-mess expects exactly one name." << std::endl;
+            return EXIT_USAGE;
+        }
+        return addMess(cmd.positional[0]) ? 0 : 1;
+    }
+
+    int runPeriods() {
+        for (const auto& period : getAllMealPeriods()) {
+            std::cout << period.id << "\t" << period.month << " " << period.year << (period.is_closed ? "\tclosed" : "") << "\n";
+        }
+        return 0;
+    }
+
+    int runClosePeriod(const CommandLine& cmd) {
+        int periodId;
+        if (!optionAsInt(cmd, "period", periodId)) return EXIT_USAGE;
+        if (!closeMealPeriod(periodId)) return 1;
+        std::cout << "Period " << periodId << " closed; its settlement is frozen." << std::endl;
+        return 0;
+    }
+
+    int runSettle(const CommandLine& cmd) {
+        int periodId;
+        if (!optionAsInt(cmd, "period", periodId)) return EXIT_USAGE;
+
+        auto [mealRate, reports] = generateMonthlySettlement(periodId);
+        if (reports.empty()) {
+            std::cerr << "Error: No settlement could be produced for period " << periodId << "." << std::endl;
+            return 1;
+        }
+
+        std::printf("Meal rate: %.4f\n\n", mealRate);
+        std::printf("%-6s %-24s %6s %12s %12s %12s %12s\n",
+                    "ID", "Name", "Meals", "Meal Cost", "Payments", "Shopping", "Balance");
+        for (const auto& r : reports) {
+            std::printf("%-6d %-24.24s %6d %12.2f %12.2f %12.2f %12.2f\n",
+                        r.user_id, r.user_name.c_str(), r.total_meals, r.total_meal_cost,
+                        r.total_payments, r.total_shopping_expenses, r.final_balance);
+        }
+        return 0;
+    }
+
+    int runImportAttendance(const CommandLine& cmd) {
+        if (cmd.positional.size() != 1) {
+            std::cerr << "Error: import-attendance expects exactly one CSV file." << std::endl;
+            return EXIT_USAGE;
+        }
+        std::ifstream in(cmd.positional[0]);
+        if (!in) {
+            std::cerr << "Error: Could not open '" << cmd.positional[0] << "'." << std::endl;
+            return 1;
+        }
+
+        // Group rows by date so each day is written with one multi-row INSERT.
+        std::map<std::string, std::vector<AttendanceRecord>> byDate;
+        std::string line;
+        size_t lineNumber = 0, skipped = 0, rows = 0;
+        while (std::getline(in, line)) {
+            ++lineNumber;
+            if (!line.empty() && line.back() == '\r') line.pop_back();
+            if (line.empty()) continue;
+
+            std::stringstream ss(line);
+            std::string date, userIdText, mealType;
+            std::getline(ss, date, ',');
+            std::getline(ss, userIdText, ',');
+            std::getline(ss, mealType, ',');
+
+            int day, userId = 0;
+            try {
+                userId = std::stoi(userIdText);
+            } catch (const std::exception&) {
+            }
+            bool validMeal = mealType == "Breakfast" || mealType == "Lunch" || mealType == "Dinner";
+            if (!parseIsoDate(date, day) || userId <= 0 || !validMeal) {
+                if (lineNumber > 1) { // The first line may be a header
+                    std::cerr << "Warning: Skipping malformed line " << lineNumber << ": " << line << std::endl;
+                }
+                ++skipped;
+                continue;
+            }
+            byDate[date].push_back({userId, mealType});
+            ++rows;
+        }
+
+        size_t failedDays = 0;
+        for (const auto& [date, records] : byDate) {
+            if (!addMultipleAttendance(date, records)) {
+                std::cerr << "Error: Failed to import attendance for " << date << "." << std::endl;
+                ++failedDays;
+            }
+        }
+
+        std::cout << "Imported " << rows << " rows across " << byDate.size() - failedDays << " days";
+        if (skipped > 0) std::cout << " (" << skipped << " lines skipped)";
+        std::cout << "." << std::endl;
+        return failedDays == 0 ? 0 : 1;
+    }
+
+    int runExport(const CommandLine& cmd) {
+        if (cmd.positional.size() != 1) {
+            std::cerr << "Error: export expects one of: settlement, attendance, expenses." << std::endl;
+            return EXIT_USAGE;
+        }
+        const std::string& what = cmd.positional[0];
+
+        auto outIt = cmd.options.find("out");
+        std::string path = outIt != cmd.options.end() ? outIt->second : "-";
+
+        ExportFormat format = ExportFormat::Csv;
+        auto formatIt = cmd.options.find("format");
+        if (formatIt != cmd.options.end()) {
+            if (formatIt->second == "columnar") {
+                format = ExportFormat::Columnar;
+            } else if (formatIt->second != "csv") {
+                std::cerr << "Error: --format must be csv or columnar." << std::endl;
+                return EXIT_USAGE;
+            }
+        }
+
+        bool ok;
+        if (what == "settlement") {
+            int periodId;
+            if (!optionAsInt(cmd, "period", periodId)) return EXIT_USAGE;
+            ok = exportSettlement(periodId, path, format);
+        } else if (what == "attendance") {
+            auto fromIt = cmd.options.find("from");
+            auto toIt = cmd.options.find("to");
+            if (fromIt == cmd.options.end() || toIt == cmd.options.end()) {
+                std::cerr << "Error: export attendance needs --from and --to dates." << std::endl;
+                return EXIT_USAGE;
+            }
+            ok = exportAttendance(fromIt->second, toIt->second, path, format);
+        } else if (what == "expenses") {
+            ok = exportExpenseLedger(path, format);
+        } else {
+            std::cerr << "Error: Unknown export '" << what << "'." << std::endl;
+            return EXIT_USAGE;
+        }
+        return ok ? 0 : 1;
+    }
+
+    int runReplicaStatus() {
+        auto statuses = getReplicaStatus();
+        if (statuses.empty()) {
+            std::cout << "No read replicas configured; all reads use the primary." << std::endl;
+            return 0;
+        }
+        for (const auto& status : statuses) {
+            std::cout << status.host << "\t" << (status.available ? "available" : "backing off")
+                      << "\tconsecutive_failures=" << status.consecutive_failures << "\n";
+        }
+        return 0;
+    }
+
+    int runAttendanceGrid(const CommandLine& cmd) {
+        auto fromIt = cmd.options.find("from");
+        auto toIt = cmd.options.find("to");
+        if (fromIt == cmd.options.end() || toIt == cmd.options.end()) {
+            std::cerr << "Error: attendance requires --from and --to." << std::endl;
+            return EXIT_USAGE;
+        }
+        AttendanceMatrix matrix = getAttendanceRange(fromIt->second, toIt->second);
+        if (matrix.dayCount() == 0) return 1;
+
+        std::cout << "user_id\tname\tmeals";
+        for (size_t day = 0; day < matrix.dayCount(); ++day) std::cout << "\t" << matrix.date(day).substr(5);
+        std::cout << "\n";
+        for (size_t user = 0; user < matrix.userCount(); ++user) {
+            std::cout << matrix.userId(user) << "\t" << matrix.userName(user) << "\t" << matrix.mealsForUser(user);
+            for (size_t day = 0; day < matrix.dayCount(); ++day) {
+                std::cout << "\t";
+                for (int meal = 0; meal < AttendanceMatrix::MEALS_PER_DAY; ++meal) {
+                    std::cout << (matrix.attended(user, day, meal) ? AttendanceMatrix::mealName(meal)[0] : '-');
+                }
+            }
+            std::cout << "\n";
+        }
+        return 0;
+    }
+
+    int runForecast(const CommandLine& cmd) {
+        int days = 7;
+        if (cmd.options.count("days") && !optionAsInt(cmd, "days", days)) return EXIT_USAGE;
+        std::string from;
+        auto fromIt = cmd.options.find("from");
+        if (fromIt != cmd.options.end()) {
+            from = fromIt->second;
+        } else {
+            std::time_t now = std::time(nullptr);
+            char today[11];
+            std::strftime(today, sizeof(today), "%Y-%m-%d", std::localtime(&now));
+            int todayNumber;
+            parseIsoDate(today, todayNumber);
+            from = formatIsoDate(todayNumber + 1);
+        }
+
+        std::vector<MealForecast> forecasts = forecastMealDemand(from, days);
+        if (forecasts.empty()) return 1;
+        std::printf("date\tmeal\texpected\tweekday_avg\trecorded\n");
+        for (const auto& forecast : forecasts) {
+            std::printf("%s\t%s\t%.1f\t%.1f\t%d\n", forecast.date.c_str(), forecast.meal_type.c_str(),
+                        forecast.expected, forecast.weekday_average, forecast.recorded);
+        }
+        return 0;
+    }
+
+    int runReplayJournal() {
+        JournalReplayResult result = replayJournal();
+        std::cout << "Replayed " << result.replayed << " journaled writes";
+        if (result.dropped > 0) std::cout << ", dropped " << result.dropped << " rejected by the database";
+        std::cout << "; " << result.remaining << " still pending." << std::endl;
+        for (const auto& rejection : result.rejections) {
+            std::cerr << "Dropped: " << describeJournalRecord(rejection.record) << ": " << rejection.reason << std::endl;
+        }
+        return result.remaining == 0 ? 0 : 1;
+    }
+
+    int runMigrate(const CommandLine& cmd) {
+        std::string action = cmd.positional.empty() ? "apply" : cmd.positional[0];
+        if (action == "status") {
+            std::vector<MigrationStatus> statuses = getMigrationStatus();
+            std::printf("version\tstate\tapplied_at\tname\n");
+            for (const auto& status : statuses) {
+                std::string state = status.modified ? "MODIFIED" : status.applied ? "applied" : "pending";
+                if (status.statements_done > 0) state = "partial (" + std::to_string(status.statements_done) + " statements run)";
+                std::printf("%d\t%s\t%s\t%s\n", status.version, state.c_str(),
+                            status.applied_at.empty() ? "-" : status.applied_at.c_str(), status.name.c_str());
+            }
+            return 0;
+        }
+        if (action == "baseline") {
+            int version;
+            if (cmd.positional.size() != 2 || !parseInt(cmd.positional[1], version)) {
+                std::cerr << "Error: migrate baseline requires a version number." << std::endl;
+                return EXIT_USAGE;
+            }
+            if (!baselineSchema(version)) return 1;
+            std::cout << "Recorded migrations up to " << version << " as already applied." << std::endl;
+            return 0;
+        }
+        if (action != "apply") {
+            std::cerr << "Error: Unknown migrate action '" << action << "'." << std::endl;
+            return EXIT_USAGE;
+        }
+
+        MigrationRunResult result = applyPendingMigrations();
+        switch (result.outcome) {
+            case MigrationOutcome::UpToDate:
+                std::cout << "Schema is up to date at version " << result.schema_version << "." << std::endl;
+                return 0;
+            case MigrationOutcome::Applied:
+                std::cout << "Applied " << result.applied << " migration(s); schema is at version " << result.schema_version << "." << std::endl;
+                return 0;
+            default:
+                std::cerr << "Error: " << result.message << std::endl;
+                return 1;
+        }
+    }
+
+    int runPartitions(const CommandLine& cmd) {
+        std::string action = cmd.positional.empty() ? "list" : cmd.positional[0];
+        if (action == "list") {
+            std::printf("table\tpartition\trows\tbytes\n");
+            for (const auto& partition : listPartitions()) {
+                std::printf("%s\t%s\t%lld\t%lld\n", partition.table.c_str(), partition.partition.c_str(),
+                            partition.rows, partition.bytes);
+            }
+            for (const auto& archive : listArchives()) {
+                std::printf("%s\tarchived %s\t%lld\t%lld\n", archive.source_table.c_str(), archive.month.c_str(),
+                            archive.rows, archive.bytes);
+            }
+            return 0;
+        }
+        if (action == "maintain") {
+            int ahead = 3;
+            if (cmd.options.count("ahead") && !optionAsInt(cmd, "ahead", ahead)) return EXIT_USAGE;
+            return ensureFuturePartitions(ahead) ? 0 : 1;
+        }
+        if (action == "archive" || action == "restore") {
+            auto monthIt = cmd.options.find("month");
+            if (monthIt == cmd.options.end()) {
+                std::cerr << "Error: partitions " << action << " requires --month <YYYY-MM>." << std::endl;
+                return EXIT_USAGE;
+            }
+            bool ok = action == "archive" ? archiveMonth(monthIt->second) : restoreArchivedMonth(monthIt->second);
+            if (!ok) return 1;
+            std::cout << monthIt->second << (action == "archive" ? " archived." : " restored.") << std::endl;
+            return 0;
+        }
+        std::cerr << "Error: Unknown partitions action '" << action << "'." << std::endl;
+        return EXIT_USAGE;
+    }
+
+    // Only the aggregates stored in the database. The expense cube and the menu
+    // search index live in each process's memory, so a rebuild here would not
+    // reach the GUI; they refresh themselves when their data changes.
+    int runRecomputeAggregates() {
+        if (!rebuildMealHeadcounts()) return 1;
+        std::cout << "Meal headcounts and weekday counts rebuilt from attendance." << std::endl;
+        return 0;
+    }
+} // namespace
+
+int main(int argc, char* argv[])
+{
+    CommandLine cmd;
+    if (!parseCommandLine(argc, argv, cmd)) {
+        printUsage();
+        return EXIT_USAGE;
+    }
+
+    auto configIt = cmd.options.find("config");
+    if (configIt != cmd.options.end()) {
+        setConfigFilePath(configIt->second);
+    }
+    if (cmd.options.count("mess")) {
+        int messId;
+        if (!optionAsInt(cmd, "mess", messId)) return EXIT_USAGE;
+        setCurrentMessId(messId);
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    int status;
+    try {
+        if (cmd.command == "messes") {
+            status = runMesses();
+        } else if (cmd.command == "add-mess") {
+            status = runAddMess(cmd);
+        } else if (cmd.command == "periods") {
+            status = runPeriods();
+        } else if (cmd.command == "settle") {
+            status = runSettle(cmd);
+        } else if (cmd.command == "close-period") {
+            status = runClosePeriod(cmd);
+        } else if (cmd.command == "import-attendance") {
+            status = runImportAttendance(cmd);
+        } else if (cmd.command == "export") {
+            status = runExport(cmd);
+        } else if (cmd.command == "attendance") {
+            status = runAttendanceGrid(cmd);
+        } else if (cmd.command == "forecast") {
+            status = runForecast(cmd);
+        } else if (cmd.command == "replica-status") {
+            status = runReplicaStatus();
+        } else if (cmd.command == "replay-journal") {
+            status = runReplayJournal();
+        } else if (cmd.command == "migrate") {
+            status = runMigrate(cmd);
+        } else if (cmd.command == "partitions") {
+            status = runPartitions(cmd);
+        } else if (cmd.command == "recompute-aggregates") {
+            status = runRecomputeAggregates();
+        } else {
+            std::cerr << "Error: Unknown command '" << cmd.command << "'." << std::endl;
+            printUsage();
+            status = EXIT_USAGE;
+        }
+    } catch (const std::exception& e) {
+        // getConnection() reports configuration problems as exceptions.
+        std::cerr << e.what() << std::endl;
+        status = 1;
+    }
+    flushLog(); // Data-layer warnings are echoed to stderr by the log writer thread
+
+    if (cmd.timing) {
+        auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start);
+        std::cerr << "elapsed_ms=" << elapsed.count() << std::endl;
+    }
+    return status;
+}
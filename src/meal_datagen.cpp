@@ -0,0 +1,141 @@
+// Synthetic dataset generator for load tests and benchmarks. Creates a new
+// mess filled with realistic, reproducible data (see datagen.h), so tests can
+// run against production-sized volumes without production data.
+
+#include "database.h"
+#include "datagen.h"
+#include "finance.h"
+#include "logger.h"
+#include "mess.h"
+#include <chrono>
+#include <cstdio>
+#include <iostream>
+#include <map>
+#include <stdexcept>
+#include <string>
+
+namespace { // Anonymous namespace for file-local helpers
+    const int EXIT_USAGE = 2;
+
+    void printUsage() {
+        std::cerr <<
+            "Usage: meal_datagen [--config <file>] [options]\n"
+            "\n"
+            "Creates a new mess and loads a synthetic dataset into the configured database.\n"
+            "The same seed and options always produce the same data.\n"
+            "\n"
+            "Options:\n"
+            "  --seed <n>                Random seed (default 1)\n"
+            "  --mess-name <name>        Name of the new mess (default \"Synthetic <seed>\")\n"
+            "  --users <n>               Users, including one admin (default 50)\n"
+            "  --start <YYYY-MM>         First month (default 2024-01)\n"
+            "  --months <n>              Months of data, one meal period each (default 3)\n"
+            "  --menu-items <n>          Menu items, at least 6 (default 60)\n"
+            "  --expenses-per-day <x>    Average food purchases per day (default 3)\n"
+            "  --password <text>         Password of every generated user (default \"password\")\n"
+            "  --close-periods           Close every period but the last, freezing its settlement\n";
+    }
+
+    bool parseCommandLine(int argc, char* argv[], std::map<std::string, std::string>& options, bool& closePeriods) {
+        for (int i = 1; i < argc; ++i) {
+            std::string arg = argv[i];
+            if (arg == "--close-periods") {
+                closePeriods = true;
+            } else if (arg.rfind("--", 0) == 0 && i + 1 < argc) {
+                options[arg.substr(2)] = argv[++i];
+            } else {
+                std::cerr << "Error: Unexpected argument " << arg << "." << std::endl;
+                return false;
+            }
+        }
+        return true;
+    }
+
+    bool applyOptions(const std::map<std::string, std::string>& options, DatasetOptions& dataset) {
+        for (const auto& [name, value] : options) {
+            try {
+                size_t consumed = 0;
+                if (name == "config") {
+                    setConfigFilePath(value);
+                    continue;
+                } else if (name == "seed") {
+                    dataset.seed = std::stoull(value, &consumed);
+                } else if (name == "users") {
+                    dataset.users = std::stoi(value, &consumed);
+                } else if (name == "months") {
+                    dataset.months = std::stoi(value, &consumed);
+                } else if (name == "menu-items") {
+                    dataset.menu_items = std::stoi(value, &consumed);
+                } else if (name == "expenses-per-day") {
+                    dataset.expenses_per_day = std::stod(value, &consumed);
+                } else if (name == "start") {
+                    dataset.start_month = value;
+                    continue;
+                } else if (name == "mess-name") {
+                    dataset.mess_name = value;
+                    continue;
+                } else if (name == "password") {
+                    dataset.password = value;
+                    continue;
+                } else {
+                    std::cerr << "Error: Unknown option --" << name << "." << std::endl;
+                    return false;
+                }
+                if (consumed != value.size()) throw std::invalid_argument(value);
+            } catch (const std::exception&) {
+                std::cerr << "Error: Option --" << name << " must be a number." << std::endl;
+                return false;
+            }
+        }
+        std::string problem = validateDatasetOptions(dataset);
+        if (!problem.empty()) {
+            std::cerr << "Error: " << problem << "." << std::endl;
+            return false;
+        }
+        return true;
+    }
+} // namespace
+
+int main(int argc, char* argv[])
+{
+    std::map<std::string, std::string> options;
+    bool closePeriods = false;
+    DatasetOptions dataset;
+    if (!parseCommandLine(argc, argv, options, closePeriods) || !applyOptions(options, dataset)) {
+        printUsage();
+        return EXIT_USAGE;
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    int status = 0;
+    try {
+        DatasetSummary summary;
+        if (!generateDataset(dataset, summary)) {
+            std::cerr << "Error: Dataset generation failed";
+            if (summary.mess_id != 0) std::cerr << "; mess " << summary.mess_id << " is partly filled";
+            std::cerr << "." << std::endl;
+            status = 1;
+        } else {
+            double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+            std::printf("Mess %d: %zu users, %zu periods, %zu menu items, %zu daily menu rows,\n"
+                        "%zu attendance rows, %zu expenses, %zu payments.\n"
+                        "%zu rows in %.1f s (%.0f rows/s).\n",
+                        summary.mess_id, summary.users, summary.period_ids.size(), summary.menu_items, summary.daily_menu_rows,
+                        summary.attendance_rows, summary.expenses, summary.payments,
+                        summary.total_rows, seconds, seconds > 0 ? summary.total_rows / seconds : 0.0);
+
+            if (closePeriods) {
+                setCurrentMessId(summary.mess_id);
+                for (size_t i = 0; i + 1 < summary.period_ids.size(); ++i) {
+                    if (!closeMealPeriod(summary.period_ids[i])) status = 1;
+                }
+            }
+        }
+    } catch (const std::exception& e) {
+        // getConnection() reports configuration problems as exceptions.
+        std::cerr << e.what() << std::endl;
+        status = 1;
+    }
+    flushLog();
+    return status;
+}
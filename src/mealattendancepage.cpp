@@ -1,5 +1,7 @@
 #include "mealattendancepage.h"
 #include "attendance.h"
+#include "attendancegridmodel.h"
+#include <QShowEvent>
 #include <QVBoxLayout>
 #include <QHBoxLayout>
 #include <QTableWidget>
@@ -9,11 +11,15 @@
 #include <QHeaderView>
 #include <QMessageBox>
 #include <QCheckBox>
+#include <QStackedWidget>
+#include <QTableView>
 #include <QLabel> // Added missing include
 #include <set>    // For efficient lookups
 #include <utility> // For std::pair
 #include "database.h"
+#include "snapshot.h"
 #include "user.h"
+#include "stallwatchdog.h"
 
 MealAttendancePage::MealAttendancePage(QWidget *parent)
     : QWidget(parent)
@@ -34,8 +40,20 @@ MealAttendancePage::MealAttendancePage(QWidget *parent)
     dateLayout->addWidget(new QLabel("Date:"));
     dateLayout->addWidget(attendanceDateEdit);
     dateLayout->addStretch();
+    dateLayout->addWidget(new QLabel("View:"));
+    viewModeComboBox = new QComboBox(this);
+    viewModeComboBox->addItems({"Day", "Week", "Month"});
+    dateLayout->addWidget(viewModeComboBox);
     mainLayout->addLayout(dateLayout);
 
+    viewStack = new QStackedWidget(this);
+    mainLayout->addWidget(viewStack);
+
+    // --- Day view ---
+    auto dayView = new QWidget();
+    auto dayLayout = new QVBoxLayout(dayView);
+    dayLayout->setContentsMargins(0, 0, 0, 0);
+
     // User attendance table
     userAttendanceTable = new QTableWidget(this);
     userAttendanceTable->setColumnCount(4); // User Name, Breakfast, Lunch, Dinner
@@ -43,25 +61,77 @@ MealAttendancePage::MealAttendancePage(QWidget *parent)
     userAttendanceTable->horizontalHeader()->setStretchLastSection(true);
     userAttendanceTable->setSelectionBehavior(QAbstractItemView::SelectRows);
     userAttendanceTable->setEditTriggers(QAbstractItemView::NoEditTriggers);
-    mainLayout->addWidget(userAttendanceTable);
+    dayLayout->addWidget(userAttendanceTable);
 
     // Record attendance button
     recordAttendanceButton = new QPushButton("Record Attendance", this);
-    mainLayout->addWidget(recordAttendanceButton);
+    dayLayout->addWidget(recordAttendanceButton);
+    viewStack->addWidget(dayView);
+
+    // --- Week / month grid view ---
+    // A model-backed view paints only the visible cells, so a month of users stays responsive.
+    auto gridView = new QWidget();
+    auto gridLayout = new QVBoxLayout(gridView);
+    gridLayout->setContentsMargins(0, 0, 0, 0);
+    gridLayout->addWidget(new QLabel("Click a column header to toggle a meal for everyone, or a name to toggle a user's whole range."));
+
+    attendanceGridModel = new AttendanceGridModel(this);
+    attendanceGridView = new QTableView(this);
+    attendanceGridView->setModel(attendanceGridModel);
+    attendanceGridView->setSelectionMode(QAbstractItemView::NoSelection);
+    attendanceGridView->horizontalHeader()->setSectionResizeMode(QHeaderView::Fixed);
+    attendanceGridView->horizontalHeader()->setDefaultSectionSize(52);
+    attendanceGridView->horizontalHeader()->setSectionsClickable(true);
+    attendanceGridView->verticalHeader()->setSectionsClickable(true);
+    gridLayout->addWidget(attendanceGridView);
+
+    auto gridButtonLayout = new QHBoxLayout();
+    pendingChangesLabel = new QLabel(this);
+    gridButtonLayout->addWidget(pendingChangesLabel);
+    gridButtonLayout->addStretch();
+    saveGridButton = new QPushButton("Save Changes", this);
+    gridButtonLayout->addWidget(saveGridButton);
+    gridLayout->addLayout(gridButtonLayout);
+    viewStack->addWidget(gridView);
 
     // Connections
-    connect(attendanceDateEdit, &QDateEdit::dateChanged, this, &MealAttendancePage::loadAttendanceForDate);
+    connect(attendanceDateEdit, &QDateEdit::dateChanged, this, &MealAttendancePage::reloadCurrentView);
+    connect(viewModeComboBox, &QComboBox::currentIndexChanged, this, &MealAttendancePage::viewModeChanged);
     connect(recordAttendanceButton, &QPushButton::clicked, this, &MealAttendancePage::recordAttendanceClicked);
+    connect(saveGridButton, &QPushButton::clicked, this, &MealAttendancePage::saveAttendanceGridClicked);
+    connect(attendanceGridModel, &AttendanceGridModel::pendingChangeCountChanged, this, &MealAttendancePage::updatePendingChanges);
+    connect(attendanceGridView->horizontalHeader(), &QHeaderView::sectionClicked, attendanceGridModel, &AttendanceGridModel::toggleColumn);
+    connect(attendanceGridView->verticalHeader(), &QHeaderView::sectionClicked, attendanceGridModel, &AttendanceGridModel::toggleRow);
 
-    // Initial load
-    allUsers = getAllUsers(); // Fetch all users once
-    loadAttendanceForDate();
+    // The user list comes from the local snapshot when there is one; attendance loads on first show
+    if (auto snapshot = currentReferenceSnapshot()) {
+        allUsers = snapshot->users;
+    }
+    updatePendingChanges(0);
 
     setLayout(mainLayout);
 }
 
+void MealAttendancePage::showEvent(QShowEvent *event)
+{
+    QWidget::showEvent(event);
+    if (loaded) return;
+    loaded = true;
+    if (allUsers.empty()) {
+        allUsers = getAllUsers(); // No snapshot yet; fetch all users once
+    }
+    loadAttendanceForDate();
+}
+
+void MealAttendancePage::applyReferenceSnapshot(const ReferenceSnapshot& snapshot)
+{
+    allUsers = snapshot.users;
+    if (loaded) loadAttendanceForDate(); // Otherwise the first show loads it
+}
+
 void MealAttendancePage::loadAttendanceForDate()
 {
+    StallActivity activity("MealAttendancePage::loadAttendanceForDate");
     userAttendanceTable->setRowCount(0); // Clear existing rows
     userAttendanceTable->setSortingEnabled(false); // Disable sorting during population
 
@@ -105,6 +175,7 @@ void MealAttendancePage::loadAttendanceForDate()
 
 void MealAttendancePage::recordAttendanceClicked()
 {
+    StallActivity activity("MealAttendancePage::recordAttendanceClicked");
     QString selectedDate = attendanceDateEdit->date().toString("yyyy-MM-dd");
     std::string dateStr = selectedDate.toStdString();
 
@@ -154,4 +225,66 @@ void MealAttendancePage::recordAttendanceClicked()
         QMessageBox::critical(this, "Error", "Failed to update one or more attendance records. Please check the logs.");
     }
     loadAttendanceForDate(); // Reload to show updated state
-}
\ No newline at end of file
+}
+void MealAttendancePage::viewModeChanged(int index)
+{
+    viewStack->setCurrentIndex(index == 0 ? 0 : 1);
+    reloadCurrentView();
+}
+
+void MealAttendancePage::reloadCurrentView()
+{
+    if (viewModeComboBox->currentIndex() == 0) {
+        loadAttendanceForDate();
+    } else {
+        loadAttendanceGrid();
+    }
+}
+
+void MealAttendancePage::loadAttendanceGrid()
+{
+    StallActivity activity("MealAttendancePage::loadAttendanceGrid");
+    if (attendanceGridModel->pendingChangeCount() > 0 &&
+        QMessageBox::question(this, "Unsaved Changes",
+                              QString("Save %1 unsaved attendance change(s) first?").arg(attendanceGridModel->pendingChangeCount()))
+            == QMessageBox::Yes) {
+        saveAttendanceGridClicked(); // Reloads on success
+        return;
+    }
+
+    // Week view starts on Monday; month view covers the calendar month of the selected date
+    QDate selected = attendanceDateEdit->date();
+    QDate start, end;
+    if (viewModeComboBox->currentIndex() == 1) {
+        start = selected.addDays(1 - selected.dayOfWeek());
+        end = start.addDays(6);
+    } else {
+        start = QDate(selected.year(), selected.month(), 1);
+        end = start.addDays(selected.daysInMonth() - 1);
+    }
+    attendanceGridModel->setMatrix(getAttendanceRange(start.toString("yyyy-MM-dd").toStdString(),
+                                                      end.toString("yyyy-MM-dd").toStdString()));
+}
+
+void MealAttendancePage::saveAttendanceGridClicked()
+{
+    StallActivity activity("MealAttendancePage::saveAttendanceGridClicked");
+    std::vector<AttendanceChange> changes = attendanceGridModel->pendingChanges();
+    if (changes.empty()) {
+        QMessageBox::information(this, "No Changes", "No changes were made to the attendance records.");
+        return;
+    }
+    if (!applyAttendanceChanges(changes)) {
+        QMessageBox::critical(this, "Error", "Failed to save attendance; nothing was changed. Please check the logs.");
+        return;
+    }
+    QMessageBox::information(this, "Success", QString("Saved %1 attendance change(s).").arg(changes.size()));
+    attendanceGridModel->setMatrix(AttendanceMatrix()); // Drop the saved edits before reloading
+    loadAttendanceGrid();
+}
+
+void MealAttendancePage::updatePendingChanges(int count)
+{
+    pendingChangesLabel->setText(count > 0 ? QString("%1 unsaved change(s)").arg(count) : QString());
+    saveGridButton->setEnabled(count > 0);
+}
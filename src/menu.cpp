@@ -1,26 +1,40 @@
 #include "menu.h"
 #include "database.h"
+#include "dateutil.h"
+#include "mess.h"
+#include "menusearch.h"
+#include "menuanalytics.h"
+#include "logger.h"
+#include "slowquery.h"
 #include <cppconn/prepared_statement.h>
 #include <cppconn/resultset.h>
-#include <iostream>
 #include <memory>
 #include <vector>
+#include <algorithm>
 
 bool addMenuItem(const std::string& name) {
     try {
         std::unique_ptr<sql::Connection> con(getConnection());
-        std::unique_ptr<sql::PreparedStatement> pstmt(
-            con->prepareStatement("INSERT INTO menu_items (name) VALUES (?)")
+        std::unique_ptr<TracedStatement> pstmt(
+            prepareTraced(*con, "addMenuItem", "INSERT INTO menu_items (mess_id, name) VALUES (?, ?)")
         );
-        pstmt->setString(1, name);
+        pstmt->setInt(1, currentMessId());
+        pstmt->setString(2, name);
         pstmt->execute();
+        noteWrite();
+
+        std::unique_ptr<sql::Statement> stmt(con->createStatement());
+        std::unique_ptr<sql::ResultSet> res(stmt->executeQuery("SELECT LAST_INSERT_ID() AS id"));
+        if (res->next()) {
+            menuSearchIndex().insert({res->getInt("id"), name});
+        }
         return true;
     } catch (sql::SQLException& e) {
         // Handle unique constraint violation gracefully
         if (e.getErrorCode() == 1062) { // 1062 = ER_DUP_ENTRY
-            std::cerr << "Error: Menu item '" << name << "' already exists." << std::endl;
+            logEvent(LogLevel::Error, "addMenuItem", "Menu item already exists", {{"name", name}});
         } else {
-            std::cerr << "SQL Error in addMenuItem: " << e.what() << std::endl;
+            logSqlError("addMenuItem", e);
         }
         return false;
     }
@@ -30,14 +44,21 @@ bool addMenuItem(const std::string& name) {
 bool editMenuItem(int id, const std::string& name) { 
     try {
         std::unique_ptr<sql::Connection> con(getConnection());
-        std::unique_ptr<sql::PreparedStatement> pstmt(
-            con->prepareStatement("UPDATE menu_items SET name = ? WHERE id = ?")
+        std::unique_ptr<TracedStatement> pstmt(
+            prepareTraced(*con, "editMenuItem", "UPDATE menu_items SET name = ? WHERE id = ? AND mess_id = ?")
         );
         pstmt->setString(1, name);
         pstmt->setInt(2, id);
-        return pstmt->executeUpdate() > 0;
+        pstmt->setInt(3, currentMessId());
+        if (pstmt->executeUpdate() > 0) {
+            noteWrite();
+            menuSearchIndex().update(id, name);
+            invalidateDishAnalytics(); // Analytics carry dish names
+            return true;
+        }
+        return false;
     } catch (sql::SQLException& e) {
-        std::cerr << "SQL Error in editMenuItem: " << e.what() << std::endl;
+        logSqlError("editMenuItem", e);
         return false;
     }
 }
@@ -45,13 +66,20 @@ bool editMenuItem(int id, const std::string& name) {
 bool deleteMenuItem(int id) { 
     try {
         std::unique_ptr<sql::Connection> con(getConnection());
-        std::unique_ptr<sql::PreparedStatement> pstmt(
-            con->prepareStatement("DELETE FROM menu_items WHERE id = ?")
+        std::unique_ptr<TracedStatement> pstmt(
+            prepareTraced(*con, "deleteMenuItem", "DELETE FROM menu_items WHERE id = ? AND mess_id = ?")
         );
         pstmt->setInt(1, id);
-        return pstmt->executeUpdate() > 0;
+        pstmt->setInt(2, currentMessId());
+        if (pstmt->executeUpdate() > 0) {
+            noteWrite();
+            menuSearchIndex().remove(id);
+            invalidateDishAnalytics();
+            return true;
+        }
+        return false;
     } catch (sql::SQLException& e) {
-        std::cerr << "SQL Error in deleteMenuItem: " << e.what() << std::endl;
+        logSqlError("deleteMenuItem", e);
         return false;
     }
 }
@@ -59,10 +87,11 @@ std::vector<MenuItem> getAllMenuItems() {
     std::vector<MenuItem> items;
     try {
         std::unique_ptr<sql::Connection> con(getConnection());
-        std::unique_ptr<sql::Statement> stmt(con->createStatement());
-        std::unique_ptr<sql::ResultSet> res(
-            stmt->executeQuery("SELECT id, name FROM menu_items ORDER BY name ASC")
+        std::unique_ptr<TracedStatement> pstmt(
+            prepareTraced(*con, "getAllMenuItems", "SELECT id, name FROM menu_items WHERE mess_id = ? ORDER BY name ASC")
         );
+        pstmt->setInt(1, currentMessId());
+        std::unique_ptr<sql::ResultSet> res(pstmt->executeQuery());
 
         while (res->next()) {
             MenuItem item;
@@ -70,8 +99,9 @@ std::vector<MenuItem> getAllMenuItems() {
             item.name = res->getString("name");
             items.push_back(item);
         }
+        menuSearchIndex().rebuild(items); // A full reload is the cheapest point to resync the index
     } catch (sql::SQLException& e) {
-        std::cerr << "SQL Error in getAllMenuItems: " << e.what() << std::endl;
+        logSqlError("getAllMenuItems", e);
     }
     return items;
 }
@@ -79,23 +109,26 @@ std::vector<MenuItem> getAllMenuItems() {
 bool setDailyMenu(const std::string& date, const std::vector<int>& breakfastItems, const std::vector<int>& lunchItems, const std::vector<int>& dinnerItems) {
             std::unique_ptr<sql::Connection> con(getConnection());
     if (!con) {
-        std::cerr << "Failed to get database connection in setDailyMenu." << std::endl;
+        logEvent(LogLevel::Error, "setDailyMenu", "Failed to get database connection");
         return false;
     }
     try {
         con->setAutoCommit(false); // Start transaction
 
-        std::unique_ptr<sql::PreparedStatement> pstmt_del(con->prepareStatement("DELETE FROM daily_menus WHERE menu_date = ?"));
-        pstmt_del->setString(1, date);
+        int messId = currentMessId();
+        std::unique_ptr<TracedStatement> pstmt_del(prepareTraced(*con, "setDailyMenu", "DELETE FROM daily_menus WHERE mess_id = ? AND menu_date = ?"));
+        pstmt_del->setInt(1, messId);
+        pstmt_del->setString(2, date);
         pstmt_del->executeUpdate();
 
-        std::unique_ptr<sql::PreparedStatement> pstmt_ins(con->prepareStatement("INSERT INTO daily_menus (menu_date, meal_type, menu_item_id) VALUES (?, ?, ?)"));
+        std::unique_ptr<TracedStatement> pstmt_ins(prepareTraced(*con, "setDailyMenu", "INSERT INTO daily_menus (mess_id, menu_date, meal_type, menu_item_id) VALUES (?, ?, ?, ?)"));
 
         auto insertItems = [&](const std::string& mealType, const std::vector<int>& items) {
             for (int itemId : items) {
-                pstmt_ins->setString(1, date);
-                pstmt_ins->setString(2, mealType);
-                pstmt_ins->setInt(3, itemId);
+                pstmt_ins->setInt(1, messId);
+                pstmt_ins->setString(2, date);
+                pstmt_ins->setString(3, mealType);
+                pstmt_ins->setInt(4, itemId);
                 pstmt_ins->executeUpdate();
             }
         };
@@ -105,14 +138,16 @@ bool setDailyMenu(const std::string& date, const std::vector<int>& breakfastItem
         insertItems("Dinner", dinnerItems);
 
         con->commit();
+        noteWrite();
+        invalidateDishAnalytics();
         con->setAutoCommit(true);
         return true;
     } catch (sql::SQLException &e) {
-        std::cerr << "SQL Error in setDailyMenu: " << e.what() << std::endl;
+        logSqlError("setDailyMenu", e);
         try {
             con->rollback();
         } catch (sql::SQLException &ex) {
-            std::cerr << "SQL Error on rollback: " << ex.what() << std::endl;
+            logSqlError("setDailyMenu", ex, {{"during", "rollback"}});
         }
         con->setAutoCommit(true);
         return false;
@@ -125,16 +160,17 @@ DailyMenu getDailyMenu(const std::string& date) {
 
     try {
         std::unique_ptr<sql::Connection> con(getConnection());
-        std::unique_ptr<sql::PreparedStatement> pstmt(
-            con->prepareStatement(
+        std::unique_ptr<TracedStatement> pstmt(
+            prepareTraced(*con, "getDailyMenu",
                 "SELECT dm.meal_type, mi.id, mi.name "
                 "FROM daily_menus dm "
                 "JOIN menu_items mi ON dm.menu_item_id = mi.id "
-                "WHERE dm.menu_date = STR_TO_DATE(?, '%Y-%m-%d') "
+                "WHERE dm.mess_id = ? AND dm.menu_date = STR_TO_DATE(?, '%Y-%m-%d') "
                 "ORDER BY dm.meal_type"
             )
         );
-        pstmt->setString(1, date);
+        pstmt->setInt(1, currentMessId());
+        pstmt->setString(2, date);
 
         std::unique_ptr<sql::ResultSet> res(pstmt->executeQuery());
 
@@ -149,21 +185,23 @@ DailyMenu getDailyMenu(const std::string& date) {
             else if (mealType == "Dinner")    dailyMenu.dinner.push_back(item);
         }
     } catch (sql::SQLException& e) {
-        std::cerr << "SQL Error in getDailyMenu: " << e.what() << std::endl;
+        logSqlError("getDailyMenu", e);
     }
     return dailyMenu;
 }
 std::vector<DailyMenu> getMenuHistory() {
     std::vector<DailyMenu> menuHistory;
     try {
-        std::unique_ptr<sql::Connection> con(getConnection());
-        std::unique_ptr<sql::Statement> stmt(con->createStatement());
-        std::unique_ptr<sql::ResultSet> res(stmt->executeQuery(
+        std::unique_ptr<sql::Connection> con(getReadConnection());
+        std::unique_ptr<TracedStatement> pstmt(prepareTraced(*con, "getMenuHistory",
             "SELECT DATE_FORMAT(dm.menu_date, '%Y-%m-%d') AS menu_date, dm.meal_type, mi.id, mi.name "
             "FROM daily_menus dm "
             "JOIN menu_items mi ON dm.menu_item_id = mi.id "
+            "WHERE dm.mess_id = ? "
             "ORDER BY dm.menu_date DESC, dm.meal_type"
         ));
+        pstmt->setInt(1, currentMessId());
+        std::unique_ptr<sql::ResultSet> res(pstmt->executeQuery());
 
         std::map<std::string, DailyMenu> menuMap;
         while (res->next()) {
@@ -191,7 +229,191 @@ std::vector<DailyMenu> getMenuHistory() {
         }
 
     } catch (sql::SQLException& e) {
-        std::cerr << "SQL Error in getMenuHistory: " << e.what() << std::endl;
+        logSqlError("getMenuHistory", e);
     }
     return menuHistory;
-}
\ No newline at end of file
+}
+
+bool createMenuTemplateFromRange(const std::string& name, const std::string& startDate, int cycleDays) {
+    int startDay;
+    if (cycleDays <= 0 || !parseIsoDate(startDate, startDay)) {
+        logEvent(LogLevel::Error, "createMenuTemplateFromRange", "Invalid start date or cycle length for menu template", {{"name", name}});
+        return false;
+    }
+    std::string endDate = formatIsoDate(startDay + cycleDays - 1);
+    int messId = currentMessId();
+
+    std::unique_ptr<sql::Connection> con(getConnection());
+    try {
+        con->setAutoCommit(false); // Start transaction
+
+        std::unique_ptr<TracedStatement> pstmt_tpl(
+            prepareTraced(*con, "createMenuTemplateFromRange", "INSERT INTO menu_templates (mess_id, name, cycle_days) VALUES (?, ?, ?)")
+        );
+        pstmt_tpl->setInt(1, messId);
+        pstmt_tpl->setString(2, name);
+        pstmt_tpl->setInt(3, cycleDays);
+        pstmt_tpl->executeUpdate();
+
+        // Copy the menus of the source range in one statement, turning each date into its offset.
+        std::unique_ptr<TracedStatement> pstmt_items(prepareTraced(*con, "createMenuTemplateFromRange",
+            "INSERT INTO menu_template_items (mess_id, template_id, day_offset, meal_type, menu_item_id) "
+            "SELECT mess_id, LAST_INSERT_ID(), DATEDIFF(menu_date, STR_TO_DATE(?, '%Y-%m-%d')), meal_type, menu_item_id "
+            "FROM daily_menus "
+            "WHERE mess_id = ? AND menu_date BETWEEN STR_TO_DATE(?, '%Y-%m-%d') AND STR_TO_DATE(?, '%Y-%m-%d')"
+        ));
+        pstmt_items->setString(1, startDate);
+        pstmt_items->setInt(2, messId);
+        pstmt_items->setString(3, startDate);
+        pstmt_items->setString(4, endDate);
+        pstmt_items->executeUpdate();
+
+        con->commit();
+        noteWrite();
+        con->setAutoCommit(true);
+        return true;
+    } catch (sql::SQLException& e) {
+        if (e.getErrorCode() == 1062) { // ER_DUP_ENTRY
+            logEvent(LogLevel::Error, "createMenuTemplateFromRange", "Menu template already exists", {{"name", name}});
+        } else {
+            logSqlError("createMenuTemplateFromRange", e);
+        }
+        try {
+            con->rollback();
+        } catch (sql::SQLException& ex) {
+            logSqlError("createMenuTemplateFromRange", ex, {{"during", "rollback"}});
+        }
+        con->setAutoCommit(true);
+        return false;
+    }
+}
+
+std::vector<MenuTemplate> getAllMenuTemplates() {
+    std::vector<MenuTemplate> templates;
+    try {
+        std::unique_ptr<sql::Connection> con(getConnection());
+        std::unique_ptr<TracedStatement> pstmt(
+            prepareTraced(*con, "getAllMenuTemplates", "SELECT id, name, cycle_days FROM menu_templates WHERE mess_id = ? ORDER BY name ASC")
+        );
+        pstmt->setInt(1, currentMessId());
+        std::unique_ptr<sql::ResultSet> res(pstmt->executeQuery());
+
+        while (res->next()) {
+            MenuTemplate tpl;
+            tpl.id = res->getInt("id");
+            tpl.name = res->getString("name");
+            tpl.cycle_days = res->getInt("cycle_days");
+            templates.push_back(tpl);
+        }
+    } catch (sql::SQLException& e) {
+        logSqlError("getAllMenuTemplates", e);
+    }
+    return templates;
+}
+
+bool applyMenuTemplate(int templateId, const std::string& startDate, const std::string& endDate) {
+    int startDay, endDay;
+    if (!parseIsoDate(startDate, startDay) || !parseIsoDate(endDate, endDay) || endDay < startDay) {
+        logEvent(LogLevel::Error, "applyMenuTemplate", "Invalid date range", {{"start_date", startDate}, {"end_date", endDate}});
+        return false;
+    }
+    int messId = currentMessId();
+
+    std::unique_ptr<sql::Connection> con(getConnection());
+    try {
+        // 1. Load the template once; the expansion below happens in memory.
+        std::unique_ptr<TracedStatement> pstmt_tpl(
+            prepareTraced(*con, "applyMenuTemplate", "SELECT cycle_days FROM menu_templates WHERE id = ? AND mess_id = ?")
+        );
+        pstmt_tpl->setInt(1, templateId);
+        pstmt_tpl->setInt(2, messId);
+        std::unique_ptr<sql::ResultSet> res_tpl(pstmt_tpl->executeQuery());
+        if (!res_tpl->next()) {
+            logEvent(LogLevel::Error, "applyMenuTemplate", "Menu template not found", {{"template_id", templateId}});
+            return false;
+        }
+        int cycleDays = res_tpl->getInt("cycle_days");
+        if (cycleDays <= 0) {
+            logEvent(LogLevel::Error, "applyMenuTemplate", "Menu template has an invalid cycle length", {{"template_id", templateId}});
+            return false;
+        }
+
+        struct TemplateEntry {
+            std::string meal_type;
+            int menu_item_id;
+        };
+        std::vector<std::vector<TemplateEntry>> entriesByOffset(cycleDays);
+
+        std::unique_ptr<TracedStatement> pstmt_items(prepareTraced(*con, "applyMenuTemplate",
+            "SELECT day_offset, meal_type, menu_item_id FROM menu_template_items WHERE template_id = ? ORDER BY day_offset"
+        ));
+        pstmt_items->setInt(1, templateId);
+        std::unique_ptr<sql::ResultSet> res_items(pstmt_items->executeQuery());
+        while (res_items->next()) {
+            int offset = res_items->getInt("day_offset");
+            if (offset < 0 || offset >= cycleDays) continue;
+            entriesByOffset[offset].push_back({res_items->getString("meal_type"), res_items->getInt("menu_item_id")});
+        }
+
+        // 2. Replace the whole range in a single transaction.
+        con->setAutoCommit(false);
+
+        std::unique_ptr<TracedStatement> pstmt_del(prepareTraced(*con, "applyMenuTemplate",
+            "DELETE FROM daily_menus WHERE mess_id = ? AND menu_date BETWEEN STR_TO_DATE(?, '%Y-%m-%d') AND STR_TO_DATE(?, '%Y-%m-%d')"
+        ));
+        pstmt_del->setInt(1, messId);
+        pstmt_del->setString(2, startDate);
+        pstmt_del->setString(3, endDate);
+        pstmt_del->executeUpdate();
+
+        // 3. Expand the rotation over the range and write it as multi-row INSERTs.
+        struct Row {
+            std::string date;
+            const TemplateEntry* entry;
+        };
+        std::vector<Row> rows;
+        for (int day = startDay; day <= endDay; ++day) {
+            std::string date = formatIsoDate(day);
+            for (const auto& entry : entriesByOffset[(day - startDay) % cycleDays]) {
+                rows.push_back({date, &entry});
+            }
+        }
+
+        const size_t batchSize = 500;
+        for (size_t begin = 0; begin < rows.size(); begin += batchSize) {
+            size_t end = std::min(begin + batchSize, rows.size());
+            std::string query = "INSERT INTO daily_menus (mess_id, menu_date, meal_type, menu_item_id) VALUES ";
+            for (size_t i = begin; i < end; ++i) {
+                query += "(?, STR_TO_DATE(?, '%Y-%m-%d'), ?, ?)";
+                if (i < end - 1) {
+                    query += ", ";
+                }
+            }
+
+            std::unique_ptr<TracedStatement> pstmt_ins(prepareTraced(*con, "applyMenuTemplate", query));
+            int paramIndex = 1;
+            for (size_t i = begin; i < end; ++i) {
+                pstmt_ins->setInt(paramIndex++, messId);
+                pstmt_ins->setString(paramIndex++, rows[i].date);
+                pstmt_ins->setString(paramIndex++, rows[i].entry->meal_type);
+                pstmt_ins->setInt(paramIndex++, rows[i].entry->menu_item_id);
+            }
+            pstmt_ins->executeUpdate();
+        }
+
+        con->commit();
+        noteWrite();
+        invalidateDishAnalytics();
+        con->setAutoCommit(true);
+        return true;
+    } catch (sql::SQLException& e) {
+        logSqlError("applyMenuTemplate", e);
+        try {
+            con->rollback();
+        } catch (sql::SQLException& ex) {
+            logSqlError("applyMenuTemplate", ex, {{"during", "rollback"}});
+        }
+        con->setAutoCommit(true);
+        return false;
+    }
+}
@@ -0,0 +1,189 @@
+#include "menuanalytics.h"
+#include "database.h"
+#include "dateutil.h"
+#include "mess.h"
+#include "logger.h"
+#include "slowquery.h"
+#include <cppconn/prepared_statement.h>
+#include <cppconn/resultset.h>
+#include <algorithm>
+#include <array>
+#include <map>
+#include <mutex>
+#include <set>
+#include <utility>
+
+namespace { // Anonymous namespace for file-local helpers
+    struct CachedAnalytics {
+        std::string fingerprint;
+        std::shared_ptr<const DishAnalytics> analytics;
+    };
+    std::mutex analyticsMutex;
+    std::map<int, CachedAnalytics> cachedAnalytics; // By period ID
+    unsigned long analyticsGeneration = 0; // Bumped on every invalidation
+
+    // Row count, highest id and a checksum of the period's daily menus, a
+    // checksum of its headcounts (rewritten in place by the attendance writes)
+    // and of the mess's dish names, so changes made by another client are
+    // noticed without rerunning the join. Empty if the period is not found.
+    std::string dishAnalyticsFingerprint(sql::Connection& con, int messId, int periodId) {
+        std::unique_ptr<TracedStatement> periodStmt(prepareTraced(con, "dishAnalyticsFingerprint",
+            "SELECT month, year FROM meal_periods WHERE id = ? AND mess_id = ?"));
+        periodStmt->setInt(1, periodId);
+        periodStmt->setInt(2, messId);
+        std::unique_ptr<sql::ResultSet> period(periodStmt->executeQuery());
+        std::string firstDay, nextFirstDay;
+        if (!period->next() || !monthDateRange(period->getString("month"), period->getString("year"), firstDay, nextFirstDay)) {
+            return std::string();
+        }
+
+        std::unique_ptr<TracedStatement> pstmt(prepareTraced(con, "dishAnalyticsFingerprint",
+            "SELECT CONCAT_WS('|', "
+            " (SELECT CONCAT_WS(':', COUNT(*), COALESCE(MAX(id), 0), COALESCE(SUM(menu_item_id), 0)) FROM daily_menus "
+            "  WHERE mess_id = ? AND menu_date >= ? AND menu_date < ?), "
+            " (SELECT CONCAT_WS(':', COUNT(*), COALESCE(SUM(CRC32(CONCAT_WS(',', meal_date, meal_type, headcount))), 0)) "
+            "  FROM meal_headcounts WHERE mess_id = ? AND meal_date >= ? AND meal_date < ?), "
+            " (SELECT CONCAT_WS(':', COUNT(*), COALESCE(SUM(CRC32(name)), 0)) FROM menu_items WHERE mess_id = ?) "
+            ") AS fingerprint"
+        ));
+        int paramIndex = 1;
+        for (int i = 0; i < 2; ++i) {
+            pstmt->setInt(paramIndex++, messId);
+            pstmt->setString(paramIndex++, firstDay);
+            pstmt->setString(paramIndex++, nextFirstDay);
+        }
+        pstmt->setInt(paramIndex, messId);
+        std::unique_ptr<sql::ResultSet> res(pstmt->executeQuery());
+        return res->next() ? res->getString("fingerprint") : std::string();
+    }
+
+    int mealTypeIndex(const std::string& mealType) {
+        return mealType == "Breakfast" ? 0 : mealType == "Lunch" ? 1 : 2;
+    }
+
+    // Running sums for one dish; turnout is regressed on the day number.
+    struct DishAccumulator {
+        std::string name;
+        int servings = 0;
+        std::array<int, 3> servingsByMealType{};
+        double sumTurnout = 0, sumDay = 0, sumDaySquared = 0, sumDayTurnout = 0;
+        std::set<int> days;
+    };
+} // namespace
+
+std::shared_ptr<const DishAnalytics> getDishAnalytics(int periodId) {
+    unsigned long generation;
+    {
+        std::lock_guard<std::mutex> lock(analyticsMutex);
+        generation = analyticsGeneration;
+    }
+
+    auto analytics = std::make_shared<DishAnalytics>();
+    analytics->period_id = periodId;
+    std::string fingerprint;
+    try {
+        std::unique_ptr<sql::Connection> con(getReadConnection());
+        int messId = currentMessId();
+
+        // Reuse the last result for this period unless its menus, headcounts or dishes have moved
+        fingerprint = dishAnalyticsFingerprint(*con, messId, periodId);
+        {
+            std::lock_guard<std::mutex> lock(analyticsMutex);
+            auto it = cachedAnalytics.find(periodId);
+            if (it != cachedAnalytics.end() && generation == analyticsGeneration &&
+                !fingerprint.empty() && it->second.fingerprint == fingerprint) {
+                return it->second.analytics;
+            }
+        }
+
+        // Every (dish, date, meal type) on the period's menus with that meal's headcount.
+        // The range on menu_date keeps the lookup on the (mess_id, menu_date, ...) key.
+        std::unique_ptr<TracedStatement> pstmt(prepareTraced(*con, "getDishAnalytics",
+            "SELECT dm.menu_item_id, mi.name, dm.meal_type, DATE_FORMAT(dm.menu_date, '%Y-%m-%d') AS menu_date, "
+            "COALESCE(h.headcount, 0) AS headcount "
+            "FROM meal_periods p "
+            "JOIN daily_menus dm ON dm.mess_id = p.mess_id "
+            "  AND dm.menu_date >= STR_TO_DATE(CONCAT('1 ', p.month, ' ', p.year), '%d %M %Y') "
+            "  AND dm.menu_date < STR_TO_DATE(CONCAT('1 ', p.month, ' ', p.year), '%d %M %Y') + INTERVAL 1 MONTH "
+            "JOIN menu_items mi ON mi.id = dm.menu_item_id "
+            "LEFT JOIN meal_headcounts h ON h.mess_id = dm.mess_id AND h.meal_date = dm.menu_date AND h.meal_type = dm.meal_type "
+            "WHERE p.id = ? AND p.mess_id = ?"
+        ));
+        pstmt->setInt(1, periodId);
+        pstmt->setInt(2, messId);
+        std::unique_ptr<sql::ResultSet> res(pstmt->executeQuery());
+
+        // One pass accumulates each dish's sums and the per-meal-type baseline,
+        // counting each served meal once however many dishes it had.
+        std::map<int, DishAccumulator> dishes;
+        std::set<std::pair<int, int>> mealsSeen; // (day, meal type index)
+        std::array<double, 3> baselineSum{};
+        std::array<int, 3> baselineCount{};
+        while (res->next()) {
+            int day;
+            if (!parseIsoDate(res->getString("menu_date"), day)) continue;
+            int mealType = mealTypeIndex(res->getString("meal_type"));
+            double headcount = res->getInt("headcount");
+
+            if (mealsSeen.insert({day, mealType}).second) {
+                baselineSum[mealType] += headcount;
+                ++baselineCount[mealType];
+            }
+
+            DishAccumulator& dish = dishes[res->getInt("menu_item_id")];
+            if (dish.servings == 0) dish.name = res->getString("name");
+            ++dish.servings;
+            ++dish.servingsByMealType[mealType];
+            dish.sumTurnout += headcount;
+            dish.sumDay += day;
+            dish.sumDaySquared += static_cast<double>(day) * day;
+            dish.sumDayTurnout += day * headcount;
+            dish.days.insert(day);
+        }
+
+        for (const auto& [id, dish] : dishes) {
+            DishStats stats;
+            stats.menu_item_id = id;
+            stats.name = dish.name;
+            stats.times_served = dish.servings;
+            stats.average_turnout = dish.sumTurnout / dish.servings;
+
+            double expected = 0.0;
+            for (int m = 0; m < 3; ++m) {
+                if (baselineCount[m] > 0) expected += dish.servingsByMealType[m] * baselineSum[m] / baselineCount[m];
+            }
+            expected /= dish.servings;
+            stats.relative_turnout = expected > 0 ? stats.average_turnout / expected : 0.0;
+
+            stats.trend_per_week = 0.0;
+            if (dish.days.size() > 1) {
+                double n = dish.servings;
+                double denominator = n * dish.sumDaySquared - dish.sumDay * dish.sumDay;
+                if (denominator != 0) {
+                    stats.trend_per_week = 7.0 * (n * dish.sumDayTurnout - dish.sumDay * dish.sumTurnout) / denominator;
+                }
+            }
+            analytics->dishes.push_back(stats);
+        }
+        std::sort(analytics->dishes.begin(), analytics->dishes.end(), [](const DishStats& a, const DishStats& b) {
+            return a.relative_turnout != b.relative_turnout ? a.relative_turnout > b.relative_turnout : a.name < b.name;
+        });
+    } catch (sql::SQLException& e) {
+        logSqlError("getDishAnalytics", e);
+        return nullptr;
+    }
+
+    std::lock_guard<std::mutex> lock(analyticsMutex);
+    if (generation == analyticsGeneration) { // Don't cache a result a menu or attendance write raced with
+        // Stored under the fingerprint read before the join, so a write that
+        // lands in between only causes a recompute on the next call.
+        cachedAnalytics[periodId] = {fingerprint, analytics};
+    }
+    return analytics;
+}
+
+void invalidateDishAnalytics() {
+    std::lock_guard<std::mutex> lock(analyticsMutex);
+    cachedAnalytics.clear();
+    ++analyticsGeneration;
+}
@@ -1,10 +1,16 @@
 #include "menuhistorypage.h"
 #include "database.h"
+#include <QShowEvent>
 #include <QVBoxLayout>
 #include <QTableWidget>
 #include <QHeaderView>
 #include <QLabel>
+#include <QComboBox>
+#include <QHBoxLayout>
 #include "menu.h"
+#include "menuanalytics.h"
+#include "period.h"
+#include "stallwatchdog.h"
 
 MenuHistoryPage::MenuHistoryPage(QWidget *parent)
     : QWidget(parent)
@@ -27,14 +33,85 @@ MenuHistoryPage::MenuHistoryPage(QWidget *parent)
     historyTable->setEditTriggers(QAbstractItemView::NoEditTriggers);
     mainLayout->addWidget(historyTable);
 
-    // Initial load
-    loadMenuHistory();
+    // Dish popularity: turnout at the meals each dish was served, per period
+    auto dishHeaderLayout = new QHBoxLayout();
+    auto dishLabel = new QLabel("Dish Turnout", this);
+    dishLabel->setStyleSheet("font-size: 18px; font-weight: bold;");
+    dishHeaderLayout->addWidget(dishLabel);
+    dishHeaderLayout->addStretch();
+    dishHeaderLayout->addWidget(new QLabel("Period:", this));
+    periodComboBox = new QComboBox(this);
+    dishHeaderLayout->addWidget(periodComboBox);
+    mainLayout->addLayout(dishHeaderLayout);
+
+    dishTable = new QTableWidget(this);
+    dishTable->setColumnCount(5);
+    dishTable->setHorizontalHeaderLabels({"Dish", "Times Served", "Avg Turnout", "vs. Usual (%)", "Trend / Week"});
+    dishTable->horizontalHeader()->setSectionResizeMode(QHeaderView::Stretch);
+    dishTable->setEditTriggers(QAbstractItemView::NoEditTriggers);
+    dishTable->setSortingEnabled(true);
+    mainLayout->addWidget(dishTable);
+
+    connect(periodComboBox, &QComboBox::currentIndexChanged, this, &MenuHistoryPage::loadDishAnalytics);
 
     setLayout(mainLayout);
 }
 
+void MenuHistoryPage::showEvent(QShowEvent *event)
+{
+    QWidget::showEvent(event);
+    if (loaded) return;
+    loaded = true;
+    loadMenuHistory();
+    loadPeriods();
+}
+
+void MenuHistoryPage::loadPeriods()
+{
+    StallActivity activity("MenuHistoryPage::loadPeriods");
+    periodComboBox->blockSignals(true);
+    periodComboBox->clear();
+    for (const auto& period : getAllMealPeriods()) {
+        periodComboBox->addItem(QString::fromStdString(period.month + " " + period.year), period.id);
+    }
+    periodComboBox->blockSignals(false);
+    loadDishAnalytics();
+}
+
+void MenuHistoryPage::loadDishAnalytics()
+{
+    StallActivity activity("MenuHistoryPage::loadDishAnalytics");
+    dishTable->setSortingEnabled(false); // Disable sorting during population
+    dishTable->setRowCount(0);
+    if (periodComboBox->currentIndex() < 0) return;
+
+    auto analytics = getDishAnalytics(periodComboBox->currentData().toInt());
+    if (!analytics) return;
+
+    dishTable->setRowCount(analytics->dishes.size());
+    for (size_t i = 0; i < analytics->dishes.size(); ++i) {
+        const DishStats& dish = analytics->dishes[i];
+        // Numeric columns carry their value in DisplayRole so sorting is numeric
+        auto numberItem = [](double value) {
+            auto item = new QTableWidgetItem();
+            item->setData(Qt::DisplayRole, value);
+            return item;
+        };
+        dishTable->setItem(i, 0, new QTableWidgetItem(QString::fromStdString(dish.name)));
+        dishTable->setItem(i, 1, numberItem(dish.times_served));
+        dishTable->setItem(i, 2, numberItem(qRound(dish.average_turnout * 10) / 10.0));
+        auto relativeItem = new QTableWidgetItem();
+        relativeItem->setData(Qt::DisplayRole, qRound(dish.relative_turnout * 100));
+        relativeItem->setData(Qt::ToolTipRole, "Percent of the usual turnout for the same meals in this period");
+        dishTable->setItem(i, 3, relativeItem);
+        dishTable->setItem(i, 4, numberItem(qRound(dish.trend_per_week * 10) / 10.0));
+    }
+    dishTable->setSortingEnabled(true);
+}
+
 void MenuHistoryPage::loadMenuHistory()
 {
+    StallActivity activity("MenuHistoryPage::loadMenuHistory");
     historyTable->setRowCount(0); // Clear existing rows
     std::vector<DailyMenu> history = getMenuHistory();
     historyTable->setRowCount(history.size());
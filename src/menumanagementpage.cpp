@@ -10,6 +10,9 @@
 #include <QLabel>
 #include <QInputDialog> // Added for editing
 #include "menu.h"
+#include "menusearch.h"
+#include "snapshot.h"
+#include "stallwatchdog.h"
 
 MenuManagementPage::MenuManagementPage(QWidget *parent)
     : QWidget(parent)
@@ -33,6 +36,12 @@ MenuManagementPage::MenuManagementPage(QWidget *parent)
     inputLayout->addWidget(addMenuItemButton);
     mainLayout->addLayout(inputLayout);
 
+    // Type-ahead filter over the catalog
+    searchLineEdit = new QLineEdit(this);
+    searchLineEdit->setPlaceholderText("Search menu items...");
+    searchLineEdit->setClearButtonEnabled(true);
+    mainLayout->addWidget(searchLineEdit);
+
     // Table for displaying menu items
     menuTable = new QTableWidget(this);
     menuTable->setColumnCount(2);
@@ -58,27 +67,52 @@ MenuManagementPage::MenuManagementPage(QWidget *parent)
     connect(editMenuItemButton, &QPushButton::clicked, this, &MenuManagementPage::editMenuItemClicked);
     connect(deleteMenuItemButton, &QPushButton::clicked, this, &MenuManagementPage::deleteMenuItemClicked);
     connect(refreshButton, &QPushButton::clicked, this, &MenuManagementPage::refreshMenuItems);
+    connect(searchLineEdit, &QLineEdit::textChanged, this, &MenuManagementPage::filterMenuItems);
 
-    // Initial load
-    loadMenuItems();
+    // Initial load, from the local snapshot when there is one
+    if (auto snapshot = currentReferenceSnapshot()) {
+        applyReferenceSnapshot(*snapshot);
+    } else {
+        loadMenuItems();
+    }
 
     setLayout(mainLayout);
 }
 
+void MenuManagementPage::applyReferenceSnapshot(const ReferenceSnapshot& snapshot)
+{
+    menuSearchIndex().rebuild(snapshot.menu_items);
+    filterMenuItems(searchLineEdit->text());
+}
+
 void MenuManagementPage::loadMenuItems()
 {
+    StallActivity activity("MenuManagementPage::loadMenuItems");
+    getAllMenuItems(); // Reloads the catalog and resyncs the search index
+    filterMenuItems(searchLineEdit->text());
+}
+
+void MenuManagementPage::filterMenuItems(const QString &query)
+{
+    populateMenuTable(searchMenuItems(query.toStdString()));
+}
+
+void MenuManagementPage::populateMenuTable(const std::vector<MenuItem>& items)
+{
+    menuTable->setUpdatesEnabled(false);
     menuTable->setRowCount(0); // Clear existing rows
-    std::vector<MenuItem> items = getAllMenuItems();
     menuTable->setRowCount(items.size());
 
     for (size_t i = 0; i < items.size(); ++i) {
         menuTable->setItem(i, 0, new QTableWidgetItem(QString::number(items[i].id)));
         menuTable->setItem(i, 1, new QTableWidgetItem(QString::fromStdString(items[i].name)));
     }
+    menuTable->setUpdatesEnabled(true);
 }
 
 void MenuManagementPage::addMenuItemClicked()
 {
+    StallActivity activity("MenuManagementPage::addMenuItemClicked");
     QString itemName = menuItemNameLineEdit->text().trimmed();
     if (itemName.isEmpty()) {
         QMessageBox::warning(this, "Input Error", "Menu item name cannot be empty.");
@@ -88,7 +122,7 @@ void MenuManagementPage::addMenuItemClicked()
     if (addMenuItem(itemName.toStdString())) {
         QMessageBox::information(this, "Success", "Menu item added successfully.");
         menuItemNameLineEdit->clear();
-        loadMenuItems(); // Refresh the table
+        filterMenuItems(searchLineEdit->text()); // The index already reflects the change
     } else {
         QMessageBox::critical(this, "Error", "Failed to add menu item. It might already exist.");
     }
@@ -96,6 +130,7 @@ void MenuManagementPage::addMenuItemClicked()
 
 void MenuManagementPage::editMenuItemClicked()
 {
+    StallActivity activity("MenuManagementPage::editMenuItemClicked");
     int selectedRow = menuTable->currentRow();
     if (selectedRow < 0) {
         QMessageBox::warning(this, "Selection Error", "Please select a menu item to edit.");
@@ -113,7 +148,7 @@ void MenuManagementPage::editMenuItemClicked()
     if (ok && !newName.isEmpty() && newName != currentName) {
         if (editMenuItem(id, newName.toStdString())) {
             QMessageBox::information(this, "Success", "Menu item updated successfully.");
-            loadMenuItems();
+            filterMenuItems(searchLineEdit->text()); // The index already reflects the change
         } else {
             QMessageBox::critical(this, "Error", "Failed to update menu item.");
         }
@@ -124,6 +159,7 @@ void MenuManagementPage::editMenuItemClicked()
 
 void MenuManagementPage::deleteMenuItemClicked()
 {
+    StallActivity activity("MenuManagementPage::deleteMenuItemClicked");
     int selectedRow = menuTable->currentRow();
     if (selectedRow < 0) {
         QMessageBox::warning(this, "Selection Error", "Please select a menu item to delete.");
@@ -138,7 +174,7 @@ void MenuManagementPage::deleteMenuItemClicked()
                               QMessageBox::Yes | QMessageBox::No) == QMessageBox::Yes) {
         if (deleteMenuItem(id)) {
             QMessageBox::information(this, "Success", "Menu item deleted successfully.");
-            loadMenuItems();
+            filterMenuItems(searchLineEdit->text()); // The index already reflects the change
         } else {
             QMessageBox::critical(this, "Error", "Failed to delete menu item.");
         }
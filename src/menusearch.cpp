@@ -0,0 +1,198 @@
+#include "menusearch.h"
+#include <algorithm>
+#include <cctype>
+#include <mutex>
+
+namespace { // Anonymous namespace for file-local helpers
+    std::string foldName(const std::string& name) {
+        std::string folded;
+        folded.reserve(name.size());
+        bool pendingSpace = false;
+        for (unsigned char c : name) {
+            if (std::isspace(c)) {
+                pendingSpace = !folded.empty();
+                continue;
+            }
+            if (pendingSpace) {
+                folded.push_back(' ');
+                pendingSpace = false;
+            }
+            folded.push_back(static_cast<char>(std::tolower(c)));
+        }
+        return folded;
+    }
+
+    uint32_t trigramKey(const std::string& s, size_t pos) {
+        return (static_cast<uint32_t>(static_cast<unsigned char>(s[pos])) << 16) |
+               (static_cast<uint32_t>(static_cast<unsigned char>(s[pos + 1])) << 8) |
+               static_cast<uint32_t>(static_cast<unsigned char>(s[pos + 2]));
+    }
+
+    std::vector<uint32_t> trigramsOf(const std::string& folded) {
+        std::vector<uint32_t> keys;
+        for (size_t i = 0; i + 3 <= folded.size(); ++i) {
+            keys.push_back(trigramKey(folded, i));
+        }
+        std::sort(keys.begin(), keys.end());
+        keys.erase(std::unique(keys.begin(), keys.end()), keys.end());
+        return keys;
+    }
+
+    // Lower is better; -1 means the query does not occur in the name.
+    int matchRank(const std::string& folded, const std::string& query) {
+        size_t pos = folded.find(query);
+        if (pos == std::string::npos) return -1;
+        if (pos == 0) return folded.size() == query.size() ? 0 : 1;
+        while (pos != std::string::npos) {
+            if (folded[pos - 1] == ' ') return 2;
+            pos = folded.find(query, pos + 1);
+        }
+        return 3;
+    }
+} // namespace
+
+void MenuSearchIndex::rebuild(const std::vector<MenuItem>& items) {
+    std::unique_lock<std::shared_mutex> lock(mutex);
+    entries.clear();
+    slotById.clear();
+    postings.clear();
+    entries.reserve(items.size());
+    for (const auto& item : items) {
+        uint32_t slot = static_cast<uint32_t>(entries.size());
+        entries.push_back({item.id, item.name, foldName(item.name), true});
+        slotById[item.id] = slot;
+        addPostings(slot);
+    }
+}
+
+void MenuSearchIndex::insert(const MenuItem& item) {
+    std::unique_lock<std::shared_mutex> lock(mutex);
+    auto it = slotById.find(item.id);
+    if (it != slotById.end()) {
+        removePostings(it->second);
+        entries[it->second].alive = false;
+    }
+    uint32_t slot = static_cast<uint32_t>(entries.size());
+    entries.push_back({item.id, item.name, foldName(item.name), true});
+    slotById[item.id] = slot;
+    addPostings(slot);
+}
+
+void MenuSearchIndex::update(int id, const std::string& name) {
+    std::unique_lock<std::shared_mutex> lock(mutex);
+    auto it = slotById.find(id);
+    if (it == slotById.end()) return;
+    Entry& entry = entries[it->second];
+    removePostings(it->second);
+    entry.name = name;
+    entry.folded = foldName(name);
+    addPostings(it->second);
+}
+
+void MenuSearchIndex::remove(int id) {
+    std::unique_lock<std::shared_mutex> lock(mutex);
+    auto it = slotById.find(id);
+    if (it == slotById.end()) return;
+    removePostings(it->second);
+    entries[it->second].alive = false;
+    slotById.erase(it);
+}
+
+std::vector<MenuItem> MenuSearchIndex::search(const std::string& query, size_t limit) const {
+    std::shared_lock<std::shared_mutex> lock(mutex);
+    std::string folded = foldName(query);
+
+    struct Match {
+        int rank;
+        size_t length;
+        const Entry* entry;
+    };
+    std::vector<Match> matches;
+
+    auto consider = [&](const Entry& entry) {
+        if (!entry.alive) return;
+        int rank = folded.empty() ? 0 : matchRank(entry.folded, folded);
+        if (rank >= 0) matches.push_back({rank, entry.folded.size(), &entry});
+    };
+
+    if (folded.size() < 3) {
+        for (const auto& entry : entries) consider(entry);
+    } else {
+        // Intersect posting lists, smallest first, so the candidate set shrinks fast.
+        std::vector<const std::vector<uint32_t>*> lists;
+        for (uint32_t key : trigramsOf(folded)) {
+            auto it = postings.find(key);
+            if (it == postings.end()) return {};
+            lists.push_back(&it->second);
+        }
+        std::sort(lists.begin(), lists.end(),
+                  [](const auto* a, const auto* b) { return a->size() < b->size(); });
+
+        std::vector<uint32_t> candidates = *lists.front();
+        std::vector<uint32_t> narrowed;
+        for (size_t i = 1; i < lists.size() && !candidates.empty(); ++i) {
+            narrowed.clear();
+            std::set_intersection(candidates.begin(), candidates.end(),
+                                  lists[i]->begin(), lists[i]->end(),
+                                  std::back_inserter(narrowed));
+            candidates.swap(narrowed);
+        }
+        for (uint32_t slot : candidates) consider(entries[slot]);
+    }
+
+    auto better = [](const Match& a, const Match& b) {
+        if (a.rank != b.rank) return a.rank < b.rank;
+        if (a.length != b.length) return a.length < b.length;
+        return a.entry->folded < b.entry->folded;
+    };
+    if (limit > 0 && matches.size() > limit) {
+        std::partial_sort(matches.begin(), matches.begin() + limit, matches.end(), better);
+        matches.resize(limit);
+    } else {
+        std::sort(matches.begin(), matches.end(), better);
+    }
+
+    std::vector<MenuItem> results;
+    results.reserve(matches.size());
+    for (const auto& match : matches) {
+        results.push_back({match.entry->id, match.entry->name});
+    }
+    return results;
+}
+
+size_t MenuSearchIndex::size() const {
+    std::shared_lock<std::shared_mutex> lock(mutex);
+    return slotById.size();
+}
+
+void MenuSearchIndex::addPostings(uint32_t slot) {
+    // Slots only grow, so appending keeps every posting list sorted.
+    for (uint32_t key : trigramsOf(entries[slot].folded)) {
+        auto& list = postings[key];
+        if (list.empty() || list.back() < slot) {
+            list.push_back(slot);
+        } else {
+            list.insert(std::lower_bound(list.begin(), list.end(), slot), slot);
+        }
+    }
+}
+
+void MenuSearchIndex::removePostings(uint32_t slot) {
+    for (uint32_t key : trigramsOf(entries[slot].folded)) {
+        auto it = postings.find(key);
+        if (it == postings.end()) continue;
+        auto& list = it->second;
+        auto pos = std::lower_bound(list.begin(), list.end(), slot);
+        if (pos != list.end() && *pos == slot) list.erase(pos);
+        if (list.empty()) postings.erase(it);
+    }
+}
+
+MenuSearchIndex& menuSearchIndex() {
+    static MenuSearchIndex index;
+    return index;
+}
+
+std::vector<MenuItem> searchMenuItems(const std::string& query, size_t limit) {
+    return menuSearchIndex().search(query, limit);
+}
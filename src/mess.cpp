@@ -0,0 +1,89 @@
+#include "mess.h"
+#include "database.h"
+#include "expenseanalytics.h"
+#include "menuanalytics.h"
+#include "menusearch.h"
+#include "logger.h"
+#include "slowquery.h"
+#include <cppconn/prepared_statement.h>
+#include <cppconn/resultset.h>
+#include <atomic>
+#include <memory>
+
+namespace { // Anonymous namespace for file-local state
+    std::atomic<int> messId{1};
+} // namespace
+
+void setCurrentMessId(int mess_id) {
+    if (messId.exchange(mess_id) == mess_id) return;
+    // The caches hold the previous mess's rows; they refill lazily on next use.
+    invalidateExpenseCube();
+    invalidateDishAnalytics();
+    menuSearchIndex().rebuild({});
+}
+
+int currentMessId() {
+    return messId.load();
+}
+
+std::vector<Mess> getAllMesses() {
+    std::vector<Mess> messes;
+    try {
+        std::unique_ptr<sql::Connection> con(getConnection());
+        std::unique_ptr<sql::Statement> stmt(con->createStatement());
+        std::unique_ptr<sql::ResultSet> res(stmt->executeQuery("SELECT id, name FROM messes ORDER BY name ASC"));
+        while (res->next()) {
+            Mess mess;
+            mess.id = res->getInt("id");
+            mess.name = res->getString("name");
+            messes.push_back(mess);
+        }
+    } catch (sql::SQLException& e) {
+        logSqlError("getAllMesses", e);
+    }
+    return messes;
+}
+
+bool addMess(const std::string& name) {
+    std::unique_ptr<sql::Connection> con(getConnection());
+    try {
+        con->setAutoCommit(false); // Start transaction
+
+        std::unique_ptr<TracedStatement> pstmt_mess(prepareTraced(*con, "addMess", "INSERT INTO messes (name) VALUES (?)"));
+        pstmt_mess->setString(1, name);
+        pstmt_mess->executeUpdate();
+
+        std::unique_ptr<sql::Statement> stmt(con->createStatement());
+        std::unique_ptr<sql::ResultSet> res(stmt->executeQuery("SELECT LAST_INSERT_ID() AS id"));
+        res->next();
+        int newMessId = res->getInt("id");
+
+        std::unique_ptr<TracedStatement> pstmt_settings(
+            prepareTraced(*con, "addMess", "INSERT INTO settings (mess_id, currency) VALUES (?, 'USD')"));
+        pstmt_settings->setInt(1, newMessId);
+        pstmt_settings->executeUpdate();
+
+        std::unique_ptr<TracedStatement> pstmt_categories(prepareTraced(*con, "addMess",
+            "INSERT INTO expense_categories (mess_id, name) VALUES (?, 'Food'), (?, 'Utilities'), (?, 'Rent'), (?, 'Other')"));
+        for (int i = 1; i <= 4; ++i) pstmt_categories->setInt(i, newMessId);
+        pstmt_categories->executeUpdate();
+
+        con->commit();
+        noteWrite();
+        con->setAutoCommit(true);
+        return true;
+    } catch (sql::SQLException& e) {
+        if (e.getErrorCode() == 1062) { // ER_DUP_ENTRY
+            logEvent(LogLevel::Error, "addMess", "Mess already exists", {{"name", name}});
+        } else {
+            logSqlError("addMess", e);
+        }
+        try {
+            con->rollback();
+        } catch (sql::SQLException& ex) {
+            logSqlError("addMess", ex, {{"during", "rollback"}});
+        }
+        con->setAutoCommit(true);
+        return false;
+    }
+}
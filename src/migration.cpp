@@ -0,0 +1,405 @@
+#include "migration.h"
+#include "database.h"
+#include "checksum.h"
+#include "logger.h"
+#include "slowquery.h"
+#include <cppconn/prepared_statement.h>
+#include <cppconn/resultset.h>
+#include <QSettings>
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <map>
+#include <sstream>
+
+namespace { // Anonymous namespace for file-local helpers
+    const char* MIGRATION_LOCK = "meal_schema_migration";
+    const int MIGRATION_LOCK_TIMEOUT_SECONDS = 60; // Long enough for another client's run to finish
+
+    const char* SCHEMA_VERSION_DDL =
+        "CREATE TABLE IF NOT EXISTS `schema_version` ("
+        "  `version` int NOT NULL,"
+        "  `name` varchar(255) NOT NULL,"
+        "  `checksum` char(64) NULL DEFAULT NULL,"
+        "  `applied_at` datetime NOT NULL DEFAULT CURRENT_TIMESTAMP,"
+        "  `execution_ms` int NOT NULL DEFAULT 0,"
+        "  PRIMARY KEY (`version`)"
+        ") ENGINE = InnoDB";
+
+    // Statements already run from a script that stopped part-way. MySQL commits
+    // each DDL statement, so a re-run resumes after them instead of repeating
+    // them; the row is removed once the script is recorded in schema_version.
+    const char* MIGRATION_PROGRESS_DDL =
+        "CREATE TABLE IF NOT EXISTS `schema_migration_progress` ("
+        "  `version` int NOT NULL,"
+        "  `checksum` char(64) NOT NULL,"
+        "  `statements_done` int NOT NULL,"
+        "  `updated_at` datetime NOT NULL DEFAULT CURRENT_TIMESTAMP ON UPDATE CURRENT_TIMESTAMP,"
+        "  PRIMARY KEY (`version`)"
+        ") ENGINE = InnoDB";
+
+    struct MigrationSettings {
+        std::string directory;
+        int lockWaitTimeoutSeconds;
+        bool runOnStartup;
+    };
+
+    MigrationSettings readSettings() {
+        QSettings settings(QString::fromStdString(getConfigFilePath()), QSettings::IniFormat);
+        MigrationSettings result;
+        result.directory = settings.value("Migrations/directory", "migrations").toString().toStdString();
+        result.lockWaitTimeoutSeconds = settings.value("Migrations/lock_wait_timeout_seconds", 10).toInt();
+        result.runOnStartup = settings.value("Migrations/apply_on_startup", false).toBool();
+        return result;
+    }
+
+    struct MigrationScript {
+        int version;
+        std::string name; // File name
+        std::string sql;
+        std::string checksum;
+    };
+
+    // Scripts in version order. A missing directory just means nothing to apply.
+    bool loadScripts(const std::string& directory, std::vector<MigrationScript>& scripts, std::string& error) {
+        namespace fs = std::filesystem;
+        std::error_code ec;
+        if (!fs::is_directory(directory, ec)) return true;
+
+        for (const auto& entry : fs::directory_iterator(directory, ec)) {
+            std::string name = entry.path().filename().string();
+            size_t digits = 0;
+            while (digits < name.size() && std::isdigit(static_cast<unsigned char>(name[digits]))) ++digits;
+            if (digits == 0 || digits >= name.size() || name[digits] != '_' ||
+                name.size() < 4 || name.compare(name.size() - 4, 4, ".sql") != 0) {
+                continue;
+            }
+
+            std::ifstream in(entry.path(), std::ios::binary);
+            if (!in) {
+                error = "Could not read migration " + entry.path().string() + ".";
+                return false;
+            }
+            std::ostringstream contents;
+            contents << in.rdbuf();
+
+            MigrationScript script;
+            script.version = std::stoi(name.substr(0, digits));
+            script.name = name;
+            script.sql = contents.str();
+            script.checksum = sha256Hex(script.sql);
+            scripts.push_back(std::move(script));
+        }
+        if (ec) {
+            error = "Could not list " + directory + ": " + ec.message();
+            return false;
+        }
+
+        std::sort(scripts.begin(), scripts.end(), [](const MigrationScript& a, const MigrationScript& b) {
+            return a.version < b.version;
+        });
+        for (size_t i = 1; i < scripts.size(); ++i) {
+            if (scripts[i].version == scripts[i - 1].version) {
+                error = "Migrations " + scripts[i - 1].name + " and " + scripts[i].name + " share a version number.";
+                return false;
+            }
+        }
+        return true;
+    }
+
+    // Splits a script on ';' outside quotes and comments. Enough for plain DDL
+    // and DML; DELIMITER blocks (procedures, triggers) are not supported.
+    std::vector<std::string> splitStatements(const std::string& sql) {
+        std::vector<std::string> statements;
+        std::string current;
+        auto flush = [&] {
+            size_t first = current.find_first_not_of(" \t\r\n");
+            if (first != std::string::npos) {
+                size_t last = current.find_last_not_of(" \t\r\n");
+                statements.push_back(current.substr(first, last - first + 1));
+            }
+            current.clear();
+        };
+
+        char quote = 0;
+        for (size_t i = 0; i < sql.size(); ++i) {
+            char c = sql[i];
+            char next = i + 1 < sql.size() ? sql[i + 1] : '\0';
+            if (quote) {
+                current += c;
+                if (c == '\\' && quote != '`' && next) {
+                    current += sql[++i];
+                } else if (c == quote) {
+                    quote = 0;
+                }
+            } else if ((c == '-' && next == '-' && (i + 2 >= sql.size() || std::isspace(static_cast<unsigned char>(sql[i + 2])))) || c == '#') {
+                while (i < sql.size() && sql[i] != '\n') ++i;
+                current += '\n';
+            } else if (c == '/' && next == '*') {
+                size_t end = sql.find("*/", i + 2);
+                i = end == std::string::npos ? sql.size() : end + 1;
+                current += ' ';
+            } else if (c == '\'' || c == '"' || c == '`') {
+                quote = c;
+                current += c;
+            } else if (c == ';') {
+                flush();
+            } else {
+                current += c;
+            }
+        }
+        flush();
+        return statements;
+    }
+
+    struct AppliedVersion {
+        std::string name;
+        std::string checksum; // Empty for a baseline row
+        std::string applied_at;
+    };
+
+    bool schemaVersionExists(sql::Connection& con) {
+        std::unique_ptr<sql::Statement> stmt(con.createStatement());
+        std::unique_ptr<sql::ResultSet> res(stmt->executeQuery(
+            "SELECT 1 FROM information_schema.TABLES WHERE TABLE_SCHEMA = DATABASE() AND TABLE_NAME = 'schema_version'"));
+        return res->next();
+    }
+
+    std::map<int, AppliedVersion> readAppliedVersions(sql::Connection& con) {
+        std::map<int, AppliedVersion> applied;
+        std::unique_ptr<sql::Statement> stmt(con.createStatement());
+        std::unique_ptr<sql::ResultSet> res(stmt->executeQuery(
+            "SELECT version, name, checksum, DATE_FORMAT(applied_at, '%Y-%m-%d %H:%i:%s') AS applied_at FROM schema_version"));
+        while (res->next()) {
+            AppliedVersion version;
+            version.name = res->getString("name");
+            version.checksum = res->isNull("checksum") ? std::string() : std::string(res->getString("checksum"));
+            version.applied_at = res->getString("applied_at");
+            applied[res->getInt("version")] = version;
+        }
+        return applied;
+    }
+
+    struct MigrationProgress {
+        std::string checksum;
+        int statements_done;
+    };
+
+    std::map<int, MigrationProgress> readMigrationProgress(sql::Connection& con) {
+        std::map<int, MigrationProgress> progress;
+        std::unique_ptr<sql::Statement> stmt(con.createStatement());
+        std::unique_ptr<sql::ResultSet> res(stmt->executeQuery(
+            "SELECT 1 FROM information_schema.TABLES WHERE TABLE_SCHEMA = DATABASE() AND TABLE_NAME = 'schema_migration_progress'"));
+        if (!res->next()) return progress;
+        res.reset(stmt->executeQuery("SELECT version, checksum, statements_done FROM schema_migration_progress"));
+        while (res->next()) {
+            progress[res->getInt("version")] = {res->getString("checksum"), res->getInt("statements_done")};
+        }
+        return progress;
+    }
+
+    // Newest version a baseline row vouches for; scripts up to it count as applied.
+    int baselineVersion(const std::map<int, AppliedVersion>& applied) {
+        int baseline = 0;
+        for (const auto& [version, row] : applied) {
+            if (row.checksum.empty()) baseline = std::max(baseline, version);
+        }
+        return baseline;
+    }
+} // namespace
+
+bool migrationsRunOnStartup() {
+    return readSettings().runOnStartup;
+}
+
+MigrationRunResult applyPendingMigrations() {
+    MigrationRunResult result;
+    MigrationSettings settings = readSettings();
+
+    std::vector<MigrationScript> scripts;
+    if (!loadScripts(settings.directory, scripts, result.message)) {
+        result.outcome = MigrationOutcome::Failed;
+        return result;
+    }
+
+    std::unique_ptr<sql::Connection> con;
+    try {
+        con = getConnection();
+    } catch (const std::exception& e) { // Also covers a missing config.ini
+        result.outcome = MigrationOutcome::Unreachable;
+        result.message = e.what();
+        return result;
+    }
+
+    try {
+        NamedLock lock(*con, MIGRATION_LOCK, MIGRATION_LOCK_TIMEOUT_SECONDS);
+        if (!lock.acquired()) {
+            result.outcome = MigrationOutcome::Failed;
+            result.message = "Timed out waiting for another client to finish applying migrations.";
+            return result;
+        }
+        if (!schemaVersionExists(*con)) {
+            result.outcome = MigrationOutcome::NotBaselined;
+            result.message = "The database has no schema_version table. Run `meal_cli migrate baseline <version>` "
+                             "with the last migration it already has.";
+            return result;
+        }
+
+        // Refuse to go forward from a history that no longer matches the scripts
+        std::map<int, AppliedVersion> applied = readAppliedVersions(*con);
+        std::map<int, MigrationProgress> progress = readMigrationProgress(*con);
+        for (const auto& script : scripts) {
+            auto it = applied.find(script.version);
+            if (it != applied.end() && !it->second.checksum.empty() && it->second.checksum != script.checksum) {
+                result.outcome = MigrationOutcome::Failed;
+                result.message = "Migration " + script.name + " was changed after it was applied. "
+                                 "Restore the original file and put the change in a new migration.";
+                return result;
+            }
+            auto partial = progress.find(script.version);
+            if (partial != progress.end() && partial->second.checksum != script.checksum) {
+                result.outcome = MigrationOutcome::Failed;
+                result.message = "Migration " + script.name + " was changed after " +
+                                 std::to_string(partial->second.statements_done) + " of its statements were applied. "
+                                 "Restore the original file so the run can resume, or finish it by hand and baseline.";
+                return result;
+            }
+        }
+
+        std::unique_ptr<sql::Statement> stmt(con->createStatement());
+        stmt->execute("SET SESSION lock_wait_timeout = " + std::to_string(settings.lockWaitTimeoutSeconds));
+        stmt->execute(MIGRATION_PROGRESS_DDL);
+        std::unique_ptr<TracedStatement> progressStmt(prepareTraced(*con, "applyPendingMigrations",
+            "INSERT INTO schema_migration_progress (version, checksum, statements_done) VALUES (?, ?, ?) "
+            "ON DUPLICATE KEY UPDATE statements_done = VALUES(statements_done)"));
+
+        int baseline = baselineVersion(applied);
+        for (const auto& script : scripts) {
+            if (script.version <= baseline || applied.count(script.version)) continue;
+
+            auto start = std::chrono::steady_clock::now();
+            std::vector<std::string> statements = splitStatements(script.sql);
+            size_t resumeAt = 0;
+            if (progress.count(script.version)) {
+                resumeAt = static_cast<size_t>(progress[script.version].statements_done);
+                logEvent(LogLevel::Info, "applyPendingMigrations", "Resuming partly applied migration",
+                         {{"migration", script.name}, {"statement", resumeAt + 1}});
+            }
+            for (size_t i = resumeAt; i < statements.size(); ++i) {
+                try {
+                    stmt->execute(statements[i]);
+                } catch (sql::SQLException& e) {
+                    result.outcome = MigrationOutcome::Failed;
+                    result.message = "Migration " + script.name + " failed at statement " + std::to_string(i + 1) + ": " + e.what();
+                    if (e.getErrorCode() == 1205) { // ER_LOCK_WAIT_TIMEOUT
+                        result.message += " (a table was busy; run it again when the database is quieter "
+                                          "and it resumes at this statement)";
+                    }
+                    logSqlError("applyPendingMigrations", e, {{"migration", script.name}, {"statement", i + 1}});
+                    return result;
+                }
+                progressStmt->setInt(1, script.version);
+                progressStmt->setString(2, script.checksum);
+                progressStmt->setInt(3, static_cast<int>(i + 1));
+                progressStmt->executeUpdate();
+            }
+            long long elapsedMs = std::chrono::duration_cast<std::chrono::milliseconds>(
+                std::chrono::steady_clock::now() - start).count();
+
+            std::unique_ptr<TracedStatement> pstmt(prepareTraced(*con, "applyPendingMigrations",
+                "INSERT INTO schema_version (version, name, checksum, execution_ms) VALUES (?, ?, ?, ?)"));
+            pstmt->setInt(1, script.version);
+            pstmt->setString(2, script.name);
+            pstmt->setString(3, script.checksum);
+            pstmt->setInt(4, static_cast<int>(elapsedMs));
+            pstmt->executeUpdate();
+            std::unique_ptr<TracedStatement> clearStmt(prepareTraced(*con, "applyPendingMigrations",
+                "DELETE FROM schema_migration_progress WHERE version = ?"));
+            clearStmt->setInt(1, script.version);
+            clearStmt->executeUpdate();
+            logEvent(LogLevel::Info, "applyPendingMigrations", "Applied migration",
+                     {{"migration", script.name}, {"version", script.version}, {"duration_ms", elapsedMs}});
+            applied[script.version] = {script.name, script.checksum, std::string()};
+            ++result.applied;
+        }
+
+        result.schema_version = applied.empty() ? 0 : applied.rbegin()->first;
+        if (result.applied > 0) {
+            result.outcome = MigrationOutcome::Applied;
+            noteWrite();
+        }
+    } catch (sql::SQLException& e) {
+        logSqlError("applyPendingMigrations", e);
+        result.outcome = MigrationOutcome::Failed;
+        result.message = e.what();
+    }
+    return result;
+}
+
+std::vector<MigrationStatus> getMigrationStatus() {
+    std::vector<MigrationStatus> statuses;
+    std::vector<MigrationScript> scripts;
+    std::string error;
+    if (!loadScripts(readSettings().directory, scripts, error)) {
+        logEvent(LogLevel::Error, "getMigrationStatus", error);
+        return statuses;
+    }
+    try {
+        std::unique_ptr<sql::Connection> con(getConnection());
+        std::map<int, AppliedVersion> applied;
+        if (schemaVersionExists(*con)) applied = readAppliedVersions(*con);
+        std::map<int, MigrationProgress> progress = readMigrationProgress(*con);
+        int baseline = baselineVersion(applied);
+
+        // One entry per script, plus baseline rows whose version has no script
+        std::map<int, MigrationStatus> byVersion;
+        for (const auto& script : scripts) {
+            MigrationStatus status{script.version, script.name, script.version <= baseline, false, std::string(), 0};
+            auto it = applied.find(script.version);
+            if (it != applied.end() && !it->second.checksum.empty()) {
+                status.applied = true;
+                status.modified = it->second.checksum != script.checksum;
+                status.applied_at = it->second.applied_at;
+            } else if (!status.applied && progress.count(script.version)) {
+                status.statements_done = progress[script.version].statements_done;
+            }
+            byVersion[script.version] = status;
+        }
+        for (const auto& [version, row] : applied) {
+            if (row.checksum.empty() && !byVersion.count(version)) {
+                byVersion[version] = {version, row.name, true, false, row.applied_at, 0};
+            }
+        }
+        for (const auto& [version, status] : byVersion) {
+            statuses.push_back(status);
+        }
+    } catch (sql::SQLException& e) {
+        logSqlError("getMigrationStatus", e);
+    }
+    return statuses;
+}
+
+bool baselineSchema(int version) {
+    try {
+        std::unique_ptr<sql::Connection> con(getConnection());
+        NamedLock lock(*con, MIGRATION_LOCK, MIGRATION_LOCK_TIMEOUT_SECONDS);
+        if (!lock.acquired()) {
+            logEvent(LogLevel::Error, "baselineSchema", "Timed out waiting for another client to finish applying migrations");
+            return false;
+        }
+        std::unique_ptr<sql::Statement> stmt(con->createStatement());
+        stmt->execute(SCHEMA_VERSION_DDL);
+
+        std::unique_ptr<TracedStatement> pstmt(prepareTraced(*con, "baselineSchema",
+            "INSERT INTO schema_version (version, name) VALUES (?, 'baseline') ON DUPLICATE KEY UPDATE version = version"));
+        pstmt->setInt(1, version);
+        pstmt->executeUpdate();
+        noteWrite();
+        return true;
+    } catch (sql::SQLException& e) {
+        logSqlError("baselineSchema", e);
+        return false;
+    }
+}
@@ -0,0 +1,298 @@
+#include "partition.h"
+#include "database.h"
+#include "logger.h"
+#include "slowquery.h"
+#include <cppconn/prepared_statement.h>
+#include <cppconn/resultset.h>
+#include <algorithm>
+#include <cstdio>
+#include <ctime>
+
+namespace { // Anonymous namespace for file-local helpers
+    struct PartitionedTable {
+        const char* name;
+        const char* dateColumn;
+    };
+    const PartitionedTable partitionedTables[] = {
+        {"meal_attendance", "attendance_date"},
+        {"expenses", "purchase_date"},
+        {"payments", "date"},
+    };
+
+    // Named lock that keeps cron and manual maintenance runs from interleaving.
+    const char* MAINTENANCE_LOCK = "meal_partition_maintenance";
+
+    // Months are counted as year * 12 + (month - 1) so ranges are plain integers.
+    int currentMonth() {
+        std::time_t now = std::time(nullptr);
+        std::tm local = *std::localtime(&now);
+        return (local.tm_year + 1900) * 12 + local.tm_mon;
+    }
+
+    bool parseMonth(const std::string& text, int& month) {
+        int y = 0, m = 0;
+        char trailing = 0;
+        if (std::sscanf(text.c_str(), "%4d-%2d%c", &y, &m, &trailing) != 2 || m < 1 || m > 12) {
+            return false;
+        }
+        month = y * 12 + (m - 1);
+        return true;
+    }
+
+    std::string formatMonth(int month, const char* format) {
+        char buffer[16];
+        std::snprintf(buffer, sizeof(buffer), format, month / 12, month % 12 + 1);
+        return buffer;
+    }
+
+    std::string partitionName(int month) { return formatMonth(month, "p%04d%02d"); }
+    std::string firstDayOf(int month) { return formatMonth(month, "%04d-%02d-01"); }
+    std::string archiveName(const std::string& table, int month) { return table + formatMonth(month, "_archive_%04d%02d"); }
+
+    // Monthly partitions of a table in ascending order. False if the table is
+    // not partitioned, i.e. migrations/008_partitioning.sql has not been applied.
+    bool readMonthlyPartitions(sql::Connection& con, const std::string& table, std::vector<int>& months) {
+        std::unique_ptr<TracedStatement> pstmt(prepareTraced(con, "readMonthlyPartitions",
+            "SELECT PARTITION_NAME FROM information_schema.PARTITIONS "
+            "WHERE TABLE_SCHEMA = DATABASE() AND TABLE_NAME = ? ORDER BY PARTITION_ORDINAL_POSITION"));
+        pstmt->setString(1, table);
+        std::unique_ptr<sql::ResultSet> res(pstmt->executeQuery());
+        bool partitioned = false;
+        while (res->next()) {
+            if (res->isNull("PARTITION_NAME")) break;
+            partitioned = true;
+            int y = 0, m = 0;
+            if (std::sscanf(res->getString("PARTITION_NAME").c_str(), "p%4d%2d", &y, &m) == 2) {
+                months.push_back(y * 12 + (m - 1));
+            }
+        }
+        if (!partitioned) {
+            logEvent(LogLevel::Error, "readMonthlyPartitions", "Table is not partitioned; apply migrations/008_partitioning.sql first", {{"table", table}});
+        }
+        return partitioned;
+    }
+
+    bool tableExists(sql::Connection& con, const std::string& table) {
+        std::unique_ptr<TracedStatement> pstmt(prepareTraced(con, "tableExists",
+            "SELECT 1 FROM information_schema.TABLES WHERE TABLE_SCHEMA = DATABASE() AND TABLE_NAME = ?"));
+        pstmt->setString(1, table);
+        std::unique_ptr<sql::ResultSet> res(pstmt->executeQuery());
+        return res->next();
+    }
+
+    // True if no period of the month is open and every mess with rows in it has closed its period.
+    bool monthIsClosed(sql::Connection& con, int month) {
+        std::string firstDay = firstDayOf(month);
+        std::string nextFirstDay = firstDayOf(month + 1);
+
+        std::unique_ptr<TracedStatement> pstmt_open(prepareTraced(con, "monthIsClosed",
+            "SELECT COUNT(*) AS open_periods FROM meal_periods "
+            "WHERE month = DATE_FORMAT(?, '%M') AND year = DATE_FORMAT(?, '%Y') AND is_active = 1"));
+        pstmt_open->setString(1, firstDay);
+        pstmt_open->setString(2, firstDay);
+        std::unique_ptr<sql::ResultSet> res_open(pstmt_open->executeQuery());
+        if (res_open->next() && res_open->getInt("open_periods") > 0) return false;
+
+        std::unique_ptr<TracedStatement> pstmt_unclosed(prepareTraced(con, "monthIsClosed",
+            "SELECT COUNT(*) AS unclosed FROM ("
+            " SELECT mess_id FROM meal_attendance WHERE attendance_date >= ? AND attendance_date < ? "
+            " UNION SELECT mess_id FROM expenses WHERE purchase_date >= ? AND purchase_date < ? "
+            " UNION SELECT mess_id FROM payments WHERE date >= ? AND date < ?"
+            ") m WHERE NOT EXISTS (SELECT 1 FROM meal_periods p WHERE p.mess_id = m.mess_id "
+            " AND p.month = DATE_FORMAT(?, '%M') AND p.year = DATE_FORMAT(?, '%Y') AND p.is_active = 0)"));
+        int paramIndex = 1;
+        for (int i = 0; i < 3; ++i) {
+            pstmt_unclosed->setString(paramIndex++, firstDay);
+            pstmt_unclosed->setString(paramIndex++, nextFirstDay);
+        }
+        pstmt_unclosed->setString(paramIndex++, firstDay);
+        pstmt_unclosed->setString(paramIndex, firstDay);
+        std::unique_ptr<sql::ResultSet> res_unclosed(pstmt_unclosed->executeQuery());
+        return res_unclosed->next() && res_unclosed->getInt("unclosed") == 0;
+    }
+} // namespace
+
+bool ensureFuturePartitions(int monthsAhead) {
+    try {
+        std::unique_ptr<sql::Connection> con(getConnection());
+        NamedLock lock(*con, MAINTENANCE_LOCK, 10);
+        if (!lock.acquired()) {
+            logEvent(LogLevel::Error, "ensureFuturePartitions", "Partition maintenance is already running elsewhere");
+            return false;
+        }
+        std::unique_ptr<sql::Statement> stmt(con->createStatement());
+        int lastMonth = currentMonth() + monthsAhead;
+
+        for (const auto& table : partitionedTables) {
+            std::vector<int> months;
+            if (!readMonthlyPartitions(*con, table.name, months)) return false;
+
+            int firstMonth = currentMonth();
+            if (!months.empty()) {
+                firstMonth = months.back() + 1;
+            } else {
+                // First run after the migration: cover the existing rows, which all sit in pmax
+                std::unique_ptr<sql::ResultSet> res(stmt->executeQuery(
+                    std::string("SELECT DATE_FORMAT(MIN(") + table.dateColumn + "), '%Y-%m') AS oldest FROM " + table.name));
+                int oldest;
+                if (res->next() && !res->isNull("oldest") && parseMonth(res->getString("oldest"), oldest) && oldest < firstMonth) {
+                    firstMonth = oldest;
+                }
+            }
+            if (firstMonth > lastMonth) continue;
+
+            // One REORGANIZE for all new months; pmax normally holds no rows, so this is cheap
+            std::string ddl = std::string("ALTER TABLE ") + table.name + " REORGANIZE PARTITION pmax INTO (";
+            for (int month = firstMonth; month <= lastMonth; ++month) {
+                ddl += "PARTITION " + partitionName(month) + " VALUES LESS THAN ('" + firstDayOf(month + 1) + "'), ";
+            }
+            ddl += "PARTITION pmax VALUES LESS THAN (MAXVALUE))";
+            stmt->execute(ddl);
+        }
+        return true;
+    } catch (sql::SQLException& e) {
+        logSqlError("ensureFuturePartitions", e);
+        return false;
+    }
+}
+
+std::vector<PartitionInfo> listPartitions() {
+    std::vector<PartitionInfo> partitions;
+    try {
+        std::unique_ptr<sql::Connection> con(getConnection());
+        std::unique_ptr<sql::Statement> stmt(con->createStatement());
+        std::unique_ptr<sql::ResultSet> res(stmt->executeQuery(
+            "SELECT TABLE_NAME, PARTITION_NAME, TABLE_ROWS, DATA_LENGTH + INDEX_LENGTH AS bytes "
+            "FROM information_schema.PARTITIONS "
+            "WHERE TABLE_SCHEMA = DATABASE() AND TABLE_NAME IN ('meal_attendance', 'expenses', 'payments') "
+            "AND PARTITION_NAME IS NOT NULL "
+            "ORDER BY TABLE_NAME, PARTITION_ORDINAL_POSITION"));
+        while (res->next()) {
+            partitions.push_back({res->getString("TABLE_NAME"), res->getString("PARTITION_NAME"),
+                                  res->getInt64("TABLE_ROWS"), res->getInt64("bytes")});
+        }
+    } catch (sql::SQLException& e) {
+        logSqlError("listPartitions", e);
+    }
+    return partitions;
+}
+
+std::vector<ArchiveInfo> listArchives() {
+    std::vector<ArchiveInfo> archives;
+    try {
+        std::unique_ptr<sql::Connection> con(getConnection());
+        std::unique_ptr<sql::Statement> stmt(con->createStatement());
+        std::unique_ptr<sql::ResultSet> res(stmt->executeQuery(
+            "SELECT TABLE_NAME, TABLE_ROWS, DATA_LENGTH + INDEX_LENGTH AS bytes "
+            "FROM information_schema.TABLES "
+            "WHERE TABLE_SCHEMA = DATABASE() AND TABLE_NAME LIKE '%\\_archive\\_______' "
+            "ORDER BY TABLE_NAME"));
+        while (res->next()) {
+            ArchiveInfo archive;
+            archive.table = res->getString("TABLE_NAME");
+            size_t suffix = archive.table.rfind("_archive_");
+            archive.source_table = archive.table.substr(0, suffix);
+            std::string digits = archive.table.substr(suffix + 9);
+            archive.month = digits.substr(0, 4) + "-" + digits.substr(4);
+            archive.rows = res->getInt64("TABLE_ROWS");
+            archive.bytes = res->getInt64("bytes");
+            archives.push_back(archive);
+        }
+    } catch (sql::SQLException& e) {
+        logSqlError("listArchives", e);
+    }
+    return archives;
+}
+
+bool archiveMonth(const std::string& monthText) {
+    int month;
+    if (!parseMonth(monthText, month)) {
+        logEvent(LogLevel::Error, "archiveMonth", "Invalid month; expected YYYY-MM", {{"month", monthText}});
+        return false;
+    }
+    try {
+        std::unique_ptr<sql::Connection> con(getConnection());
+        NamedLock lock(*con, MAINTENANCE_LOCK, 10);
+        if (!lock.acquired()) {
+            logEvent(LogLevel::Error, "archiveMonth", "Partition maintenance is already running elsewhere");
+            return false;
+        }
+        if (!monthIsClosed(*con, month)) {
+            logEvent(LogLevel::Error, "archiveMonth", "Cannot archive; close every period for that month first", {{"month", monthText}});
+            return false;
+        }
+
+        // Check every table before changing any, so a refusal leaves nothing half-archived
+        for (const auto& table : partitionedTables) {
+            std::vector<int> months;
+            if (!readMonthlyPartitions(*con, table.name, months)) return false;
+            if (std::find(months.begin(), months.end(), month) == months.end()) {
+                logEvent(LogLevel::Error, "archiveMonth", "Table has no partition for the month", {{"table", table.name}, {"month", monthText}});
+                return false;
+            }
+            if (tableExists(*con, archiveName(table.name, month))) {
+                logEvent(LogLevel::Error, "archiveMonth", "Month is already archived", {{"month", monthText}});
+                return false;
+            }
+        }
+
+        std::unique_ptr<sql::Statement> stmt(con->createStatement());
+        for (const auto& table : partitionedTables) {
+            std::string archive = archiveName(table.name, month);
+            stmt->execute("CREATE TABLE " + archive + " LIKE " + table.name);
+            stmt->execute("ALTER TABLE " + archive + " REMOVE PARTITIONING");
+            stmt->execute(std::string("ALTER TABLE ") + table.name + " EXCHANGE PARTITION " + partitionName(month) +
+                          " WITH TABLE " + archive);
+            // Rebuilds only the archive; the live table was never copied
+            stmt->execute("ALTER TABLE " + archive + " ROW_FORMAT = COMPRESSED KEY_BLOCK_SIZE = 8");
+        }
+        return true;
+    } catch (sql::SQLException& e) {
+        logSqlError("archiveMonth", e);
+        return false;
+    }
+}
+
+bool restoreArchivedMonth(const std::string& monthText) {
+    int month;
+    if (!parseMonth(monthText, month)) {
+        logEvent(LogLevel::Error, "restoreArchivedMonth", "Invalid month; expected YYYY-MM", {{"month", monthText}});
+        return false;
+    }
+    try {
+        std::unique_ptr<sql::Connection> con(getConnection());
+        NamedLock lock(*con, MAINTENANCE_LOCK, 10);
+        if (!lock.acquired()) {
+            logEvent(LogLevel::Error, "restoreArchivedMonth", "Partition maintenance is already running elsewhere");
+            return false;
+        }
+        std::unique_ptr<sql::Statement> stmt(con->createStatement());
+        bool restored = false;
+        for (const auto& table : partitionedTables) {
+            std::string archive = archiveName(table.name, month);
+            if (!tableExists(*con, archive)) continue;
+
+            // Exchanging into a partition that gained rows would move those rows into the archive
+            std::unique_ptr<sql::ResultSet> res(stmt->executeQuery(
+                std::string("SELECT COUNT(*) AS live_rows FROM ") + table.name + " PARTITION (" + partitionName(month) + ")"));
+            if (res->next() && res->getInt64("live_rows") > 0) {
+                logEvent(LogLevel::Error, "restoreArchivedMonth", "Cannot restore; the table already has rows for the month", {{"archive", archive}, {"table", table.name}, {"month", monthText}});
+                return false;
+            }
+
+            // The exchange needs the live table's row format back
+            stmt->execute("ALTER TABLE " + archive + " ROW_FORMAT = DYNAMIC KEY_BLOCK_SIZE = 0");
+            stmt->execute(std::string("ALTER TABLE ") + table.name + " EXCHANGE PARTITION " + partitionName(month) +
+                          " WITH TABLE " + archive);
+            stmt->execute("DROP TABLE " + archive);
+            restored = true;
+        }
+        if (!restored) {
+            logEvent(LogLevel::Error, "restoreArchivedMonth", "Month is not archived", {{"month", monthText}});
+        }
+        return restored;
+    } catch (sql::SQLException& e) {
+        logSqlError("restoreArchivedMonth", e);
+        return false;
+    }
+}
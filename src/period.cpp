@@ -1,25 +1,31 @@
 #include "period.h"
 #include "database.h"
+#include "mess.h"
+#include "logger.h"
+#include "slowquery.h"
 #include <cppconn/prepared_statement.h>
 #include <cppconn/resultset.h>
-#include <iostream>
+#include <cppconn/exception.h>
 #include <memory>
+#include <set>
 #include <vector>
 
 bool setupMealPeriod(const std::string& month, const std::string& year) {
     try {
         std::unique_ptr<sql::Connection> con(getConnection());
-        std::unique_ptr<sql::PreparedStatement> pstmt(
-            con->prepareStatement("INSERT INTO meal_periods (month, year) VALUES (?, ?)"));
-        pstmt->setString(1, month);
-        pstmt->setString(2, year);
+        std::unique_ptr<TracedStatement> pstmt(
+            prepareTraced(*con, "setupMealPeriod", "INSERT INTO meal_periods (mess_id, month, year) VALUES (?, ?, ?)"));
+        pstmt->setInt(1, currentMessId());
+        pstmt->setString(2, month);
+        pstmt->setString(3, year);
         pstmt->execute();
+        noteWrite();
         return true;
     } catch (sql::SQLException& e) {
         if (e.getErrorCode() == 1062) { // ER_DUP_ENTRY for `period_unique` constraint
-            std::cerr << "Error: Meal period for " << month << " " << year << " already exists." << std::endl;
+            logEvent(LogLevel::Error, "setupMealPeriod", "Meal period already exists", {{"month", month}, {"year", year}});
         } else {
-            std::cerr << "SQL Error in setupMealPeriod: " << e.what() << std::endl;
+            logSqlError("setupMealPeriod", e);
         }
         return false;
     }
@@ -29,17 +35,54 @@ std::vector<MealPeriod> getAllMealPeriods() {
     std::vector<MealPeriod> periods;
     try {
         std::unique_ptr<sql::Connection> con(getConnection());
-        std::unique_ptr<sql::Statement> stmt(con->createStatement());
-        std::unique_ptr<sql::ResultSet> res(stmt->executeQuery("SELECT id, month, year FROM meal_periods ORDER BY year DESC, month DESC"));
+        std::unique_ptr<TracedStatement> pstmt(
+            prepareTraced(*con, "getAllMealPeriods", "SELECT id, month, year, is_active FROM meal_periods WHERE mess_id = ? ORDER BY year DESC, month DESC"));
+        pstmt->setInt(1, currentMessId());
+        std::unique_ptr<sql::ResultSet> res(pstmt->executeQuery());
         while (res->next()) {
             MealPeriod period;
             period.id = res->getInt("id");
             period.month = res->getString("month");
             period.year = res->getString("year");
+            period.is_closed = !res->isNull("is_active") && res->getInt("is_active") == 0;
             periods.push_back(period);
         }
     } catch (sql::SQLException& e) {
-        std::cerr << "SQL Error in getAllMealPeriods: " << e.what() << std::endl;
+        logSqlError("getAllMealPeriods", e);
     }
     return periods;
 }
+
+void lockOpenPeriods(sql::Connection& con, int messId, const std::vector<std::string>& dates) {
+    // One representative date per month is enough; the period is the month.
+    std::set<std::string> months;
+    std::vector<std::string> representatives;
+    for (const auto& date : dates) {
+        if (months.insert(date.substr(0, 7)).second) representatives.push_back(date);
+    }
+    if (representatives.empty()) {
+        return;
+    }
+
+    std::string query = "SELECT month, year, is_active FROM meal_periods WHERE mess_id = ? AND (month, year) IN (";
+    for (size_t i = 0; i < representatives.size(); ++i) {
+        query += "(DATE_FORMAT(STR_TO_DATE(?, '%Y-%m-%d'), '%M'), DATE_FORMAT(STR_TO_DATE(?, '%Y-%m-%d'), '%Y'))";
+        if (i < representatives.size() - 1) query += ", ";
+    }
+    query += ") LOCK IN SHARE MODE";
+
+    std::unique_ptr<TracedStatement> pstmt(prepareTraced(con, "lockOpenPeriods", query));
+    int paramIndex = 1;
+    pstmt->setInt(paramIndex++, messId);
+    for (const auto& date : representatives) {
+        pstmt->setString(paramIndex++, date);
+        pstmt->setString(paramIndex++, date);
+    }
+    std::unique_ptr<sql::ResultSet> res(pstmt->executeQuery());
+    while (res->next()) {
+        if (!res->isNull("is_active") && res->getInt("is_active") == 0) {
+            throw sql::SQLException("Meal period " + std::string(res->getString("month")) + " " + std::string(res->getString("year")) +
+                                    " is closed; its records can no longer be changed.", "45000", ER_PERIOD_CLOSED);
+        }
+    }
+}
@@ -1,22 +1,25 @@
 #include "settings.h"
 #include "database.h"
+#include "mess.h"
+#include "logger.h"
+#include "slowquery.h"
 #include <cppconn/prepared_statement.h>
 #include <cppconn/resultset.h>
-#include <iostream>
 
 SystemSettings getSystemSettings() {
     SystemSettings settings;
     try {
         std::unique_ptr<sql::Connection> con(getConnection());
-        std::unique_ptr<sql::Statement> stmt(con->createStatement());
-        std::unique_ptr<sql::ResultSet> res(stmt->executeQuery("SELECT currency FROM settings WHERE id = 1"));
+        std::unique_ptr<TracedStatement> pstmt(prepareTraced(*con, "getSystemSettings", "SELECT currency FROM settings WHERE mess_id = ?"));
+        pstmt->setInt(1, currentMessId());
+        std::unique_ptr<sql::ResultSet> res(pstmt->executeQuery());
         if (res->next()) {
             settings.currency = res->getString("currency");
         } else {
             settings.currency = "USD"; // Default
         }
     } catch (sql::SQLException &e) {
-        std::cerr << "SQLException in getSystemSettings: " << e.what() << std::endl;
+        logSqlError("getSystemSettings", e);
     }
     return settings;
 }
@@ -24,12 +27,15 @@ SystemSettings getSystemSettings() {
 bool updateSystemSettings(const SystemSettings& settings) {
     try {
         std::unique_ptr<sql::Connection> con(getConnection());
-        std::unique_ptr<sql::PreparedStatement> pstmt(con->prepareStatement("UPDATE settings SET currency = ? WHERE id = 1"));
-        pstmt->setString(1, settings.currency);
+        std::unique_ptr<TracedStatement> pstmt(prepareTraced(*con, "updateSystemSettings",
+            "INSERT INTO settings (mess_id, currency) VALUES (?, ?) ON DUPLICATE KEY UPDATE currency = VALUES(currency)"));
+        pstmt->setInt(1, currentMessId());
+        pstmt->setString(2, settings.currency);
         pstmt->executeUpdate();
+        noteWrite();
         return true;
     } catch (sql::SQLException &e) {
-        std::cerr << "SQLException in updateSystemSettings: " << e.what() << std::endl;
+        logSqlError("updateSystemSettings", e);
         return false;
     }
 }
\ No newline at end of file
@@ -0,0 +1,422 @@
+#include "slowquery.h"
+#include "database.h"
+#include "checksum.h"
+#include "logger.h"
+#include <cppconn/resultset_metadata.h>
+#include <mysql_driver.h>
+#include <QDateTime>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QSettings>
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <filesystem>
+#include <fstream>
+#include <mutex>
+#include <thread>
+
+namespace { // Anonymous namespace for file-local helpers
+    const size_t MAX_PENDING = 100;        // Records waiting for the writer; more are dropped
+    const size_t MAX_RECORDED_PARAMS = 100; // Multi-row inserts bind thousands
+    const size_t MAX_RECORDED_SQL = 4000;
+
+    struct SlowQuerySettings {
+        int thresholdMs = 500;
+        bool explain = true;
+        std::string file;
+        uintmax_t maxFileBytes = 10240 * 1024;
+        int maxFiles = 5;
+    };
+
+    const SlowQuerySettings& settings() {
+        static const SlowQuerySettings loaded = [] {
+            QSettings config(QString::fromStdString(getConfigFilePath()), QSettings::IniFormat);
+            SlowQuerySettings result;
+            result.thresholdMs = std::max(0, config.value("SlowQueries/threshold_ms", 500).toInt());
+            result.explain = config.value("SlowQueries/explain", true).toBool();
+            result.file = config.value("SlowQueries/file", "slow_queries.log").toString().toStdString();
+            result.maxFileBytes = static_cast<uintmax_t>(std::max(0, config.value("SlowQueries/max_file_size_kb", 10240).toInt())) * 1024;
+            result.maxFiles = std::max(0, config.value("SlowQueries/max_files", 5).toInt());
+            return result;
+        }();
+        return loaded;
+    }
+
+    double elapsedMs(std::chrono::steady_clock::time_point start) {
+        return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    }
+
+    // Whitespace-insensitive, so reformatting a statement keeps its id.
+    std::string sqlId(const std::string& sql) {
+        std::string normalized;
+        bool space = false;
+        for (unsigned char c : sql) {
+            if (std::isspace(c)) {
+                space = !normalized.empty();
+                continue;
+            }
+            if (space) normalized += ' ';
+            normalized += static_cast<char>(c);
+            space = false;
+        }
+        return sha256Hex(normalized).substr(0, 16);
+    }
+
+    bool explainable(const std::string& sql) {
+        size_t start = sql.find_first_not_of(" \t\r\n(");
+        if (start == std::string::npos) return false;
+        std::string verb;
+        for (size_t i = start; i < sql.size() && std::isalpha(static_cast<unsigned char>(sql[i])); ++i) {
+            verb += static_cast<char>(std::toupper(static_cast<unsigned char>(sql[i])));
+        }
+        return verb == "SELECT" || verb == "UPDATE" || verb == "DELETE";
+    }
+
+    struct PendingQuery {
+        SlowQueryRecord record;
+        std::string fullSql;                          // Untruncated, for EXPLAIN
+        std::vector<std::pair<char, std::string>> binds; // 'i'nteger, 'd'ouble or 's'tring
+    };
+
+    QJsonObject toJson(const SlowQueryRecord& record) {
+        QJsonObject object;
+        object["ts"] = QString::fromStdString(record.timestamp);
+        object["sql_id"] = QString::fromStdString(record.sql_id);
+        object["fn"] = QString::fromStdString(record.function);
+        object["sql"] = QString::fromStdString(record.sql);
+        QJsonArray params;
+        for (const auto& param : record.params) {
+            params.append(QString::fromStdString(param));
+        }
+        object["params"] = params;
+        object["rows"] = static_cast<double>(record.rows);
+        object["prepare_ms"] = record.prepare_ms;
+        object["execute_ms"] = record.execute_ms;
+        object["total_ms"] = record.total_ms;
+        if (!record.plan.empty()) object["plan"] = QString::fromStdString(record.plan);
+        return object;
+    }
+
+    SlowQueryRecord fromJson(const QJsonObject& object) {
+        SlowQueryRecord record;
+        record.timestamp = object["ts"].toString().toStdString();
+        record.sql_id = object["sql_id"].toString().toStdString();
+        record.function = object["fn"].toString().toStdString();
+        record.sql = object["sql"].toString().toStdString();
+        for (const auto& param : object["params"].toArray()) {
+            record.params.push_back(param.toString().toStdString());
+        }
+        record.rows = static_cast<long long>(object["rows"].toDouble(-1));
+        record.prepare_ms = object["prepare_ms"].toDouble();
+        record.execute_ms = object["execute_ms"].toDouble();
+        record.total_ms = object["total_ms"].toDouble();
+        record.plan = object["plan"].toString().toStdString();
+        return record;
+    }
+
+    // Runs EXPLAIN with the statement's bound values on a fresh connection.
+    // The plan is rendered as tab-separated rows under a header row.
+    std::string explain(const PendingQuery& query) {
+        std::unique_ptr<sql::Connection> con(getConnection());
+        std::unique_ptr<sql::PreparedStatement> pstmt(con->prepareStatement("EXPLAIN " + query.fullSql));
+        for (size_t i = 0; i < query.binds.size(); ++i) {
+            const auto& [kind, text] = query.binds[i];
+            unsigned int index = static_cast<unsigned int>(i + 1);
+            if (kind == 'i') {
+                pstmt->setInt64(index, std::stoll(text));
+            } else if (kind == 'd') {
+                pstmt->setDouble(index, std::stod(text));
+            } else {
+                pstmt->setString(index, text);
+            }
+        }
+        std::unique_ptr<sql::ResultSet> res(pstmt->executeQuery());
+        sql::ResultSetMetaData* meta = res->getMetaData();
+        unsigned int columns = meta->getColumnCount();
+        std::string plan;
+        for (unsigned int c = 1; c <= columns; ++c) {
+            plan += std::string(meta->getColumnLabel(c)) + (c < columns ? "\t" : "\n");
+        }
+        while (res->next()) {
+            for (unsigned int c = 1; c <= columns; ++c) {
+                plan += (res->isNull(c) ? std::string("NULL") : std::string(res->getString(c))) + (c < columns ? "\t" : "\n");
+            }
+        }
+        return plan;
+    }
+
+    // Fetches plans and appends records off the querying threads.
+    class SlowQueryWriter {
+    public:
+        SlowQueryWriter() : worker(&SlowQueryWriter::run, this) {}
+
+        ~SlowQueryWriter() {
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                stopping = true;
+            }
+            wake.notify_one();
+            worker.join();
+        }
+
+        void enqueue(PendingQuery&& query) {
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                if (pending.size() >= MAX_PENDING) return;
+                pending.push_back(std::move(query));
+            }
+            wake.notify_one();
+        }
+
+    private:
+        std::mutex mutex;
+        std::condition_variable wake;
+        std::deque<PendingQuery> pending;
+        bool stopping = false;
+        std::thread worker; // Last, so it starts after everything it uses
+
+        void run() {
+            sql::Driver* driver = sql::mysql::get_driver_instance();
+            driver->threadInit(); // Connector/C++ needs this on every thread that connects
+            for (;;) {
+                PendingQuery query;
+                bool shuttingDown;
+                {
+                    std::unique_lock<std::mutex> lock(mutex);
+                    wake.wait(lock, [&] { return stopping || !pending.empty(); });
+                    if (pending.empty()) break;
+                    query = std::move(pending.front());
+                    pending.pop_front();
+                    shuttingDown = stopping;
+                }
+                // Skipped when exiting, so a slow database can't hold up shutdown
+                if (settings().explain && !shuttingDown && explainable(query.fullSql)) {
+                    try {
+                        query.record.plan = explain(query);
+                    } catch (const std::exception& e) {
+                        query.record.plan = std::string("EXPLAIN failed: ") + e.what();
+                    }
+                }
+                append(query.record);
+            }
+            driver->threadEnd();
+        }
+
+        void append(const SlowQueryRecord& record) {
+            const SlowQuerySettings& config = settings();
+            if (config.file.empty()) return;
+            std::string line = QJsonDocument(toJson(record)).toJson(QJsonDocument::Compact).toStdString() + "\n";
+            std::error_code ec;
+            uintmax_t size = std::filesystem::file_size(config.file, ec);
+            if (!ec && config.maxFileBytes > 0 && size > 0 && size + line.size() > config.maxFileBytes) {
+                rotateLogFiles(config.file, config.maxFiles);
+            }
+            std::ofstream out(config.file, std::ios::app);
+            out << line;
+            if (!out) {
+                logEvent(LogLevel::Warning, "SlowQueryWriter", "Could not write to the slow-query file", {{"path", config.file}});
+            }
+        }
+    };
+
+    // The statement the watched thread is executing. Only that thread writes
+    // it, between the start and end of an execution, so the pointers stay
+    // valid while set.
+    std::atomic<bool> watching{false};
+    std::thread::id watchedThread;
+    std::mutex inFlightMutex;
+    const char* inFlightFunction = nullptr;
+    const std::string* inFlightSql = nullptr;
+    std::chrono::steady_clock::time_point inFlightStart;
+
+    class InFlightScope {
+    public:
+        InFlightScope(const char* function, const std::string& sql)
+            : active(watching.load(std::memory_order_acquire) && std::this_thread::get_id() == watchedThread) {
+            if (!active) return;
+            std::lock_guard<std::mutex> lock(inFlightMutex);
+            inFlightFunction = function;
+            inFlightSql = &sql;
+            inFlightStart = std::chrono::steady_clock::now();
+        }
+
+        ~InFlightScope() {
+            if (!active) return;
+            std::lock_guard<std::mutex> lock(inFlightMutex);
+            inFlightFunction = nullptr;
+            inFlightSql = nullptr;
+        }
+
+        InFlightScope(const InFlightScope&) = delete;
+        InFlightScope& operator=(const InFlightScope&) = delete;
+
+    private:
+        bool active;
+    };
+
+    SlowQueryWriter& writer() {
+        static SlowQueryWriter instance;
+        return instance;
+    }
+
+    void readRecords(const std::string& path, std::vector<SlowQueryRecord>& records, size_t limit) {
+        std::ifstream in(path);
+        std::vector<std::string> lines;
+        std::string line;
+        while (std::getline(in, line)) {
+            if (!line.empty()) lines.push_back(line);
+        }
+        for (auto it = lines.rbegin(); it != lines.rend() && records.size() < limit; ++it) {
+            QJsonDocument document = QJsonDocument::fromJson(QByteArray::fromStdString(*it));
+            if (document.isObject()) { // A line still being written is skipped
+                records.push_back(fromJson(document.object()));
+            }
+        }
+    }
+} // namespace
+
+TracedStatement::TracedStatement(std::unique_ptr<sql::PreparedStatement> statement, const char* function,
+                                 std::string sql, double prepareMs)
+    : statement(std::move(statement)), function(function), sql(std::move(sql)), prepareMs(prepareMs)
+{
+}
+
+void TracedStatement::bind(unsigned int index, BoundValue value) {
+    if (index == 0) return;
+    if (values.size() < index) values.resize(index);
+    values[index - 1] = std::move(value);
+}
+
+void TracedStatement::setInt(unsigned int index, int32_t value) {
+    statement->setInt(index, value);
+    bind(index, {'i', std::to_string(value)});
+}
+
+void TracedStatement::setInt64(unsigned int index, int64_t value) {
+    statement->setInt64(index, value);
+    bind(index, {'i', std::to_string(value)});
+}
+
+void TracedStatement::setDouble(unsigned int index, double value) {
+    statement->setDouble(index, value);
+    bind(index, {'d', std::to_string(value)});
+}
+
+void TracedStatement::setString(unsigned int index, const std::string& value) {
+    statement->setString(index, value);
+    bind(index, {'s', value});
+}
+
+sql::ResultSet* TracedStatement::executeQuery() {
+    auto start = std::chrono::steady_clock::now();
+    InFlightScope inFlight(function, sql);
+    sql::ResultSet* res = statement->executeQuery();
+    double executeMs = elapsedMs(start);
+    if (isSlow(executeMs)) {
+        long long rows = -1;
+        try {
+            rows = static_cast<long long>(res->rowsCount());
+        } catch (sql::SQLException&) {
+            // Not available on streaming result sets
+        }
+        report(executeMs, rows);
+    }
+    prepareMs = 0.0;
+    return res;
+}
+
+int TracedStatement::executeUpdate() {
+    auto start = std::chrono::steady_clock::now();
+    InFlightScope inFlight(function, sql);
+    int rows = statement->executeUpdate();
+    double executeMs = elapsedMs(start);
+    if (isSlow(executeMs)) report(executeMs, rows);
+    prepareMs = 0.0;
+    return rows;
+}
+
+bool TracedStatement::execute() {
+    auto start = std::chrono::steady_clock::now();
+    InFlightScope inFlight(function, sql);
+    bool hasResult = statement->execute();
+    double executeMs = elapsedMs(start);
+    if (isSlow(executeMs)) report(executeMs, -1);
+    prepareMs = 0.0;
+    return hasResult;
+}
+
+bool TracedStatement::isSlow(double executeMs) const {
+    int threshold = settings().thresholdMs;
+    return threshold > 0 && prepareMs + executeMs >= threshold;
+}
+
+void TracedStatement::report(double executeMs, long long rows) {
+    PendingQuery query;
+    SlowQueryRecord& record = query.record;
+    record.timestamp = QDateTime::currentDateTimeUtc().toString(Qt::ISODateWithMs).toStdString();
+    record.sql_id = sqlId(sql);
+    record.function = function;
+    record.sql = sql.size() > MAX_RECORDED_SQL ? sql.substr(0, MAX_RECORDED_SQL) + "..." : sql;
+    for (size_t i = 0; i < values.size() && i < MAX_RECORDED_PARAMS; ++i) {
+        record.params.push_back(values[i].kind == 's' ? "'" + values[i].text + "'" : values[i].text);
+    }
+    if (values.size() > MAX_RECORDED_PARAMS) {
+        record.params.push_back("... " + std::to_string(values.size() - MAX_RECORDED_PARAMS) + " more");
+    }
+    record.rows = rows;
+    record.prepare_ms = prepareMs;
+    record.execute_ms = executeMs;
+    record.total_ms = prepareMs + executeMs;
+    logEvent(LogLevel::Info, function, "Slow query", {{"sql_id", record.sql_id}, {"total_ms", record.total_ms}, {"rows", rows}});
+
+    query.fullSql = sql;
+    for (const auto& value : values) {
+        query.binds.emplace_back(value.kind, value.text);
+    }
+    writer().enqueue(std::move(query));
+}
+
+std::unique_ptr<TracedStatement> prepareTraced(sql::Connection& con, const char* function, const std::string& sql) {
+    auto start = std::chrono::steady_clock::now();
+    std::unique_ptr<sql::PreparedStatement> statement(con.prepareStatement(sql));
+    return std::make_unique<TracedStatement>(std::move(statement), function, sql, elapsedMs(start));
+}
+
+void watchInFlightStatements(std::thread::id thread) {
+    watchedThread = thread;
+    watching.store(true, std::memory_order_release);
+}
+
+bool currentInFlightStatement(InFlightStatement& statement) {
+    std::lock_guard<std::mutex> lock(inFlightMutex);
+    if (!inFlightSql) return false;
+    statement.function = inFlightFunction;
+    statement.sql_id = sqlId(*inFlightSql);
+    statement.sql = inFlightSql->size() > MAX_RECORDED_SQL ? inFlightSql->substr(0, MAX_RECORDED_SQL) + "..." : *inFlightSql;
+    statement.elapsed_ms = elapsedMs(inFlightStart);
+    return true;
+}
+
+int slowQueryThresholdMs() {
+    return settings().thresholdMs;
+}
+
+const std::string& slowQueryLogPath() {
+    return settings().file;
+}
+
+std::vector<SlowQueryRecord> readSlowQueries(size_t limit) {
+    std::vector<SlowQueryRecord> records;
+    const std::string& path = settings().file;
+    if (path.empty()) return records;
+    readRecords(path, records, limit);
+    if (records.size() < limit) {
+        readRecords(path + ".1", records, limit);
+    }
+    return records;
+}
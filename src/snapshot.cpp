@@ -0,0 +1,320 @@
+#include "snapshot.h"
+#include "checksum.h"
+#include "mess.h"
+#include "settings.h"
+#include "logger.h"
+#include <cppconn/driver.h>
+#include <mysql_driver.h>
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <fcntl.h>
+#include <mutex>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace { // Anonymous namespace for file-local helpers
+    const char SNAPSHOT_MAGIC[8] = {'M', 'M', 'S', 'N', 'A', 'P', '1', '\0'};
+    const uint32_t SNAPSHOT_FORMAT_VERSION = 1;
+    const size_t HEADER_SIZE = 32;
+
+    std::mutex snapshotMutex;
+    std::shared_ptr<const ReferenceSnapshot> current;
+
+    std::string snapshotPath(int messId) {
+        return "reference_snapshot_mess" + std::to_string(messId) + ".bin";
+    }
+
+    class Writer {
+    public:
+        void u32(uint32_t value) {
+            for (int i = 0; i < 4; ++i) out += static_cast<char>(value >> (8 * i));
+        }
+        void u64(uint64_t value) {
+            u32(static_cast<uint32_t>(value));
+            u32(static_cast<uint32_t>(value >> 32));
+        }
+        void i32(int value) { u32(static_cast<uint32_t>(value)); }
+        void f64(double value) {
+            uint64_t bits;
+            std::memcpy(&bits, &value, sizeof(bits));
+            u64(bits);
+        }
+        void str(const std::string& value) {
+            u32(static_cast<uint32_t>(value.size()));
+            out += value;
+        }
+        std::string out;
+    };
+
+    // Decodes from the mapped bytes; every read is bounds-checked.
+    class Reader {
+    public:
+        Reader(const char* data, size_t size) : data(data), size(size) {}
+        bool u32(uint32_t& value) {
+            if (size - pos < 4) return false;
+            value = 0;
+            for (int i = 0; i < 4; ++i) value |= static_cast<uint32_t>(static_cast<unsigned char>(data[pos + i])) << (8 * i);
+            pos += 4;
+            return true;
+        }
+        bool u64(uint64_t& value) {
+            uint32_t low, high;
+            if (!u32(low) || !u32(high)) return false;
+            value = (static_cast<uint64_t>(high) << 32) | low;
+            return true;
+        }
+        bool i32(int& value) {
+            uint32_t raw;
+            if (!u32(raw)) return false;
+            value = static_cast<int>(raw);
+            return true;
+        }
+        bool f64(double& value) {
+            uint64_t bits;
+            if (!u64(bits)) return false;
+            std::memcpy(&value, &bits, sizeof(bits));
+            return true;
+        }
+        bool str(std::string& value) {
+            uint32_t length;
+            if (!u32(length) || size - pos < length) return false;
+            value.assign(data + pos, length);
+            pos += length;
+            return true;
+        }
+        // Guards vector reserves against a corrupt count; each element takes at least 4 bytes.
+        bool count(uint32_t& value) { return u32(value) && value <= (size - pos) / 4; }
+        bool atEnd() const { return pos == size; }
+
+    private:
+        const char* data;
+        size_t size;
+        size_t pos = 0;
+    };
+
+    std::string encodeBody(const ReferenceSnapshot& snapshot) {
+        Writer w;
+        w.u32(static_cast<uint32_t>(snapshot.users.size()));
+        for (const auto& user : snapshot.users) {
+            w.i32(user.id);
+            w.str(user.username);
+            w.str(user.name);
+            w.i32(static_cast<int>(user.role));
+        }
+        w.u32(static_cast<uint32_t>(snapshot.menu_items.size()));
+        for (const auto& item : snapshot.menu_items) {
+            w.i32(item.id);
+            w.str(item.name);
+        }
+        w.u32(static_cast<uint32_t>(snapshot.periods.size()));
+        for (const auto& period : snapshot.periods) {
+            w.i32(period.id);
+            w.str(period.month);
+            w.str(period.year);
+        }
+        w.str(snapshot.currency);
+        w.i32(snapshot.current_period_id);
+        w.f64(snapshot.current_meal_rate);
+        w.u32(static_cast<uint32_t>(snapshot.current_settlement.size()));
+        for (const auto& r : snapshot.current_settlement) {
+            w.i32(r.user_id);
+            w.str(r.user_name);
+            w.i32(r.total_meals);
+            w.f64(r.total_meal_cost);
+            w.f64(r.total_payments);
+            w.f64(r.total_shopping_expenses);
+            w.f64(r.total_contributions);
+            w.f64(r.final_balance);
+        }
+        return w.out;
+    }
+
+    bool decodeBody(const char* data, size_t size, ReferenceSnapshot& snapshot) {
+        Reader r(data, size);
+        uint32_t n;
+        if (!r.count(n)) return false;
+        snapshot.users.resize(n);
+        for (auto& user : snapshot.users) {
+            int role;
+            if (!r.i32(user.id) || !r.str(user.username) || !r.str(user.name) || !r.i32(role)) return false;
+            user.role = static_cast<UserRole>(role);
+        }
+        if (!r.count(n)) return false;
+        snapshot.menu_items.resize(n);
+        for (auto& item : snapshot.menu_items) {
+            if (!r.i32(item.id) || !r.str(item.name)) return false;
+        }
+        if (!r.count(n)) return false;
+        snapshot.periods.resize(n);
+        for (auto& period : snapshot.periods) {
+            if (!r.i32(period.id) || !r.str(period.month) || !r.str(period.year)) return false;
+        }
+        if (!r.str(snapshot.currency) || !r.i32(snapshot.current_period_id) || !r.f64(snapshot.current_meal_rate)) return false;
+        if (!r.count(n)) return false;
+        snapshot.current_settlement.resize(n);
+        for (auto& s : snapshot.current_settlement) {
+            if (!r.i32(s.user_id) || !r.str(s.user_name) || !r.i32(s.total_meals) || !r.f64(s.total_meal_cost) ||
+                !r.f64(s.total_payments) || !r.f64(s.total_shopping_expenses) || !r.f64(s.total_contributions) ||
+                !r.f64(s.final_balance)) {
+                return false;
+            }
+        }
+        return r.atEnd();
+    }
+
+    std::shared_ptr<ReferenceSnapshot> readSnapshotFile(int messId) {
+        std::string path = snapshotPath(messId);
+        int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0) return nullptr;
+
+        struct stat info;
+        if (::fstat(fd, &info) != 0 || static_cast<size_t>(info.st_size) < HEADER_SIZE) {
+            ::close(fd);
+            return nullptr;
+        }
+        size_t fileSize = static_cast<size_t>(info.st_size);
+        void* mapped = ::mmap(nullptr, fileSize, PROT_READ, MAP_PRIVATE, fd, 0);
+        ::close(fd); // The mapping stays valid
+        if (mapped == MAP_FAILED) return nullptr;
+
+        const char* bytes = static_cast<const char*>(mapped);
+        auto snapshot = std::make_shared<ReferenceSnapshot>();
+        Reader header(bytes + sizeof(SNAPSHOT_MAGIC), HEADER_SIZE - sizeof(SNAPSHOT_MAGIC));
+        uint32_t version, fileMessId, bodyLength, checksum;
+        uint64_t created;
+        bool valid = std::memcmp(bytes, SNAPSHOT_MAGIC, sizeof(SNAPSHOT_MAGIC)) == 0 &&
+                     header.u32(version) && version == SNAPSHOT_FORMAT_VERSION &&
+                     header.u32(fileMessId) && static_cast<int>(fileMessId) == messId &&
+                     header.u64(created) && header.u32(bodyLength) && header.u32(checksum) &&
+                     bodyLength == fileSize - HEADER_SIZE &&
+                     crc32(bytes + HEADER_SIZE, bodyLength) == checksum &&
+                     decodeBody(bytes + HEADER_SIZE, bodyLength, *snapshot);
+        ::munmap(mapped, fileSize);
+
+        if (!valid) {
+            logEvent(LogLevel::Warning, "readSnapshotFile", "Ignoring invalid reference snapshot", {{"path", path}});
+            return nullptr;
+        }
+        snapshot->mess_id = messId;
+        snapshot->created_unix = static_cast<int64_t>(created);
+        snapshot->body_checksum = checksum;
+        return snapshot;
+    }
+
+    bool writeSnapshotFile(const ReferenceSnapshot& snapshot, const std::string& body) {
+        Writer header;
+        header.out.append(SNAPSHOT_MAGIC, sizeof(SNAPSHOT_MAGIC));
+        header.u32(SNAPSHOT_FORMAT_VERSION);
+        header.i32(snapshot.mess_id);
+        header.u64(static_cast<uint64_t>(snapshot.created_unix));
+        header.u32(static_cast<uint32_t>(body.size()));
+        header.u32(snapshot.body_checksum);
+
+        // Write a temp file and rename it over the old one, so a reader never sees a partial file.
+        std::string path = snapshotPath(snapshot.mess_id);
+        std::string tempPath = path + ".tmp";
+        std::FILE* file = std::fopen(tempPath.c_str(), "wb");
+        if (!file) return false;
+        bool ok = std::fwrite(header.out.data(), 1, header.out.size(), file) == header.out.size() &&
+                  std::fwrite(body.data(), 1, body.size(), file) == body.size();
+        ok = std::fclose(file) == 0 && ok;
+        return ok && std::rename(tempPath.c_str(), path.c_str()) == 0;
+    }
+
+    // The period whose month and year match today, as MONTHNAME() would spell it.
+    int findCurrentPeriodId(const std::vector<MealPeriod>& periods) {
+        std::time_t now = std::time(nullptr);
+        std::tm local = *std::localtime(&now);
+        static const char* monthNames[] = {"January", "February", "March", "April", "May", "June", "July",
+                                           "August", "September", "October", "November", "December"};
+        std::string month = monthNames[local.tm_mon];
+        std::string year = std::to_string(local.tm_year + 1900);
+        for (const auto& period : periods) {
+            if (period.month == month && period.year == year) return period.id;
+        }
+        return 0;
+    }
+
+    // Reads everything from the database; nullptr if it is unreachable.
+    std::shared_ptr<ReferenceSnapshot> buildSnapshot(int messId) {
+        auto snapshot = std::make_shared<ReferenceSnapshot>();
+        snapshot->mess_id = messId;
+        try {
+            // Each getter reports its own SQL errors; an empty users list means the database was not reachable.
+            snapshot->users = getAllUsers();
+            if (snapshot->users.empty()) return nullptr;
+            snapshot->menu_items = getAllMenuItems();
+            snapshot->periods = getAllMealPeriods();
+            snapshot->currency = getSystemSettings().currency;
+            snapshot->current_period_id = findCurrentPeriodId(snapshot->periods);
+            if (snapshot->current_period_id != 0) {
+                auto [mealRate, reports] = generateMonthlySettlement(snapshot->current_period_id);
+                snapshot->current_meal_rate = mealRate;
+                snapshot->current_settlement = std::move(reports);
+            }
+        } catch (const std::exception& e) {
+            logEvent(LogLevel::Error, "buildSnapshot", std::string("Error building reference snapshot: ") + e.what(), {{"mess_id", messId}});
+            return nullptr;
+        }
+        for (auto& user : snapshot->users) {
+            user.password_hash.clear();
+            user.salt.clear();
+        }
+        snapshot->created_unix = static_cast<int64_t>(std::time(nullptr));
+        return snapshot;
+    }
+} // namespace
+
+std::shared_ptr<const ReferenceSnapshot> mapReferenceSnapshot() {
+    std::shared_ptr<const ReferenceSnapshot> snapshot = readSnapshotFile(currentMessId());
+    std::lock_guard<std::mutex> lock(snapshotMutex);
+    current = snapshot;
+    return snapshot;
+}
+
+std::shared_ptr<const ReferenceSnapshot> currentReferenceSnapshot() {
+    std::lock_guard<std::mutex> lock(snapshotMutex);
+    return current;
+}
+
+ReferenceSnapshotRefresher::ReferenceSnapshotRefresher(Callback onRefreshed)
+    : onRefreshed(std::move(onRefreshed))
+{
+}
+
+ReferenceSnapshotRefresher::~ReferenceSnapshotRefresher() {
+    if (worker.joinable()) worker.join();
+}
+
+void ReferenceSnapshotRefresher::start() {
+    if (running.exchange(true)) return;
+    if (worker.joinable()) worker.join(); // The previous refresh has finished
+
+    int messId = currentMessId();
+    worker = std::thread([this, messId] {
+        sql::Driver* driver = sql::mysql::get_driver_instance();
+        driver->threadInit(); // Connector/C++ needs this on every thread that connects
+
+        std::shared_ptr<ReferenceSnapshot> fresh = buildSnapshot(messId);
+        if (fresh) {
+            std::string body = encodeBody(*fresh);
+            fresh->body_checksum = crc32(body);
+
+            std::shared_ptr<const ReferenceSnapshot> previous = currentReferenceSnapshot();
+            bool changed = !previous || previous->mess_id != messId || previous->body_checksum != fresh->body_checksum;
+            if (changed && !writeSnapshotFile(*fresh, body)) {
+                logEvent(LogLevel::Warning, "ReferenceSnapshotRefresher", "Could not write reference snapshot", {{"path", snapshotPath(messId)}});
+            }
+            {
+                std::lock_guard<std::mutex> lock(snapshotMutex);
+                current = fresh;
+            }
+            if (onRefreshed) onRefreshed(fresh, changed);
+        }
+
+        driver->threadEnd();
+        running = false;
+    });
+}
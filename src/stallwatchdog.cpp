@@ -0,0 +1,194 @@
+#include "stallwatchdog.h"
+#include "database.h"
+#include "logger.h"
+#include "slowquery.h"
+#include <QCoreApplication>
+#include <QDateTime>
+#include <QSettings>
+#include <QTimer>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+namespace { // Anonymous namespace for file-local helpers
+    using Clock = std::chrono::steady_clock;
+
+    const int HEARTBEAT_INTERVAL_MS = 50;
+    const auto CHECK_INTERVAL = std::chrono::milliseconds(50);
+    const char* UNMARKED_ACTIVITY = "(unmarked)";
+    const int MAX_ACTIVITY_DEPTH = 8; // Deeper scopes are counted but not named
+
+    // Open StallActivity scopes, written by the GUI thread only. The watchdog
+    // may read a slot mid-update; at worst it names the previous activity.
+    std::atomic<const char*> activityStack[MAX_ACTIVITY_DEPTH];
+    std::atomic<int> activityDepth{0};
+
+    std::atomic<Clock::rep> lastBeat{0}; // 0 until the event loop first runs
+
+    std::mutex statsMutex;
+    std::map<std::string, StallStats> stallStats; // By activity
+
+    int readThresholdMs() {
+        QSettings settings(QString::fromStdString(getConfigFilePath()), QSettings::IniFormat);
+        return std::max(0, settings.value("Watchdog/stall_threshold_ms", 250).toInt());
+    }
+
+    std::string currentActivity() {
+        int depth = std::min(activityDepth.load(), MAX_ACTIVITY_DEPTH);
+        std::string chain;
+        for (int i = 0; i < depth; ++i) {
+            const char* name = activityStack[i].load();
+            if (!name) continue;
+            if (!chain.empty()) chain += " > ";
+            chain += name;
+        }
+        return chain;
+    }
+
+    double ticksToMs(Clock::rep ticks) {
+        return std::chrono::duration<double, std::milli>(Clock::duration(ticks)).count();
+    }
+
+    void recordStall(const std::string& activity, double durationMs, const InFlightStatement* query) {
+        std::string name = activity.empty() ? UNMARKED_ACTIVITY : activity;
+        {
+            std::lock_guard<std::mutex> lock(statsMutex);
+            auto it = stallStats.find(name);
+            if (it == stallStats.end()) {
+                it = stallStats.emplace(name, StallStats{name, 0, 0.0, 0.0, "", ""}).first;
+            }
+            StallStats& stats = it->second;
+            stats.count++;
+            stats.total_ms += durationMs;
+            stats.max_ms = std::max(stats.max_ms, durationMs);
+            if (query) stats.last_query = query->function + ": " + query->sql;
+            stats.last_seen = QDateTime::currentDateTime().toString("yyyy-MM-dd HH:mm:ss").toStdString();
+        }
+
+        if (query) {
+            logEvent(LogLevel::Warning, "stallWatchdog", "GUI thread stalled",
+                     {LogField("activity", name), LogField("duration_ms", durationMs), LogField("query_fn", query->function),
+                      LogField("sql_id", query->sql_id), LogField("query_ms", query->elapsed_ms)});
+        } else {
+            logEvent(LogLevel::Warning, "stallWatchdog", "GUI thread stalled",
+                     {LogField("activity", name), LogField("duration_ms", durationMs)});
+        }
+    }
+
+    // Samples the heartbeat. A stall starts when the last beat is older than
+    // the threshold and ends with the next beat; while it lasts, the activity
+    // first seen and the longest-running statement are kept for the record.
+    class Watchdog {
+    public:
+        explicit Watchdog(int thresholdMs)
+            : threshold(std::chrono::duration_cast<Clock::duration>(std::chrono::milliseconds(thresholdMs + HEARTBEAT_INTERVAL_MS)).count()),
+              worker(&Watchdog::run, this) {}
+
+        ~Watchdog() {
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                stopping = true;
+            }
+            wake.notify_one();
+            worker.join();
+        }
+
+    private:
+        Clock::rep threshold; // Beat age that counts as a stall, one interval over the setting
+        std::mutex mutex;
+        std::condition_variable wake;
+        bool stopping = false;
+        std::thread worker; // Last, so it starts after everything it uses
+
+        void run() {
+            bool stalled = false;
+            Clock::rep stalledBeat = 0;
+            std::string activity;
+            InFlightStatement query;
+            bool haveQuery = false;
+
+            std::unique_lock<std::mutex> lock(mutex);
+            while (!wake.wait_for(lock, CHECK_INTERVAL, [this] { return stopping; })) {
+                Clock::rep beat = lastBeat.load(std::memory_order_acquire);
+                if (beat == 0) continue;
+
+                if (stalled && beat != stalledBeat) {
+                    double durationMs = ticksToMs(beat - stalledBeat) - HEARTBEAT_INTERVAL_MS;
+                    recordStall(activity, durationMs, haveQuery ? &query : nullptr);
+                    stalled = false;
+                    continue;
+                }
+                if (!stalled) {
+                    if (Clock::now().time_since_epoch().count() - beat < threshold) continue;
+                    stalled = true;
+                    stalledBeat = beat;
+                    activity.clear();
+                    haveQuery = false;
+                }
+
+                if (activity.empty()) activity = currentActivity();
+                InFlightStatement running;
+                if (currentInFlightStatement(running) && (!haveQuery || running.elapsed_ms > query.elapsed_ms)) {
+                    query = running;
+                    haveQuery = true;
+                }
+            }
+        }
+    };
+
+    std::unique_ptr<Watchdog> watchdog; // GUI thread only
+} // namespace
+
+StallActivity::StallActivity(const char* name) {
+    int depth = activityDepth.load();
+    if (depth < MAX_ACTIVITY_DEPTH) activityStack[depth].store(name);
+    activityDepth.store(depth + 1);
+}
+
+StallActivity::~StallActivity() {
+    activityDepth.fetch_sub(1);
+}
+
+void startStallWatchdog() {
+    int thresholdMs = stallThresholdMs();
+    if (thresholdMs <= 0 || watchdog) return;
+
+    watchInFlightStatements(std::this_thread::get_id());
+
+    auto heartbeat = new QTimer(QCoreApplication::instance());
+    heartbeat->setTimerType(Qt::PreciseTimer);
+    QObject::connect(heartbeat, &QTimer::timeout, heartbeat, [] {
+        lastBeat.store(Clock::now().time_since_epoch().count(), std::memory_order_release);
+    });
+    heartbeat->start(HEARTBEAT_INTERVAL_MS);
+
+    watchdog = std::make_unique<Watchdog>(thresholdMs);
+}
+
+void stopStallWatchdog() {
+    watchdog.reset();
+}
+
+int stallThresholdMs() {
+    static const int thresholdMs = readThresholdMs();
+    return thresholdMs;
+}
+
+std::vector<StallStats> getStallStats() {
+    std::vector<StallStats> result;
+    {
+        std::lock_guard<std::mutex> lock(statsMutex);
+        for (const auto& entry : stallStats) {
+            result.push_back(entry.second);
+        }
+    }
+    std::sort(result.begin(), result.end(), [](const StallStats& a, const StallStats& b) {
+        return a.total_ms > b.total_ms;
+    });
+    return result;
+}
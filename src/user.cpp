@@ -1,9 +1,13 @@
 #include "user.h"
 #include "database.h"
+#include "expenseanalytics.h"
+#include "mess.h"
+#include "logger.h"
+#include "slowquery.h"
 #include <cppconn/prepared_statement.h>
 #include <cppconn/resultset.h>
-#include <iostream>
 #include <memory>
+#include <set>
 
 namespace { // Anonymous namespace for file-local helpers
     std::string roleToString(UserRole role) {
@@ -28,19 +32,21 @@ bool registerUser(const std::string& username, const std::string& password, cons
         std::string password_hash = hashPassword(password, salt);
 
         std::unique_ptr<sql::Connection> con(getConnection());
-        std::unique_ptr<sql::PreparedStatement> pstmt(
-            con->prepareStatement("INSERT INTO users (username, password_hash, salt, name, role) VALUES (?, ?, ?, ?, ?)")
+        std::unique_ptr<TracedStatement> pstmt(
+            prepareTraced(*con, "registerUser", "INSERT INTO users (mess_id, username, password_hash, salt, name, role) VALUES (?, ?, ?, ?, ?, ?)")
         );
-        pstmt->setString(1, username);
-        pstmt->setString(2, password_hash);
-        pstmt->setString(3, salt);
-        pstmt->setString(4, name);
-        pstmt->setString(5, roleToString(role));
+        pstmt->setInt(1, currentMessId());
+        pstmt->setString(2, username);
+        pstmt->setString(3, password_hash);
+        pstmt->setString(4, salt);
+        pstmt->setString(5, name);
+        pstmt->setString(6, roleToString(role));
         pstmt->execute();
+        noteWrite();
         return true;
     } catch (sql::SQLException& e) {
         if (e.getErrorCode() == 1062) { // ER_DUP_ENTRY
-            std::cerr << "Error: Username '" << username << "' already exists." << std::endl;
+            logEvent(LogLevel::Error, "registerUser", "Username already exists", {{"username", username}});
         }
         return false;
     }
@@ -49,10 +55,11 @@ bool registerUser(const std::string& username, const std::string& password, cons
 std::unique_ptr<User> loginUser(const std::string& username, const std::string& password) {
     try {
         std::unique_ptr<sql::Connection> con(getConnection());
-        std::unique_ptr<sql::PreparedStatement> pstmt(
-            con->prepareStatement("SELECT id, username, password_hash, salt, name, role FROM users WHERE username = ?")
+        std::unique_ptr<TracedStatement> pstmt(
+            prepareTraced(*con, "loginUser", "SELECT id, username, password_hash, salt, name, role FROM users WHERE mess_id = ? AND username = ?")
         );
-        pstmt->setString(1, username);
+        pstmt->setInt(1, currentMessId());
+        pstmt->setString(2, username);
 
         std::unique_ptr<sql::ResultSet> res(pstmt->executeQuery());
 
@@ -71,7 +78,7 @@ std::unique_ptr<User> loginUser(const std::string& username, const std::string&
             }
         }
     } catch (sql::SQLException& e) {
-        std::cerr << "SQL Error in loginUser: " << e.what() << std::endl;
+        logSqlError("loginUser", e);
     }
     return nullptr;
 }
@@ -80,8 +87,11 @@ std::vector<User> getAllUsers() {
     std::vector<User> users;
     try {
         std::unique_ptr<sql::Connection> con(getConnection());
-        std::unique_ptr<sql::Statement> stmt(con->createStatement());
-        std::unique_ptr<sql::ResultSet> res(stmt->executeQuery("SELECT id, username, name, role FROM users ORDER BY id"));
+        std::unique_ptr<TracedStatement> pstmt(
+            prepareTraced(*con, "getAllUsers", "SELECT id, username, name, role FROM users WHERE mess_id = ? ORDER BY id")
+        );
+        pstmt->setInt(1, currentMessId());
+        std::unique_ptr<sql::ResultSet> res(pstmt->executeQuery());
 
         while (res->next()) {
             User user;
@@ -92,7 +102,7 @@ std::vector<User> getAllUsers() {
             users.push_back(user);
         }
     } catch (sql::SQLException& e) {
-        std::cerr << "SQL Error in getAllUsers: " << e.what() << std::endl;
+        logSqlError("getAllUsers", e);
     }
     return users;
 }
@@ -100,10 +110,11 @@ std::vector<User> getAllUsers() {
 std::unique_ptr<User> getUserById(int id) {
     try {
         std::unique_ptr<sql::Connection> con(getConnection());
-        std::unique_ptr<sql::PreparedStatement> pstmt(
-            con->prepareStatement("SELECT id, username, password_hash, salt, name, role FROM users WHERE id = ?")
+        std::unique_ptr<TracedStatement> pstmt(
+            prepareTraced(*con, "getUserById", "SELECT id, username, password_hash, salt, name, role FROM users WHERE id = ? AND mess_id = ?")
         );
         pstmt->setInt(1, id);
+        pstmt->setInt(2, currentMessId());
 
         std::unique_ptr<sql::ResultSet> res(pstmt->executeQuery());
 
@@ -118,7 +129,7 @@ std::unique_ptr<User> getUserById(int id) {
             return user;
         }
     } catch (sql::SQLException& e) {
-        std::cerr << "SQL Error in getUserById: " << e.what() << std::endl;
+        logSqlError("getUserById", e);
     }
     return nullptr;
 }
@@ -126,13 +137,17 @@ std::unique_ptr<User> getUserById(int id) {
 bool updateUserProfile(int id, const std::string& name) {
     try {
         std::unique_ptr<sql::Connection> con(getConnection());
-        std::unique_ptr<sql::PreparedStatement> pstmt(con->prepareStatement("UPDATE users SET name = ? WHERE id = ?"));
+        std::unique_ptr<TracedStatement> pstmt(prepareTraced(*con, "updateUserProfile", "UPDATE users SET name = ? WHERE id = ? AND mess_id = ?"));
         pstmt->setString(1, name);
         pstmt->setInt(2, id);
+        pstmt->setInt(3, currentMessId());
         // executeUpdate returns the number of affected rows
-        return pstmt->executeUpdate() > 0; 
+        bool updated = pstmt->executeUpdate() > 0;
+        noteWrite();
+        if (updated) invalidateExpenseCube(); // The cube carries payer names
+        return updated;
     } catch (sql::SQLException& e) {
-        std::cerr << "SQL Error in updateUserProfile: " << e.what() << std::endl;
+        logSqlError("updateUserProfile", e);
         return false;
     }
 }
@@ -140,14 +155,15 @@ bool updateUserProfile(int id, const std::string& name) {
 bool updateUserPassword(int id, const std::string& oldPassword, const std::string& newPassword) {
     try {
         std::unique_ptr<sql::Connection> con(getConnection());
-        std::unique_ptr<sql::PreparedStatement> pstmt_select(
-            con->prepareStatement("SELECT password_hash, salt FROM users WHERE id = ?")
+        std::unique_ptr<TracedStatement> pstmt_select(
+            prepareTraced(*con, "updateUserPassword", "SELECT password_hash, salt FROM users WHERE id = ? AND mess_id = ?")
         );
         pstmt_select->setInt(1, id);
+        pstmt_select->setInt(2, currentMessId());
         std::unique_ptr<sql::ResultSet> res(pstmt_select->executeQuery());
 
         if (!res->next()) {
-            std::cerr << "Error: User with ID " << id << " not found." << std::endl;
+            logEvent(LogLevel::Error, "updateUserPassword", "User not found", {{"user_id", id}});
             return false;
         }
 
@@ -155,7 +171,7 @@ bool updateUserPassword(int id, const std::string& oldPassword, const std::strin
         std::string db_salt = res->getString("salt");
 
         if (db_password_hash != hashPassword(oldPassword, db_salt)) {
-            std::cerr << "Error: Old password does not match." << std::endl;
+            logEvent(LogLevel::Error, "updateUserPassword", "Old password does not match", {{"user_id", id}});
             return false;
         }
 
@@ -163,8 +179,8 @@ bool updateUserPassword(int id, const std::string& oldPassword, const std::strin
         std::string new_salt = generateSalt();
         std::string new_password_hash = hashPassword(newPassword, new_salt);
 
-        std::unique_ptr<sql::PreparedStatement> pstmt_update(
-            con->prepareStatement("UPDATE users SET password_hash = ?, salt = ? WHERE id = ?")
+        std::unique_ptr<TracedStatement> pstmt_update(
+            prepareTraced(*con, "updateUserPassword", "UPDATE users SET password_hash = ?, salt = ? WHERE id = ?")
         );
         pstmt_update->setString(1, new_password_hash);
         pstmt_update->setString(2, new_salt);
@@ -172,7 +188,36 @@ bool updateUserPassword(int id, const std::string& oldPassword, const std::strin
         return pstmt_update->executeUpdate() > 0;
 
     } catch (sql::SQLException& e) {
-        std::cerr << "SQL Error in updateUserPassword: " << e.what() << std::endl;
+        logSqlError("updateUserPassword", e);
         return false;
     }
 }
+
+void lockMessMembers(sql::Connection& con, int messId, const std::vector<int>& userIds) {
+    std::set<int> wanted(userIds.begin(), userIds.end());
+    if (wanted.empty()) {
+        return;
+    }
+
+    std::string query = "SELECT id FROM users WHERE mess_id = ? AND id IN (";
+    for (size_t i = 0; i < wanted.size(); ++i) {
+        query += "?";
+        if (i < wanted.size() - 1) query += ", ";
+    }
+    query += ") LOCK IN SHARE MODE";
+
+    std::unique_ptr<TracedStatement> pstmt(prepareTraced(con, "lockMessMembers", query));
+    int paramIndex = 1;
+    pstmt->setInt(paramIndex++, messId);
+    for (int userId : wanted) {
+        pstmt->setInt(paramIndex++, userId);
+    }
+    std::unique_ptr<sql::ResultSet> res(pstmt->executeQuery());
+    while (res->next()) {
+        wanted.erase(res->getInt("id"));
+    }
+    if (!wanted.empty()) {
+        throw sql::SQLException("User " + std::to_string(*wanted.begin()) + " is not a member of this mess.",
+                                "23000", ER_NOT_MESS_MEMBER);
+    }
+}
@@ -10,6 +10,8 @@
 #include <QMessageBox>
 #include <QLabel> // Added missing include
 #include "database.h"
+#include "snapshot.h"
+#include "stallwatchdog.h"
 
 // Helper function to convert UserRole enum to QString (re-using from UserProfilePage)
 QString userRoleToString(UserRole role);
@@ -71,16 +73,30 @@ UserManagementPage::UserManagementPage(QWidget *parent)
     connect(registerButton, &QPushButton::clicked, this, &UserManagementPage::registerUserClicked);
     connect(refreshButton, &QPushButton::clicked, this, &UserManagementPage::refreshUsers);
 
-    // Initial load
-    loadUsers();
+    // Initial load, from the local snapshot when there is one
+    if (auto snapshot = currentReferenceSnapshot()) {
+        populateUsers(snapshot->users);
+    } else {
+        loadUsers();
+    }
 
     setLayout(mainLayout);
 }
 
+void UserManagementPage::applyReferenceSnapshot(const ReferenceSnapshot& snapshot)
+{
+    populateUsers(snapshot.users);
+}
+
 void UserManagementPage::loadUsers()
+{
+    StallActivity activity("UserManagementPage::loadUsers");
+    populateUsers(getAllUsers());
+}
+
+void UserManagementPage::populateUsers(const std::vector<User>& users)
 {
     userTable->setRowCount(0); // Clear existing rows
-    std::vector<User> users = getAllUsers();
     userTable->setRowCount(users.size());
 
     for (size_t i = 0; i < users.size(); ++i) {
@@ -93,6 +109,7 @@ void UserManagementPage::loadUsers()
 
 void UserManagementPage::registerUserClicked()
 {
+    StallActivity activity("UserManagementPage::registerUserClicked");
     QString username = usernameLineEdit->text().trimmed();
     QString password = passwordLineEdit->text();
     QString name = nameLineEdit->text().trimmed();
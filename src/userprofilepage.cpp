@@ -1,5 +1,6 @@
 #include "userprofilepage.h"
 #include "user.h"
+#include "userstatementdialog.h"
 #include <QVBoxLayout>
 #include <QHBoxLayout>
 #include <QLabel>
@@ -48,7 +49,12 @@ UserProfilePage::UserProfilePage(User* user, QWidget *parent)
     auto saveButton = new QPushButton("Save Profile", this);
     mainLayout->addWidget(saveButton);
 
+    // Statement of the user's payments, shopping and meal charges
+    auto statementButton = new QPushButton("View Statement", this);
+    mainLayout->addWidget(statementButton);
+
     connect(saveButton, &QPushButton::clicked, this, &UserProfilePage::saveProfile);
+    connect(statementButton, &QPushButton::clicked, this, &UserProfilePage::viewStatement);
 
     setLayout(mainLayout);
 }
@@ -63,4 +69,10 @@ void UserProfilePage::updatePassword()
 {
     QMessageBox::information(this, "Update Password", "Update password functionality not yet implemented.");
     // Future: Implement password update logic here
-}
\ No newline at end of file
+}
+
+void UserProfilePage::viewStatement()
+{
+    UserStatementDialog dialog(currentUser->id, this);
+    dialog.exec();
+}
@@ -0,0 +1,120 @@
+#include "userstatementdialog.h"
+#include "ledger.h"
+#include "stallwatchdog.h"
+#include <QVBoxLayout>
+#include <QHBoxLayout>
+#include <QTableWidget>
+#include <QPushButton>
+#include <QHeaderView>
+#include <QLabel>
+
+namespace {
+    QString entryTypeLabel(LedgerEntryType type) {
+        switch (type) {
+            case LedgerEntryType::Payment:  return "Payment";
+            case LedgerEntryType::Shopping: return "Shopping";
+            case LedgerEntryType::MealCost: return "Meal charge";
+        }
+        return "Payment";
+    }
+} // namespace
+
+UserStatementDialog::UserStatementDialog(int userId, QWidget *parent)
+    : QDialog(parent), userId(userId)
+{
+    auto mainLayout = new QVBoxLayout(this);
+
+    LedgerBalance balance{};
+    bool found = getLedgerBalance(userId, balance);
+    QString userName = found ? QString::fromStdString(balance.user_name) : QString("User %1").arg(userId);
+    setWindowTitle("Statement - " + userName);
+
+    // Title
+    auto titleLabel = new QLabel("Statement for " + userName, this);
+    titleLabel->setStyleSheet("font-size: 18px; font-weight: bold;");
+    mainLayout->addWidget(titleLabel);
+
+    // Positive balances are owed to the user by the mess
+    balanceLabel = new QLabel(this);
+    if (found) {
+        balanceLabel->setText(QString("Balance: %1 (%2)")
+            .arg(balance.balance, 0, 'f', 2)
+            .arg(balance.balance < 0 ? "owed to the mess" : "owed by the mess"));
+    }
+    mainLayout->addWidget(balanceLabel);
+
+    // Entries in posting order, so each row's balance follows from the one above
+    statementTable = new QTableWidget(this);
+    statementTable->setColumnCount(5);
+    statementTable->setHorizontalHeaderLabels({"Date", "Type", "Description", "Amount", "Balance"});
+    statementTable->horizontalHeader()->setSectionResizeMode(2, QHeaderView::Stretch);
+    statementTable->setSelectionBehavior(QAbstractItemView::SelectRows);
+    statementTable->setEditTriggers(QAbstractItemView::NoEditTriggers);
+    statementTable->verticalHeader()->setVisible(false);
+    mainLayout->addWidget(statementTable);
+
+    // Navigation
+    auto navigationLayout = new QHBoxLayout();
+    olderButton = new QPushButton("< Older", this);
+    navigationLayout->addWidget(olderButton);
+    newerButton = new QPushButton("Newer >", this);
+    navigationLayout->addWidget(newerButton);
+    newestButton = new QPushButton("Newest", this);
+    navigationLayout->addWidget(newestButton);
+    navigationLayout->addStretch();
+    auto closeButton = new QPushButton("Close", this);
+    navigationLayout->addWidget(closeButton);
+    mainLayout->addLayout(navigationLayout);
+
+    // Connections
+    connect(olderButton, &QPushButton::clicked, this, &UserStatementDialog::showOlder);
+    connect(newerButton, &QPushButton::clicked, this, &UserStatementDialog::showNewer);
+    connect(newestButton, &QPushButton::clicked, this, &UserStatementDialog::showNewest);
+    connect(closeButton, &QPushButton::clicked, this, &QDialog::accept);
+
+    // Initial load
+    showNewest();
+
+    resize(720, 520);
+    setLayout(mainLayout);
+}
+
+void UserStatementDialog::showNewest()
+{
+    StallActivity activity("UserStatementDialog::showNewest");
+    showPage(getLedgerStatementBefore(userId, 0, PAGE_SIZE));
+}
+
+void UserStatementDialog::showOlder()
+{
+    StallActivity activity("UserStatementDialog::showOlder");
+    showPage(getLedgerStatementBefore(userId, firstEntryId, PAGE_SIZE));
+}
+
+void UserStatementDialog::showNewer()
+{
+    StallActivity activity("UserStatementDialog::showNewer");
+    showPage(getLedgerStatementAfter(userId, lastEntryId, PAGE_SIZE));
+}
+
+void UserStatementDialog::showPage(const LedgerStatementPage& page)
+{
+    statementTable->setRowCount(0); // Clear existing rows
+    statementTable->setRowCount(page.entries.size());
+
+    for (size_t i = 0; i < page.entries.size(); ++i) {
+        const LedgerEntry& entry = page.entries[i];
+        statementTable->setItem(i, 0, new QTableWidgetItem(QString::fromStdString(entry.entry_date)));
+        statementTable->setItem(i, 1, new QTableWidgetItem(entryTypeLabel(entry.type)));
+        statementTable->setItem(i, 2, new QTableWidgetItem(QString::fromStdString(entry.description)));
+        statementTable->setItem(i, 3, new QTableWidgetItem(QString::number(entry.amount, 'f', 2)));
+        statementTable->setItem(i, 4, new QTableWidgetItem(QString::number(entry.running_balance, 'f', 2)));
+    }
+    statementTable->scrollToBottom();
+
+    firstEntryId = page.entries.empty() ? 0 : page.entries.front().id;
+    lastEntryId = page.entries.empty() ? 0 : page.entries.back().id;
+    olderButton->setEnabled(page.has_older);
+    newerButton->setEnabled(page.has_newer);
+    newestButton->setEnabled(page.has_newer);
+}